@@ -37,6 +37,7 @@
 #define MAX_SPVERSION_LEN 80
 #define MAXTABLELEN 32
 #define MAXTAGLEN 64
+#define RCACHE_MAX_LEVELS 8 /* most b-tree levels the rcache keeps */
 #define REPMAX 64
 /* Maximum buffer length for generated key name. */
 #define MAXGENKEYLEN 25
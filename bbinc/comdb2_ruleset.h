@@ -200,6 +200,8 @@ struct ruleset_item {
                                    * matched? */
 };
 
+struct ruleset_index;
+
 struct ruleset {
   long long int version;          /* What version was seen when reading this
                                    * ruleset into memory? */
@@ -213,6 +215,11 @@ struct ruleset {
 
   struct ruleset_item *aRule;     /* An array of rules with a minimum size of
                                    * nRule. */
+
+  struct ruleset_index *pIndex;   /* The rules compiled into lookup tables,
+                                   * used to find the rules a request could
+                                   * match without visiting all of them.  If
+                                   * NULL, every rule is evaluated. */
 };
 
 struct ruleset_result {
@@ -274,6 +281,12 @@ size_t comdb2_ruleset_result_to_str(
   size_t nBuf
 );
 
+int comdb2_bench_ruleset(
+  struct ruleset *rules,
+  struct ruleset_item_criteria *context,
+  int nIter
+);
+
 int comdb2_enable_ruleset_item(struct ruleset *rules, int ruleNo, int bEnable);
 void comdb2_dump_ruleset(struct ruleset *rules);
 void comdb2_free_ruleset(struct ruleset *rules);
@@ -0,0 +1,52 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef INCLUDED_PGMAP_H
+#define INCLUDED_PGMAP_H
+
+/*
+ * On-disk format of the changed-page maps kept by mpool for incremental
+ * backups.  For every data file, mpool records a clock value for each chunk
+ * of PGMAP chunk_pages pages when one of its pages is written.  The clock is
+ * the highest log file number seen when the page was written, and never goes
+ * backwards.  A backup which read a file when its map's clock was C only
+ * needs to re-read chunks whose clock is >= C.  Entries are only meaningful
+ * for backups taken at or after valid_from.
+ *
+ * The maps live in a "pgmap" directory beside the data files, under the data
+ * file's name.  They are written in native byte order and replaced with a
+ * rename, so a reader always sees a complete map.
+ */
+
+#include <stdint.h>
+
+#define PGMAP_DIR "pgmap"
+#define PGMAP_MAGIC 0x50474d50 /* "PGMP" */
+#define PGMAP_VERSION 1
+
+struct pgmap_header {
+    uint32_t magic;
+    uint32_t version;
+    uint8_t fileid[20];   /* Must match the data file's meta page uid */
+    uint32_t chunk_pages; /* Pages covered by each entry */
+    uint32_t clean;       /* Written when the file was closed */
+    uint32_t valid_from;  /* Oldest clock the entries can be compared to */
+    uint32_t clock;       /* Clock when the map was written */
+    uint32_t nchunks;     /* Number of entries that follow */
+    uint32_t unused;
+};
+
+#endif
@@ -109,6 +109,8 @@ int thdpool_get_nfreethds(struct thdpool *pool);
 int thdpool_get_nbusythds(struct thdpool *pool);
 void thdpool_add_waitthd(struct thdpool *pool);
 void thdpool_remove_waitthd(struct thdpool *pool);
+/* count work that timed out waiting for the pool somewhere else */
+void thdpool_add_timeout(struct thdpool *pool);
 int thdpool_get_maxthds(struct thdpool *pool);
 int thdpool_get_peaknthds(struct thdpool *pool);
 int thdpool_get_creates(struct thdpool *pool);
@@ -19,6 +19,20 @@
 
 #include <stdint.h>
 
+/* What a thread was waiting on; see wait_time_us[] below */
+enum thread_wait_event {
+    THD_WAIT_LOCK_PAGE,  /* page and handle locks */
+    THD_WAIT_LOCK_ROW,   /* row, keyhash and minmax locks */
+    THD_WAIT_LOCK_TABLE, /* table locks */
+    THD_WAIT_LOCK_OTHER, /* any other lock object */
+    THD_WAIT_PAGE_IN,    /* reading a page in on a buffer pool miss */
+    THD_WAIT_LOG_FLUSH,  /* flushing the log for a commit */
+    THD_WAIT_REP,        /* waiting for replicants to ack a commit */
+    THD_WAIT_OSQL,       /* waiting on the master for an osql reply */
+    THD_WAIT_THROTTLE,   /* deliberate delays and retry backoffs */
+    THD_WAIT_MAX
+};
+
 struct berkdb_thread_stats {
     uint64_t n_locks;
     unsigned n_lock_waits;
@@ -54,6 +68,11 @@ struct berkdb_thread_stats {
 
     uint64_t rep_collect_time_us;
     uint64_t rep_exec_time_us;
+
+    unsigned n_waits[THD_WAIT_MAX];
+    uint64_t wait_time_us[THD_WAIT_MAX];
 };
 
+const char *thread_wait_event_name(enum thread_wait_event event);
+
 #endif
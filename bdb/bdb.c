@@ -735,6 +735,12 @@ void bdb_fingerprint_rtstats_foreach(bdb_fingerprint_rtstats_enum_fn fn, void *a
     bb_berkdb_fingerprint_rtstats_foreach((bb_berkdb_fingerprint_rtstats_enum_fn)fn, arg);
 }
 
+/* Account a wait (enum thread_wait_event) outside berkdb to this thread */
+void bdb_thread_wait(int event, uint64_t us)
+{
+    bb_berkdb_thread_wait(event, us);
+}
+
 /* Call this any time to get process wide stats (which get updated locklessly)
  */
 const struct berkdb_thread_stats *bdb_get_process_stats(void)
@@ -767,6 +773,13 @@ void bdb_print_stats(const struct berkdb_thread_stats *st, const char *prefix,
                  U2M(st->lock_wait_time_us), U2M(st->lock_wait_time_us / st->n_lock_waits));
         printfn(s, context);
     }
+    for (int i = 0; i < THD_WAIT_MAX; i++) {
+        if (st->n_waits[i] == 0)
+            continue;
+        snprintf(s, sizeof(s), "%s%u %s waits took %u ms\n", prefix, st->n_waits[i], thread_wait_event_name(i),
+                 U2M(st->wait_time_us[i]));
+        printfn(s, context);
+    }
     if (st->n_preads > 0) {
         snprintf(s, sizeof(s), "%s%u preads took %u ms total of %u bytes\n",
                  prefix, st->n_preads, U2M(st->pread_time_us), st->pread_bytes);
@@ -914,6 +914,10 @@ int bdb_queue_add(bdb_state_type *bdb_state, tran_type *tran, const void *dta,
                   size_t dtalen, int *bdberr, unsigned long long *out_genid);
 int bdb_queue_add_recno(bdb_state_type *bdb_state, tran_type *tran, uint32_t recno, const void *dta, size_t dtalen,
                         int *bdberr, unsigned long long *out_genid);
+/* add an item to the end of one partition of a partitioned queuedb. */
+int bdb_queue_add_partition(bdb_state_type *bdb_state, tran_type *tran,
+                            const void *dta, size_t dtalen, int partition,
+                            int *bdberr, unsigned long long *out_genid);
 
 /* add/consume dummy records to aid extent reclaimation.  winner of the
  * May 2006 "Most Absurd Hack" award. */
@@ -1204,6 +1208,8 @@ struct temp_table *bdb_temp_hashtable_create(bdb_state_type *bdb_state,
                                              int *bdberr);
 struct temp_table *bdb_temp_array_create(bdb_state_type *bdb_state,
                                          int *bdberr);
+struct temp_table *bdb_temp_joinhash_create(bdb_state_type *bdb_state,
+                                            int *bdberr);
 struct temp_table *bdb_temp_table_create_flags(bdb_state_type *bdb_state,
                                                int flags, int *bdberr);
 
@@ -1254,12 +1260,21 @@ void *bdb_temp_table_data(struct temp_cursor *cursor);
 typedef int (*tmptbl_cmp)(void *, int, const void *, int, const void *);
 void bdb_temp_table_set_cmp_func(struct temp_table *table, tmptbl_cmp);
 
+/* Hash the first nfields fields of a key (unpacked if keylen < 0); returns
+ * non-zero if the key cannot be hashed */
+typedef int (*tmptbl_hash)(int nfields, int keylen, const void *key,
+                           unsigned int *hash);
+void bdb_temp_table_set_hash_func(struct temp_table *table, tmptbl_hash);
+
 int bdb_temp_table_find(bdb_state_type *bdb_state, struct temp_cursor *cursor,
                         const void *key, int keylen, void *unpacked,
                         int *bdberr);
 int bdb_temp_table_find_exact(bdb_state_type *bdb_state,
                               struct temp_cursor *cursor, void *key, int keylen,
                               int *bdberr);
+int bdb_temp_table_find_joinhash(bdb_state_type *bdb_state,
+                                 struct temp_cursor *cursor, void *unpacked,
+                                 int nfields, int *bdberr);
 void bdb_temp_table_reset_datapointers(struct temp_cursor *cur);
 
 void *bdb_temp_table_get_cur(struct temp_cursor *skippy);
@@ -1371,6 +1386,7 @@ extern int gbl_bb_berkdb_enable_shalloc_timing;
 void bdb_reset_thread_stats(void);
 const struct berkdb_thread_stats *bdb_get_thread_stats(void);
 const struct berkdb_thread_stats *bdb_get_process_stats(void);
+void bdb_thread_wait(int event, uint64_t us);
 
 /* Must match FINGERPRINTSZ (db/fingerprint.h) and berkdb's FP_RTSTATS_KEYSZ. */
 #define BDB_FINGERPRINTSZ 16
@@ -1979,6 +1995,7 @@ void bdb_verify_dbreg(bdb_state_type *bdb_state);
 int bdb_the_lock_desired(void);
 
 int bdb_is_hashtable(struct temp_table *);
+int bdb_is_joinhash(struct temp_table *);
 
 void analyze_set_headroom(uint64_t);
 
@@ -2455,6 +2472,12 @@ typedef struct repl_wait_and_net_use {
     double max_wait_over_1min;
     char lsn_text[LSN_TEXT_WIDTH];
     uint64_t lsn_bytes_behind;
+    unsigned long long compress_raw_bytes;
+    unsigned long long compress_bytes;
+    unsigned long long compress_usec;
+    unsigned long long decompress_usec;
+    unsigned long long acks;
+    unsigned long long waiters_released;
 } repl_wait_and_net_use_t;
 repl_wait_and_net_use_t *bdb_get_repl_wait_and_net_stats(bdb_state_type *bdb_state, int *pnnodes);
 
@@ -2519,6 +2542,16 @@ void fill_ssl_info(CDB2DBINFORESPONSE *);
 
 void thedb_set_master(char *);
 int bdb_queuedb_has_seq(bdb_state_type *);
+
+/* Partitioned queuedbs: each partition is ordered independently and is
+ * drained by its own consumer.  Consumers pass the encoded consumer number
+ * to bdb_queue_get. */
+#define BDB_QUEUEDB_MAX_PARTITIONS 256
+void bdb_queuedb_set_partitions(bdb_state_type *, int npartitions);
+int bdb_queuedb_set_partitions_tran(bdb_state_type *, tran_type *,
+                                    int npartitions, int *bdberr);
+int bdb_queuedb_get_partitions(bdb_state_type *);
+int bdb_queuedb_partition_consumer(int consumer, int partition);
 void dispatch_waiting_clients(void);
 
 struct sqlclntstate;
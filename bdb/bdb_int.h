@@ -552,6 +552,14 @@ struct waiting_for_lsn {
 
 typedef LISTC_T(struct waiting_for_lsn) wait_for_lsn_list;
 
+/* A commit waiting for one node to ack lsn, queued on that node's hostinfo */
+struct seqnum_waiter {
+    DB_LSN lsn;
+    pthread_cond_t *cond;
+    int queued;
+    LINKC_T(struct seqnum_waiter) lnk;
+};
+
 typedef struct {
     pthread_mutex_t lock;
     pthread_cond_t cond;
@@ -626,6 +634,9 @@ struct hostinfo
     int coherent_state;
     int appseqnum;
     wait_for_lsn_list waitlist;
+    LISTC_T(struct seqnum_waiter) waiters; /* sorted by lsn */
+    uint64_t acks;             /* seqnums received from the node */
+    uint64_t waiters_released; /* commit waiters its acks released */
     short expected_udp_count;
     short incoming_udp_count;
     short udp_average_counter;
@@ -843,6 +854,7 @@ struct bdb_state_tag {
     signed char compress;      /* boolean: compress data? */
     signed char compress_blobs; /*boolean: compress blobs? */
     signed char persistent_seq; /* boolean: persistent seq for queue? */
+    int qdb_npartitions;        /* queuedb partitions, 0 or 1 if none */
 
     signed char got_gblcontext;
     signed char need_to_upgrade;
@@ -882,6 +894,16 @@ struct bdb_state_tag {
     pthread_mutex_t thread_lock_info_list_mutex;
     LISTC_T(thread_lock_info_type) thread_lock_info_list;
 
+    /* Reader slots of the bdb lock, also parent only.  A reader bumps the
+     * count of its cpu's slot and is done unless bdb_lock_writer is set; a
+     * writer takes bdb_lock exclusively, sets bdb_lock_writer and waits for
+     * the slots to drain.  With no slots every reader takes bdb_lock. */
+    struct bdb_lock_slot *bdb_lock_slots;
+    int bdb_lock_nslots;
+    int bdb_lock_writer;
+    pthread_mutex_t bdb_lock_drain_lk;
+    pthread_cond_t bdb_lock_drain_cd;
+
     /* cache the version_num for the data; this is used to detect dta changes */
     unsigned long long version_num;
 
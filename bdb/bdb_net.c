@@ -42,6 +42,8 @@
 #include "crc32c.h"
 #include <timer_util.h>
 #include <hostname_support.h>
+#include <thread_util.h>
+#include "thrman.h"
 
 #undef UDP_DEBUG
 #undef UDP_TRACE
@@ -58,6 +60,7 @@
 #endif
 
 extern void fsnapf(FILE *, void *, int);
+extern pthread_attr_t gbl_pthread_attr_detached;
 extern int get_myseqnum(bdb_state_type *bdb_state, uint8_t *p_net_seqnum);
 extern int verify_master_leases_int(bdb_state_type *bdb_state,
                                     struct interned_string **comlist, int comcount,
@@ -136,7 +139,7 @@ void disable_ack_trace(void)
     gbl_ack_trace = 0;
 }
 
-int do_ack(bdb_state_type *bdb_state, DB_LSN permlsn, uint32_t commit_gen, uint32_t rep_gen)
+static int send_ack(bdb_state_type *bdb_state, DB_LSN permlsn, uint32_t commit_gen, uint32_t rep_gen)
 {
     int rc;
     char *master;
@@ -192,6 +195,107 @@ int do_ack(bdb_state_type *bdb_state, DB_LSN permlsn, uint32_t commit_gen, uint3
     return rc;
 }
 
+/* Acks are cumulative: the master only keeps the highest lsn a node has
+ * acked.  With rep_ack_coalesce_us set, a replicant holds an ack back until
+ * that long has passed since its last one, or the log has advanced
+ * rep_ack_coalesce_bytes past it, and then sends only the latest. */
+int gbl_rep_ack_coalesce_us = 0;
+int gbl_rep_ack_coalesce_bytes = 262144;
+
+static pthread_mutex_t ack_lk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ack_cond = PTHREAD_COND_INITIALIZER;
+static int ack_flusher_running;
+static struct {
+    bdb_state_type *bdb_state;
+    DB_LSN lsn;
+    uint32_t commit_gen;
+    uint32_t rep_gen;
+    int held;
+} last_ack;
+static DB_LSN sent_lsn;
+static uint64_t sent_us;
+
+/* Called with ack_lk held */
+static int send_held_ack(uint64_t now)
+{
+    last_ack.held = 0;
+    sent_lsn = last_ack.lsn;
+    sent_us = now;
+    return send_ack(last_ack.bdb_state, last_ack.lsn, last_ack.commit_gen,
+                    last_ack.rep_gen);
+}
+
+static void *ack_flusher_thd(void *arg)
+{
+    struct timespec ts;
+    uint64_t now, due;
+
+    thrman_register(THRTYPE_GENERIC);
+    thread_started("bdb ack flusher");
+
+    Pthread_mutex_lock(&ack_lk);
+    while (!db_is_exiting()) {
+        now = comdb2_time_epochus();
+        if (last_ack.held) {
+            due = sent_us;
+            if (gbl_rep_ack_coalesce_us > 0)
+                due += gbl_rep_ack_coalesce_us;
+            if (now >= due) {
+                send_held_ack(now);
+                continue;
+            }
+        } else {
+            due = now + 1000000;
+        }
+        ts.tv_sec = due / 1000000;
+        ts.tv_nsec = (due % 1000000) * 1000;
+        pthread_cond_timedwait(&ack_cond, &ack_lk, &ts);
+    }
+    ack_flusher_running = 0;
+    Pthread_mutex_unlock(&ack_lk);
+    return NULL;
+}
+
+int do_ack(bdb_state_type *bdb_state, DB_LSN permlsn, uint32_t commit_gen, uint32_t rep_gen)
+{
+    int rc = 0, interval = gbl_rep_ack_coalesce_us;
+    uint64_t now;
+
+    Pthread_mutex_lock(&ack_lk);
+    if (interval <= 0 && !last_ack.held) {
+        Pthread_mutex_unlock(&ack_lk);
+        return send_ack(bdb_state, permlsn, commit_gen, rep_gen);
+    }
+
+    /* an older lsn of the same generation is covered by the newer ack which
+     * was already sent or is held */
+    if (rep_gen == last_ack.rep_gen && log_compare(&permlsn, &last_ack.lsn) <= 0) {
+        Pthread_mutex_unlock(&ack_lk);
+        return 0;
+    }
+    now = comdb2_time_epochus();
+    int newgen = (rep_gen != last_ack.rep_gen);
+    last_ack.bdb_state = bdb_state;
+    last_ack.lsn = permlsn;
+    last_ack.commit_gen = commit_gen;
+    last_ack.rep_gen = rep_gen;
+    last_ack.held = 1;
+
+    if (interval <= 0 || newgen || now >= sent_us + interval ||
+        permlsn.file != sent_lsn.file ||
+        permlsn.offset - sent_lsn.offset >= (uint32_t)gbl_rep_ack_coalesce_bytes) {
+        rc = send_held_ack(now);
+    } else if (!ack_flusher_running) {
+        pthread_t tid;
+        ack_flusher_running = 1;
+        Pthread_create(&tid, &gbl_pthread_attr_detached, ack_flusher_thd, NULL);
+    } else {
+        Pthread_cond_signal(&ack_cond);
+    }
+    Pthread_mutex_unlock(&ack_lk);
+    return rc;
+}
+
 void comdb2_early_ack(DB_ENV *dbenv, DB_LSN permlsn, uint32_t commit_gen, uint32_t rep_gen)
 {
     bdb_state_type *bdb_state = (bdb_state_type *)dbenv->app_private;
@@ -23,12 +23,15 @@
 #include <string.h>
 #include <strings.h>
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
+#include <inttypes.h>
 
 #include <list.h>
 #include <comdb2_walkback.h>
 
 #include "bdb_int.h"
+#include "comdb2_atomic.h"
 #include "locks.h"
 #include "sys_wrap.h"
 #include "logmsg.h"
@@ -38,6 +41,7 @@ extern pthread_t gbl_invalid_tid;
 extern int gbl_exit;
 
 int gbl_bdblock_debug = 0;
+int gbl_bdblock_reader_slots = 0;
 
 static pthread_key_t lock_key;
 
@@ -194,6 +198,7 @@ struct thread_lock_info_tag {
     unsigned callers;            /* how many people called in bdb_thread_event */
     const char *ident;           /* who in this thread locked it */
     enum bdb_lock_type locktype; /* type of lock currently held */
+    int rdslot;                  /* reader slot held, -1 if the rwlock is */
 
     /* If we hold the write lock, this records whether or not we previously
      * held the read lock.  If this is non-zero then when we release the
@@ -237,11 +242,144 @@ int bdb_lock_desired(bdb_state_type *bdb_state)
     return bdb_state->bdb_lock_desired;
 }
 
+/* Each reader slot has a cache line to itself */
+struct bdb_lock_slot {
+    int readers;
+} __attribute__((aligned(64)));
+
 void bdb_lock_init(bdb_state_type *bdb_state)
 {
     listc_init(&bdb_state->thread_lock_info_list,
                offsetof(thread_lock_info_type, linkv));
     Pthread_mutex_init(&bdb_state->thread_lock_info_list_mutex, NULL);
+
+    Pthread_mutex_init(&bdb_state->bdb_lock_drain_lk, NULL);
+    Pthread_cond_init(&bdb_state->bdb_lock_drain_cd, NULL);
+    bdb_state->bdb_lock_writer = 0;
+    bdb_state->bdb_lock_nslots = 0;
+    if (gbl_bdblock_reader_slots > 0 &&
+        posix_memalign((void **)&bdb_state->bdb_lock_slots, sizeof(struct bdb_lock_slot),
+                       gbl_bdblock_reader_slots * sizeof(struct bdb_lock_slot)) == 0) {
+        memset(bdb_state->bdb_lock_slots, 0, gbl_bdblock_reader_slots * sizeof(struct bdb_lock_slot));
+        bdb_state->bdb_lock_nslots = gbl_bdblock_reader_slots;
+    }
+}
+
+static inline int reader_slot(bdb_state_type *lock_handle)
+{
+#ifdef _LINUX_SOURCE
+    int cpu = sched_getcpu();
+    if (cpu >= 0)
+        return cpu % lock_handle->bdb_lock_nslots;
+#endif
+    return ((uintptr_t)pthread_self() >> 12) % lock_handle->bdb_lock_nslots;
+}
+
+static int slot_readers(bdb_state_type *lock_handle)
+{
+    int readers = 0;
+    for (int i = 0; i < lock_handle->bdb_lock_nslots; i++)
+        readers += ATOMIC_LOAD32(lock_handle->bdb_lock_slots[i].readers);
+    return readers;
+}
+
+/* bdb_lock_writer: a writer owns bdb_lock and is waiting for the slots to
+ * drain, or it holds the lock.  New slot readers are turned away in both
+ * cases, so a stream of readers cannot starve a draining writer. */
+enum { SLOTS_OPEN = 0, SLOTS_DRAINING = 1, SLOTS_CLOSED = 2 };
+
+static void wake_slot_waiters(bdb_state_type *lock_handle)
+{
+    Pthread_mutex_lock(&lock_handle->bdb_lock_drain_lk);
+    Pthread_cond_broadcast(&lock_handle->bdb_lock_drain_cd);
+    Pthread_mutex_unlock(&lock_handle->bdb_lock_drain_lk);
+}
+
+static void put_reader_slot(bdb_state_type *lock_handle, int slot)
+{
+    ATOMIC_ADD32(lock_handle->bdb_lock_slots[slot].readers, -1);
+    if (ATOMIC_LOAD32(lock_handle->bdb_lock_writer) != SLOTS_OPEN)
+        wake_slot_waiters(lock_handle);
+}
+
+/* Take a reader slot unless a writer wants the lock.  The increment and the
+ * load of bdb_lock_writer are both sequentially consistent, as are the
+ * writer's store and its loads of the slots, so either we see the writer or
+ * it sees us. */
+static inline int get_reader_slot(bdb_state_type *lock_handle, int have_drain_lk)
+{
+    int slot = reader_slot(lock_handle);
+    ATOMIC_ADD32(lock_handle->bdb_lock_slots[slot].readers, 1);
+    if (ATOMIC_LOAD32(lock_handle->bdb_lock_writer) != SLOTS_OPEN) {
+        ATOMIC_ADD32(lock_handle->bdb_lock_slots[slot].readers, -1);
+        if (have_drain_lk)
+            Pthread_cond_broadcast(&lock_handle->bdb_lock_drain_cd);
+        else
+            wake_slot_waiters(lock_handle);
+        return -1;
+    }
+    return slot;
+}
+
+static void slot_timedwait(bdb_state_type *lock_handle)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 10 * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&lock_handle->bdb_lock_drain_cd, &lock_handle->bdb_lock_drain_lk, &ts);
+}
+
+/* Block until the writer lets go */
+static int wait_reader_slot(bdb_state_type *lock_handle)
+{
+    int slot;
+    Pthread_mutex_lock(&lock_handle->bdb_lock_drain_lk);
+    while ((slot = get_reader_slot(lock_handle, 1)) < 0)
+        slot_timedwait(lock_handle);
+    Pthread_mutex_unlock(&lock_handle->bdb_lock_drain_lk);
+    return slot;
+}
+
+/* Called holding bdb_lock exclusively: turn new slot readers away and wait
+ * for the ones already in to leave.  A reader that is turned away bumps its
+ * slot for a moment, so a count seen while draining may be too high but
+ * never misses a reader that got in. */
+static void close_reader_slots(bdb_state_type *lock_handle, const char *idstr,
+                               int abort_waiters)
+{
+    int logged = 0;
+
+    XCHANGE32(lock_handle->bdb_lock_writer, SLOTS_DRAINING);
+    Pthread_mutex_lock(&lock_handle->bdb_lock_drain_lk);
+    for (;;) {
+        if (slot_readers(lock_handle) == 0) {
+            XCHANGE32(lock_handle->bdb_lock_writer, SLOTS_CLOSED);
+            break;
+        } else if (!logged) {
+            logged = 1;
+            logmsg(LOGMSG_INFO, "writelock (%s %p) waiting for %d readers\n", idstr, (void *)pthread_self(),
+                   slot_readers(lock_handle));
+            if (abort_waiters && gbl_rowlocks &&
+                lock_handle->repinfo->master_host != lock_handle->repinfo->myhost) {
+                Pthread_mutex_unlock(&lock_handle->bdb_lock_drain_lk);
+                bdb_abort_logical_waiters(lock_handle);
+                Pthread_mutex_lock(&lock_handle->bdb_lock_drain_lk);
+                continue;
+            }
+        }
+        slot_timedwait(lock_handle);
+    }
+    Pthread_mutex_unlock(&lock_handle->bdb_lock_drain_lk);
+}
+
+static void open_reader_slots(bdb_state_type *lock_handle)
+{
+    XCHANGE32(lock_handle->bdb_lock_writer, SLOTS_OPEN);
+    wake_slot_waiters(lock_handle);
 }
 
 /* Catches thread specific lock info structs that were not released in the
@@ -378,7 +516,11 @@ static inline void bdb_get_writelock_int(bdb_state_type *bdb_state,
            */
         lk->readlockref = lk->lockref;
         lk->readident = lk->ident;
-        Pthread_rwlock_unlock(lock_handle->bdb_lock);
+        if (lk->rdslot >= 0)
+            put_reader_slot(lock_handle, lk->rdslot);
+        else
+            Pthread_rwlock_unlock(lock_handle->bdb_lock);
+        lk->rdslot = -1;
 
         if (gbl_bdblock_debug)
             rel_lock_log(bdb_state);
@@ -433,6 +575,9 @@ static inline void bdb_get_writelock_int(bdb_state_type *bdb_state,
             abort();
         }
 
+        if (lock_handle->bdb_lock_nslots)
+            close_reader_slots(lock_handle, idstr, abort_waiters && rc != EBUSY);
+
         /* Wait on rep_processor threads while we have the writelock lock */
         if (gbl_force_serial_on_writelock && lock_handle->passed_dbenv_open)
             __rep_block_on_inflight_transactions(lock_handle->dbenv);
@@ -507,12 +652,18 @@ int bdb_get_readlock(bdb_state_type *bdb_state, int trylock, const char *idstr,
             lk->initpri = 1;
         }
 #endif
-        rc = pthread_rwlock_tryrdlock(lock_handle->bdb_lock);
+        if (lock_handle->bdb_lock_nslots == 0)
+            rc = pthread_rwlock_tryrdlock(lock_handle->bdb_lock);
+        else
+            rc = (lk->rdslot = get_reader_slot(lock_handle, 0)) >= 0 ? 0 : EBUSY;
         if (rc == EBUSY) {
             logmsg(LOGMSG_INFO, "trying readlock (%s %p), last writelock is %s %p\n", idstr, (void *)pthread_self(),
                    lock_handle->bdb_lock_write_idstr, (void *)lock_handle->bdb_lock_write_holder);
             if (trylock) return rc;
-            Pthread_rwlock_rdlock(lock_handle->bdb_lock);
+            if (lock_handle->bdb_lock_nslots == 0)
+                Pthread_rwlock_rdlock(lock_handle->bdb_lock);
+            else
+                lk->rdslot = wait_reader_slot(lock_handle);
         } else if (rc != 0) {
             logmsg(LOGMSG_FATAL, "%s/%s(%s): pthread_rwlock_tryrdlock error %d %s\n", idstr,
                    funcname, __func__, rc, strerror(rc));
@@ -590,9 +741,15 @@ void bdb_rellock(bdb_state_type *bdb_state, const char *funcname, int line)
         if (lk->locktype == WRITELOCK) {
             lock_handle->bdb_lock_write_holder_ptr = NULL;
             lock_handle->bdb_lock_write_holder = 0;
+            if (lock_handle->bdb_lock_nslots)
+                open_reader_slots(lock_handle);
         }
 
-        Pthread_rwlock_unlock(lock_handle->bdb_lock);
+        if (lk->rdslot >= 0)
+            put_reader_slot(lock_handle, lk->rdslot);
+        else
+            Pthread_rwlock_unlock(lock_handle->bdb_lock);
+        lk->rdslot = -1;
 
         if (gbl_bdblock_debug)
             rel_lock_log(bdb_state);
@@ -745,6 +902,7 @@ static void new_thread_lock_info(bdb_state_type *bdb_state)
 
     lk->threadid = pthread_self();
     lk->callers = 1;
+    lk->rdslot = -1;
 
     if (bdb_state->attr && bdb_state->attr->debug_bdb_lock_stack) {
         lk->stack = (void **)malloc(sizeof(void *) * BDB_DEBUG_STACK);
@@ -918,3 +1076,166 @@ void bdb_init_lock_key(void)
 {
     Pthread_key_create(&lock_key, bdb_lock_destructor);
 }
+
+/* bdblockstress: threads take the bdb lock every way it can be taken while
+ * counting who is inside, and flag any reader that sees a writer or any
+ * writer that sees anyone else.  It runs in the background, since the thread
+ * that asks for it may itself hold the read lock. */
+struct bdb_lock_stress {
+    bdb_state_type *bdb_state;
+    int nthreads;
+    int nsecs;
+    int running;
+    int stop;
+    int readers;
+    int writers;
+    int64_t reads;
+    int64_t trybusy;
+    int64_t writes;
+    int64_t upgrades;
+    int64_t violations;
+};
+
+static pthread_mutex_t lock_stress_lk = PTHREAD_MUTEX_INITIALIZER;
+static struct bdb_lock_stress lock_stress;
+
+static void lock_stress_pause(unsigned int *seed)
+{
+    int us = rand_r(seed) % 50;
+    if (us > 25)
+        usleep(us);
+}
+
+static void lock_stress_read(struct bdb_lock_stress *st, unsigned int *seed)
+{
+    ATOMIC_ADD32(st->readers, 1);
+    if (ATOMIC_LOAD32(st->writers) != 0)
+        ATOMIC_ADD64(st->violations, 1);
+    lock_stress_pause(seed);
+    ATOMIC_ADD32(st->readers, -1);
+    ATOMIC_ADD64(st->reads, 1);
+}
+
+static void lock_stress_write(struct bdb_lock_stress *st, unsigned int *seed)
+{
+    if (ATOMIC_ADD32(st->writers, 1) != 1 || ATOMIC_LOAD32(st->readers) != 0)
+        ATOMIC_ADD64(st->violations, 1);
+    lock_stress_pause(seed);
+    ATOMIC_ADD32(st->writers, -1);
+    ATOMIC_ADD64(st->writes, 1);
+}
+
+static void *lock_stress_thd(void *arg)
+{
+    struct bdb_lock_stress *st = arg;
+    bdb_state_type *bdb_state = st->bdb_state;
+    unsigned int seed = (unsigned int)(uintptr_t)pthread_self();
+
+    bdb_thread_event(bdb_state, BDBTHR_EVENT_START);
+    while (!ATOMIC_LOAD32(st->stop)) {
+        switch (rand_r(&seed) % 10) {
+        case 7: /* writer */
+            BDB_WRITELOCK("lock stress write");
+            lock_stress_write(st, &seed);
+            BDB_RELLOCK();
+            break;
+        case 8: /* writer that aborts logical waiters on a replicant */
+            BDB_WRITELOCK_REP("lock stress write rep");
+            lock_stress_write(st, &seed);
+            BDB_RELLOCK();
+            break;
+        case 9: /* reader upgraded to a writer and back */
+            BDB_READLOCK("lock stress upgrade");
+            lock_stress_read(st, &seed);
+            BDB_WRITELOCK("lock stress upgrade");
+            lock_stress_write(st, &seed);
+            BDB_RELLOCK();
+            lock_stress_read(st, &seed);
+            BDB_RELLOCK();
+            ATOMIC_ADD64(st->upgrades, 1);
+            break;
+        case 6: /* trylock, which fails while a writer is in */
+            if (BDB_TRYREADLOCK("lock stress tryread") != 0) {
+                ATOMIC_ADD64(st->trybusy, 1);
+                break;
+            }
+            lock_stress_read(st, &seed);
+            BDB_RELLOCK();
+            break;
+        default:
+            BDB_READLOCK("lock stress read");
+            lock_stress_read(st, &seed);
+            BDB_RELLOCK();
+            break;
+        }
+    }
+    bdb_thread_event(bdb_state, BDBTHR_EVENT_DONE);
+    return NULL;
+}
+
+static void *lock_stress_main(void *arg)
+{
+    struct bdb_lock_stress *st = arg;
+    pthread_t *tids = calloc(st->nthreads, sizeof(pthread_t));
+    int n = 0;
+
+    for (; tids && n < st->nthreads; n++) {
+        if (pthread_create(&tids[n], NULL, lock_stress_thd, st) != 0)
+            break;
+    }
+    sleep(st->nsecs);
+    XCHANGE32(st->stop, 1);
+    for (int i = 0; i < n; i++)
+        Pthread_join(tids[i], NULL);
+    free(tids);
+
+    logmsg(LOGMSG_USER,
+           "bdblockstress: %d threads, %d reader slots, reads %" PRId64 " trylock busy %" PRId64 " writes %" PRId64
+           " upgrades %" PRId64 " violations %" PRId64 "\n",
+           n, st->bdb_state->bdb_lock_nslots, st->reads, st->trybusy, st->writes, st->upgrades, st->violations);
+    Pthread_mutex_lock(&lock_stress_lk);
+    st->running = 0;
+    Pthread_mutex_unlock(&lock_stress_lk);
+    return NULL;
+}
+
+void bdb_lock_stress(bdb_state_type *bdb_state, FILE *out, int nthreads, int nsecs)
+{
+    struct bdb_lock_stress *st = &lock_stress;
+    pthread_attr_t attr;
+    pthread_t tid;
+
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    Pthread_mutex_lock(&lock_stress_lk);
+    if (st->running || nthreads <= 0 || nsecs <= 0) {
+        if (st->running)
+            logmsgf(LOGMSG_USER, out, "bdblockstress: running\n");
+        else if (st->bdb_state)
+            logmsgf(LOGMSG_USER, out,
+                    "bdblockstress: done, %d reader slots, reads %" PRId64 " trylock busy %" PRId64
+                    " writes %" PRId64 " upgrades %" PRId64 " violations %" PRId64 "\n",
+                    st->bdb_state->bdb_lock_nslots, st->reads, st->trybusy, st->writes, st->upgrades,
+                    st->violations);
+        else
+            logmsgf(LOGMSG_USER, out, "bdblockstress: not run\n");
+        Pthread_mutex_unlock(&lock_stress_lk);
+        return;
+    }
+    memset(st, 0, sizeof(*st));
+    st->bdb_state = bdb_state;
+    st->nthreads = nthreads;
+    st->nsecs = nsecs;
+    st->running = 1;
+    Pthread_attr_init(&attr);
+    Pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&tid, &attr, lock_stress_main, st) != 0) {
+        st->running = 0;
+        logmsgf(LOGMSG_ERROR, out, "bdblockstress: can't create thread\n");
+    } else {
+        logmsgf(LOGMSG_USER, out, "bdblockstress: started %d threads for %d seconds\n", nthreads, nsecs);
+    }
+    Pthread_attr_destroy(&attr);
+    Pthread_mutex_unlock(&lock_stress_lk);
+}
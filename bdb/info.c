@@ -568,6 +568,8 @@ static void cache_stats(FILE *out, bdb_state_type *bdb_state, int extra)
     prn_lstat(st_ro_levict);
     prn_lstat(st_rw_levict);
     prn_lstat(st_pf_evict);
+    prn_lstat(st_probation_evict);
+    prn_lstat(st_probation_promote);
     prn_lstat(st_rw_evict_skip);
     prn_lstat(st_page_trickle);
     prn_lstat(st_pages);
@@ -1340,6 +1342,7 @@ void bdb_process_user_command(bdb_state_type *bdb_state, char *line, int lline,
         " f <name> ..    - redirect answer to command .. to file <name>",
         " memdump        - dump region memory usage",
         "*bdblockdump    - dump bdb lock thread info structures",
+        " bdblockstress # # - stress the bdb lock with # threads for # seconds",
         " llmeta         - dump llmeta information",
         " freepages      - dump free page counts",
         " lccache        - lsn collection cache commands",
@@ -1819,6 +1822,16 @@ void bdb_process_user_command(bdb_state_type *bdb_state, char *line, int lline,
         __dbenv_heap_dump(bdb_state->dbenv);
     } else if (tokcmp(tok, ltok, "bdblockdump") == 0) {
         bdb_locks_dump(bdb_state, out);
+    } else if (tokcmp(tok, ltok, "bdblockstress") == 0) {
+        int nthreads = 0, nsecs = 0;
+        tok = segtok(line, lline, &st, &ltok);
+        if (ltok > 0) {
+            nthreads = toknum(tok, ltok);
+            tok = segtok(line, lline, &st, &ltok);
+            if (ltok > 0)
+                nsecs = toknum(tok, ltok);
+        }
+        bdb_lock_stress(bdb_state, out, nthreads, nsecs);
     } else if (tokcmp(tok, ltok, "bdblocktest") == 0) {
        logmsg(LOGMSG_USER, "doing lock tests\n");
         BDB_READLOCK("lock test 0");
@@ -2204,7 +2217,13 @@ repl_wait_and_net_use_t *bdb_get_repl_wait_and_net_stats(
                                         &pos->bytes_read,
                                         &pos->throttle_waits,
                                         &pos->reorders);
-                                            
+        if (rc == 0)
+            rc = net_get_host_compress_usage(p_netinfo, host,
+                                             &pos->compress_raw_bytes,
+                                             &pos->compress_bytes,
+                                             &pos->compress_usec,
+                                             &pos->decompress_usec);
+
         struct hostinfo *h = retrieve_hostinfo(nodes[i].host_interned);
         Pthread_mutex_lock(&(bdb_state->seqnum_info->lock));
 
@@ -2220,6 +2239,12 @@ repl_wait_and_net_use_t *bdb_get_repl_wait_and_net_stats(
             pos->max_wait_over_1min = 0;
             pos->lsn_text[0] = '\0';
             pos->lsn_bytes_behind = 0;
+            pos->compress_raw_bytes = 0;
+            pos->compress_bytes = 0;
+            pos->compress_usec = 0;
+            pos->decompress_usec = 0;
+            pos->acks = 0;
+            pos->waiters_released = 0;
         } else {
             pos->avg_wait_over_10secs = averager_avg(h->time_10seconds);
             pos->max_wait_over_10secs = averager_max(h->time_10seconds);
@@ -2229,6 +2254,8 @@ repl_wait_and_net_use_t *bdb_get_repl_wait_and_net_stats(
             lsnp = &h->seqnum.lsn;
             lsn_to_str(pos->lsn_text, lsnp);
             pos->lsn_bytes_behind = subtract_lsn(bdb_state, master_lsnp, lsnp);
+            pos->acks = h->acks;
+            pos->waiters_released = h->waiters_released;
         }
 
         Pthread_mutex_unlock(&(bdb_state->seqnum_info->lock));
@@ -29,6 +29,10 @@ void bdb_lock_init(bdb_state_type *bdb_state);
 void bdb_locks_dump(bdb_state_type *bdb_state, FILE *out);
 void bdb_dump_my_lock_state(FILE *out);
 
+/* Start nthreads threads taking the bdb lock for nsecs seconds, or report on
+ * the last run if either is 0 */
+void bdb_lock_stress(bdb_state_type *bdb_state, FILE *out, int nthreads, int nsecs);
+
 #define FILEID_LEN 20
 #define MINMAXFLUFF_LEN 10
 #define KEYFLUFF_LEN 12
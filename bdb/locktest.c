@@ -51,6 +51,8 @@ static pthread_attr_t locktest_attr;
 static DB_ENV *dbenv = NULL;
 extern uint64_t detect_skip;
 extern uint64_t detect_run;
+extern uint64_t dd_incremental_checks;
+extern uint64_t dd_incremental_fallbacks;
 static uint64_t counter;
 static uint64_t deadlock;
 
@@ -372,6 +374,7 @@ static void test_lock_per_sec(db_lockmode_t mode)
 static void reset_counters()
 {
     deadlock = detect_skip = detect_run = counter = 0;
+    dd_incremental_checks = dd_incremental_fallbacks = 0;
     for (int i = 0; i < THDS; ++i) {
         diffs[i] = 0;
     }
@@ -387,6 +390,10 @@ static void print_counters()
            "detect_skip:%" PRIu64 " detect_run:%" PRIu64 " counter:%" PRIu64
            " deadlock:%" PRIu64 " time:%.2fms\n",
            detect_skip, detect_run, counter, deadlock, (double)diff / THDS);
+    if (dd_incremental_checks)
+        logmsg(LOGMSG_USER,
+               "incremental dd checks:%" PRIu64 " fallbacks:%" PRIu64 "\n",
+               dd_incremental_checks, dd_incremental_fallbacks);
 }
 
 static void test_n_locks_rd(void)
@@ -586,6 +593,59 @@ static void *ring_tester(void *arg_)
     return (void *)0;
 }
 
+/*
+ * Two readers (ids 0 and 1) and a queued writer (id 2): reader 0 upgrades
+ * behind the writer, and then reader 1 lets go.  Reader 0 and the writer
+ * now wait on each other, though the release promoted nobody.
+ */
+static void *upgrade_tester(void *arg_)
+{
+    tester_arg *arg = arg_;
+    u_int32_t locker_id;
+    DB_LOCK lock1;
+    DB_LOCK lock2;
+    int obj = 1000;
+
+    if (lock_id(&locker_id))
+        return (void *)199;
+
+    if (arg->id == 1) {
+        if (lock_get(locker_id, obj, DB_LOCK_READ, &lock1))
+            return (void *)299;
+        sleep(3);
+        assert(lock_put(&lock1) == 0);
+        assert(lock_id_free(locker_id) == 0);
+        return (void *)0;
+    }
+
+    if (arg->id == 0) {
+        if (lock_get(locker_id, obj, DB_LOCK_READ, &lock1))
+            return (void *)299;
+        sleep(2);
+    } else {
+        sleep(1);
+    }
+
+    switch (lock_get(locker_id, obj, DB_LOCK_WRITE, &lock2)) {
+    case 0:
+        ++counter;
+        break;
+    case DB_LOCK_DEADLOCK:
+        ++deadlock;
+        if (arg->id == 0)
+            assert(lock_put(&lock1) == 0);
+        assert(lock_id_free(locker_id) == 0);
+        return (void *)1;
+    default:
+        return (void *)399;
+    }
+    if (arg->id == 0)
+        assert(lock_put(&lock1) == 0);
+    assert(lock_put(&lock2) == 0);
+    assert(lock_id_free(locker_id) == 0);
+    return (void *)0;
+}
+
 static ssize_t tester(const char *name, size_t num, tester_routine *routine)
 {
     tester_arg arg[num];
@@ -626,6 +686,8 @@ static void berkdb_tester(void)
         rc = tester("ring", num[i], ring_tester);
         assert(rc == 1 || gbl_all_waitdie); // just one should ddlk
     }
+    rc = tester("upgrade", 3, upgrade_tester);
+    assert(rc == 1 || gbl_all_waitdie); // the upgrader or the writer
     return;
 }
 
@@ -590,7 +590,7 @@ int bdb_queue_add_recno(bdb_state_type *bdb_state, tran_type *tran, uint32_t rec
 
     BDB_READLOCK("bdb_queue_add");
     if (bdb_state->bdbtype == BDBTYPE_QUEUEDB) {
-        rc = bdb_queuedb_add(bdb_state, tran, dta, dtalen, bdberr, out_genid);
+        rc = bdb_queuedb_add(bdb_state, tran, dta, dtalen, 0, bdberr, out_genid);
     } else {
         bdb_lock_table_read(bdb_state, tran);
         rc = bdb_queue_add_int(bdb_state, tran, recno, dta, dtalen, bdberr, out_genid);
@@ -608,7 +608,7 @@ int bdb_queue_add(bdb_state_type *bdb_state, tran_type *tran, const void *dta,
 
     BDB_READLOCK("bdb_queue_add");
     if (bdb_state->bdbtype == BDBTYPE_QUEUEDB) {
-        rc = bdb_queuedb_add(bdb_state, tran, dta, dtalen, bdberr, out_genid);
+        rc = bdb_queuedb_add(bdb_state, tran, dta, dtalen, 0, bdberr, out_genid);
     } else {
         bdb_lock_table_read(bdb_state, tran);
         rc = bdb_queue_add_int(bdb_state, tran, 0, dta, dtalen, bdberr, out_genid);
@@ -618,6 +618,24 @@ int bdb_queue_add(bdb_state_type *bdb_state, tran_type *tran, const void *dta,
     return rc;
 }
 
+/* add an item to the end of one partition of a partitioned queuedb. */
+int bdb_queue_add_partition(bdb_state_type *bdb_state, tran_type *tran,
+                            const void *dta, size_t dtalen, int partition,
+                            int *bdberr, unsigned long long *out_genid)
+{
+    int rc = 0;
+
+    if (bdb_state->bdbtype != BDBTYPE_QUEUEDB)
+        return bdb_queue_add(bdb_state, tran, dta, dtalen, bdberr, out_genid);
+
+    BDB_READLOCK("bdb_queue_add_partition");
+    rc = bdb_queuedb_add(bdb_state, tran, dta, dtalen, partition, bdberr,
+                         out_genid);
+    BDB_RELLOCK();
+
+    return rc;
+}
+
 static int bdb_queue_add_goose_int(bdb_state_type *bdb_state, tran_type *tran,
                                    int *bdberr)
 {
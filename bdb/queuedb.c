@@ -65,8 +65,58 @@ struct queuedb_key {
 
 enum { QUEUEDB_KEY_LEN = 4 + 8 };
 
+/* Partitioned queues keep all partitions in the same btree.  The partition
+ * number lives in the upper bits of the key's consumer field, so each
+ * partition is a contiguous key range with its own right-most leaf and its own
+ * ordering.  Partition 0 encodes exactly like an unpartitioned queue. */
+#define QUEUEDB_PARTITION_SHIFT 16
+#define QUEUEDB_PARTITION(c) ((c) >> QUEUEDB_PARTITION_SHIFT)
+
 int gbl_debug_queuedb = 0;
 
+int bdb_queuedb_partition_consumer(int consumer, int partition)
+{
+    return (partition << QUEUEDB_PARTITION_SHIFT) | consumer;
+}
+
+void bdb_queuedb_set_partitions(bdb_state_type *bdb_state, int npartitions)
+{
+    if (npartitions < 1)
+        npartitions = 1;
+    if (npartitions > BDB_QUEUEDB_MAX_PARTITIONS)
+        npartitions = BDB_QUEUEDB_MAX_PARTITIONS;
+    bdb_state->qdb_npartitions = npartitions;
+}
+
+/* Adds read the partition count under the queue's table read lock, so
+ * change it under the table write lock: no add is mid-way through with the
+ * old count. */
+int bdb_queuedb_set_partitions_tran(bdb_state_type *bdb_state,
+                                    tran_type *tran, int npartitions,
+                                    int *bdberr)
+{
+    int rc = bdb_lock_table_write(bdb_state, tran);
+    if (rc == DB_LOCK_DEADLOCK) {
+        *bdberr = BDBERR_DEADLOCK;
+        return -1;
+    } else if (rc != 0) {
+        logmsg(LOGMSG_ERROR, "%s: queuedb %s error getting tablelock %d\n",
+               __func__, bdb_state->name, rc);
+        *bdberr = BDBERR_MISC;
+        return -1;
+    }
+    bdb_queuedb_set_partitions(bdb_state, npartitions);
+    *bdberr = BDBERR_NOERROR;
+    return 0;
+}
+
+int bdb_queuedb_get_partitions(bdb_state_type *bdb_state)
+{
+    if (bdb_state == NULL || bdb_state->qdb_npartitions < 1)
+        return 1;
+    return bdb_state->qdb_npartitions;
+}
+
 static uint8_t *queuedb_key_get(struct queuedb_key *p_queuedb_key,
                                 uint8_t *p_buf, uint8_t *p_buf_end)
 {
@@ -92,6 +142,53 @@ static uint8_t *queuedb_key_put(struct queuedb_key *p_queuedb_key,
     return p_buf;
 }
 
+/* Position dbcp on the first (DB_SET_RANGE) or last record of a partition.
+ * Returns DB_NOTFOUND if the partition is empty.  On success dbt_key holds the
+ * found key and dbt_data is filled according to its flags. */
+static int queuedb_partition_cget(bdb_state_type *bdb_state, DBC *dbcp,
+                                  int partition, int last, DBT *dbt_key,
+                                  DBT *dbt_data, uint8_t *ver, u_int32_t rmw)
+{
+    struct queuedb_key k = {0};
+    uint8_t *key = dbt_key->data;
+    int rc;
+
+    k.consumer = bdb_queuedb_partition_consumer(0, partition + (last ? 1 : 0));
+    if (queuedb_key_put(&k, key, key + QUEUEDB_KEY_LEN) == NULL)
+        return EINVAL;
+    dbt_key->size = QUEUEDB_KEY_LEN;
+
+    rc = bdb_cget_unpack(bdb_state, dbcp, dbt_key, dbt_data, ver,
+                         DB_SET_RANGE | rmw);
+    if (last) {
+        /* step back from the start of the next partition, or from eof */
+        if (rc == 0) {
+            if (dbt_data->flags & DB_DBT_MALLOC) {
+                free(dbt_data->data);
+                dbt_data->data = NULL;
+            }
+            rc = bdb_cget_unpack(bdb_state, dbcp, dbt_key, dbt_data, ver,
+                                 DB_PREV | rmw);
+        } else if (rc == DB_NOTFOUND) {
+            rc = bdb_cget_unpack(bdb_state, dbcp, dbt_key, dbt_data, ver,
+                                 DB_LAST | rmw);
+        }
+    }
+    if (rc)
+        return rc;
+
+    if (queuedb_key_get(&k, dbt_key->data,
+                        (uint8_t *)dbt_key->data + dbt_key->size) == NULL ||
+        QUEUEDB_PARTITION(k.consumer) != partition) {
+        if (dbt_data->flags & DB_DBT_MALLOC) {
+            free(dbt_data->data);
+            dbt_data->data = NULL;
+        }
+        return DB_NOTFOUND;
+    }
+    return 0;
+}
+
 static int bdb_queuedb_is_db_empty(DB *db, tran_type *tran)
 {
     int rc;
@@ -318,11 +415,13 @@ int bdb_queuedb_best_pagesize(int avg_item_sz)
     return calc_pagesize(4096, avg_item_sz);
 }
 
-/* add to queue */
+/* add to queue; partition is ignored unless the queue is partitioned */
 int bdb_queuedb_add(bdb_state_type *bdb_state, tran_type *tran, const void *dta,
-                    size_t dtalen, int *bdberr, unsigned long long *out_genid)
+                    size_t dtalen, int partition, int *bdberr,
+                    unsigned long long *out_genid)
 {
     struct bdb_queue_priv *qstate = (struct bdb_queue_priv *)bdb_state->qpriv;
+    int npartitions;
 
     /* TODO: rather than grabbing inline, minimize the time we hold this lock by
      * deferring queue-writes until after everything else in toblock is done.
@@ -341,6 +440,17 @@ int bdb_queuedb_add(bdb_state_type *bdb_state, tran_type *tran, const void *dta,
         return -1;
     }
 
+    /* Stable while we hold the table lock */
+    npartitions = bdb_queuedb_get_partitions(bdb_state);
+    if (npartitions == 1) {
+        partition = 0;
+    } else if (partition < 0 || partition >= npartitions) {
+        logmsg(LOGMSG_ERROR, "%s: queuedb %s bad partition %d of %d\n",
+               __func__, bdb_state->name, partition, npartitions);
+        *bdberr = BDBERR_BADARGS;
+        return -1;
+    }
+
     struct queuedb_key k;
     unsigned long long genid;
     uint8_t ver = 0;
@@ -383,9 +493,13 @@ int bdb_queuedb_add(bdb_state_type *bdb_state, tran_type *tran, const void *dta,
     dbt_data.data = NULL;
     dbt_data.flags = DB_DBT_MALLOC;
 
-    /* Lock last page */
-    rc = bdb_cget_unpack(bdb_state, dbcp1, &dbt_key, &dbt_data, &ver,
-                         DB_LAST | DB_RMW);
+    /* Lock last page (of this partition) */
+    if (npartitions > 1)
+        rc = queuedb_partition_cget(bdb_state, dbcp1, partition, 1, &dbt_key,
+                                    &dbt_data, &ver, DB_RMW);
+    else
+        rc = bdb_cget_unpack(bdb_state, dbcp1, &dbt_key, &dbt_data, &ver,
+                             DB_LAST | DB_RMW);
 
     if (rc == 0) {
         freeme1 = dbt_data.data;
@@ -444,8 +558,12 @@ int bdb_queuedb_add(bdb_state_type *bdb_state, tran_type *tran, const void *dta,
             dbt_data.data = NULL;
             dbt_data.flags = DB_DBT_MALLOC;
 
-            rc2 = bdb_cget_unpack(bdb_state, dbcp2, &dbt_key, &dbt_data, &ver,
-                                  DB_LAST);
+            if (npartitions > 1)
+                rc2 = queuedb_partition_cget(bdb_state, dbcp2, partition, 1,
+                                             &dbt_key, &dbt_data, &ver, 0);
+            else
+                rc2 = bdb_cget_unpack(bdb_state, dbcp2, &dbt_key, &dbt_data,
+                                      &ver, DB_LAST);
 
             if (rc2 == 0) {
                 freeme2 = dbt_data.data;
@@ -471,10 +589,10 @@ int bdb_queuedb_add(bdb_state_type *bdb_state, tran_type *tran, const void *dta,
                 *bdberr = BDBERR_MISC;
                 rc = -1;
                 goto done;
-            } else if (bdb_state->persistent_seq) {
+            } else if (bdb_state->persistent_seq && npartitions == 1) {
                 get_queue_sequence_tran(bdb_state->name, &prev_seq.seq, tran);
             }
-        } else if (bdb_state->persistent_seq) {
+        } else if (bdb_state->persistent_seq && npartitions == 1) {
             get_queue_sequence_tran(bdb_state->name, &prev_seq.seq, tran);
         }
         qfnd_odh.seq = (prev_seq.seq + 1);
@@ -523,7 +641,7 @@ int bdb_queuedb_add(bdb_state_type *bdb_state, tran_type *tran, const void *dta,
             uint8_t *p_buf, *p_buf_end;
             p_buf = key;
             p_buf_end = key + sizeof(key);
-            k.consumer = i;
+            k.consumer = bdb_queuedb_partition_consumer(i, partition);
             k.genid = genid;
             p_buf = queuedb_key_put(&k, p_buf, p_buf_end);
             if (p_buf == NULL) {
@@ -614,6 +732,124 @@ done:
     return rc;
 }
 
+/* Read the seq/epoch of the first or last record of a partition, looking in
+ * the preferred file first and the other one (if any) second. */
+static int queuedb_partition_seq(bdb_state_type *bdb_state, DBC *dbcp_pref,
+                                 DBC *dbcp_other, int partition, int last,
+                                 struct bdb_queue_found_seq *qfnd_odh,
+                                 size_t *item_length)
+{
+    uint8_t key[QUEUEDB_KEY_LEN];
+    DBT dbt_key = {0}, dbt_data = {0};
+    uint8_t ver = 0;
+    uint8_t *p_buf;
+    int rc;
+
+    dbt_key.data = key;
+    dbt_key.ulen = QUEUEDB_KEY_LEN;
+    dbt_key.flags = DB_DBT_USERMEM;
+    dbt_data.flags = DB_DBT_MALLOC;
+
+    rc = queuedb_partition_cget(bdb_state, dbcp_pref, partition, last,
+                                &dbt_key, &dbt_data, &ver, 0);
+    if (rc == DB_NOTFOUND && dbcp_other != dbcp_pref)
+        rc = queuedb_partition_cget(bdb_state, dbcp_other, partition, last,
+                                    &dbt_key, &dbt_data, &ver, 0);
+    if (rc)
+        return rc;
+
+    p_buf = dbt_data.data;
+    p_buf = (uint8_t *)queue_found_seq_get(qfnd_odh, p_buf,
+                                           p_buf + dbt_data.size);
+    if (item_length)
+        *item_length = dbt_data.size;
+    free(dbt_data.data);
+    return p_buf ? 0 : EINVAL;
+}
+
+/* Depth of a partitioned queue is the sum of each partition's depth; the
+ * reported epoch and item length are those of the oldest head item. */
+static int queuedb_partitioned_stats(bdb_state_type *bdb_state,
+                                     bdb_queue_stats_callback_t callback,
+                                     tran_type *tran, void *userptr,
+                                     int *bdberr)
+{
+    DBC *dbcp1 = NULL;
+    DBC *dbcp2 = NULL;
+    struct bdb_queue_found_seq first, last;
+    size_t item_length = 0, len;
+    unsigned int epoch = 0, depth = 0;
+    int npartitions = bdb_queuedb_get_partitions(bdb_state);
+    int rc;
+
+    DB *db1 = BDB_QUEUEDB_GET_DBP_ZERO(bdb_state);
+    rc = db1->cursor(db1, tran ? tran->tid : NULL, &dbcp1, 0);
+    if (rc != 0) {
+        *bdberr = BDBERR_MISC;
+        goto done;
+    }
+    DB *db2 = BDB_QUEUEDB_GET_DBP_ONE(bdb_state);
+    if (db2 != NULL) {
+        rc = db2->cursor(db2, tran ? tran->tid : NULL, &dbcp2, 0);
+        if (rc != 0) {
+            *bdberr = BDBERR_MISC;
+            goto done;
+        }
+    } else {
+        dbcp2 = dbcp1;
+    }
+
+    for (int i = 0; i < npartitions; i++) {
+        rc = queuedb_partition_seq(bdb_state, dbcp1, dbcp2, i, 0, &first,
+                                   &len);
+        if (rc == 0)
+            rc = queuedb_partition_seq(bdb_state, dbcp2, dbcp1, i, 1, &last,
+                                       NULL);
+        if (rc == DB_NOTFOUND) {
+            continue;
+        } else if (rc == DB_LOCK_DEADLOCK) {
+            *bdberr = BDBERR_DEADLOCK;
+            rc = -1;
+            goto done;
+        } else if (rc) {
+            logmsg(LOGMSG_ERROR, "%s partition %d berk rc %d\n", __func__, i,
+                   rc);
+            *bdberr = BDBERR_MISC;
+            rc = -1;
+            goto done;
+        }
+        if (last.seq < first.seq)
+            continue;
+        depth += (last.seq - first.seq) + 1;
+        if (epoch == 0 || first.epoch < epoch) {
+            epoch = first.epoch;
+            item_length = len;
+        }
+    }
+    rc = 0;
+    if (depth)
+        callback(0, item_length, epoch, depth, userptr);
+
+done:
+    if (dbcp2 && (dbcp2 != dbcp1)) {
+        int crc = dbcp2->c_close(dbcp2);
+        if (crc) {
+            logmsg(LOGMSG_ERROR, "%s: c_close berk rc %d\n", __func__, crc);
+            *bdberr = (crc == DB_LOCK_DEADLOCK) ? BDBERR_DEADLOCK : BDBERR_MISC;
+            rc = -1;
+        }
+    }
+    if (dbcp1) {
+        int crc = dbcp1->c_close(dbcp1);
+        if (crc) {
+            logmsg(LOGMSG_ERROR, "%s: c_close berk rc %d\n", __func__, crc);
+            *bdberr = (crc == DB_LOCK_DEADLOCK) ? BDBERR_DEADLOCK : BDBERR_MISC;
+            rc = -1;
+        }
+    }
+    return rc;
+}
+
 int bdb_queuedb_stats(bdb_state_type *bdb_state,
                       bdb_queue_stats_callback_t callback, tran_type *tran,
                       void *userptr, int *bdberr)
@@ -643,6 +879,10 @@ int bdb_queuedb_stats(bdb_state_type *bdb_state,
     if (gbl_debug_queuedb)
         logmsg(LOGMSG_USER, ">>> bdb_queuedb_stats %s\n", bdb_state->name);
 
+    if (bdb_queuedb_get_partitions(bdb_state) > 1)
+        return queuedb_partitioned_stats(bdb_state, callback, tran, userptr,
+                                         bdberr);
+
     dbt_key.flags = dbt_data.flags = DB_DBT_REALLOC;
 
     DB *db1 = BDB_QUEUEDB_GET_DBP_ZERO(bdb_state);
@@ -1376,7 +1616,7 @@ static int bdb_queuedb_consume_int(bdb_state_type *bdb_state, DB *db,
     bdb_state->qdb_cons++;
 
 done:
-    if (put_seq && bdb_state->persistent_seq && val.data)
+    if (bdb_state->persistent_seq && val.data)
         free(val.data);
     if (dbcp) {
         int crc;
@@ -1411,21 +1651,35 @@ int bdb_queuedb_consume(bdb_state_type *bdb_state, tran_type *tran,
         return -1;
     }
 
+    int npartitions = bdb_queuedb_get_partitions(bdb_state);
     DB *db1 = BDB_QUEUEDB_GET_DBP_ZERO(bdb_state);
     DB *db2 = BDB_QUEUEDB_GET_DBP_ONE(bdb_state);
-    int put_seq = (db2 != NULL) ? bdb_queuedb_is_db_empty(db2, tran) : 1;
-
-    *bdberr = 0;
-
-    rc = bdb_queuedb_consume_int(bdb_state, db1, tran, consumer,
-                                 fnd, put_seq, bdberr);
-    if ((rc == -1) && (*bdberr == BDBERR_DELNOTFOUND)) { /* EMPTY FILE #0? */
-        if (db2 != NULL) {
-            *bdberr = 0;
-
-            rc = bdb_queuedb_consume_int(bdb_state, db2, tran, consumer,
-                                         fnd, 1, bdberr);
+    /* the persistent sequence is per-queue; partitions have their own */
+    int put_seq = (npartitions > 1) ? 0
+                  : (db2 != NULL) ? bdb_queuedb_is_db_empty(db2, tran) : 1;
+    int partition = QUEUEDB_PARTITION(consumer);
+    int basecons = consumer & ((1 << QUEUEDB_PARTITION_SHIFT) - 1);
+
+    for (int i = 0; i < npartitions; i++) {
+        /* Try the partition we were told first.  Consumes that arrive via
+         * osql only know the genid, so probe the remaining partitions. */
+        if (i > 0) {
+            consumer = bdb_queuedb_partition_consumer(
+                basecons, (partition + i) % npartitions);
+        }
+        *bdberr = 0;
+        rc = bdb_queuedb_consume_int(bdb_state, db1, tran, consumer, fnd,
+                                     put_seq, bdberr);
+        if ((rc == -1) && (*bdberr == BDBERR_DELNOTFOUND)) { /* EMPTY FILE #0? */
+            if (db2 != NULL) {
+                *bdberr = 0;
+
+                rc = bdb_queuedb_consume_int(bdb_state, db2, tran, consumer,
+                                             fnd, npartitions == 1, bdberr);
+            }
         }
+        if (rc != -1 || *bdberr != BDBERR_DELNOTFOUND)
+            break;
     }
     return rc;
 }
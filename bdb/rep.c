@@ -36,6 +36,8 @@
 #include "util.h"
 #include "crc32c.h"
 #include "gettimeofday_ms.h"
+#include "histogram.h"
+#include "thread_stats.h"
 
 #include <build/db_int.h>
 #include "dbinc/log.h"
@@ -412,6 +414,7 @@ static struct hostinfo *retrieve_hostinfo_int(struct interned_string *s, int cre
             static int appseqnum = 1;
             struct hostinfo *h = s->ptr = calloc(sizeof(struct hostinfo), 1);
             listc_init(&h->waitlist, offsetof(struct waiting_for_lsn, lnk));
+            listc_init(&h->waiters, offsetof(struct seqnum_waiter, lnk));
             h->time_10seconds = averager_new(10000, 100000);
             h->time_minute = averager_new(60000, 100000);
             h->appseqnum = appseqnum++;
@@ -781,6 +784,7 @@ int berkdb_send_rtn(DB_ENV *dbenv, const DBT *control, const DBT *rec,
     int *seqnum;
     int nodelay;
     int useheap = 0;
+    int shared = 0;
     int is_logput = 0;
     tran_type *tran = NULL;
 
@@ -847,10 +851,18 @@ int berkdb_send_rtn(DB_ENV *dbenv, const DBT *control, const DBT *rec,
             sizeof(int) +   /* controlcrc */
             control->size;  /* controlbuf */
 
-    if (bufsz > 1024 * 65)
-        useheap = 1;
-
-    char *buf = useheap ? malloc(bufsz) : alloca(bufsz);
+    /* A large broadcast is serialized straight into a buffer which every
+     * peer queues by reference */
+    char *buf = NULL;
+    if (host == db_eid_broadcast && bufsz > NET_SHARED_MSG_MIN_BYTES)
+        buf = net_shared_msg_new(USER_TYPE_BERKDB_REP, bufsz);
+    if (buf) {
+        shared = 1;
+    } else {
+        if (bufsz > 1024 * 65)
+            useheap = 1;
+        buf = useheap ? malloc(bufsz) : alloca(bufsz);
+    }
 
     bytecount += bufsz;
 
@@ -979,7 +991,8 @@ int berkdb_send_rtn(DB_ENV *dbenv, const DBT *control, const DBT *rec,
                     ((flags & DB_REP_NODROP) ? NET_SEND_NODROP : 0) |
                     (bdb_state->attr->net_inorder_logputs ? NET_SEND_INORDER : 0) |
                     (nodelay ? NET_SEND_NODELAY : 0) |
-                    (flags & DB_REP_TRACE ? NET_SEND_TRACE : 0);
+                    (flags & DB_REP_TRACE ? NET_SEND_TRACE : 0) |
+                    (shared ? NET_SEND_SHARED : 0);
         ++num;
         rc = net_send_all(bdb_state->repinfo->netinfo, num, data, sz, type, flag);
     } else {
@@ -1030,7 +1043,9 @@ int berkdb_send_rtn(DB_ENV *dbenv, const DBT *control, const DBT *rec,
         outrc = 1;
     }
 
-    if (useheap)
+    if (shared)
+        net_shared_msg_put(buf);
+    else if (useheap)
         free(buf);
 
     return outrc;
@@ -2334,6 +2349,53 @@ static inline int should_copy_seqnum(bdb_state_type *bdb_state, seqnum_type *seq
     return 1;
 }
 
+/* Commit waiters queue on the node they wait for, in lsn order, and sleep
+ * on a condition of their own.  An ack from a node releases every waiter it
+ * covers in one pass instead of broadcasting to all committing threads. */
+int gbl_commit_ack_coordinator = 0;
+
+static __thread pthread_cond_t seqnum_waiter_cond = PTHREAD_COND_INITIALIZER;
+
+/* Called with seqnum_info->lock held.  Commits mostly arrive in lsn order,
+ * so search for the insert point from the bottom. */
+static void add_seqnum_waiter(struct hostinfo *h, struct seqnum_waiter *w)
+{
+    struct seqnum_waiter *prev = h->waiters.bot;
+    while (prev && log_compare(&prev->lsn, &w->lsn) > 0)
+        prev = prev->lnk.prev;
+    if (prev)
+        listc_add_after(&h->waiters, w, prev);
+    else
+        listc_atl(&h->waiters, w);
+    w->queued = 1;
+}
+
+/* Called with seqnum_info->lock held.  Release the waiters on h up to lsn,
+ * or all of them if lsn is NULL. */
+static void release_seqnum_waiters(struct hostinfo *h, DB_LSN *lsn)
+{
+    struct seqnum_waiter *w;
+    while ((w = h->waiters.top) != NULL &&
+           (lsn == NULL || log_compare(&w->lsn, lsn) <= 0)) {
+        listc_rtl(&h->waiters);
+        w->queued = 0;
+        Pthread_cond_signal(w->cond);
+        if (lsn)
+            h->waiters_released++;
+    }
+}
+
+static void release_all_seqnum_waiters(void)
+{
+    struct hostinfo *h;
+    hostinfo_lock();
+    LISTC_FOR_EACH(&hostinfo_list, h, lnk)
+    {
+        release_seqnum_waiters(h, NULL);
+    }
+    hostinfo_unlock();
+}
+
 /* Added for testing- allows us to test slow-replicant-check and inactive-timeout separately */
 int gbl_incoherent_slow_inactive_timeout = 1;
 
@@ -2523,6 +2585,7 @@ static void got_new_seqnum_from_node(bdb_state_type *bdb_state,
     if (should_copy_seqnum(bdb_state, seqnum, &h->seqnum)) {
         memcpy(&h->seqnum, seqnum, sizeof(seqnum_type));
     }
+    h->acks++;
 
     if (gbl_set_seqnum_trace) {
         logmsg(LOGMSG_USER, "%s line %d set %s seqnum to %d:%d\n", __func__,
@@ -2554,6 +2617,9 @@ static void got_new_seqnum_from_node(bdb_state_type *bdb_state,
     if (bdb_state->repinfo->master_host == bdb_state->repinfo->myhost)
         update_node_acks(bdb_state, hostinterned, is_tcp);
 
+    if (h->waiters.count > 0 && seqnum->lsn.file != INT_MAX)
+        release_seqnum_waiters(h, &h->seqnum.lsn);
+
     Pthread_mutex_unlock(&(bdb_state->seqnum_info->lock));
 
     if (bdb_state->repinfo->master_host != bdb_state->repinfo->myhost) {
@@ -3072,8 +3138,17 @@ again:
         reset_ts = 0;
     }
 
-    rc = pthread_cond_timedwait(&(bdb_state->seqnum_info->cond),
-                                &(bdb_state->seqnum_info->lock), &waittime);
+    if (gbl_commit_ack_coordinator) {
+        struct seqnum_waiter w = {.lsn = seqnum->lsn, .cond = &seqnum_waiter_cond};
+        add_seqnum_waiter(h, &w);
+        rc = pthread_cond_timedwait(w.cond, &(bdb_state->seqnum_info->lock),
+                                    &waittime);
+        if (w.queued)
+            listc_rfl(&h->waiters, &w);
+    } else {
+        rc = pthread_cond_timedwait(&(bdb_state->seqnum_info->cond),
+                                    &(bdb_state->seqnum_info->lock), &waittime);
+    }
 
     /* Come up to check lock-desired */
     if (rc == ETIMEDOUT && remaining > 0) {
@@ -3188,7 +3263,7 @@ int gbl_replicant_retry_on_not_durable = 0;
 int gbl_debug_force_non_durable = 0;
 int gbl_assert_no_schemalk_in_distributed_commit = 0;
 
-int bdb_wait_for_seqnum_from_all_int(bdb_state_type *bdb_state, seqnum_type *seqnum, int *timeoutms, int is_final)
+static int wait_for_seqnum_from_all_int(bdb_state_type *bdb_state, seqnum_type *seqnum, int *timeoutms, int is_final)
 {
     int i, now, cntbytes;
     struct interned_string *nodelist[REPMAX];
@@ -3579,6 +3654,19 @@ done_wait:
     return outrc;
 }
 
+int bdb_wait_for_seqnum_from_all_int(bdb_state_type *bdb_state, seqnum_type *seqnum, int *timeoutms, int is_final)
+{
+    uint64_t start_us = comdb2_time_epochus();
+    int rc = wait_for_seqnum_from_all_int(bdb_state, seqnum, timeoutms, is_final);
+    /* nothing to wait for on lsn 0:0; don't let those drag p50 to zero */
+    if (seqnum->lsn.file != 0 || seqnum->lsn.offset != 0) {
+        uint64_t us = comdb2_time_epochus() - start_us;
+        latency_histogram_add(LATENCY_REP_WAIT, us);
+        bdb_thread_wait(THD_WAIT_REP, us);
+    }
+    return rc;
+}
+
 int bdb_wait_for_seqnum_from_all(bdb_state_type *bdb_state, seqnum_type *seqnum)
 {
     int timeoutms = bdb_state->attr->reptimeout * MILLISEC;
@@ -5953,6 +6041,7 @@ void *watcher_thread(void *arg)
         if (bdb_state->pending_seqnum_broadcast) {
             Pthread_mutex_lock(&(bdb_state->seqnum_info->lock));
             Pthread_cond_broadcast(&(bdb_state->seqnum_info->cond));
+            release_all_seqnum_waiters();
             Pthread_mutex_unlock(&(bdb_state->seqnum_info->lock));
 
             bdb_state->pending_seqnum_broadcast = 0;
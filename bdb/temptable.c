@@ -143,6 +143,14 @@ struct temp_cursor {
     int ind;
     int keymalloclen;
     int datamalloclen;
+    /* joinhash probe results */
+    struct hj_elem **hj_match;
+    int hj_nmatch;
+    int hj_matchsz;
+    int hj_probing;
+    /* joinhash scan position */
+    struct hj_chunk *hj_chunk;
+    size_t hj_off;
 };
 
 typedef struct arr_elem {
@@ -186,12 +194,39 @@ typedef struct arr_elem {
    a temparray will fall back to a temptable.
    A temparray is more efficient than a temptable. Besides, it uses far
    less memory than a temptable for small and medium-sized requests. */
+/* A joinhash is the build side of a hash join: entries are carved out of an
+   arena and only linked into hash buckets on the first probe, once the number
+   of key fields probed on is known.  A probe collects every entry whose
+   leading fields equal the probe key.  It is unordered; past
+   gbl_hash_join_mem_kb of entries it falls back to a temptable. */
 enum {
     TEMP_TABLE_TYPE_BTREE,
     TEMP_TABLE_TYPE_HASH,
-    TEMP_TABLE_TYPE_ARRAY
+    TEMP_TABLE_TYPE_ARRAY,
+    TEMP_TABLE_TYPE_JOINHASH
 };
 
+struct hj_elem {
+    struct hj_elem *next;
+    unsigned int hash;
+    int keylen;
+    int dtalen;
+    uint8_t kv[]; /* key followed by data */
+};
+
+struct hj_chunk {
+    struct hj_chunk *next;
+    size_t used;
+    size_t size;
+    uint8_t mem[];
+};
+
+#define HJ_CHUNK_SIZE (64 * 1024)
+#define HJ_ELEM_SIZE(keylen, dtalen)                                           \
+    ((offsetof(struct hj_elem, kv) + (keylen) + (dtalen) + 7) & ~(size_t)7)
+
+int gbl_hash_join_mem_kb = 16384;
+
 struct temp_table {
     DB_ENV *dbenv_temp;
 
@@ -214,6 +249,14 @@ struct temp_table {
     unsigned long long inmemsz;
     unsigned long long cachesz;
     arr_elem_t *elements;
+
+    /* TEMP_TABLE_TYPE_JOINHASH */
+    tmptbl_hash hashfunc;
+    struct hj_chunk *hj_arena;
+    struct hj_elem **hj_buckets;
+    unsigned int hj_nbuckets;
+    int hj_nfields;    /* key fields hashed, set by the first probe */
+    int hj_unhashable; /* some entry could not be hashed; probes scan */
 };
 
 enum { TMPTBL_PRIORITY, TMPTBL_WAIT };
@@ -468,6 +511,193 @@ done:
     return rc;
 }
 
+static void joinhash_free(struct temp_table *tbl)
+{
+    struct hj_chunk *chunk;
+
+    while ((chunk = tbl->hj_arena) != NULL) {
+        tbl->hj_arena = chunk->next;
+        free(chunk);
+    }
+    free(tbl->hj_buckets);
+    tbl->hj_buckets = NULL;
+    tbl->hj_nbuckets = 0;
+    tbl->hj_nfields = 0;
+    tbl->hj_unhashable = 0;
+    tbl->inmemsz = 0;
+}
+
+static struct hj_elem *joinhash_alloc(struct temp_table *tbl, int keylen,
+                                      int dtalen)
+{
+    struct hj_chunk *chunk = tbl->hj_arena;
+    size_t sz = HJ_ELEM_SIZE(keylen, dtalen);
+    struct hj_elem *e;
+
+    if (chunk == NULL || chunk->size - chunk->used < sz) {
+        size_t chunksz = sz > HJ_CHUNK_SIZE ? sz : HJ_CHUNK_SIZE;
+        chunk = malloc(offsetof(struct hj_chunk, mem) + chunksz);
+        if (chunk == NULL)
+            return NULL;
+        chunk->used = 0;
+        chunk->size = chunksz;
+        chunk->next = tbl->hj_arena;
+        tbl->hj_arena = chunk;
+        tbl->inmemsz += chunksz;
+    }
+    e = (struct hj_elem *)(chunk->mem + chunk->used);
+    chunk->used += sz;
+    e->next = NULL;
+    e->keylen = keylen;
+    e->dtalen = dtalen;
+    return e;
+}
+
+/* Walk the arena in allocation order within each chunk */
+static struct hj_elem *joinhash_arena_next(struct hj_chunk **pchunk,
+                                           size_t *poff)
+{
+    struct hj_chunk *chunk = *pchunk;
+    struct hj_elem *e;
+
+    while (chunk && *poff >= chunk->used) {
+        chunk = chunk->next;
+        *poff = 0;
+    }
+    *pchunk = chunk;
+    if (chunk == NULL)
+        return NULL;
+    e = (struct hj_elem *)(chunk->mem + *poff);
+    *poff += HJ_ELEM_SIZE(e->keylen, e->dtalen);
+    return e;
+}
+
+static void joinhash_link(struct temp_table *tbl, struct hj_elem *e)
+{
+    if (tbl->hashfunc == NULL ||
+        tbl->hashfunc(tbl->hj_nfields, e->keylen, e->kv, &e->hash) != 0) {
+        tbl->hj_unhashable = 1;
+        e->hash = 0;
+    }
+    e->next = tbl->hj_buckets[e->hash & (tbl->hj_nbuckets - 1)];
+    tbl->hj_buckets[e->hash & (tbl->hj_nbuckets - 1)] = e;
+}
+
+static int joinhash_resize(struct temp_table *tbl, unsigned int nbuckets)
+{
+    struct hj_elem **buckets, *e, *next;
+
+    buckets = calloc(nbuckets, sizeof(struct hj_elem *));
+    if (buckets == NULL)
+        return -1;
+    for (unsigned int i = 0; i < tbl->hj_nbuckets; i++) {
+        for (e = tbl->hj_buckets[i]; e; e = next) {
+            next = e->next;
+            e->next = buckets[e->hash & (nbuckets - 1)];
+            buckets[e->hash & (nbuckets - 1)] = e;
+        }
+    }
+    free(tbl->hj_buckets);
+    tbl->hj_buckets = buckets;
+    tbl->hj_nbuckets = nbuckets;
+    return 0;
+}
+
+/* Hash every entry on its first nfields fields */
+static int joinhash_build(struct temp_table *tbl, int nfields)
+{
+    struct hj_chunk *chunk = tbl->hj_arena;
+    size_t off = 0;
+    unsigned int nbuckets = 16;
+    struct hj_elem *e;
+
+    while (nbuckets < tbl->num_mem_entries)
+        nbuckets <<= 1;
+    free(tbl->hj_buckets);
+    tbl->hj_buckets = calloc(nbuckets, sizeof(struct hj_elem *));
+    if (tbl->hj_buckets == NULL) {
+        tbl->hj_nbuckets = 0;
+        return -1;
+    }
+    tbl->hj_nbuckets = nbuckets;
+    tbl->hj_nfields = nfields;
+    tbl->hj_unhashable = 0;
+    while ((e = joinhash_arena_next(&chunk, &off)) != NULL)
+        joinhash_link(tbl, e);
+    return 0;
+}
+
+static int bdb_joinhash_copy_to_temp_db(bdb_state_type *bdb_state,
+                                        struct temp_table *tbl, int *bdberr)
+{
+    int rc = 0;
+    DBT dbt_key, dbt_data;
+    struct temp_cursor *cur;
+    struct hj_chunk *chunk = tbl->hj_arena;
+    size_t off = 0;
+    struct hj_elem *e;
+
+    bzero(&dbt_key, sizeof(DBT));
+    bzero(&dbt_data, sizeof(DBT));
+
+    if (tbl->dbenv_temp == NULL &&
+        create_temp_db_env(bdb_state, tbl, bdberr) != 0) {
+        bdb_temp_table_destroy_pool_wrapper(tbl, bdb_state);
+    }
+
+    while ((e = joinhash_arena_next(&chunk, &off)) != NULL) {
+        dbt_key.flags = dbt_data.flags = DB_DBT_USERMEM;
+        dbt_key.ulen = dbt_key.size = e->keylen;
+        dbt_data.ulen = dbt_data.size = e->dtalen;
+        dbt_key.data = e->kv;
+        dbt_data.data = e->kv + e->keylen;
+
+        rc = tbl->tmpdb->put(tbl->tmpdb, NULL, &dbt_key, &dbt_data, 0);
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "%s:%d put rc %d\n", __FILE__, __LINE__, rc);
+            return rc;
+        }
+    }
+
+    joinhash_free(tbl);
+
+    /* its now a btree! */
+    tbl->temp_table_type = TEMP_TABLE_TYPE_BTREE;
+
+    /* Reset all the cursors for this table.
+       For now don't care about position. */
+    LISTC_FOR_EACH(&tbl->cursors, cur, lnk)
+    {
+        cur->hj_nmatch = 0;
+        cur->hj_probing = 0;
+        cur->valid = 0;
+        rc = tbl->tmpdb->cursor(tbl->tmpdb, NULL, &cur->cur, 0);
+        if (rc) {
+            cur->cur = NULL;
+            logmsg(LOGMSG_ERROR, "%s:%d cursor rc %d\n", __FILE__, __LINE__,
+                   rc);
+            goto done;
+        }
+
+        /* New cursor does not point to any data */
+        cur->key = cur->data = NULL;
+        cur->keylen = cur->datalen = 0;
+    }
+
+done:
+    return rc;
+}
+
+static inline void joinhash_set_cur(struct temp_cursor *cur,
+                                    struct hj_elem *e)
+{
+    cur->key = e->kv;
+    cur->keylen = e->keylen;
+    cur->data = e->kv + e->keylen;
+    cur->datalen = e->dtalen;
+    cur->valid = 1;
+}
+
 static void bdb_temp_table_reset(struct temp_table *tbl)
 {
     tbl->rowid = 0;
@@ -779,6 +1009,9 @@ static struct temp_table *bdb_temp_table_create_type(bdb_state_type *bdb_state,
                 }
             }
             break;
+        case TEMP_TABLE_TYPE_JOINHASH:
+            table->inmemsz = 0;
+            break;
         }
 
         table->num_mem_entries = 0;
@@ -815,6 +1048,13 @@ struct temp_table *bdb_temp_array_create(bdb_state_type *bdb_state, int *bdberr)
     return bdb_temp_table_create_type(bdb_state, TEMP_TABLE_TYPE_ARRAY, bdberr);
 }
 
+struct temp_table *bdb_temp_joinhash_create(bdb_state_type *bdb_state,
+                                            int *bdberr)
+{
+    return bdb_temp_table_create_type(bdb_state, TEMP_TABLE_TYPE_JOINHASH,
+                                      bdberr);
+}
+
 struct temp_cursor *bdb_temp_table_cursor(bdb_state_type *bdb_state,
                                           struct temp_table *tbl, void *usermem,
                                           int *bdberr)
@@ -840,6 +1080,7 @@ struct temp_cursor *bdb_temp_table_cursor(bdb_state_type *bdb_state,
         break;
 
     case TEMP_TABLE_TYPE_ARRAY:
+    case TEMP_TABLE_TYPE_JOINHASH:
         cur->ind = 0;
         break;
     }
@@ -1068,6 +1309,24 @@ static int bdb_temp_table_first_last(bdb_state_type *bdb_state,
         return 0;
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_JOINHASH) {
+        struct hj_elem *e;
+        cur->valid = 0;
+        cur->hj_probing = 0;
+        if (how != DB_FIRST) {
+            logmsg(LOGMSG_ERROR, "%s: operation not supported for joinhash\n",
+                   __func__);
+            return -1;
+        }
+        cur->hj_chunk = cur->tbl->hj_arena;
+        cur->hj_off = 0;
+        e = joinhash_arena_next(&cur->hj_chunk, &cur->hj_off);
+        if (e == NULL)
+            return IX_EMPTY;
+        joinhash_set_cur(cur, e);
+        return 0;
+    }
+
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
         arrlen = cur->tbl->num_mem_entries;
         if (arrlen == 0) {
@@ -1151,6 +1410,26 @@ static int bdb_temp_table_next_prev_norewind(bdb_state_type *bdb_state,
         return 0;
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_JOINHASH) {
+        struct hj_elem *e;
+        if (how != DB_NEXT) {
+            logmsg(LOGMSG_ERROR, "%s: operation not supported for joinhash\n",
+                   __func__);
+            return -1;
+        }
+        if (cur->hj_probing) {
+            if (++cur->ind >= cur->hj_nmatch)
+                return IX_PASTEOF;
+            e = cur->hj_match[cur->ind];
+        } else {
+            e = joinhash_arena_next(&cur->hj_chunk, &cur->hj_off);
+            if (e == NULL)
+                return IX_PASTEOF;
+        }
+        joinhash_set_cur(cur, e);
+        return 0;
+    }
+
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
         if ((how == DB_NEXT && ++cur->ind >= cur->tbl->num_mem_entries) ||
             (how == DB_PREV && --cur->ind < 0)) {
@@ -1430,6 +1709,11 @@ int bdb_temp_table_truncate(bdb_state_type *bdb_state, struct temp_table *tbl,
         tbl->num_mem_entries = 0;
         break;
 
+    case TEMP_TABLE_TYPE_JOINHASH:
+        rc = bdb_temp_table_reset_cursors(bdb_state, tbl, bdberr);
+        joinhash_free(tbl);
+        break;
+
     case TEMP_TABLE_TYPE_BTREE:
         rc = tbl->tmpdb->size(tbl->tmpdb, &sz);
         if (tbl->num_mem_entries < 100 && (rc == 0 && sz < gbl_temptable_recreate_size))
@@ -1663,6 +1947,10 @@ int bdb_temp_table_destroy_lru(struct temp_table *tbl,
         }
         break;
 
+    case TEMP_TABLE_TYPE_JOINHASH:
+        joinhash_free(tbl);
+        break;
+
     case TEMP_TABLE_TYPE_BTREE:
         break;
     }
@@ -1722,6 +2010,13 @@ int bdb_temp_table_delete(bdb_state_type *bdb_state, struct temp_cursor *cur,
         goto done;
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_JOINHASH) {
+        logmsg(LOGMSG_ERROR, "%s: operation not supported for joinhash\n",
+               __func__);
+        rc = -1;
+        goto done;
+    }
+
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
         elem = &cur->tbl->elements[cur->ind];
         free(elem->key);
@@ -1764,6 +2059,82 @@ void bdb_temp_table_set_cmp_func(struct temp_table *tbl, tmptbl_cmp cmpfunc)
         tbl->cmpfunc = key_memcmp;
 }
 
+void bdb_temp_table_set_hash_func(struct temp_table *tbl, tmptbl_hash hashfunc)
+{
+    tbl->hashfunc = hashfunc;
+}
+
+static int joinhash_add_match(struct temp_cursor *cur, struct hj_elem *e)
+{
+    if (cur->hj_nmatch == cur->hj_matchsz) {
+        int sz = cur->hj_matchsz ? 2 * cur->hj_matchsz : 16;
+        struct hj_elem **m = realloc(cur->hj_match, sz * sizeof(*m));
+        if (m == NULL)
+            return -1;
+        cur->hj_match = m;
+        cur->hj_matchsz = sz;
+    }
+    cur->hj_match[cur->hj_nmatch++] = e;
+    return 0;
+}
+
+/* Position the cursor on the entries whose first nfields fields compare
+ * equal to the unpacked probe key; next walks the rest of them */
+int bdb_temp_table_find_joinhash(bdb_state_type *bdb_state,
+                                 struct temp_cursor *cur, void *unpacked,
+                                 int nfields, int *bdberr)
+{
+    struct temp_table *tbl = cur->tbl;
+    tmptbl_cmp cmpfn = tbl->cmpfunc;
+    struct hj_elem *e;
+    unsigned int hash;
+
+    assert(tbl->temp_table_type == TEMP_TABLE_TYPE_JOINHASH);
+
+    cur->valid = 0;
+    cur->hj_probing = 1;
+    cur->hj_nmatch = 0;
+    cur->ind = 0;
+
+    if (tbl->num_mem_entries == 0)
+        return IX_EMPTY;
+
+    if (tbl->hj_buckets == NULL || tbl->hj_nfields != nfields) {
+        if (joinhash_build(tbl, nfields)) {
+            *bdberr = BDBERR_MALLOC;
+            return -1;
+        }
+    }
+
+    if (!tbl->hj_unhashable && tbl->hashfunc &&
+        tbl->hashfunc(nfields, -1, unpacked, &hash) == 0) {
+        for (e = tbl->hj_buckets[hash & (tbl->hj_nbuckets - 1)]; e;
+             e = e->next) {
+            if (e->hash == hash &&
+                cmpfn(tbl->usermem, e->keylen, e->kv, -1, unpacked) == 0 &&
+                joinhash_add_match(cur, e)) {
+                *bdberr = BDBERR_MALLOC;
+                return -1;
+            }
+        }
+    } else {
+        struct hj_chunk *chunk = tbl->hj_arena;
+        size_t off = 0;
+        while ((e = joinhash_arena_next(&chunk, &off)) != NULL) {
+            if (cmpfn(tbl->usermem, e->keylen, e->kv, -1, unpacked) == 0 &&
+                joinhash_add_match(cur, e)) {
+                *bdberr = BDBERR_MALLOC;
+                return -1;
+            }
+        }
+    }
+
+    if (cur->hj_nmatch == 0)
+        return IX_PASTEOF;
+    joinhash_set_cur(cur, cur->hj_match[0]);
+    return IX_FND;
+}
+
 /* compare btree keys */
 static int temp_table_compare(DB *db, const DBT *dbt1, const DBT *dbt2)
 {
@@ -1843,6 +2214,12 @@ int bdb_temp_table_find(bdb_state_type *bdb_state, struct temp_cursor *cur,
         return bdb_temp_table_find_hash(cur, key, keylen);
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_JOINHASH) {
+        logmsg(LOGMSG_ERROR, "%s: operation not supported for joinhash\n",
+               __func__);
+        return -1;
+    }
+
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
 
         /* Find the 1st occurrence of `key'. If `key' is not found,
@@ -1993,6 +2370,12 @@ int bdb_temp_table_find_exact(bdb_state_type *bdb_state,
         return bdb_temp_table_find_exact_hash(cur, key, keylen);
     }
 
+    if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_JOINHASH) {
+        logmsg(LOGMSG_ERROR, "%s: operation not supported for joinhash\n",
+               __func__);
+        return -1;
+    }
+
     if (cur->tbl->temp_table_type == TEMP_TABLE_TYPE_ARRAY) {
 
         /* Find the 1st occurrence of `key'. */
@@ -2132,8 +2515,17 @@ static int bdb_temp_table_reset_cursor(bdb_state_type *bdb_state, struct temp_cu
             }
             cur->cur = NULL;
         }
+    } else if (tbl->temp_table_type == TEMP_TABLE_TYPE_JOINHASH) {
+        /* key and data point into the arena */
+        cur->key = cur->data = NULL;
+        cur->valid = 0;
     }
 
+    free(cur->hj_match);
+    cur->hj_match = NULL;
+    cur->hj_nmatch = cur->hj_matchsz = 0;
+    cur->hj_probing = 0;
+
     return rc;
 }
 
@@ -2216,6 +2608,11 @@ inline int bdb_is_hashtable(struct temp_table *tt)
     return (tt->temp_table_type == TEMP_TABLE_TYPE_HASH);
 }
 
+inline int bdb_is_joinhash(struct temp_table *tt)
+{
+    return (tt->temp_table_type == TEMP_TABLE_TYPE_JOINHASH);
+}
+
 int bdb_temp_table_maybe_set_priority_thread(bdb_state_type *bdb_state)
 {
     int rc = TMPTBL_WAIT;
@@ -2375,6 +2772,37 @@ static int bdb_temp_table_insert_put(bdb_state_type *bdb_state,
         return 0;
     }
 
+    if (tbl->temp_table_type == TEMP_TABLE_TYPE_JOINHASH) {
+        struct hj_elem *e = joinhash_alloc(tbl, keylen, dtalen);
+        if (e == NULL) {
+            *bdberr = BDBERR_MALLOC;
+            return -1;
+        }
+        memcpy(e->kv, key, keylen);
+        memcpy(e->kv + keylen, data, dtalen);
+        ++tbl->num_mem_entries;
+
+        /* already probed: keep the buckets current */
+        if (tbl->hj_buckets) {
+            if (tbl->num_mem_entries > 2 * tbl->hj_nbuckets &&
+                joinhash_resize(tbl, tbl->hj_nbuckets << 1)) {
+                *bdberr = BDBERR_MALLOC;
+                return -1;
+            }
+            joinhash_link(tbl, e);
+        }
+
+        if (tbl->inmemsz > (unsigned long long)gbl_hash_join_mem_kb * 1024) {
+            gbl_temptable_spills++;
+            rc = bdb_joinhash_copy_to_temp_db(bdb_state, tbl, bdberr);
+            if (unlikely(rc)) {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
     assert (tbl->temp_table_type == TEMP_TABLE_TYPE_BTREE);
     tbl->num_mem_entries++;
 
@@ -61,6 +61,7 @@
 
 #include "logmsg.h"
 #include "txn_properties.h"
+#include "histogram.h"
 #include <build/db.h>
 
 static unsigned int curtran_counter = 0;
@@ -1516,6 +1517,7 @@ int bdb_tran_commit_with_seqnum_int(bdb_state_type *bdb_state, tran_type *tran,
     tran_type *physical_tran = NULL;
     DB_LSN lsn;
     DB_LSN old_lsn;
+    uint64_t start_us = comdb2_time_epochus();
 
     bzero(&lsn, sizeof(DB_LSN));
     bzero(&old_lsn, sizeof(DB_LSN));
@@ -2066,6 +2068,9 @@ cleanup:
 
     free(tran);
 
+    if (outrc == 0)
+        latency_histogram_add(LATENCY_COMMIT, comdb2_time_epochus() - start_us);
+
     return outrc;
 }
 
@@ -15,8 +15,11 @@ uint32_t rcache_savd;
 uint32_t rcache_invalid;
 uint32_t rcache_collide;
 
+/* Slots are keyed by file and page, so the top levels of a tree share the
+ * cache with the roots of other trees. */
 typedef struct {
 	uint8_t fileid[DB_FILE_ID_LEN];
+	db_pgno_t pgno;
 	uint16_t gen;
 	uint32_t hitmiss;
 	void *bfpool_pg;
@@ -62,10 +65,10 @@ rcache_init(size_t count, size_t pgsz)
 }
 
 static inline void
-hash_fileid(void *fileid, uint32_t * crc, uint32_t * hash)
+hash_fileid(void *fileid, db_pgno_t pgno, uint32_t * crc, uint32_t * hash)
 {
 	*crc = crc32c(fileid, DB_FILE_ID_LEN);
-	*hash = *crc % hndl->count;
+	*hash = (*crc + pgno * 2654435761U) % hndl->count;
 }
 
 void
@@ -78,19 +81,19 @@ rcache_destroy(void)
 }
 
 int
-rcache_find(DB *dbp, void **cached_pg, void **bfpool_pg,
+rcache_find(DB *dbp, db_pgno_t pgno, void **cached_pg, void **bfpool_pg,
     uint16_t * gen, uint32_t * slot_ptr)
 {
 	if (hndl == NULL || dbp->pgsize > hndl->pgsz)
 		return -1;
 	uint32_t crc, slot;
 
-	hash_fileid(dbp->fileid, &crc, &slot);
+	hash_fileid(dbp->fileid, pgno, &crc, &slot);
 	if (crc == 0)
 		return -1;
 	CacheSlot *cache = &hndl->slots[slot];
 
-	if (cache->bfpool_pg
+	if (cache->bfpool_pg && cache->pgno == pgno
 	    && memcmp(cache->fileid, dbp->fileid, DB_FILE_ID_LEN) == 0) {
 		*cached_pg = cache->cached_pg;
 		*bfpool_pg = cache->bfpool_pg;
@@ -106,13 +109,13 @@ rcache_find(DB *dbp, void **cached_pg, void **bfpool_pg,
 }
 
 int
-rcache_save(DB *dbp, void *page, uint16_t gen)
+rcache_save(DB *dbp, void *page, db_pgno_t pgno, uint16_t gen)
 {
 	if (hndl == NULL || dbp->pgsize > hndl->pgsz)
 		return -1;
 	uint32_t crc, slot;
 
-	hash_fileid(dbp->fileid, &crc, &slot);
+	hash_fileid(dbp->fileid, pgno, &crc, &slot);
 	if (crc == 0)
 		return -1;
 	CacheSlot *cache = &hndl->slots[slot];
@@ -125,6 +128,7 @@ rcache_save(DB *dbp, void *page, uint16_t gen)
 		}
 	}
 	cache->hitmiss = 1;
+	cache->pgno = pgno;
 	cache->bfpool_pg = page;
 	cache->gen = gen;
 	memcpy(cache->cached_pg, page, dbp->pgsize);
@@ -307,6 +307,15 @@ genidsetzero(void *g)
 	memset(g, 0, HASH_GENID_SIZE);
 }
 
+static inline void
+__bam_rcache_save(DB *dbp, PAGE *h)
+{
+	uint16_t gen = LSN(h).file + LSN(h).offset;
+
+	GET_BH_GEN(h) = gen;
+	rcache_save(dbp, h, PGNO(h), gen);
+}
+
 /*
  * __bam_search --
  *	Search a btree for a key.
@@ -336,10 +345,14 @@ __bam_search(dbc, root_pgno, key, flags, stop, recnop, exactp)
 	int adjust, cmp, deloffset, ret, stack;
 	int (*func) __P((DB *, const DBT *, const DBT *));
 	void *cached_pg = NULL;
-	void *bfpool_pg = NULL;
+	struct {
+		void *cached_pg;
+		void *bfpool_pg;
+		uint16_t gen;
+		uint32_t slot;
+	} rc_used[RCACHE_MAX_LEVELS];
+	int rc_nused = 0, rc_retry = 0, depth, r;
 	int save = 0;
-	uint16_t gen;
-	uint32_t slot;
 	unsigned int hh = 0;
 	genid_hash *hash = NULL;
 	__genid_pgno *hashtbl = NULL;
@@ -389,13 +402,25 @@ try_again:
 	gettimeofday(&before, NULL);
 
 	extern int gbl_rcache;
+	extern int gbl_rcache_levels;
 
-	if (gbl_rcache && pg == 1 && bfpool_pg == NULL &&
+	/*
+	 * Read-only lookups may descend through copies of the top
+	 * gbl_rcache_levels levels of the tree without locking or pinning
+	 * them.  Every copy used is checked against its buffer once the first
+	 * real page below them is pinned; if any changed, start over without
+	 * the cache.
+	 */
+	depth = 0;
+	rc_nused = 0;
+	if (gbl_rcache && pg == 1 && !rc_retry &&
 	    lock_mode == DB_LOCK_READ && LF_ISSET(S_FIND)) {
 		save = 1;
-		if (rcache_find(
-		    dbp, &cached_pg, &bfpool_pg, &gen, &slot) == 0) {
-			h = cached_pg;
+		if (rcache_find(dbp, pg, &rc_used[0].cached_pg,
+		    &rc_used[0].bfpool_pg, &rc_used[0].gen,
+		    &rc_used[0].slot) == 0) {
+			h = cached_pg = rc_used[0].cached_pg;
+			rc_nused = 1;
 			goto got_pg;
 		}
 	}
@@ -519,12 +544,8 @@ hash_backup:
 		}
 	}
 
-	if (save && TYPE(h) == P_IBTREE) {	// WORKS ONLY WHEN ROOT IS INTERNAL
-		uint16_t gen = LSN(h).file + LSN(h).offset;
-
-		GET_BH_GEN(h) = gen;
-		rcache_save(dbp, h, gen);
-	}
+	if (save && TYPE(h) == P_IBTREE)	// WORKS ONLY WHEN ROOT IS INTERNAL
+		__bam_rcache_save(dbp, h);
 
 	INTERNAL_PTR_CHECK(cp == dbc->internal);
 
@@ -727,6 +748,23 @@ next:		if (recnop != NULL)
 			lock_mode = stack &&
 			    LF_ISSET(S_WRITE) ? DB_LOCK_WRITE : DB_LOCK_READ;
 
+			/* Try the cache for an internal child near the top. */
+			if (save && !stack && !rc_retry &&
+			    depth + 1 < gbl_rcache_levels &&
+			    rc_nused < RCACHE_MAX_LEVELS &&
+			    rcache_find(dbp, pg, &rc_used[rc_nused].cached_pg,
+			    &rc_used[rc_nused].bfpool_pg,
+			    &rc_used[rc_nused].gen,
+			    &rc_used[rc_nused].slot) == 0) {
+				if (cached_pg == NULL) {
+					PAGEPUT(dbc, mpf, h, 0);
+					(void)__LPUT(dbc, lock);
+				}
+				h = cached_pg = rc_used[rc_nused++].cached_pg;
+				++depth;
+				continue;
+			}
+
 			if (cached_pg) {
 				/* Used rcache to get here. Don't lck couple. */
 				if ((ret = __db_lget(dbc, 0, pg, lock_mode, 0,
@@ -762,27 +800,38 @@ next:		if (recnop != NULL)
 				 */
 				cached_pg = NULL;
 
-				rcache_invalidate(slot);
+				for (r = 0; r < rc_nused; ++r)
+					rcache_invalidate(rc_used[r].slot);
+				rc_retry = 1;
 				__LPUT(dbc, lock);
 				goto try_again;
 			}
 			goto err;
 		}
+		++depth;
 
 		if (cached_pg) {
 			/* Used rcache and got child page. Validate rcache. */
-			DB_LSN *l1 = &LSN(cached_pg);
-			DB_LSN *l2 = &LSN(bfpool_pg);
+			int valid = 1;
 			cached_pg = NULL;
 
-			if (gen == GET_BH_GEN(bfpool_pg)
-			    && memcmp(l1, l2, sizeof(DB_LSN)) == 0 && gen == GET_BH_GEN(bfpool_pg)	//re-check. warm&fuzzy
-			    ) {
-				;
-			} else {
+			for (r = 0; r < rc_nused; ++r) {
+				DB_LSN *l1 = &LSN(rc_used[r].cached_pg);
+				DB_LSN *l2 = &LSN(rc_used[r].bfpool_pg);
+				uint16_t gen = rc_used[r].gen;
+
+				if (gen == GET_BH_GEN(rc_used[r].bfpool_pg)
+				    && memcmp(l1, l2, sizeof(DB_LSN)) == 0 && gen == GET_BH_GEN(rc_used[r].bfpool_pg)	//re-check. warm&fuzzy
+				    )
+					continue;
+				rcache_invalidate(rc_used[r].slot);
+				valid = 0;
+			}
+			rc_nused = 0;
+			if (!valid) {
 				PAGEPUT(dbc, mpf, h, 0);
 				__LPUT(dbc, lock);
-				rcache_invalidate(slot);
+				rc_retry = 1;
 				goto try_again;
 			}
 		}
@@ -803,6 +852,9 @@ next:		if (recnop != NULL)
 		default:
 			return (__db_pgfmt(dbp->dbenv, PGNO(h)));
 		}
+
+		if (save && TYPE(h) == P_IBTREE && depth < gbl_rcache_levels)
+			__bam_rcache_save(dbp, h);
 	}
 	/* NOTREACHED */
 
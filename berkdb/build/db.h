@@ -922,6 +922,8 @@ struct __db_mpool_stat {
 	u_int64_t st_ro_levict;		/* Clean leaf pages forced from cache.*/
 	u_int64_t st_rw_levict;		/* Dirty leaf pages forced from cache.*/
 	u_int64_t st_pf_evict;		/* Prefault pages forced from  cache. */
+	u_int64_t st_probation_evict;	/* Pages forced from cache unused. */
+	u_int64_t st_probation_promote;	/* Pages referenced again. */
 	u_int64_t st_rw_evict_skip;	/* Dirty pages skipped during evict. */
 	u_int64_t st_page_trickle;	/* Pages written by memp_trickle. */
 	u_int64_t st_pages;		/* Total number of pages. */
@@ -1608,6 +1610,8 @@ struct __db {
 #define	DB_LOGFILEID_INVALID	-1
 	FNAME *log_filename;		/* File's naming info for logging. */
 	int added_to_ufid;
+	int ufid_pfcnt;			/* Prefaults holding this handle open,
+					   under ufid_to_db_lk */
 
 	db_pgno_t meta_pgno;		/* Meta page number */
 	u_int32_t lid;			/* Locker id for handle locking. */
@@ -2757,6 +2761,7 @@ struct __db_env {
 	/* ufid to dbp hash */
 	hash_t *ufid_to_db_hash;
 	pthread_mutex_t ufid_to_db_lk;
+	pthread_cond_t ufid_pf_cond;	/* Signals the last prefault of a handle */
 
 	/* prepared transactions */
 	hash_t *prepared_txn_hash;
@@ -3127,6 +3132,7 @@ struct berkdb_thread_stats *bb_berkdb_get_thread_stats(void);
 struct berkdb_thread_stats *bb_berkdb_get_process_stats(void);
 void bb_berkdb_thread_stats_init(void);
 void bb_berkdb_thread_stats_reset(void);
+void bb_berkdb_thread_wait(int event, uint64_t us);
 
 /* counts[] for _get()/_foreach(): (total, disk-I/O subset) pairs for
  * [0][1] SQL execution, [2][3] master write-apply, [4][5] replicant apply. */
@@ -3215,10 +3221,25 @@ struct logrecord {
 	DBT rec;
 };
 
+/* Page a log record is going to change, for reading it in ahead of time */
+struct log_prefetch_target {
+	int type;	/* LOG_PREFETCH_* */
+	int32_t fileid;
+	u_int8_t fuid[DB_FILE_ID_LEN];
+	db_pgno_t pgno;
+};
+
+enum {
+	LOG_PREFETCH_NONE = 0,
+	LOG_PREFETCH_DBREG = 1,
+	LOG_PREFETCH_UFID = 2
+};
+
 struct __recovery_record {
 	DBT logdbt;	/* log record to apply */
 	DB_LSN lsn;	/* LSN of log record to apply */
 	int fileid;
+	struct log_prefetch_target pf;
 	/* Statement this record belongs to, from the DB_llog_fingerprint record
 	 * preceding it. Stamped while the txn is still in LSN order. */
 	int have_fingerprint;
@@ -3306,6 +3327,8 @@ int berkdb_verify_lsn_written_to_disk(DB_ENV *dbenv, DB_LSN *lsn,
 
 int ufid_for_recovery_record(DB_ENV *env, DB_LSN *lsn,
 	int rectype, u_int8_t *ufid, DBT *dbt, int utxnid_logged);
+int log_prefetch_decode(DBT *dbt, struct log_prefetch_target *pf);
+int log_prefetch_page(DB_ENV *env, struct log_prefetch_target *pf);
 
 int __rep_get_master(DB_ENV *dbenv, char **master, u_int32_t *gen, u_int32_t *egen);
 int __rep_get_eid(DB_ENV *dbenv,char **eid);
@@ -1049,6 +1049,13 @@ __db_close(dbp, txn, flags)
 		__ufid_clear_dbp(dbenv,  dbp);
 	}
 
+	/* Out of the ufid hash, so no new prefault can find the handle; let
+	 * running ones finish */
+	Pthread_mutex_lock(&dbenv->ufid_to_db_lk);
+	while (dbp->ufid_pfcnt > 0)
+		Pthread_cond_wait(&dbenv->ufid_pf_cond, &dbenv->ufid_to_db_lk);
+	Pthread_mutex_unlock(&dbenv->ufid_to_db_lk);
+
 	/* Refresh the structure and close any underlying resources. */
 	ret = __db_refresh(dbp, txn, flags, &deferred_close);
 
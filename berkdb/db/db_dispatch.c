@@ -66,6 +66,8 @@ static const char revid[] = "$Id: db_dispatch.c,v 11.145 2003/09/10 20:31:18 ube
 #include <pthread.h>
 
 #include <logmsg.h>
+#include <thdpool.h>
+#include "comdb2_atomic.h"
 
 static int __db_limbo_fix __P((DB *, DB_TXN *,
 	DB_TXN *, DB_TXNLIST *, db_pgno_t *, DBMETA *, db_limbo_state));
@@ -451,6 +453,143 @@ ufid_for_recovery_record(DB_ENV *env, DB_LSN *lsn, int rectype,
 	return is_fuid;
 }
 
+/* Records ahead of the one being applied whose pages are read in early */
+int gbl_log_prefetch_records = 0;
+int64_t gbl_log_prefetch_pages = 0;
+
+extern struct thdpool *gbl_udppfault_thdpool;
+
+struct log_prefetch_rq {
+	DB_ENV *dbenv;
+	struct log_prefetch_target pf;
+};
+
+static void
+log_prefetch_pp(struct thdpool *pool, void *work, void *thddata, int op)
+{
+	struct log_prefetch_rq *rq = work;
+	struct log_prefetch_target *pf = &rq->pf;
+	DB *dbp;
+
+	switch (op) {
+	case THD_RUN:
+		if (pf->type == LOG_PREFETCH_UFID) {
+			if (__ufid_to_db_prefault(rq->dbenv, &dbp, pf->fuid) == 0) {
+				touch_page(dbp->mpf, pf->pgno);
+				__ufid_prefault_complete(dbp);
+				ATOMIC_ADD64(gbl_log_prefetch_pages, 1);
+			}
+		} else if (__dbreg_id_to_db_prefault(rq->dbenv, NULL, &dbp,
+			pf->fileid, 1) == 0) {
+			touch_page(dbp->mpf, pf->pgno);
+			__dbreg_prefault_complete(rq->dbenv, pf->fileid);
+			ATOMIC_ADD64(gbl_log_prefetch_pages, 1);
+		}
+		break;
+	}
+	free(rq);
+}
+
+/*
+ * log_prefetch_decode --
+ *	Find the page a log record is going to change.  Only page-level btree
+ * and db records are looked at: for those the page number follows the
+ * fileid (and the opcode, for addrem, big and relink).  For pg_alloc it is
+ * the allocated page, which follows the meta page's lsn and number and the
+ * page's own lsn.  Returns 1 and fills in pf if the record has a target.
+ */
+int
+log_prefetch_decode(DBT *dbt, struct log_prefetch_target *pf)
+{
+	u_int32_t rectype;
+	int utxnid_logged, is_fuid = 0;
+	size_t off, pgoff = 0;
+
+	pf->type = LOG_PREFETCH_NONE;
+	if (dbt->data == NULL || dbt->size < sizeof(u_int32_t))
+		return 0;
+
+	LOGCOPY_32(&rectype, dbt->data);
+	utxnid_logged = normalize_rectype(&rectype);
+	if (rectype > 1000 && rectype < 10000) {
+		is_fuid = 1;
+		rectype -= 1000;
+	}
+
+	off = sizeof(u_int32_t) + sizeof(u_int32_t) + sizeof(DB_LSN);
+	if (utxnid_logged)
+		off += sizeof(u_int64_t);
+
+	switch (rectype) {
+	case DB___db_addrem:
+	case DB___db_big:
+	case DB___db_relink:
+		off += sizeof(u_int32_t);
+		break;
+	case DB___bam_split:
+	case DB___bam_rsplit:
+	case DB___bam_adj:
+	case DB___bam_cadjust:
+	case DB___bam_cdel:
+	case DB___bam_repl:
+	case DB___bam_prefix:
+	case DB___bam_pgcompact:
+	case DB___db_ovref:
+	case DB___db_pg_free:
+	case DB___db_pg_freedata:
+	case DB___db_pg_new:
+		break;
+	case DB___db_pg_alloc:
+		pgoff = sizeof(DB_LSN) + sizeof(db_pgno_t) + sizeof(DB_LSN);
+		break;
+	default:
+		return 0;
+	}
+
+	if (dbt->size < off + (is_fuid ? DB_FILE_ID_LEN : sizeof(int32_t)) +
+	    pgoff + sizeof(db_pgno_t))
+		return 0;
+
+	if (is_fuid) {
+		memcpy(pf->fuid, (u_int8_t *)dbt->data + off, DB_FILE_ID_LEN);
+		off += DB_FILE_ID_LEN;
+		pf->type = LOG_PREFETCH_UFID;
+	} else {
+		LOGCOPY_32(&pf->fileid, (u_int8_t *)dbt->data + off);
+		off += sizeof(int32_t);
+		pf->type = LOG_PREFETCH_DBREG;
+	}
+	off += pgoff;
+	LOGCOPY_32(&pf->pgno, (u_int8_t *)dbt->data + off);
+	return 1;
+}
+
+/*
+ * log_prefetch_page --
+ *	Queue an asynchronous read of a decoded target page, so that it is
+ * resident by the time its record is applied.  The read is dropped if the
+ * file is not open by then or the prefault pool is full.  Returns 1 if a
+ * read was queued.
+ */
+int
+log_prefetch_page(DB_ENV *dbenv, struct log_prefetch_target *pf)
+{
+	struct log_prefetch_rq *rq;
+
+	if (pf->type == LOG_PREFETCH_NONE || gbl_udppfault_thdpool == NULL)
+		return 0;
+	if ((rq = malloc(sizeof(*rq))) == NULL)
+		return 0;
+	rq->dbenv = dbenv;
+	rq->pf = *pf;
+	if (thdpool_enqueue(gbl_udppfault_thdpool, log_prefetch_pp, rq, 0,
+		NULL, 0) != 0) {
+		free(rq);
+		return 0;
+	}
+	return 1;
+}
+
 /*
  * __db_dispatch --
  *
@@ -299,6 +299,8 @@ typedef struct __db_locker {
 	u_int8_t has_pglk_lsn;
 	u_int8_t wstatus;  /* master locker waiting, for deadlock detection */
 	int64_t timestamp;  /* wait-die timestamp */
+	u_int32_t nwait;	/* family members blocked (master only) */
+	DB_LOCKOBJ *wait_obj;	/* what the last of them blocked on */
 } DB_LOCKER;
 
 /*
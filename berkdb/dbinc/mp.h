@@ -290,6 +290,9 @@ struct __mpoolfile {
 	u_int32_t  flags;
 
     int32_t    flushed;
+
+	/* Changed-page map for incremental backups (see mp_pgmap.c). */
+	struct __memp_pgmap *pgmap;
 };
 
 /*
@@ -310,10 +313,12 @@ struct __bh {
 #define	BH_TRASH	0x020		/* Page is garbage. */
 #define BH_NOINCR	0x040		/* Don't increment lru_cache. */
 #define BH_PREFAULT	0x080		/* prefault pages */
+#define BH_PROBATION	0x100		/* Not referenced since read in. */
 	u_int16_t	flags;
 	u_int16_t	generation;	/* This changes before page changes */
 	u_int32_t	priority;	/* LRU priority. */
 	u_int32_t	fget_count;	/* Number memp_fgets. */
+	u_int32_t	probation_clock; /* LRU count when read in. */
 	SH_TAILQ_ENTRY(__bh) hq;	/* MPOOL hash bucket queue. */
 
 	db_pgno_t pgno;			/* Underlying MPOOLFILE page number. */
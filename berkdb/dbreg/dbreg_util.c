@@ -652,6 +652,46 @@ __ufid_find_db_for_removal(dbenv, txn, dbpp, inufid, lsnp)
 	return __ufid_to_db_int(dbenv, txn, dbpp, inufid, lsnp, NULL, 0, 0, 1);
 }
 
+/*
+ * __ufid_to_db_prefault --
+ *	Return the open DB for a ufid without trying to open it, and hold it
+ *	open until __ufid_prefault_complete.
+ *
+ * PUBLIC: int __ufid_to_db_prefault __P((DB_ENV *, DB **, u_int8_t *));
+ */
+int
+__ufid_to_db_prefault(dbenv, dbpp, inufid)
+	DB_ENV *dbenv;
+	DB **dbpp;
+	u_int8_t *inufid;
+{
+	struct __ufid_to_db_t *ufid;
+	int ret = ENOENT;
+
+	Pthread_mutex_lock(&dbenv->ufid_to_db_lk);
+	if ((ufid = hash_find(dbenv->ufid_to_db_hash, inufid)) != NULL &&
+	    ufid->dbp != NULL && !ufid->ignore) {
+		*dbpp = ufid->dbp;
+		(*dbpp)->ufid_pfcnt++;
+		ret = 0;
+	}
+	Pthread_mutex_unlock(&dbenv->ufid_to_db_lk);
+	return (ret);
+}
+
+// PUBLIC: void __ufid_prefault_complete __P((DB *));
+void
+__ufid_prefault_complete(dbp)
+	DB *dbp;
+{
+	DB_ENV *dbenv = dbp->dbenv;
+
+	Pthread_mutex_lock(&dbenv->ufid_to_db_lk);
+	if (--dbp->ufid_pfcnt == 0)
+		Pthread_cond_broadcast(&dbenv->ufid_pf_cond);
+	Pthread_mutex_unlock(&dbenv->ufid_to_db_lk);
+}
+
 // PUBLIC: int __ufid_to_fname __P(( DB_ENV *, char **, u_int8_t *));
 int
 __ufid_to_fname(dbenv, fname, inufid)
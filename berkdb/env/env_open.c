@@ -399,6 +399,7 @@ __dbenv_open(dbenv, db_home, flags, mode)
 	}
 	dbenv->ufid_to_db_hash = hash_init(DB_FILE_ID_LEN);
 	Pthread_mutex_init(&dbenv->ufid_to_db_lk, NULL);
+	Pthread_cond_init(&dbenv->ufid_pf_cond, NULL);
 	dbenv->prepared_txn_hash = hash_init_strptr(offsetof(struct __db_txn_prepared, dist_txnid));
 	dbenv->prepared_utxnid_hash = hash_init_o(offsetof(struct __db_txn_prepared, utxnid), sizeof(u_int64_t));
 	dbenv->prepared_children = hash_init(sizeof(u_int64_t));
@@ -88,6 +88,361 @@ int __log_find_latest_checkpoint_before_lsn_try_harder(DB_ENV *dbenv,
 	DB_LOGC *logc, DB_LSN *max_lsn, DB_LSN *foundlsn);
 int gbl_ufid_dbreg_test = 0;
 int gbl_ufid_log = 1;
+extern int gbl_log_prefetch_records;
+
+/*
+ * __db_apprec_prefetch --
+ *	Read ahead of the forward pass with a second cursor, queueing reads of
+ * the pages the next gbl_log_prefetch_records records change.  *ahead is
+ * how many records past the current one are already queued.  Returns
+ * non-zero once there is nothing left to read ahead.
+ */
+static int
+__db_apprec_prefetch(dbenv, logc, data, pf_lsn, stop_lsn, ahead)
+	DB_ENV *dbenv;
+	DB_LOGC *logc;
+	DBT *data;
+	DB_LSN *pf_lsn, *stop_lsn;
+	int *ahead;
+{
+	struct log_prefetch_target pf;
+
+	if (*ahead > 0)
+		(*ahead)--;
+	while (*ahead < gbl_log_prefetch_records) {
+		if (__log_c_get(logc, pf_lsn, data, DB_NEXT) != 0 ||
+		    log_compare(pf_lsn, stop_lsn) > 0)
+			return (1);
+		if (log_prefetch_decode(data, &pf))
+			log_prefetch_page(dbenv, &pf);
+		(*ahead)++;
+	}
+	return (0);
+}
+
+/* Threads redoing page records in the forward pass; 0 redoes them inline */
+int gbl_recovery_redo_threads = 0;
+/* Records redone on the redo threads, by every recovery since startup */
+int64_t gbl_recovery_redo_records = 0;
+
+/* Records queued to the redo threads, across all of them, per thread */
+#define REDO_MAX_QUEUED 1024
+/* Seconds between forward pass progress reports */
+#define REDO_REPORT_INTERVAL 10
+
+struct redo_rec {
+	DB_LSN lsn;
+	u_int32_t rectype;
+	u_int32_t size;
+	struct redo_rec *next;
+	u_int8_t data[1];
+};
+
+struct redo_thd {
+	pthread_t tid;
+	pthread_cond_t cond;
+	struct redo_rec *head, *tail;
+	struct redo_pool *pool;
+};
+
+/*
+ * The forward pass hands page records to the redo threads by file: all of
+ * a file's records go to the same thread, in log order.  Files opened by
+ * recovery are not free-threaded, and this also keeps each page's records
+ * in lsn order.  Everything but the page records is applied by the
+ * scanning thread, once the redo threads have drained.
+ */
+struct redo_pool {
+	DB_ENV *dbenv;
+	pthread_mutex_t lk;
+	pthread_cond_t drained;
+	int nthds;
+	int queued;
+	int stop;
+	int ret;
+	DB_LSN err_lsn;
+	u_int64_t nqueued;	/* only touched by the scanning thread */
+	struct redo_thd *thds;
+};
+
+static void *
+__db_apprec_redo_thd(arg)
+	void *arg;
+{
+	struct redo_thd *thd = arg;
+	struct redo_pool *pool = thd->pool;
+	DB_ENV *dbenv = pool->dbenv;
+	struct redo_rec *rec;
+	DBT dbt;
+	int ret;
+
+	Pthread_mutex_lock(&pool->lk);
+	for (;;) {
+		while (thd->head == NULL && !pool->stop)
+			Pthread_cond_wait(&thd->cond, &pool->lk);
+		if ((rec = thd->head) == NULL)
+			break;
+		if ((thd->head = rec->next) == NULL)
+			thd->tail = NULL;
+		Pthread_mutex_unlock(&pool->lk);
+
+		/* Page records never look at the txnlist: pass none. */
+		memset(&dbt, 0, sizeof(dbt));
+		dbt.data = rec->data;
+		dbt.size = rec->size;
+		ret = dbenv->recover_dtab[rec->rectype](dbenv, &dbt, &rec->lsn,
+		    DB_TXN_FORWARD_ROLL, NULL);
+
+		Pthread_mutex_lock(&pool->lk);
+		if (ret != 0 && (pool->ret == 0 ||
+		    log_compare(&rec->lsn, &pool->err_lsn) < 0)) {
+			pool->ret = ret;
+			pool->err_lsn = rec->lsn;
+		}
+		__os_free(dbenv, rec);
+		if (--pool->queued < pool->nthds * REDO_MAX_QUEUED)
+			Pthread_cond_broadcast(&pool->drained);
+	}
+	Pthread_mutex_unlock(&pool->lk);
+	return (NULL);
+}
+
+static void
+__db_apprec_redo_stop(pool)
+	struct redo_pool *pool;
+{
+	struct redo_rec *rec;
+	int i;
+
+	Pthread_mutex_lock(&pool->lk);
+	pool->stop = 1;
+	for (i = 0; i < pool->nthds; i++)
+		Pthread_cond_signal(&pool->thds[i].cond);
+	Pthread_mutex_unlock(&pool->lk);
+
+	for (i = 0; i < pool->nthds; i++) {
+		Pthread_join(pool->thds[i].tid, NULL);
+		while ((rec = pool->thds[i].head) != NULL) {
+			pool->thds[i].head = rec->next;
+			__os_free(pool->dbenv, rec);
+		}
+		Pthread_cond_destroy(&pool->thds[i].cond);
+	}
+	Pthread_cond_destroy(&pool->drained);
+	Pthread_mutex_destroy(&pool->lk);
+	__os_free(pool->dbenv, pool->thds);
+	__os_free(pool->dbenv, pool);
+}
+
+static int
+__db_apprec_redo_start(dbenv, nthds, poolp)
+	DB_ENV *dbenv;
+	int nthds;
+	struct redo_pool **poolp;
+{
+	struct redo_pool *pool;
+	int i, ret;
+
+	*poolp = NULL;
+	if ((ret = __os_calloc(dbenv, 1, sizeof(*pool), &pool)) != 0)
+		return (ret);
+	if ((ret = __os_calloc(dbenv,
+	    nthds, sizeof(struct redo_thd), &pool->thds)) != 0) {
+		__os_free(dbenv, pool);
+		return (ret);
+	}
+	pool->dbenv = dbenv;
+	Pthread_mutex_init(&pool->lk, NULL);
+	Pthread_cond_init(&pool->drained, NULL);
+	for (i = 0; i < nthds; i++) {
+		pool->thds[i].pool = pool;
+		Pthread_cond_init(&pool->thds[i].cond, NULL);
+		Pthread_create(&pool->thds[i].tid, NULL,
+		    __db_apprec_redo_thd, &pool->thds[i]);
+		pool->nthds++;
+	}
+	*poolp = pool;
+	return (0);
+}
+
+/*
+ * __db_apprec_redo_drain --
+ *	Wait until the redo threads are done with everything queued to them.
+ * Returns the error of the earliest record they failed, and its lsn.
+ */
+static int
+__db_apprec_redo_drain(pool, err_lsn)
+	struct redo_pool *pool;
+	DB_LSN *err_lsn;
+{
+	int ret;
+
+	Pthread_mutex_lock(&pool->lk);
+	while (pool->queued > 0)
+		Pthread_cond_wait(&pool->drained, &pool->lk);
+	if ((ret = pool->ret) != 0)
+		*err_lsn = pool->err_lsn;
+	Pthread_mutex_unlock(&pool->lk);
+	return (ret);
+}
+
+/*
+ * __db_apprec_redo_enqueue --
+ *	Hand a page record of a committed transaction to the thread owning
+ * its file, or drop a page record of any other transaction, which the
+ * forward pass does not redo.  Sets *handled if it did either; otherwise
+ * the caller applies the record itself.
+ */
+static int
+__db_apprec_redo_enqueue(pool, data, lsnp, txninfo, handled)
+	struct redo_pool *pool;
+	DBT *data;
+	DB_LSN *lsnp;
+	void *txninfo;
+	int *handled;
+{
+	DB_ENV *dbenv = pool->dbenv;
+	struct log_prefetch_target pf;
+	struct redo_thd *thd;
+	struct redo_rec *rec;
+	u_int32_t rectype, txnid, h;
+	u_int8_t *fuid;
+	DB *dbp;
+	int i, ret;
+
+	*handled = 0;
+	if (!log_prefetch_decode(data, &pf))
+		return (0);
+	LOGCOPY_32(&rectype, data->data);
+	normalize_rectype(&rectype);
+	if (rectype > 1000)
+		rectype -= 1000;
+	/* pg_new puts its page in limbo, which lives in the txnlist */
+	if (rectype == DB___db_pg_new || rectype >= dbenv->recover_dtab_size ||
+	    dbenv->recover_dtab[rectype] == NULL)
+		return (0);
+
+	/*
+	 * As __db_dispatch: only committed transactions are redone.  The
+	 * exception is pg_alloc, which is undone for the others and can then
+	 * put its page in limbo; the caller applies those.  Redoing it never
+	 * looks at limbo.
+	 */
+	LOGCOPY_32(&txnid, (u_int8_t *)data->data + sizeof(u_int32_t));
+	if (txnid == 0 ||
+	    __db_txnlist_find(dbenv, txninfo, txnid) != TXN_COMMIT) {
+		if (rectype != DB___db_pg_alloc)
+			*handled = 1;
+		return (0);
+	}
+
+	/*
+	 * Pick the thread by the file's uid, whichever way the record names
+	 * the file.  Resolving a dbreg id here also opens the file, so the
+	 * redo threads only ever look it up.
+	 */
+	if (pf.type == LOG_PREFETCH_UFID)
+		fuid = pf.fuid;
+	else {
+		if (__dbreg_id_to_db(dbenv,
+		    NULL, &dbp, pf.fileid, 0, lsnp, 0) != 0 || dbp == NULL)
+			return (0);
+		fuid = dbp->fileid;
+	}
+	for (h = 0, i = 0; i < DB_FILE_ID_LEN; i++)
+		h = h * 31 + fuid[i];
+
+	if ((ret = __os_malloc(dbenv,
+	    sizeof(*rec) + data->size, &rec)) != 0)
+		return (ret);
+	rec->lsn = *lsnp;
+	rec->rectype = rectype;
+	rec->size = data->size;
+	rec->next = NULL;
+	memcpy(rec->data, data->data, data->size);
+
+	thd = &pool->thds[h % pool->nthds];
+	Pthread_mutex_lock(&pool->lk);
+	while (pool->queued >= pool->nthds * REDO_MAX_QUEUED)
+		Pthread_cond_wait(&pool->drained, &pool->lk);
+	if (thd->tail == NULL)
+		thd->head = rec;
+	else
+		thd->tail->next = rec;
+	thd->tail = rec;
+	pool->queued++;
+	Pthread_cond_signal(&thd->cond);
+	Pthread_mutex_unlock(&pool->lk);
+	pool->nqueued++;
+	*handled = 1;
+	return (0);
+}
+
+/*
+ * __db_apprec_redo_inline --
+ *	Whether a record left to the scanning thread can be applied without
+ * draining the redo threads first.  Transaction records only change the
+ * txnlist and the commit bookkeeping, never a page.
+ */
+static int
+__db_apprec_redo_inline(data)
+	DBT *data;
+{
+	u_int32_t rectype;
+
+	LOGCOPY_32(&rectype, data->data);
+	normalize_rectype(&rectype);
+	switch (rectype) {
+	case DB___txn_regop:
+	case DB___txn_regop_gen:
+	case DB___txn_regop_gen_endianize:
+	case DB___txn_regop_rowlocks:
+	case DB___txn_regop_rowlocks_endianize:
+	case DB___txn_dist_commit:
+	case DB___txn_dist_abort:
+	case DB___txn_child:
+	case DB___txn_ckp:
+	case DB___txn_ckp_recovery:
+	case DB___txn_recycle:
+		return (1);
+	default:
+		return (0);
+	}
+}
+
+/*
+ * __db_apprec_report --
+ *	Periodically log the forward pass' rate and how much log is left.
+ */
+static void
+__db_apprec_report(lsnp, stop_lsn, log_size, nrecs, nparallel, start, last, final)
+	DB_LSN *lsnp, *stop_lsn;
+	int32_t log_size;
+	u_int64_t nrecs, nparallel;
+	time_t start, *last;
+	int final;
+{
+	time_t now;
+	u_int64_t left;
+
+	now = time(NULL);
+	if (!final && now - *last < REDO_REPORT_INTERVAL)
+		return;
+	*last = now;
+
+	if (log_compare(lsnp, stop_lsn) >= 0)
+		left = 0;
+	else
+		left = (u_int64_t)(stop_lsn->file - lsnp->file) * log_size +
+		    stop_lsn->offset - lsnp->offset;
+	logmsg(LOGMSG_WARN, "%sforward pass at %u:%u, %lu records "
+	    "(%lu on redo threads) in %lds, %lu records/sec, "
+	    "~%lu bytes of log left to %u:%u\n",
+	    final ? "finished " : "", lsnp->file, lsnp->offset, (u_long)nrecs,
+	    (u_long)nparallel, (long)(now - start),
+	    (u_long)(now > start ? nrecs / (u_int64_t)(now - start) : nrecs),
+	    (u_long)left, stop_lsn->file, stop_lsn->offset);
+}
 
 /* Get the recovery LSN. */
 int
@@ -956,9 +1311,9 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 	DB_LSN *max_lsn, *trunclsn;
 	u_int32_t update, flags;
 {
-	DBT data;
-	DB_LOGC *logc;
-	DB_LSN ckp_lsn, first_lsn, last_lsn, lowlsn, lsn, stop_lsn;
+	DBT data, pf_data;
+	DB_LOGC *logc, *pf_logc;
+	DB_LSN ckp_lsn, first_lsn, last_lsn, lowlsn, lsn, stop_lsn, pf_lsn;
 	DB_REP *db_rep;
 	DB_TXNREGION *region;
 	REP *rep;
@@ -973,10 +1328,17 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 	void *txninfo;
 	DB_LSN logged_checkpoint_lsn;
 	int start_recovery_at_dbregs;
+	int pf_ahead, handled;
+	struct redo_pool *redo;
+	u_int64_t nrecs;
+	time_t redo_start, redo_last;
 
 	COMPQUIET(nfiles, (double)0);
 
 	logc = NULL;
+	pf_logc = NULL;
+	memset(&pf_data, 0, sizeof(pf_data));
+	redo = NULL;
 	ckp_args = NULL;
 	dtab = NULL;
 
@@ -1100,6 +1462,8 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 	 *	specified rollback point).  During this pass, checkpoint
 	 *	file information is ignored, and file openings and closings
 	 *	are redone.
+	 *	With gbl_recovery_redo_threads, page records are redone on
+	 *	threads of their own; see struct redo_pool.
 	 *
 	 * ckp_lsn   -- lsn of the last checkpoint or the first in the log.
 	 * first_lsn -- the lsn where the forward passes begin.
@@ -1446,6 +1810,21 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 
 	logmsg(LOGMSG_WARN, "running forward pass from %u:%u -> %u:%u\n",
 		lsn.file, lsn.offset, stop_lsn.file, stop_lsn.offset);
+	pf_ahead = 0;
+	if (gbl_log_prefetch_records > 0 &&
+	    __log_cursor(dbenv, &pf_logc) == 0) {
+		pf_data.flags = DB_DBT_REALLOC;
+		pf_lsn = lsn;
+		if (__log_c_get(pf_logc, &pf_lsn, &pf_data, DB_SET) != 0) {
+			(void)__log_c_close(pf_logc);
+			pf_logc = NULL;
+		}
+	}
+	if (gbl_recovery_redo_threads > 0 && (ret = __db_apprec_redo_start(
+	    dbenv, gbl_recovery_redo_threads, &redo)) != 0)
+		goto err;
+	nrecs = 0;
+	redo_start = redo_last = time(NULL);
 	for (ret = __log_c_get(logc, &lsn, &data, DB_NEXT);
 		ret == 0; ret = __log_c_get(logc, &lsn, &data, DB_NEXT)) {
 		/*
@@ -1457,6 +1836,12 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 
 		if (log_compare(&lsn, &stop_lsn) > 0)
 			break;
+
+		if (pf_logc != NULL && __db_apprec_prefetch(dbenv, pf_logc,
+			&pf_data, &pf_lsn, &stop_lsn, &pf_ahead) != 0) {
+			(void)__log_c_close(pf_logc);
+			pf_logc = NULL;
+		}
 #if 0
 		progress = 67 + (int)(33 * (__lsn_diff(&first_lsn,
 #else
@@ -1468,6 +1853,20 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 		if (dbenv->db_feedback != NULL) {
 			dbenv->db_feedback(dbenv, DB_RECOVER, progress);
 		}
+		nrecs++;
+		__db_apprec_report(&lsn, &stop_lsn, log_size, nrecs,
+		    redo != NULL ? redo->nqueued : 0, redo_start, &redo_last, 0);
+
+		if (redo != NULL) {
+			if ((ret = __db_apprec_redo_enqueue(redo,
+			    &data, &lsn, txninfo, &handled)) != 0)
+				goto err;
+			if (handled)
+				continue;
+			if (!__db_apprec_redo_inline(&data) &&
+			    (ret = __db_apprec_redo_drain(redo, &lsn)) != 0)
+				goto msgerr;
+		}
 
 		ret = __db_dispatch(dbenv, dbenv->recover_dtab,
 			dbenv->recover_dtab_size, &data, &lsn,
@@ -1481,6 +1880,23 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 
 	}
 
+	if (pf_logc != NULL) {
+		(void)__log_c_close(pf_logc);
+		pf_logc = NULL;
+	}
+	if (redo != NULL &&
+	    (t_ret = __db_apprec_redo_drain(redo, &lsn)) != 0) {
+		ret = t_ret;
+		goto msgerr;
+	}
+	__db_apprec_report(&lsn, &stop_lsn, log_size, nrecs,
+	    redo != NULL ? redo->nqueued : 0, redo_start, &redo_last, 1);
+	if (redo != NULL) {
+		gbl_recovery_redo_records += redo->nqueued;
+		__db_apprec_redo_stop(redo);
+		redo = NULL;
+	}
+
 	if (ret != 0 && ret != DB_NOTFOUND)
 		goto err;
 	dbenv->recovery_pass = DB_TXN_NOT_IN_RECOVERY;
@@ -1690,6 +2106,13 @@ msgerr:	__db_err(dbenv,
 err:	if (logc != NULL && (t_ret = __log_c_close(logc)) != 0 && ret == 0)
 		ret = t_ret;
 
+	if (pf_logc != NULL)
+		(void)__log_c_close(pf_logc);
+	if (redo != NULL)
+		__db_apprec_redo_stop(redo);
+	if (pf_data.data != NULL)
+		__os_ufree(dbenv, pf_data.data);
+
 	if (txninfo != NULL)
 		__db_txnlist_end(dbenv, txninfo);
 
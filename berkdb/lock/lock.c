@@ -44,6 +44,8 @@ static const char revid[] = "$Id: lock.c,v 11.134 2003/11/18 21:30:38 ubell Exp
 #include "thread_stats.h"
 #include "tohex.h"
 #include "txn_properties.h"
+#include "histogram.h"
+#include "comdb2_atomic.h"
 
 #include <bbhrtime.h>
 
@@ -62,6 +64,7 @@ extern int gbl_page_latches;
 extern int gbl_replicant_latches;
 extern int gbl_print_deadlock_cycles;
 extern int gbl_lock_conflict_trace;
+extern int gbl_incremental_deadlock_detect;
 
 /* Experimental Waitdie .. allows us to disable dd entirely */
 int gbl_all_waitdie = 0;
@@ -2153,6 +2156,28 @@ void comdb2_dump_blockers(DB_ENV *dbenv)
 		holdarr[holdix++] = x;                                         \
 	} while (0)
 
+/*
+ * __lock_wait_event --
+ *	Classify a lock object for wait accounting, by its size as
+ *	__collect_lock does.
+ */
+static inline int
+__lock_wait_event(obj)
+	SH_DBT *obj;
+{
+	switch (obj->size) {
+	case sizeof(struct __db_ilock):
+		return (THD_WAIT_LOCK_PAGE);
+	case 30: /* row or keyhash */
+	case 31: /* minmax */
+		return (THD_WAIT_LOCK_ROW);
+	case 32:
+		return (THD_WAIT_LOCK_TABLE);
+	default:
+		return (THD_WAIT_LOCK_OTHER);
+	}
+}
+
 /*
  * __lock_get_internal --
  *
@@ -2184,10 +2209,11 @@ __lock_get_internal_int(lt, locker, in_locker, flags, obj, lock_mode, timeout,
 	uint64_t x1 = 0, x2;
 	struct __db_lock *newl, *lp, *firstlp, *wwrite;
 	DB_ENV *dbenv;
-	DB_LOCKER *sh_locker;
+	DB_LOCKER *sh_locker, *wmaster = NULL;
 	DB_LOCKOBJ *sh_obj;
 	DB_LOCKREGION *region;
 	u_int32_t holder, obj_ndx, ihold, *holdarr = NULL, holdix, holdsz;
+	u_int32_t wobj_gen = 0;
 	extern int gbl_lock_get_verbose_waiter;
 	int verbose_waiter = gbl_lock_get_verbose_waiter;;
 	int grant_dirty, no_dd, ret, t_ret;
@@ -2753,6 +2779,17 @@ upgrade:
 	case GRANT:
 		newl->status = DB_LSTAT_HELD;
 		SH_TAILQ_INSERT_TAIL(&sh_obj->holders, newl, links);
+		/*
+		 * Granting past waiters to a family which is blocked
+		 * elsewhere adds waits-for edges without a new wait;
+		 * leave those to the full detector.
+		 */
+		if (gbl_incremental_deadlock_detect &&
+		    SH_TAILQ_FIRST(&sh_obj->waiters, __db_lock) != NULL &&
+		    ATOMIC_LOAD32((sh_locker->master_locker == INVALID_ROFF ?
+			sh_locker : (DB_LOCKER *)R_ADDR(&lt->reginfo,
+			    sh_locker->master_locker))->nwait) != 0)
+			region->need_dd = 1;
 		if (gbl_bb_berkdb_enable_thread_stats) {
 			struct berkdb_thread_stats *t;
 			struct berkdb_thread_stats *p;
@@ -2829,7 +2866,12 @@ upgrade:
 			}
 		}
 
-		region->need_dd = 1;
+		/*
+		 * The incremental check decides below whether this wait
+		 * can have closed a cycle.
+		 */
+		if (!gbl_incremental_deadlock_detect)
+			region->need_dd = 1;
 
 		/*
 		 * First check to see if this txn has expired.
@@ -2876,10 +2918,14 @@ upgrade:
 
 		/* set waiting status for master_locker */
 		if (sh_locker->master_locker == INVALID_ROFF)
-			sh_locker->wstatus = 1;
+			wmaster = sh_locker;
 		else
-			((DB_LOCKER *)R_ADDR(&lt->reginfo,
-				sh_locker->master_locker))->wstatus = 1;
+			wmaster = (DB_LOCKER *)R_ADDR(&lt->reginfo,
+			    sh_locker->master_locker);
+		wmaster->wstatus = 1;
+		wobj_gen = sh_obj->generation;
+		__atomic_store_n(&wmaster->wait_obj, sh_obj, __ATOMIC_SEQ_CST);
+		ATOMIC_ADD32(wmaster->nwait, 1);
 
 		unlock_locker_partition(region, lpartition);
 
@@ -2899,6 +2945,7 @@ upgrade:
 		if (LF_ISSET(DB_LOCK_SWITCH) &&
 		    (ret = __lock_put_nolock(dbenv,
 			    lock, &ihold, DB_LOCK_NOWAITERS)) != 0) {
+			ATOMIC_ADD32(wmaster->nwait, -1);
 			lock_locker_partition(region, lpartition);
 			lock_obj_partition(region, partition);
 			__lock_remove_waiter(lt, sh_obj, newl, DB_LSTAT_FREE);
@@ -2933,9 +2980,14 @@ upgrade:
 
 		/*
 		 * We are about to wait; before waiting, see if the deadlock
-		 * detector should be run.
+		 * detector should be run.  With incremental detection we
+		 * only run it if this wait may have closed a cycle.
 		 */
-		if (region->detect != DB_LOCK_NORUN && !no_dd)
+		if (region->detect != DB_LOCK_NORUN && !no_dd &&
+		    (!gbl_incremental_deadlock_detect || region->need_dd ||
+			LF_ISSET(DB_LOCK_LOGICAL) ||
+			__lock_dd_incremental(dbenv, wmaster, sh_obj,
+			    wobj_gen)))
 			__lock_detect(dbenv, region->detect, NULL);
 
 		if (gbl_bb_berkdb_enable_lock_timing) {
@@ -2964,6 +3016,11 @@ upgrade:
 			t->n_lock_waits++;
 			t->n_locks++;
 			p->n_locks++;
+			if (gbl_bb_berkdb_enable_lock_timing) {
+				latency_histogram_add(LATENCY_LOCK_WAIT, d);
+				bb_berkdb_thread_wait(
+				    __lock_wait_event(&sh_obj->lockobj), d);
+			}
 
 			if (gbl_bb_log_lock_waits_fn) {
 				/* We had to wait on this lock - call our
@@ -2977,6 +3034,7 @@ upgrade:
 		LOCKREGION(dbenv, (DB_LOCKTAB *)dbenv->lk_handle);
 		lock_locker_partition(region, lpartition);
 		lock_obj_partition(region, partition);
+		ATOMIC_ADD32(wmaster->nwait, -1);
 
 		/* Turn off lock timeout. */
 		if (newl->status != DB_LSTAT_EXPIRED)
@@ -4322,6 +4380,8 @@ __lock_getlocker_int(lt, locker, indx, partition, create, prop, retp,
 			sh_locker->maxtrackedlocks = 0;
 			sh_locker->tracked_locklist = NULL;
 			sh_locker->wstatus = 0;
+			sh_locker->nwait = 0;
+			sh_locker->wait_obj = NULL;
 			for (i = 0; i < num; ++i, ++sh_locker)
 				SH_TAILQ_INSERT_HEAD(&region->
 				    free_lockers[partition], sh_locker, links,
@@ -4356,6 +4416,8 @@ __lock_getlocker_int(lt, locker, indx, partition, create, prop, retp,
 		sh_locker->lk_timeout = 0;
 		sh_locker->partition = partition;
 		sh_locker->wstatus = 0;
+		sh_locker->nwait = 0;
+		sh_locker->wait_obj = NULL;
 		LOCK_SET_TIME_INVALID(&sh_locker->tx_expire);
 		LOCK_SET_TIME_INVALID(&sh_locker->lk_expire);
 
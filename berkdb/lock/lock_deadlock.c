@@ -33,6 +33,7 @@ static const char revid[] = "$Id: lock_deadlock.c,v 11.66 2003/11/19 19:59:02 ub
 #include "debug_switches.h"
 #include "logmsg.h"
 #include "sys_wrap.h"
+#include "comdb2_atomic.h"
 
 extern int verbose_deadlocks;
 extern int gbl_sparse_lockerid_map;
@@ -466,6 +467,174 @@ __dd_print_tracked(idmap, deadmap, nlockers, victim)
 uint64_t detect_skip = 0;
 uint64_t detect_run = 0;
 
+/*
+ * Incremental detection: a new wait adds edges from the waiting family to
+ * the holders of one object, so the only cycles it can close go through
+ * those edges.  Rather than rebuilding the whole waits-for matrix, walk
+ * from those holders along what each blocked family is waiting on, and
+ * only run the full detector (which still picks the victim) if we get back
+ * to the waiter or cannot tell.
+ */
+int gbl_incremental_deadlock_detect = 0;
+uint64_t dd_incremental_checks = 0;
+uint64_t dd_incremental_fallbacks = 0;
+
+/* Families one incremental check may visit before giving up */
+#define DD_INCR_MAXNODES 128
+
+static inline DB_LOCKER *
+__dd_master(lt, lockerp)
+	DB_LOCKTAB *lt;
+	DB_LOCKER *lockerp;
+{
+	if (lockerp->master_locker == INVALID_ROFF)
+		return (lockerp);
+	return ((DB_LOCKER *)R_ADDR(&lt->reginfo, lockerp->master_locker));
+}
+
+/*
+ * __dd_incr_push --
+ *	Push the masters of the granted holders of op, which the family of
+ *	from waits on, onto the stack.  Called with op's partition locked.
+ *	Returns 1 if we got back to self, or ran out of room, or from both
+ *	holds op and waits behind another waiter for it: the full detector
+ *	counts that as a deadlock with itself (see self_wait in __dd_build).
+ */
+static int
+__dd_incr_push(lt, op, self, from, stack, nstack)
+	DB_LOCKTAB *lt;
+	DB_LOCKOBJ *op;
+	DB_LOCKER *self, *from;
+	DB_LOCKER **stack;
+	int *nstack;
+{
+	struct __db_lock *lp;
+	DB_LOCKER *m;
+	int holds;
+
+	holds = 0;
+	for (lp = SH_TAILQ_FIRST(&op->holders, __db_lock);
+	    lp != NULL; lp = SH_TAILQ_NEXT(lp, links, __db_lock)) {
+		if (lp->status != DB_LSTAT_HELD || lp->holderp == NULL)
+			continue;
+		m = __dd_master(lt, lp->holderp);
+		if (m == from) {
+			holds = 1;
+			continue;
+		}
+		if (m == self || *nstack == DD_INCR_MAXNODES)
+			return (1);
+		stack[(*nstack)++] = m;
+	}
+	if (holds) {
+		lp = SH_TAILQ_FIRST(&op->waiters, __db_lock);
+		if (lp == NULL || lp->holderp == NULL ||
+		    __dd_master(lt, lp->holderp) != from)
+			return (1);
+	}
+	return (0);
+}
+
+/*
+ * __lock_dd_incremental --
+ *	The family of master has just blocked on obj.  Return 0 if that
+ *	cannot have closed a deadlock cycle, 1 if it may have and the full
+ *	detector should run.
+ *
+ * PUBLIC: int __lock_dd_incremental
+ * PUBLIC:     __P((DB_ENV *, DB_LOCKER *, DB_LOCKOBJ *, u_int32_t));
+ */
+int
+__lock_dd_incremental(dbenv, master, obj, generation)
+	DB_ENV *dbenv;
+	DB_LOCKER *master;
+	DB_LOCKOBJ *obj;
+	u_int32_t generation;
+{
+	DB_LOCKTAB *lt;
+	DB_LOCKREGION *region;
+	DB_LOCKER *stack[DD_INCR_MAXNODES], *seen[DD_INCR_MAXNODES], *m;
+	DB_LOCKOBJ *op;
+	struct __db_lock *lp;
+	u_int32_t partition;
+	int i, nstack, nseen, ret;
+
+	lt = dbenv->lk_handle;
+	region = lt->reginfo.primary;
+	++dd_incremental_checks;
+
+	/*
+	 * Wait-die and lock timeouts are resolved by the full detector;
+	 * let it run whenever either is in play.
+	 */
+	if (master->timestamp > 0 ||
+	    LOCK_TIME_ISVALID(&region->next_timeout))
+		goto fallback;
+
+	nstack = nseen = 0;
+	partition = obj->partition;
+	lock_obj_partition(region, partition);
+	if (partition != obj->partition || generation != obj->generation) {
+		unlock_obj_partition(region, partition);
+		goto fallback;
+	}
+	ret = __dd_incr_push(lt, obj, NULL, master, stack, &nstack);
+	unlock_obj_partition(region, partition);
+	if (ret)
+		goto fallback;
+
+	while (nstack > 0) {
+		m = stack[--nstack];
+		for (i = 0; i < nseen && seen[i] != m; i++)
+			;
+		if (i < nseen)
+			continue;
+		if (nseen == DD_INCR_MAXNODES || m->timestamp > 0)
+			goto fallback;
+		seen[nseen++] = m;
+
+		/*
+		 * A family which is not blocked adds no edges; one with
+		 * several members blocked is more than we track.
+		 */
+		switch (ATOMIC_LOAD32(m->nwait)) {
+		case 0:
+			continue;
+		case 1:
+			break;
+		default:
+			goto fallback;
+		}
+		op = __atomic_load_n(&m->wait_obj, __ATOMIC_SEQ_CST);
+		if (op == NULL)
+			goto fallback;
+
+		partition = op->partition;
+		lock_obj_partition(region, partition);
+		if (partition != op->partition) {
+			unlock_obj_partition(region, partition);
+			goto fallback;
+		}
+		/* Make sure wait_obj is still what the family waits on. */
+		for (lp = SH_TAILQ_FIRST(&op->waiters, __db_lock);
+		    lp != NULL; lp = SH_TAILQ_NEXT(lp, links, __db_lock))
+			if (lp->status == DB_LSTAT_WAITING &&
+			    lp->holderp != NULL &&
+			    __dd_master(lt, lp->holderp) == m)
+				break;
+		ret = lp == NULL ||
+		    __dd_incr_push(lt, op, master, m, stack, &nstack);
+		unlock_obj_partition(region, partition);
+		if (ret)
+			goto fallback;
+	}
+	return (0);
+
+fallback:
+	++dd_incremental_fallbacks;
+	return (1);
+}
+
 #define LOCK_DETECT_Q 1
 
 #if LOCK_DETECT_Q
@@ -44,6 +44,7 @@ static const char revid[] = "$Id: log_put.c,v 11.145 2003/09/13 19:20:39 bostic
 #include <netinet/in.h>
 
 #include "logmsg.h"
+#include "thread_stats.h"
 #include <sys_wrap.h>
 #include <poll.h>
 
@@ -989,9 +990,12 @@ __log_flush_commit(dbenv, lsnp, flags)
 	 * DB_LOG_WRNOSYNC:
 	 *	If there's anything in the current log buffer, write it out.
 	 */
-	if (LF_ISSET(DB_FLUSH))
+	if (LF_ISSET(DB_FLUSH)) {
+		uint64_t start_us = bb_berkdb_fasttime();
 		ret = __log_flush_int(dblp, &flush_lsn, 1);
-	else if (!__inmemory_buf_empty(lp)) {
+		bb_berkdb_thread_wait(THD_WAIT_LOG_FLUSH,
+		    bb_berkdb_fasttime() - start_us);
+	} else if (!__inmemory_buf_empty(lp)) {
 		if ((ret = __write_inmemory_buffer(dblp, 1)) == 0)
 			lp->b_off = 0;
 	}
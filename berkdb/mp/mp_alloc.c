@@ -550,6 +550,8 @@ found:		if (offsetp != NULL)
 				__memp_bad_buffer(hp);
 			goto next_hb;
 		}
+		if (F_ISSET(bhp, BH_PROBATION))
+			++c_mp->stat.st_probation_evict;
 
 		/*
 		 * Check to see if the buffer is the size we're looking for.
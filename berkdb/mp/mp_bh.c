@@ -988,6 +988,7 @@ __memp_pgwrite_multi(dbenv, dbmfp, hps, bhps, numpages, wrrec)
 		__os_fsync(dbenv, dbmfp->fhp);
 
 	mfp->file_written = 1;
+	__memp_pgmap_mark(dbenv, mfp, bhps[0]->pgno, numpages);
 	mfp->stat.st_page_out += numpages;
 	mfp->stat.st_rw_merges += numpages - 1;
 
@@ -44,11 +44,14 @@ static const char revid[] = "$Id: mp_fget.c,v 11.81 2003/09/25 02:15:16 sue Exp
 #include "thrman.h"
 #include "thread_util.h"
 #include "thread_stats.h"
+#include "histogram.h"
 
 
 struct bdb_state_tag;
 typedef struct bdb_state_tag bdb_state_type;
 
+extern int gbl_memp_probation_pct;
+extern int gbl_memp_probation_min_age_pct;
 extern int gbl_prefault_udp;
 extern __thread int send_prefault_udp;
 extern __thread DB *prefault_dbp;
@@ -740,6 +743,16 @@ alloc:		/*
 				F_CLR(bhp, BH_PREFAULT);
 			}
 
+			/*
+			 * Until it is referenced again the page is a
+			 * candidate for early eviction, see __memp_fput.
+			 */
+			if (gbl_memp_probation_pct > 0 &&
+			    flags != DB_MPOOL_NOCACHE) {
+				F_SET(bhp, BH_PROBATION);
+				bhp->probation_clock = c_mp->lru_count;
+			}
+
 			gbl_memp_pgreads++;
 			if (did_io != NULL)
 				*did_io = 1;
@@ -772,6 +785,18 @@ alloc:		/*
 
 	/* from patch */
 	if (state != SECOND_MISS && bhp->ref == 1) {
+		/*
+		 * Promote a page on probation only if it comes back once
+		 * enough of the pool has been released since it was read in.
+		 */
+		if (F_ISSET(bhp, BH_PROBATION) &&
+		    c_mp->lru_count >= bhp->probation_clock &&
+		    c_mp->lru_count - bhp->probation_clock >=
+		    (u_int32_t)(c_mp->stat.st_pages *
+		    gbl_memp_probation_min_age_pct / 100)) {
+			F_CLR(bhp, BH_PROBATION);
+			++c_mp->stat.st_probation_promote;
+		}
 		bhp->priority = UINT32_T_MAX;
 		if (SH_TAILQ_FIRST(&hp->hash_bucket, __bh) !=
 		    SH_TAILQ_LAST(&hp->hash_bucket, HashTab)) {
@@ -808,11 +833,16 @@ alloc:		/*
 
 
 	if (F_ISSET(bhp, BH_TRASH)) {
+		uint64_t pgread_us = bb_berkdb_fasttime();
+
 		if ((ret = __memp_pgread(dbmfp,
 				hp, bhp,
 			    LF_ISSET(DB_MPOOL_CREATE) ? 1 : 0,
 			    is_recovery_page)) != 0)
 			 goto err;
+		pgread_us = bb_berkdb_fasttime() - pgread_us;
+		latency_histogram_add(LATENCY_PAGE_IN, pgread_us);
+		bb_berkdb_thread_wait(THD_WAIT_PAGE_IN, pgread_us);
 
 		if (state == SECOND_MISS) {
 			if (ISINTERNAL(bhp->buf))
@@ -649,7 +649,7 @@ __memp_fopen(dbmfp, mfp, path, flags, mode, pagesize)
 	db_pgno_t last_pgno;
 	size_t maxmap;
 	u_int32_t mbytes, bytes, oflags;
-	int refinc, ret;
+	int refinc, ret, t_ret;
 	char *rpath, *recp_path, *recp_ext;
 	struct __fileid_mpf *fileid_mpf;
 	void *p;
@@ -1102,6 +1102,16 @@ check_map:
 		}
 	}
 
+	/*
+	 * Track which pages get written, for incremental backups.  The map
+	 * is optional: without one the next backup reads the whole file.
+	 */
+	if (!F_ISSET(dbmfp, MP_READONLY) &&
+	    (t_ret = __memp_pgmap_open(dbenv, mfp)) != 0)
+		logmsg(LOGMSG_WARN, "%s: can't create changed-page map, next "
+		    "backup of it will be full: %s\n", path,
+		    db_strerror(t_ret));
+
 	F_SET(dbmfp, MP_OPEN_CALLED);
 
 	/*
@@ -1450,6 +1460,7 @@ __memp_mf_discard(dbmp, mfp)
 	 */
 	if (mfp->file_written && !mfp->deadfile)
 		ret = __memp_mf_sync(dbmp, mfp);
+	__memp_pgmap_close(dbenv, mfp);
 
 	/*
 	 * We have to release the MPOOLFILE lock before acquiring the region
@@ -26,6 +26,20 @@ static const char revid[] = "$Id: mp_fput.c,v 11.48 2003/09/30 17:12:00 sue Exp
 
 extern int gbl_enable_cache_internal_nodes;
 
+/*
+ * Percentage of the pool by which a page that has not been referenced again
+ * since it was read in is aged on release.  A single pass over a large file
+ * then recycles its own pages instead of evicting the working set.
+ */
+int gbl_memp_probation_pct = 0;
+
+/*
+ * A page on probation is only promoted when it is fetched again after at
+ * least this percentage of the pool has been released since it was read in,
+ * so a cursor coming back for the next row of the same page does not count.
+ */
+int gbl_memp_probation_min_age_pct = 25;
+
 static void __memp_reset_lru __P((DB_ENV *, REGINFO *));
 
 /*
@@ -248,6 +262,11 @@ __memp_fput_internal(dbmfp, pgaddr, flags, pgorder)
 		    TYPE(pgaddr) == P_IBTREE)
 			adjust += c_mp->stat.st_pages / MPOOL_PRI_INTERNAL;
 
+		/* Age pages no one has come back for since they were read. */
+		if (F_ISSET(bhp, BH_PROBATION))
+			adjust -= (int)(c_mp->stat.st_pages *
+			    gbl_memp_probation_pct / 100);
+
 		if (adjust > 0) {
 			if (UINT32_T_MAX - bhp->priority >= (u_int32_t)adjust)
 				bhp->priority += adjust;
@@ -377,10 +396,15 @@ __memp_reset_lru(dbenv, memreg)
 
 		MUTEX_LOCK(dbenv, &hp->hash_mutex);
 		for (bhp = SH_TAILQ_FIRST(&hp->hash_bucket, __bh);
-		    bhp != NULL; bhp = SH_TAILQ_NEXT(bhp, hq, __bh))
+		    bhp != NULL; bhp = SH_TAILQ_NEXT(bhp, hq, __bh)) {
 			if (bhp->priority != UINT32_T_MAX &&
 			    bhp->priority > MPOOL_BASE_DECREMENT)
 				bhp->priority -= MPOOL_BASE_DECREMENT;
+			if (bhp->probation_clock > MPOOL_BASE_DECREMENT)
+				bhp->probation_clock -= MPOOL_BASE_DECREMENT;
+			else
+				bhp->probation_clock = 0;
+		}
 		MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
 	}
 }
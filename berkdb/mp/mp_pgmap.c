@@ -0,0 +1,435 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Changed-page maps for incremental backups.
+ *
+ * For each data file we keep, per chunk of pages, the clock value at which a
+ * page in that chunk was last written (see pgmap.h for the format and what
+ * the clock means).  The maps are written out after every mpool sync, so
+ * that a backup which reads the checkpoint file first and the map second
+ * sees every page written before that checkpoint.  Pages written later
+ * carry only changes that recovery from that checkpoint will replay.
+ *
+ * If we crash, pages written since the map was last written are not in it.
+ * A map is marked unclean while its file is open, and on the next open an
+ * unclean map is restarted with valid_from past anything it could have
+ * handed out, so the next incremental falls back to reading the whole file.
+ */
+
+#include "db_config.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "db_int.h"
+#include "dbinc/db_shash.h"
+#include "dbinc/log.h"
+#include "dbinc/mp.h"
+
+#include <list.h>
+#include <pgmap.h>
+#include "logmsg.h"
+#include "sys_wrap.h"
+
+int gbl_pgmap_enable = 0;
+int gbl_pgmap_chunk_pages = 64;
+
+struct __memp_pgmap {
+	pthread_mutex_t lk;
+	char *path;
+	u_int8_t fileid[DB_FILE_ID_LEN];
+	u_int32_t chunk_pages;
+	u_int32_t valid_from;
+	u_int32_t clock;
+	u_int32_t nchunks;
+	u_int32_t *clocks;
+	int dirty;
+	LINKC_T(struct __memp_pgmap) lnk;
+};
+
+static pthread_mutex_t pgmap_lk = PTHREAD_MUTEX_INITIALIZER;
+static LISTC_T(struct __memp_pgmap) pgmaps;
+static int pgmaps_inited;
+
+static u_int32_t
+pgmap_logfile(dbenv)
+	DB_ENV *dbenv;
+{
+	DB_LOG *dblp;
+	LOG *lp;
+
+	if ((dblp = dbenv->lg_handle) == NULL)
+		return (0);
+	lp = dblp->reginfo.primary;
+	return (lp->lsn.file);
+}
+
+static int
+pgmap_path(dbenv, mfp, pathp)
+	DB_ENV *dbenv;
+	MPOOLFILE *mfp;
+	char **pathp;
+{
+	DB_MPOOL *dbmp;
+	char *rpath, *slash, *path;
+	size_t len;
+	int ret;
+
+	dbmp = dbenv->mp_handle;
+	if ((ret = __db_appname(dbenv, DB_APP_DATA,
+	    R_ADDR(dbmp->reginfo, mfp->path_off), 0, NULL, &rpath)) != 0)
+		return (ret);
+
+	len = strlen(rpath) + sizeof(PGMAP_DIR) + 2;
+	if ((ret = __os_malloc(dbenv, len, &path)) != 0) {
+		__os_free(dbenv, rpath);
+		return (ret);
+	}
+	if ((slash = strrchr(rpath, '/')) != NULL) {
+		*slash = '\0';
+		snprintf(path, len, "%s/%s", rpath, PGMAP_DIR);
+		(void)mkdir(path, 0755);
+		snprintf(path, len, "%s/%s/%s", rpath, PGMAP_DIR, slash + 1);
+	} else {
+		(void)mkdir(PGMAP_DIR, 0755);
+		snprintf(path, len, "%s/%s", PGMAP_DIR, rpath);
+	}
+	__os_free(dbenv, rpath);
+	*pathp = path;
+	return (0);
+}
+
+/*
+ * Write a map out under a temporary name and rename it into place.  The
+ * caller must not hold map->lk.
+ */
+static int
+pgmap_write(dbenv, map, clean)
+	DB_ENV *dbenv;
+	struct __memp_pgmap *map;
+	int clean;
+{
+	struct pgmap_header hdr = {0};
+	u_int32_t *clocks;
+	char *tmp;
+	size_t len, sz;
+	int fd, ret;
+
+	clocks = NULL;
+	len = strlen(map->path) + 5;
+	if ((ret = __os_malloc(dbenv, len, &tmp)) != 0)
+		return (ret);
+	snprintf(tmp, len, "%s.tmp", map->path);
+
+	Pthread_mutex_lock(&map->lk);
+	hdr.magic = PGMAP_MAGIC;
+	hdr.version = PGMAP_VERSION;
+	memcpy(hdr.fileid, map->fileid, DB_FILE_ID_LEN);
+	hdr.chunk_pages = map->chunk_pages;
+	hdr.clean = clean;
+	hdr.valid_from = map->valid_from;
+	hdr.clock = map->clock;
+	hdr.nchunks = map->nchunks;
+	sz = map->nchunks * sizeof(u_int32_t);
+	if (sz && (ret = __os_malloc(dbenv, sz, &clocks)) != 0) {
+		Pthread_mutex_unlock(&map->lk);
+		goto done;
+	}
+	if (sz)
+		memcpy(clocks, map->clocks, sz);
+	map->dirty = 0;
+	Pthread_mutex_unlock(&map->lk);
+
+	if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1) {
+		ret = errno;
+		goto err;
+	}
+	if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+	    (sz && write(fd, clocks, sz) != (ssize_t)sz) || fsync(fd) != 0) {
+		ret = errno ? errno : EIO;
+		Close(fd);
+		goto err;
+	}
+	Close(fd);
+	if (rename(tmp, map->path) != 0) {
+		ret = errno;
+		goto err;
+	}
+	goto done;
+
+err:	logmsg(LOGMSG_ERROR, "%s: failed to write %s: %s\n", __func__,
+	    map->path, strerror(ret));
+	(void)unlink(tmp);
+	/* Try again at the next sync. */
+	Pthread_mutex_lock(&map->lk);
+	map->dirty = 1;
+	Pthread_mutex_unlock(&map->lk);
+done:	if (clocks)
+		__os_free(dbenv, clocks);
+	__os_free(dbenv, tmp);
+	return (ret);
+}
+
+/*
+ * Load the map left by a previous open of the file.  Returns 0 if it can be
+ * carried on with, non-0 if the map has to be started afresh.
+ */
+static int
+pgmap_load(dbenv, map)
+	DB_ENV *dbenv;
+	struct __memp_pgmap *map;
+{
+	struct pgmap_header hdr;
+	size_t sz;
+	int fd, ret;
+
+	if ((fd = open(map->path, O_RDONLY)) == -1)
+		return (ENOENT);
+
+	ret = EINVAL;
+	if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+	    hdr.magic != PGMAP_MAGIC || hdr.version != PGMAP_VERSION ||
+	    memcmp(hdr.fileid, map->fileid, DB_FILE_ID_LEN) != 0 ||
+	    hdr.chunk_pages != map->chunk_pages)
+		goto done;
+
+	/* Its clock carries on regardless, so that it never goes backwards. */
+	if (hdr.clock > map->clock)
+		map->clock = hdr.clock;
+	if (!hdr.clean)
+		goto done;
+
+	sz = hdr.nchunks * sizeof(u_int32_t);
+	if (sz && (ret = __os_malloc(dbenv, sz, &map->clocks)) != 0)
+		goto done;
+	if (sz && read(fd, map->clocks, sz) != (ssize_t)sz) {
+		__os_free(dbenv, map->clocks);
+		map->clocks = NULL;
+		ret = EINVAL;
+		goto done;
+	}
+	map->nchunks = hdr.nchunks;
+	map->valid_from = hdr.valid_from;
+	ret = 0;
+
+done:	Close(fd);
+	return (ret);
+}
+
+/*
+ * __memp_pgmap_open --
+ *	Start tracking writes to a file which is being opened.
+ *
+ * PUBLIC: int __memp_pgmap_open __P((DB_ENV *, MPOOLFILE *));
+ */
+int
+__memp_pgmap_open(dbenv, mfp)
+	DB_ENV *dbenv;
+	MPOOLFILE *mfp;
+{
+	struct __memp_pgmap *map;
+	u_int32_t logfile;
+	int ret;
+
+	if (!gbl_pgmap_enable || mfp->pgmap != NULL || mfp->path_off == 0 ||
+	    F_ISSET(mfp, MP_TEMP) || mfp->no_backing_file)
+		return (0);
+
+	if ((ret = __os_calloc(dbenv, 1, sizeof(*map), &map)) != 0)
+		return (ret);
+	if ((ret = pgmap_path(dbenv, mfp, &map->path)) != 0) {
+		__os_free(dbenv, map);
+		return (ret);
+	}
+	Pthread_mutex_init(&map->lk, NULL);
+	memcpy(map->fileid, mfp->fileid, DB_FILE_ID_LEN);
+	map->chunk_pages =
+	    gbl_pgmap_chunk_pages > 0 ? gbl_pgmap_chunk_pages : 1;
+
+	logfile = pgmap_logfile(dbenv);
+	if (pgmap_load(dbenv, map) != 0) {
+		/*
+		 * No usable history: nothing before now can be compared
+		 * against this map.
+		 */
+		if (logfile > map->clock)
+			map->clock = logfile;
+		map->clock++;
+		map->valid_from = map->clock;
+	} else if (logfile > map->clock)
+		map->clock = logfile;
+
+	/*
+	 * Mark it unclean on disk before any page can be written.  If we
+	 * can't, remove the old map: writes from now on won't be in it, so
+	 * the next backup has to read the whole file.
+	 */
+	if ((ret = pgmap_write(dbenv, map, 0)) != 0) {
+		if (unlink(map->path) != 0 && errno != ENOENT)
+			logmsg(LOGMSG_ERROR, "%s: can't remove stale map %s: %s\n",
+			    __func__, map->path, strerror(errno));
+		Pthread_mutex_destroy(&map->lk);
+		if (map->clocks)
+			__os_free(dbenv, map->clocks);
+		__os_free(dbenv, map->path);
+		__os_free(dbenv, map);
+		return (ret);
+	}
+
+	MUTEX_LOCK(dbenv, &mfp->mutex);
+	if (mfp->pgmap != NULL) {
+		/* Lost a race with another opener; theirs is as good. */
+		MUTEX_UNLOCK(dbenv, &mfp->mutex);
+		Pthread_mutex_destroy(&map->lk);
+		if (map->clocks)
+			__os_free(dbenv, map->clocks);
+		__os_free(dbenv, map->path);
+		__os_free(dbenv, map);
+		return (0);
+	}
+	Pthread_mutex_lock(&pgmap_lk);
+	if (!pgmaps_inited) {
+		listc_init(&pgmaps, offsetof(struct __memp_pgmap, lnk));
+		pgmaps_inited = 1;
+	}
+	listc_abl(&pgmaps, map);
+	Pthread_mutex_unlock(&pgmap_lk);
+	mfp->pgmap = map;
+	MUTEX_UNLOCK(dbenv, &mfp->mutex);
+	return (0);
+}
+
+/*
+ * __memp_pgmap_mark --
+ *	Record that npages pages starting at pgno have been written.
+ *
+ * PUBLIC: void __memp_pgmap_mark
+ * PUBLIC:     __P((DB_ENV *, MPOOLFILE *, db_pgno_t, int));
+ */
+void
+__memp_pgmap_mark(dbenv, mfp, pgno, npages)
+	DB_ENV *dbenv;
+	MPOOLFILE *mfp;
+	db_pgno_t pgno;
+	int npages;
+{
+	struct __memp_pgmap *map;
+	u_int32_t first, last, logfile, n, *clocks;
+
+	if ((map = mfp->pgmap) == NULL)
+		return;
+
+	logfile = pgmap_logfile(dbenv);
+	first = pgno / map->chunk_pages;
+	last = (pgno + npages - 1) / map->chunk_pages;
+
+	Pthread_mutex_lock(&map->lk);
+	if (logfile > map->clock)
+		map->clock = logfile;
+	if (last >= map->nchunks) {
+		n = map->nchunks ? map->nchunks : 16;
+		while (n <= last)
+			n *= 2;
+		clocks = map->clocks;
+		if (__os_realloc(dbenv, n * sizeof(u_int32_t), &clocks) != 0) {
+			/*
+			 * Can't record this write, so nothing before it can
+			 * be trusted.
+			 */
+			map->clock++;
+			map->valid_from = map->clock;
+			map->dirty = 1;
+			Pthread_mutex_unlock(&map->lk);
+			return;
+		}
+		/* Not written since valid_from */
+		memset(clocks + map->nchunks, 0,
+		    (n - map->nchunks) * sizeof(u_int32_t));
+		map->clocks = clocks;
+		map->nchunks = n;
+	}
+	for (n = first; n <= last; n++)
+		map->clocks[n] = map->clock;
+	map->dirty = 1;
+	Pthread_mutex_unlock(&map->lk);
+}
+
+/*
+ * __memp_pgmap_sync --
+ *	Write out every map which has changed.  Called once mpool has been
+ *	synced.
+ *
+ * PUBLIC: void __memp_pgmap_sync __P((DB_ENV *));
+ */
+void
+__memp_pgmap_sync(dbenv)
+	DB_ENV *dbenv;
+{
+	struct __memp_pgmap *map;
+
+	if (!gbl_pgmap_enable)
+		return;
+
+	Pthread_mutex_lock(&pgmap_lk);
+	if (pgmaps_inited) {
+		LISTC_FOR_EACH(&pgmaps, map, lnk) {
+			if (map->dirty)
+				(void)pgmap_write(dbenv, map, 0);
+		}
+	}
+	Pthread_mutex_unlock(&pgmap_lk);
+}
+
+/*
+ * __memp_pgmap_close --
+ *	Stop tracking a file.  Its map is written out as clean, or removed if
+ *	the file is gone.  The file must have been synced.
+ *
+ * PUBLIC: void __memp_pgmap_close __P((DB_ENV *, MPOOLFILE *));
+ */
+void
+__memp_pgmap_close(dbenv, mfp)
+	DB_ENV *dbenv;
+	MPOOLFILE *mfp;
+{
+	struct __memp_pgmap *map;
+
+	if ((map = mfp->pgmap) == NULL)
+		return;
+	mfp->pgmap = NULL;
+
+	Pthread_mutex_lock(&pgmap_lk);
+	listc_rfl(&pgmaps, map);
+	Pthread_mutex_unlock(&pgmap_lk);
+
+	if (mfp->deadfile)
+		(void)unlink(map->path);
+	else
+		(void)pgmap_write(dbenv, map, 1);
+
+	Pthread_mutex_destroy(&map->lk);
+	if (map->clocks)
+		__os_free(dbenv, map->clocks);
+	__os_free(dbenv, map->path);
+	__os_free(dbenv, map);
+}
@@ -299,6 +299,8 @@ __memp_dbenv_refresh(dbenv)
 {
 	DB_MPOOL *dbmp;
 	DB_MPOOLFILE *dbmfp;
+	MPOOL *mp;
+	MPOOLFILE *mfp;
 	u_int32_t i;
 	int ret, t_ret;
 
@@ -310,6 +312,12 @@ __memp_dbenv_refresh(dbenv)
 		if ((t_ret = __memp_fclose(dbmfp, 0)) != 0 && ret == 0)
 			ret = t_ret;
 
+	/* Files with pages still cached keep their changed-page maps. */
+	mp = dbmp->reginfo[0].primary;
+	for (mfp = SH_TAILQ_FIRST(&mp->mpfq, __mpoolfile);
+	    mfp != NULL; mfp = SH_TAILQ_NEXT(mfp, q, __mpoolfile))
+		__memp_pgmap_close(dbenv, mfp);
+
 	/* Discard the thread mutex. */
 	if (dbmp->mutexp != NULL)
 		__db_mutex_free(dbenv, dbmp->reginfo, dbmp->mutexp);
@@ -136,6 +136,10 @@ __memp_stat(dbenv, gspp, fspp, flags)
 			sp->st_ro_levict += c_mp->stat.st_ro_levict;
 			sp->st_rw_levict += c_mp->stat.st_rw_levict;
 			sp->st_pf_evict += c_mp->stat.st_pf_evict;
+			sp->st_probation_evict +=
+			    c_mp->stat.st_probation_evict;
+			sp->st_probation_promote +=
+			    c_mp->stat.st_probation_promote;
 			sp->st_rw_evict_skip += c_mp->stat.st_rw_evict_skip;
 			sp->st_page_trickle += c_mp->stat.st_page_trickle;
 			sp->st_pages += c_mp->stat.st_pages;
@@ -416,6 +416,12 @@ __memp_sync_restartable(dbenv, lsnp, restartable, fixed)
 	    restartable, (dbenv->tx_perfect_ckp ? lsnp : NULL), fixed)) != 0)
 		 return (ret);
 
+	/*
+	 * Everything written so far is on disk; so is the changed-page map
+	 * once this returns.
+	 */
+	__memp_pgmap_sync(dbenv);
+
 	if (lsnp != NULL) {
 		R_LOCK(dbenv, dbmp->reginfo);
 		if (log_compare(lsnp, &mp->lsn) > 0)
@@ -1270,6 +1270,39 @@ bb_berkdb_get_process_stats(void)
 	return &s;
 }
 
+const char *
+thread_wait_event_name(enum thread_wait_event event)
+{
+	switch (event) {
+	case THD_WAIT_LOCK_PAGE: return "lock_page";
+	case THD_WAIT_LOCK_ROW: return "lock_row";
+	case THD_WAIT_LOCK_TABLE: return "lock_table";
+	case THD_WAIT_LOCK_OTHER: return "lock_other";
+	case THD_WAIT_PAGE_IN: return "page_in";
+	case THD_WAIT_LOG_FLUSH: return "log_flush";
+	case THD_WAIT_REP: return "rep";
+	case THD_WAIT_OSQL: return "osql";
+	case THD_WAIT_THROTTLE: return "throttle";
+	default: return "???";
+	}
+}
+
+/* Account a wait of us microseconds to this thread and to the process */
+void
+bb_berkdb_thread_wait(int event, uint64_t us)
+{
+	struct berkdb_thread_stats *t, *p;
+
+	if (!gbl_bb_berkdb_enable_thread_stats)
+		return;
+	t = bb_berkdb_get_thread_stats();
+	p = bb_berkdb_get_process_stats();
+	t->n_waits[event]++;
+	t->wait_time_us[event] += us;
+	p->n_waits[event]++;
+	p->wait_time_us[event] += us;
+}
+
 void bb_berkdb_reset_worst_lock_wait_time_us(void)
 {
 	bb_berkdb_get_process_stats()->worst_lock_wait_time_us = 0;
@@ -79,6 +79,7 @@ extern int gbl_early;
 extern int gbl_reallyearly;
 extern int gbl_rep_process_txn_time;
 extern int gbl_is_physical_replicant;
+extern int gbl_log_prefetch_records;
 extern int gbl_physrep_debug;
 extern int gbl_dumptxn_at_commit;
 extern int gbl_sql_logfill;
@@ -4229,8 +4230,8 @@ worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
 {
 	struct __recovery_processor *rp;
 	struct __recovery_queue *rq;
-	struct __recovery_record *rr;
-	int rc;
+	struct __recovery_record *rr, *prefetch;
+	int rc, i, npf;
 	DB_ENV *dbenv;
 	DB_LOGC *logc = NULL;
 	DBT tmpdbt;
@@ -4247,9 +4248,23 @@ worker_thd(struct thdpool *pool, void *work, void *thddata, int op)
 	dbenv = rq->processor->dbenv;
 	commit_lsn = rp->commit_lsn;
 
+	/* The processor read in the pages of the first records; keep the next
+	 * one going as each record is applied */
+	prefetch = NULL;
+	if ((npf = gbl_log_prefetch_records) > 0) {
+		prefetch = rq->records.top;
+		for (i = 0; prefetch && i < npf; i++)
+			prefetch = prefetch->lnk.next;
+	}
+
 	rr = listc_rtl(&rq->records);
 
 	while (rr) {
+		if (prefetch) {
+			log_prefetch_page(dbenv, &prefetch->pf);
+			prefetch = prefetch->lnk.next;
+		}
+
 		/* Per record, not per queue: fileid fan-out splits a txn across
 		 * workers, and a txn can span statements. */
 		if (rr->have_fingerprint)
@@ -4628,6 +4643,16 @@ processor_thd(struct thdpool *pool, void *work, void *thddata, int op)
 			rr->logdbt.data = NULL;
 		rr->lsn = *lsnp;
 		rr->fileid = fileid;
+		rr->pf.type = LOG_PREFETCH_NONE;
+		if (gbl_log_prefetch_records > 0) {
+			/* Read in the pages of the first records of each queue now;
+			 * the worker keeps the window full as it applies */
+			log_prefetch_decode(rp->lc.array[i].rec.data ?
+				&rp->lc.array[i].rec : &data_dbt, &rr->pf);
+			if (rp->recovery_queues[fileid]->records.count <
+				gbl_log_prefetch_records)
+				log_prefetch_page(dbenv, &rr->pf);
+		}
 		rr->have_fingerprint = have_cur_fingerprint;
 		if (have_cur_fingerprint)
 			memcpy(rr->fingerprint, cur_fingerprint,
@@ -700,6 +700,7 @@ int gbl_reorder_idx_writes = 0;
 char *gbl_recovery_options = NULL;
 
 int gbl_rcache = 0;
+int gbl_rcache_levels = 1;
 
 int gbl_check_sql_source = 0;
 int skip_clear_queue_extents = 0;
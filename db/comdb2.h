@@ -2675,6 +2675,8 @@ struct bdb_queue_found;
 struct bdb_queue_cursor;
 int dbq_add(struct ireq *iq, void *trans, const void *dta, size_t dtalen);
 int dbq_add_recno(struct ireq *iq, void *trans, uint32_t recno, const void *dta, size_t dtalen);
+int dbq_add_partition(struct ireq *iq, void *trans, const void *dta,
+                      size_t dtalen, int partition);
 int dbq_consume(struct ireq *iq, void *trans, int consumer,
                 const struct bdb_queue_found *fnd);
 int dbq_consume_genid(struct ireq *, void *trans, int consumer, const genid_t);
@@ -3751,6 +3753,7 @@ void init_password_cache();
 void destroy_password_cache();
 
 extern int gbl_rcache;
+extern int gbl_rcache_levels;
 extern int gbl_throttle_txn_chunks_msec;
 extern int gbl_fail_client_write_lock;
 extern int gbl_server_admin_mode;
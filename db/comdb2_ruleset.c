@@ -24,6 +24,8 @@
 #include "logmsg.h"
 #include "comdb2buf.h"
 #include "tohex.h"
+#include "epochlib.h"
+#include <plhash_glue.h>
 
 #define RULESET_MIN_BUF   (300)
 #define RULESET_MAX_BUF   (8192)
@@ -291,6 +293,482 @@ static const char *comdb2_ruleset_match_mode_to_str(
   return zBuf;
 }
 
+/*
+** The compiled form of a ruleset.  Each rule is filed under the one
+** criterion that most cheaply rules it out:
+**
+**   1. its fingerprint, in a hash of fingerprints;
+**   2. for EXACT rules, one of its string values, in a per-field hash;
+**   3. for GLOB rules, the longest literal run of one of its patterns, in a
+**      per-field Aho-Corasick automaton;
+**
+** and anything else (REGEXP rules, rules without criteria) is always
+** evaluated.  A lookup on each field plus one pass of each automaton over
+** its string yields a superset of the rules a request can match, which
+** are then evaluated in rule order exactly as before.
+**
+** The rules visited this way no longer say how many rules were "evaluated"
+** for a request, so evalCount is kept as a count of requests that reached
+** each rule index (the stopping rule or the last one), summed on demand.
+*/
+enum ruleset_field {
+  RULESET_FIELD_ORIGIN_HOST = 0,
+  RULESET_FIELD_ORIGIN_TASK = 1,
+  RULESET_FIELD_USER = 2,
+  RULESET_FIELD_SQL = 3,
+  RULESET_FIELD_IDENTITY = 4,
+  RULESET_FIELD_MAX = 5
+};
+
+#define RULESET_MAX_WORDS ((RULESET_MAX_COUNT+63)/64)
+
+struct ruleset_ac {
+  int nClass;                     /* Number of byte classes; class 0 is for
+                                   * bytes not found in any pattern. */
+  unsigned char aClass[256];      /* Byte to class, both cases alike. */
+  int nNode;                      /* Number of automaton states. */
+  int *aGoto;                     /* Transitions, nNode rows of nClass. */
+  int *aOut;                      /* First output of each state, or -1. */
+  int *aDict;                     /* Next state on the suffix chain that has
+                                   * outputs, or 0 if none. */
+  int nOutput;                    /* Number of outputs. */
+  int *aOutRule;                  /* Rule index of each output. */
+  int *aOutNext;                  /* Next output of the same state, or -1. */
+};
+
+struct ruleset_literal {
+  int iRule;                      /* Index of the rule in aRule. */
+  const char *z;                  /* Start of the literal. */
+  int n;                          /* Length of the literal. */
+};
+
+struct ruleset_bucket {
+  const char *zKey;               /* Criteria value, owned by the rule. */
+  int nRule;                      /* Number of rules in this bucket. */
+  int *aRule;                     /* Indexes of those rules in aRule. */
+};
+
+struct ruleset_fp_bucket {
+  unsigned char aFingerprint[FPSZ];
+  int nRule;
+  int *aRule;
+};
+
+struct ruleset_index {
+  int nRule;                      /* Rules covered, i.e. rules->nRule. */
+  int nWord;                      /* Words in a candidate bitmap. */
+  uint64_t aAlways[RULESET_MAX_WORDS]; /* Rules always evaluated. */
+  hash_t *pFingerprints;          /* Fingerprint => ruleset_fp_bucket. */
+  hash_t *aExact[RULESET_FIELD_MAX]; /* Value, any case => ruleset_bucket. */
+  struct ruleset_ac *aGlob[RULESET_FIELD_MAX]; /* Literals of patterns. */
+  int nFingerprint;               /* How many rules are in each kind of */
+  int nExact;                     /* lookup, for diagnostics. */
+  int nGlob;
+  int nAlways;
+  int *aReached;                  /* Requests whose evaluation stopped at
+                                   * each rule index, see above. */
+};
+
+static const char *comdb2_ruleset_field_value(
+  const struct ruleset_item_criteria *criteria,
+  int iField
+){
+  switch( iField ){
+    case RULESET_FIELD_ORIGIN_HOST: return criteria->zOriginHost;
+    case RULESET_FIELD_ORIGIN_TASK: return criteria->zOriginTask;
+    case RULESET_FIELD_USER:        return criteria->zUser;
+    case RULESET_FIELD_SQL:         return criteria->zSql;
+    case RULESET_FIELD_IDENTITY:    return criteria->zIdentity;
+  }
+  return NULL;
+}
+
+/*
+** Find the longest run of characters in a GLOB pattern that any matching
+** string must contain verbatim, i.e. outside of '*', '?' and '[...]'.
+*/
+static int glob_longest_literal(
+  const char *zPattern,
+  const char **pzLit
+){
+  const char *z = zPattern;
+  const char *zRun = z;
+  int nBest = 0;
+  *pzLit = NULL;
+  for(;;){
+    char c = *z;
+    if( c=='\0' || c=='*' || c=='?' || c=='[' ){
+      if( z-zRun>nBest ){
+        nBest = (int)(z-zRun);
+        *pzLit = zRun;
+      }
+      if( c=='\0' ) break;
+      if( c=='[' ){
+        z++;
+        if( *z=='^' ) z++;
+        if( *z==']' ) z++;
+        while( *z && *z!=']' ) z++;
+        if( *z=='\0' ) break;
+      }
+      zRun = z+1;
+    }
+    z++;
+  }
+  return nBest;
+}
+
+static void comdb2_free_ruleset_ac(struct ruleset_ac *ac){
+  if( ac==NULL ) return;
+  free(ac->aGoto);
+  free(ac->aOut);
+  free(ac->aDict);
+  free(ac->aOutRule);
+  free(ac->aOutNext);
+  free(ac);
+}
+
+/*
+** Build a case-insensitive Aho-Corasick automaton over the literals, with
+** the failure links folded into a complete transition table so matching
+** is one table lookup per byte.
+*/
+static struct ruleset_ac *comdb2_build_ruleset_ac(
+  struct ruleset_literal *aLit,
+  int nLit
+){
+  struct ruleset_ac *ac = calloc(1, sizeof(struct ruleset_ac));
+  int *aFail = NULL;
+  int *aQueue = NULL;
+  int nAlloc = 1;
+  if( ac==NULL ) return NULL;
+
+  ac->nClass = 1;
+  for(int i=0; i<nLit; i++){
+    for(int j=0; j<aLit[i].n; j++){
+      unsigned char c = (unsigned char)tolower((unsigned char)aLit[i].z[j]);
+      if( ac->aClass[c]==0 ){
+        ac->aClass[c] = ac->aClass[toupper(c)] = ac->nClass++;
+      }
+    }
+    nAlloc += aLit[i].n;
+  }
+  ac->aGoto = malloc(sizeof(int) * nAlloc * ac->nClass);
+  ac->aOut = malloc(sizeof(int) * nAlloc);
+  ac->aDict = calloc(nAlloc, sizeof(int));
+  ac->aOutRule = malloc(sizeof(int) * nLit);
+  ac->aOutNext = malloc(sizeof(int) * nLit);
+  aFail = calloc(nAlloc, sizeof(int));
+  aQueue = malloc(sizeof(int) * nAlloc);
+  if( ac->aGoto==NULL || ac->aOut==NULL || ac->aDict==NULL ||
+      ac->aOutRule==NULL || ac->aOutNext==NULL || aFail==NULL ||
+      aQueue==NULL ){
+    comdb2_free_ruleset_ac(ac);
+    ac = NULL;
+    goto done;
+  }
+
+  /* the trie */
+  ac->nNode = 1;
+  memset(ac->aGoto, -1, sizeof(int) * ac->nClass);
+  ac->aOut[0] = -1;
+  for(int i=0; i<nLit; i++){
+    int s = 0;
+    for(int j=0; j<aLit[i].n; j++){
+      int k = ac->aClass[(unsigned char)aLit[i].z[j]];
+      int *pNext = &ac->aGoto[s*ac->nClass + k];
+      if( *pNext<0 ){
+        *pNext = ac->nNode++;
+        memset(&ac->aGoto[*pNext*ac->nClass], -1, sizeof(int) * ac->nClass);
+        ac->aOut[*pNext] = -1;
+      }
+      s = *pNext;
+    }
+    ac->aOutRule[ac->nOutput] = aLit[i].iRule;
+    ac->aOutNext[ac->nOutput] = ac->aOut[s];
+    ac->aOut[s] = ac->nOutput++;
+  }
+
+  /* failure links, breadth first */
+  int nHead = 0, nTail = 0;
+  for(int k=0; k<ac->nClass; k++){
+    int v = ac->aGoto[k];
+    if( v<0 ){
+      ac->aGoto[k] = 0;
+    }else{
+      aFail[v] = 0;
+      aQueue[nTail++] = v;
+    }
+  }
+  while( nHead<nTail ){
+    int u = aQueue[nHead++];
+    for(int k=0; k<ac->nClass; k++){
+      int *pNext = &ac->aGoto[u*ac->nClass + k];
+      int f = ac->aGoto[aFail[u]*ac->nClass + k];
+      if( *pNext<0 ){
+        *pNext = f;
+      }else{
+        int v = *pNext;
+        aFail[v] = f;
+        ac->aDict[v] = ac->aOut[f]>=0 ? f : ac->aDict[f];
+        aQueue[nTail++] = v;
+      }
+    }
+  }
+
+done:
+  free(aFail);
+  free(aQueue);
+  return ac;
+}
+
+static void comdb2_ruleset_ac_match(
+  const struct ruleset_ac *ac,
+  const char *z,
+  uint64_t *aBits
+){
+  int s = 0;
+  for(; *z; z++){
+    s = ac->aGoto[s*ac->nClass + ac->aClass[(unsigned char)*z]];
+    for(int t=(ac->aOut[s]>=0 ? s : ac->aDict[s]); t>0; t=ac->aDict[t]){
+      for(int o=ac->aOut[t]; o>=0; o=ac->aOutNext[o]){
+        int i = ac->aOutRule[o];
+        aBits[i/64] |= 1ULL << (i%64);
+      }
+    }
+  }
+}
+
+static int free_ruleset_bucket(void *obj, void *arg){
+  struct ruleset_bucket *pBucket = (struct ruleset_bucket *)obj;
+  free(pBucket->aRule);
+  free(pBucket);
+  return 0;
+}
+
+static int free_ruleset_fp_bucket(void *obj, void *arg){
+  struct ruleset_fp_bucket *pBucket = (struct ruleset_fp_bucket *)obj;
+  free(pBucket->aRule);
+  free(pBucket);
+  return 0;
+}
+
+static void comdb2_free_ruleset_index(struct ruleset_index *pIndex){
+  if( pIndex==NULL ) return;
+  if( pIndex->pFingerprints!=NULL ){
+    hash_for(pIndex->pFingerprints, free_ruleset_fp_bucket, NULL);
+    hash_free(pIndex->pFingerprints);
+  }
+  for(int f=0; f<RULESET_FIELD_MAX; f++){
+    if( pIndex->aExact[f]!=NULL ){
+      hash_for(pIndex->aExact[f], free_ruleset_bucket, NULL);
+      hash_free(pIndex->aExact[f]);
+    }
+    comdb2_free_ruleset_ac(pIndex->aGlob[f]);
+  }
+  free(pIndex->aReached);
+  free(pIndex);
+}
+
+static int comdb2_add_to_bucket(int **paRule, int *pnRule, int iRule){
+  int *aNew = realloc(*paRule, sizeof(int) * (*pnRule+1));
+  if( aNew==NULL ) return ENOMEM;
+  aNew[(*pnRule)++] = iRule;
+  *paRule = aNew;
+  return 0;
+}
+
+static int comdb2_index_ruleset_item(
+  struct ruleset_index *pIndex,
+  struct ruleset_item *rule,
+  int iRule,
+  struct ruleset_literal **aaLit,
+  int *anLit
+){
+  struct ruleset_item_criteria *criteria = &rule->criteria;
+  int mode = rule->mode & ~RULESET_MM_NOCASE;
+
+  if( criteria->pFingerprint!=NULL ){
+    struct ruleset_fp_bucket *pBucket;
+    if( pIndex->pFingerprints==NULL ){
+      pIndex->pFingerprints = hash_init(FPSZ);
+      if( pIndex->pFingerprints==NULL ) return ENOMEM;
+    }
+    pBucket = hash_find(pIndex->pFingerprints, criteria->pFingerprint);
+    if( pBucket==NULL ){
+      pBucket = calloc(1, sizeof(struct ruleset_fp_bucket));
+      if( pBucket==NULL ) return ENOMEM;
+      memcpy(pBucket->aFingerprint, criteria->pFingerprint, FPSZ);
+      hash_add(pIndex->pFingerprints, pBucket);
+    }
+    pIndex->nFingerprint++;
+    return comdb2_add_to_bucket(&pBucket->aRule, &pBucket->nRule, iRule);
+  }
+
+  if( mode==RULESET_MM_EXACT ){
+    for(int f=0; f<RULESET_FIELD_MAX; f++){
+      const char *zValue = comdb2_ruleset_field_value(criteria, f);
+      struct ruleset_bucket *pBucket;
+      if( zValue==NULL ) continue;
+      if( pIndex->aExact[f]==NULL ){
+        pIndex->aExact[f] = hash_init_strcaseptr(
+          offsetof(struct ruleset_bucket, zKey)
+        );
+        if( pIndex->aExact[f]==NULL ) return ENOMEM;
+      }
+      pBucket = hash_find(pIndex->aExact[f], &zValue);
+      if( pBucket==NULL ){
+        pBucket = calloc(1, sizeof(struct ruleset_bucket));
+        if( pBucket==NULL ) return ENOMEM;
+        pBucket->zKey = zValue;
+        hash_add(pIndex->aExact[f], pBucket);
+      }
+      pIndex->nExact++;
+      return comdb2_add_to_bucket(&pBucket->aRule, &pBucket->nRule, iRule);
+    }
+  }else if( mode==RULESET_MM_GLOB ){
+    int fBest = -1;
+    struct ruleset_literal best = {iRule, NULL, 0};
+    for(int f=0; f<RULESET_FIELD_MAX; f++){
+      const char *zValue = comdb2_ruleset_field_value(criteria, f);
+      const char *zLit;
+      int nLit;
+      if( zValue==NULL ) continue;
+      nLit = glob_longest_literal(zValue, &zLit);
+      if( nLit>best.n ){
+        fBest = f;
+        best.z = zLit;
+        best.n = nLit;
+      }
+    }
+    if( fBest>=0 ){
+      aaLit[fBest][anLit[fBest]++] = best;
+      pIndex->nGlob++;
+      return 0;
+    }
+  }
+
+  pIndex->aAlways[iRule/64] |= 1ULL << (iRule%64);
+  pIndex->nAlways++;
+  return 0;
+}
+
+static struct ruleset_index *comdb2_compile_ruleset(struct ruleset *rules){
+  struct ruleset_index *pIndex;
+  struct ruleset_literal *aaLit[RULESET_FIELD_MAX] = {0};
+  int anLit[RULESET_FIELD_MAX] = {0};
+  int rc = 0;
+
+  if( rules->nRule>RULESET_MAX_COUNT ) return NULL;
+  pIndex = calloc(1, sizeof(struct ruleset_index));
+  if( pIndex==NULL ) return NULL;
+  pIndex->nRule = (int)rules->nRule;
+  pIndex->nWord = (pIndex->nRule+63)/64;
+  pIndex->aReached = calloc(rules->nRule+1, sizeof(int));
+  if( pIndex->aReached==NULL ){
+    rc = ENOMEM;
+    goto done;
+  }
+  for(int f=0; f<RULESET_FIELD_MAX; f++){
+    aaLit[f] = malloc(sizeof(struct ruleset_literal) * (rules->nRule+1));
+    if( aaLit[f]==NULL ){
+      rc = ENOMEM;
+      goto done;
+    }
+  }
+  for(int i=0; i<rules->nRule; i++){
+    struct ruleset_item *rule = &rules->aRule[i];
+    if( rule->ruleNo==0 ) continue;
+    rc = comdb2_index_ruleset_item(pIndex, rule, i, aaLit, anLit);
+    if( rc!=0 ) goto done;
+  }
+  for(int f=0; f<RULESET_FIELD_MAX; f++){
+    if( anLit[f]==0 ) continue;
+    pIndex->aGlob[f] = comdb2_build_ruleset_ac(aaLit[f], anLit[f]);
+    if( pIndex->aGlob[f]==NULL ){
+      rc = ENOMEM;
+      goto done;
+    }
+  }
+
+done:
+  for(int f=0; f<RULESET_FIELD_MAX; f++){
+    free(aaLit[f]);
+  }
+  if( rc!=0 ){
+    logmsg(LOGMSG_ERROR,
+           "%s: could not compile ruleset %p, rc=%d, evaluating every rule\n",
+           __func__, rules, rc);
+    comdb2_free_ruleset_index(pIndex);
+    return NULL;
+  }
+  return pIndex;
+}
+
+/* Set a bit for every rule which could possibly match the context. */
+static void comdb2_ruleset_candidates(
+  struct ruleset_index *pIndex,
+  struct ruleset_item_criteria *context,
+  uint64_t *aBits
+){
+  memcpy(aBits, pIndex->aAlways, sizeof(uint64_t) * pIndex->nWord);
+  if( pIndex->pFingerprints!=NULL && context->pFingerprint!=NULL ){
+    struct ruleset_fp_bucket *pBucket = hash_find_readonly(
+      pIndex->pFingerprints, context->pFingerprint
+    );
+    for(int j=0; pBucket!=NULL && j<pBucket->nRule; j++){
+      int i = pBucket->aRule[j];
+      aBits[i/64] |= 1ULL << (i%64);
+    }
+  }
+  for(int f=0; f<RULESET_FIELD_MAX; f++){
+    const char *zValue = comdb2_ruleset_field_value(context, f);
+    if( zValue==NULL ) continue;
+    if( pIndex->aExact[f]!=NULL ){
+      struct ruleset_bucket *pBucket = hash_find_readonly(
+        pIndex->aExact[f], &zValue
+      );
+      for(int j=0; pBucket!=NULL && j<pBucket->nRule; j++){
+        int i = pBucket->aRule[j];
+        aBits[i/64] |= 1ULL << (i%64);
+      }
+    }
+    if( pIndex->aGlob[f]!=NULL ){
+      comdb2_ruleset_ac_match(pIndex->aGlob[f], zValue, aBits);
+    }
+  }
+}
+
+static int comdb2_ruleset_item_eval_count(
+  struct ruleset *rules,
+  struct ruleset_item *rule
+){
+  int count = rule->evalCount;
+  struct ruleset_index *pIndex = rules ? rules->pIndex : NULL;
+  if( pIndex!=NULL && (rule->flags&RULESET_F_DISABLE)==0 ){
+    for(int i=(int)(rule-rules->aRule); i<pIndex->nRule; i++){
+      count += pIndex->aReached[i];
+    }
+  }
+  return count;
+}
+
+/*
+** Move the per-index evaluation counts into the rules themselves, before
+** the set of enabled rules changes or the index is rebuilt.
+*/
+static void comdb2_fold_ruleset_eval_counts(struct ruleset *rules){
+  struct ruleset_index *pIndex = rules ? rules->pIndex : NULL;
+  int count = 0;
+  if( pIndex==NULL ) return;
+  for(int i=pIndex->nRule-1; i>=0; i--){
+    count += pIndex->aReached[i];
+    pIndex->aReached[i] = 0;
+    if( i<rules->nRule && (rules->aRule[i].flags&RULESET_F_DISABLE)==0 ){
+      rules->aRule[i].evalCount += count;
+    }
+  }
+}
+
 static void comdb2_dump_ruleset_item(
   loglvl level,
   char *zMessage,
@@ -329,7 +807,7 @@ static void comdb2_dump_ruleset_item(
          criteria->zOriginHost ? criteria->zOriginHost : "<null>",
          criteria->zOriginTask ? criteria->zOriginTask : "<null>", criteria->zUser ? criteria->zUser : "<null>",
          criteria->zSql ? criteria->zSql : "<null>", zFingerprint, criteria->zIdentity ? criteria->zIdentity : "<null>",
-         rule->evalCount, rule->matchCount);
+         comdb2_ruleset_item_eval_count(rules, rule), rule->matchCount);
 }
 
 static ruleset_match_t comdb2_evaluate_ruleset_item(
@@ -339,7 +817,6 @@ static ruleset_match_t comdb2_evaluate_ruleset_item(
   struct ruleset_item_criteria *context,
   struct ruleset_result *result
 ){
-  rule->evalCount++;
   if( stringComparer==NULL ){
     stringComparer = comdb2_get_xstrcmp_for_mode(rule->mode);
   }
@@ -468,7 +945,7 @@ static ruleset_match_t comdb2_evaluate_ruleset_item(
   return (rule->flags&RULESET_F_STOP) ? RULESET_M_STOP : RULESET_M_TRUE;
 }
 
-size_t comdb2_evaluate_ruleset(
+static size_t comdb2_evaluate_ruleset_linear(
   xStrCmp stringComparer,
   struct ruleset *rules,
   struct ruleset_item_criteria *context,
@@ -480,6 +957,7 @@ size_t comdb2_evaluate_ruleset(
       struct ruleset_item *rule = &rules->aRule[i];
       if( rule->ruleNo==0 ){ continue; }
       if( rule->flags&RULESET_F_DISABLE ){ continue; }
+      rule->evalCount++;
       ruleset_match_t match = comdb2_evaluate_ruleset_item(
         stringComparer, rules, rule, context, result
       );
@@ -495,6 +973,130 @@ size_t comdb2_evaluate_ruleset(
   return count;
 }
 
+static size_t comdb2_evaluate_ruleset_compiled(
+  struct ruleset *rules,
+  struct ruleset_item_criteria *context,
+  struct ruleset_result *result
+){
+  struct ruleset_index *pIndex = rules->pIndex;
+  uint64_t aBits[RULESET_MAX_WORDS];
+  size_t count = 0;
+  int iLast = pIndex->nRule-1;
+  comdb2_ruleset_candidates(pIndex, context, aBits);
+  for(int w=0; w<pIndex->nWord; w++){
+    uint64_t bits = aBits[w];
+    while( bits ){
+      int i = w*64 + __builtin_ctzll(bits);
+      bits &= bits-1;
+      struct ruleset_item *rule = &rules->aRule[i];
+      if( rule->ruleNo==0 ){ continue; }
+      if( rule->flags&RULESET_F_DISABLE ){ continue; }
+      ruleset_match_t match = comdb2_evaluate_ruleset_item(
+        NULL, rules, rule, context, result
+      );
+      if( match==RULESET_M_ERROR ){
+        /* HACK: Invalidate current ruleset result if error. */
+        memset(result, 0, sizeof(struct ruleset_result));
+        iLast = i;
+        goto done;
+      }
+      if( match==RULESET_M_STOP ){ count++; iLast = i; goto done; }
+      if( match==RULESET_M_TRUE ){ count++; }
+    }
+  }
+done:
+  if( iLast>=0 ){
+    ATOMIC_ADD32(pIndex->aReached[iLast], 1);
+  }
+  return count;
+}
+
+size_t comdb2_evaluate_ruleset(
+  xStrCmp stringComparer,
+  struct ruleset *rules,
+  struct ruleset_item_criteria *context,
+  struct ruleset_result *result
+){
+  if( rules==NULL ) return 0;
+  if( stringComparer==NULL && rules->pIndex!=NULL ){
+    return comdb2_evaluate_ruleset_compiled(rules, context, result);
+  }
+  return comdb2_evaluate_ruleset_linear(
+    stringComparer, rules, context, result
+  );
+}
+
+static int comdb2_same_ruleset_result(
+  struct ruleset_result *result1,
+  struct ruleset_result *result2
+){
+  if( result1->action!=result2->action ) return 0;
+  if( result1->flags!=result2->flags ) return 0;
+  if( result1->ruleNo!=result2->ruleNo ) return 0;
+  if( (result1->zPool==NULL)!=(result2->zPool==NULL) ) return 0;
+  if( result1->zPool && strcmp(result1->zPool, result2->zPool)!=0 ) return 0;
+  return 1;
+}
+
+/*
+** Time nIter evaluations of the context against every rule in turn and
+** against the compiled ruleset, and check that both give the same result.
+** The rule counters are updated, so this must be given a private copy of
+** the ruleset rather than the one in use.
+*/
+int comdb2_bench_ruleset(
+  struct ruleset *rules,
+  struct ruleset_item_criteria *context,
+  int nIter
+){
+  struct ruleset_result linear = {0};
+  struct ruleset_result compiled = {0};
+  size_t nLinear = 0, nCompiled = 0;
+  int64_t linearUs, compiledUs, startUs;
+  int rc = 0;
+
+  if( rules==NULL || rules->pIndex==NULL || nIter<=0 ) return EINVAL;
+
+  startUs = comdb2_time_epochus();
+  for(int i=0; i<nIter; i++){
+    free(linear.zPool);
+    memset(&linear, 0, sizeof(linear));
+    nLinear = comdb2_evaluate_ruleset_linear(NULL, rules, context, &linear);
+  }
+  linearUs = comdb2_time_epochus() - startUs;
+
+  startUs = comdb2_time_epochus();
+  for(int i=0; i<nIter; i++){
+    free(compiled.zPool);
+    memset(&compiled, 0, sizeof(compiled));
+    nCompiled = comdb2_evaluate_ruleset_compiled(rules, context, &compiled);
+  }
+  compiledUs = comdb2_time_epochus() - startUs;
+
+  if( nLinear!=nCompiled || !comdb2_same_ruleset_result(&linear, &compiled) ){
+    char zLinear[RULESET_MIN_BUF];
+    char zCompiled[RULESET_MIN_BUF];
+    comdb2_ruleset_result_to_str(&linear, zLinear, sizeof(zLinear));
+    comdb2_ruleset_result_to_str(&compiled, zCompiled, sizeof(zCompiled));
+    logmsg(LOGMSG_ERROR,
+           "%s: ruleset %p results differ, linear matched %zu {%s}, "
+           "compiled matched %zu {%s}\n", __func__, rules, nLinear, zLinear,
+           nCompiled, zCompiled);
+    rc = EFAULT;
+  }
+  logmsg(LOGMSG_USER,
+         "%s: ruleset %p, %zu rules (%d fingerprint, %d exact, %d glob, "
+         "%d always), %d iterations, linear %.1f ns/eval, compiled %.1f "
+         "ns/eval, results %s\n", __func__, rules, rules->nRule,
+         rules->pIndex->nFingerprint, rules->pIndex->nExact,
+         rules->pIndex->nGlob, rules->pIndex->nAlways, nIter,
+         linearUs * 1000.0 / nIter, compiledUs * 1000.0 / nIter,
+         rc==0 ? "match" : "DIFFER");
+  free(linear.zPool);
+  free(compiled.zPool);
+  return rc;
+}
+
 size_t comdb2_ruleset_result_to_str(
   struct ruleset_result *result,
   char *zBuf,
@@ -545,6 +1147,7 @@ int comdb2_enable_ruleset_item(
   if( ruleNo<1 || ruleNo>rules->nRule ) return ERANGE;
   struct ruleset_item *rule = &rules->aRule[ruleNo-1];
   if( rule->ruleNo==0 ) return ENOENT;
+  comdb2_fold_ruleset_eval_counts(rules);
   if( bEnable ){
     rule->flags &= ~RULESET_F_DISABLE;
   }else{
@@ -917,6 +1520,8 @@ static void comdb2_free_ruleset_int(
   struct ruleset *rules
 ){
   if( rules==NULL ) return;
+  comdb2_free_ruleset_index(rules->pIndex);
+  rules->pIndex = NULL;
   if( rules->aRule!=NULL ){
     for(int i=0; i<rules->nRule; i++){
       struct ruleset_item *rule = &rules->aRule[i];
@@ -1296,6 +1901,7 @@ int comdb2_load_ruleset_fp(struct ruleset **pRules, FILE *fp, const char *zFileN
         }
     }
     if (*pRules != NULL) {
+        comdb2_fold_ruleset_eval_counts(*pRules);
         if (comdb2_merge_ruleset_items(*pRules, rules, zError, sizeof(zError), zFileName, lineNo) != 0) {
             goto failure;
         }
@@ -1304,6 +1910,9 @@ int comdb2_load_ruleset_fp(struct ruleset **pRules, FILE *fp, const char *zFileN
         *pRules = rules;
     }
 
+    comdb2_free_ruleset_index((*pRules)->pIndex);
+    (*pRules)->pIndex = comdb2_compile_ruleset(*pRules);
+
     (*pRules)->generation = ATOMIC_ADD64(gbl_ruleset_generation, 1);
     assert(rc == 0);
     goto done;
@@ -27,6 +27,7 @@
 #include "util.h"
 #include "tohex.h"
 #include "string_ref.h"
+#include "thread_stats.h"
 #include <ctrace.h>
 
 extern int gbl_old_column_names;
@@ -90,6 +91,20 @@ int fingerprint_has_main_entry(const unsigned char fingerprint[FINGERPRINTSZ])
     return found;
 }
 
+/* Mean execution time (ms) of a fingerprint so far, or -1 if it has never
+ * completed on this node. Feeds the cost-aware SQL scheduler. */
+int64_t fingerprint_avg_time(const unsigned char fingerprint[FINGERPRINTSZ])
+{
+    int64_t avg = -1;
+    struct fingerprint_track *t;
+    Pthread_mutex_lock(&gbl_fingerprint_hash_mu);
+    if (gbl_fingerprint_hash != NULL &&
+        (t = hash_find_readonly(gbl_fingerprint_hash, fingerprint)) != NULL && t->count > 0)
+        avg = t->time / t->count;
+    Pthread_mutex_unlock(&gbl_fingerprint_hash_mu);
+    return avg;
+}
+
 /* 1 if the fingerprint is all-zeros, which is what a statement with no
  * normalized SQL gets. Senders skip those rather than pool them under one key. */
 int fingerprint_is_zero(const unsigned char fingerprint[FINGERPRINTSZ])
@@ -210,6 +225,17 @@ static void do_type_checks(struct sqlclntstate *clnt, sqlite3_stmt *stmt,
     strbuf_free(newtypes);
 }
 
+/* Fold this statement's cpu and wait profile into the fingerprint */
+static void add_wait_profile(struct fingerprint_track *t, struct reqlogger *logger)
+{
+    const struct berkdb_thread_stats *st = bdb_get_thread_stats();
+
+    t->cpu_time += reqlog_cpu_us(logger);
+    for (int i = 0; i < THD_WAIT_MAX; i++)
+        t->wait_time[i] += st->wait_time_us[i];
+    t->osql_round_trips += st->n_waits[THD_WAIT_OSQL];
+}
+
 void add_fingerprint(struct sqlclntstate *clnt, sqlite3_stmt *stmt, struct string_ref *zSql_ref, const char *zNormSql,
                      int64_t cost, int64_t time, int64_t prepTime, int64_t nrows, struct reqlogger *logger,
                      unsigned char *fingerprint_out, int is_lua)
@@ -356,6 +382,11 @@ void add_fingerprint(struct sqlclntstate *clnt, sqlite3_stmt *stmt, struct strin
         assert( strncmp(t->zNormSql,zNormSql,t->nNormSql)==0 );
     }
 
+    /* statements run inside a stored procedure have no logger of their own;
+     * their waits are counted once, against the exec procedure */
+    if (logger)
+        add_wait_profile(t, logger);
+
     if (clnt->adjusted_column_names && t->alert_once_truncated_col) {
         t->alert_once_truncated_col = 0;
         char fp[FINGERPRINTSZ * 2 + 1]; /* 16 ==> 33 */
@@ -33,6 +33,8 @@
 #include <sys/resource.h>
 #include "comdb2_query_preparer.h"
 #include "net_int.h"
+#include "histogram.h"
+#include "sql_scheduler.h"
 
 struct comdb2_metrics_store {
     int64_t cache_hits;
@@ -64,6 +66,12 @@ struct comdb2_metrics_store {
     int64_t threads;
     int64_t current_connections;
     int64_t max_current_connections;
+    int64_t latency_p50[LATENCY_MAX];
+    int64_t latency_p99[LATENCY_MAX];
+    int64_t latency_p999[LATENCY_MAX];
+    int64_t sql_sched_queued;
+    int64_t sql_sched_running;
+    int64_t sql_sched_wait_us;
     int64_t diskspace;
     double service_time;
     double queue_depth;
@@ -119,6 +127,11 @@ struct comdb2_metrics_store {
     int64_t inmem_repdb_memory;
     int64_t physrep_metadb_sql_count;
     int64_t physrep_no_viable_source;
+    int64_t osql_coalesce_flushes;
+    int64_t osql_stream_sessions;
+    int64_t osql_stream_fallbacks;
+    int64_t log_prefetch_pages;
+    int64_t recovery_redo_records;
 
     int64_t page_reads;
     int64_t page_writes;
@@ -336,6 +349,16 @@ comdb2_metric gbl_metrics[] = {
      STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.physrep_metadb_sql_count, NULL},
     {"physrep_no_viable_source", "This physical replicant found no source retaining logs that cover its LSN",
      STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_LATEST, &stats.physrep_no_viable_source, NULL},
+    {"osql_coalesce_flushes", "Number of times socksql row ops held back in the shadow tables were sent",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.osql_coalesce_flushes, NULL},
+    {"osql_stream_sessions", "Number of socksql transactions applied while they were still arriving",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.osql_stream_sessions, NULL},
+    {"osql_stream_fallbacks", "Number of streamed socksql transactions that had to be applied as a whole",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.osql_stream_fallbacks, NULL},
+    {"log_prefetch_pages", "Number of pages read in ahead of the log records that change them",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.log_prefetch_pages, NULL},
+    {"recovery_redo_records", "Number of log records recovery redid on its redo threads",
+     STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.recovery_redo_records, NULL},
     {"page_reads", "Total page reads", STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.page_reads,
      NULL},
     {"page_writes", "Total page writes", STATISTIC_INTEGER, STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.page_writes,
@@ -416,6 +439,42 @@ comdb2_metric gbl_metrics[] = {
      &stats.legacy_requests, NULL},
     {"max_current_connections", "Max current connections for sampled interval", STATISTIC_INTEGER,
      STATISTIC_COLLECTION_TYPE_LATEST, &stats.max_current_connections, NULL},
+    {"sql_statement_latency_p50", "SQL statement latency, 50th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p50[LATENCY_SQL_STATEMENT], NULL},
+    {"sql_statement_latency_p99", "SQL statement latency, 99th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p99[LATENCY_SQL_STATEMENT], NULL},
+    {"sql_statement_latency_p999", "SQL statement latency, 99.9th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p999[LATENCY_SQL_STATEMENT], NULL},
+    {"commit_latency_p50", "Transaction commit latency, 50th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p50[LATENCY_COMMIT], NULL},
+    {"commit_latency_p99", "Transaction commit latency, 99th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p99[LATENCY_COMMIT], NULL},
+    {"commit_latency_p999", "Transaction commit latency, 99.9th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p999[LATENCY_COMMIT], NULL},
+    {"rep_wait_latency_p50", "Replication wait latency, 50th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p50[LATENCY_REP_WAIT], NULL},
+    {"rep_wait_latency_p99", "Replication wait latency, 99th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p99[LATENCY_REP_WAIT], NULL},
+    {"rep_wait_latency_p999", "Replication wait latency, 99.9th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p999[LATENCY_REP_WAIT], NULL},
+    {"lock_wait_latency_p50", "Lock wait latency, 50th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p50[LATENCY_LOCK_WAIT], NULL},
+    {"lock_wait_latency_p99", "Lock wait latency, 99th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p99[LATENCY_LOCK_WAIT], NULL},
+    {"lock_wait_latency_p999", "Lock wait latency, 99.9th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p999[LATENCY_LOCK_WAIT], NULL},
+    {"page_in_latency_p50", "Page-in latency, 50th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p50[LATENCY_PAGE_IN], NULL},
+    {"page_in_latency_p99", "Page-in latency, 99th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p99[LATENCY_PAGE_IN], NULL},
+    {"page_in_latency_p999", "Page-in latency, 99.9th percentile (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.latency_p999[LATENCY_PAGE_IN], NULL},
+    {"sql_scheduler_queued", "Requests waiting in the SQL scheduler", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.sql_sched_queued, NULL},
+    {"sql_scheduler_running", "Requests admitted by the SQL scheduler and running", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_LATEST, &stats.sql_sched_running, NULL},
+    {"sql_scheduler_wait_us", "Time requests spent waiting in the SQL scheduler (usec)", STATISTIC_INTEGER,
+     STATISTIC_COLLECTION_TYPE_CUMULATIVE, &stats.sql_sched_wait_us, NULL},
 };
 
 const char *metric_collection_type_string(comdb2_collection_type t) {
@@ -463,6 +522,11 @@ extern int64_t gbl_incoherent_slow_skips;
 extern int64_t gbl_inmem_repdb_memory;
 extern int64_t gbl_physrep_metadb_sql_count;
 extern int gbl_physrep_no_viable_source;
+extern int64_t gbl_osql_coalesce_flushes;
+extern int64_t gbl_osql_stream_sessions;
+extern int64_t gbl_osql_stream_fallbacks;
+extern int64_t gbl_log_prefetch_pages;
+extern int64_t gbl_recovery_redo_records;
 
 static void update_sqllogfill_metrics()
 {
@@ -497,6 +561,19 @@ static void update_fastsql_metrics()
     stats.fastsql_execute_stop = gbl_fastsql_execute_stop;
 }
 
+static void update_latency_metrics()
+{
+    static const double pct[] = {50, 99, 99.9};
+    uint64_t v[3];
+
+    for (int i = 0; i < LATENCY_MAX; i++) {
+        histogram_percentiles(latency_histogram(i), pct, v, 3);
+        stats.latency_p50[i] = v[0];
+        stats.latency_p99[i] = v[1];
+        stats.latency_p999[i] = v[2];
+    }
+}
+
 static int64_t refresh_diskspace(struct dbenv *dbenv, tran_type *tran)
 {
     int64_t total = 0;
@@ -669,6 +746,7 @@ int refresh_metrics(void)
     stats.concurrent_sql = time_metric_average(thedb->concurrent_queries);
     stats.sql_queue_time = time_metric_average(thedb->sql_queue_time);
     stats.sql_queue_timeouts = get_all_sql_pool_timeouts();
+    sql_sched_totals(&stats.sql_sched_queued, &stats.sql_sched_running, &stats.sql_sched_wait_us);
     stats.handle_buf_queue_time =
         time_metric_average(thedb->handle_buf_queue_time);
     stats.concurrent_connections = time_metric_average(thedb->connections);
@@ -679,6 +757,11 @@ int refresh_metrics(void)
     stats.inmem_repdb_memory = gbl_inmem_repdb_memory;
     stats.physrep_metadb_sql_count = gbl_physrep_metadb_sql_count;
     stats.physrep_no_viable_source = gbl_physrep_no_viable_source;
+    stats.osql_coalesce_flushes = gbl_osql_coalesce_flushes;
+    stats.osql_stream_sessions = gbl_osql_stream_sessions;
+    stats.osql_stream_fallbacks = gbl_osql_stream_fallbacks;
+    stats.log_prefetch_pages = gbl_log_prefetch_pages;
+    stats.recovery_redo_records = gbl_recovery_redo_records;
     struct global_stats gstats = {0};
 
     global_request_stats(&gstats);
@@ -768,6 +851,7 @@ int refresh_metrics(void)
     update_sqllogfill_metrics();
     update_fastsql_metrics();
     stats.max_current_connections = time_metric_max(thedb->connections);
+    update_latency_metrics();
 
     return 0;
 }
@@ -35,6 +35,7 @@
 #include "sc_rename_table.h"
 #include <disttxn.h>
 #include "views.h"
+#include "sql_scheduler.h"
 
 /* Maximum allowable size of the value of tunable. */
 #define MAX_TUNABLE_VALUE_SIZE 512
@@ -47,6 +48,9 @@ extern int gbl_transactional_drop_plus_rename;
 extern int gbl_bulk_import_validation_werror;
 extern int gbl_debug_sleep_during_bulk_import;
 extern int gbl_enable_bulk_import;
+extern int gbl_enable_bulk_load;
+extern int gbl_bulk_load_threads;
+extern int gbl_bulk_load_batch_rows;
 extern int gbl_enable_bulk_import_different_tables;
 extern int gbl_debug_stall_in_oplog_seed;
 extern int gbl_waitalive_iterations;
@@ -59,6 +63,8 @@ extern int gbl_berkdb_epochms_repts;
 extern int gbl_pmux_route_enabled;
 extern int gbl_allow_user_schema;
 extern int gbl_test_badwrite_intvl;
+extern int gbl_pgmap_enable;
+extern int gbl_pgmap_chunk_pages;
 extern int gbl_broken_max_rec_sz;
 extern int gbl_broken_num_parser;
 extern int gbl_crc32c;
@@ -86,6 +92,11 @@ extern int gbl_2pc;
 char *gbl_allowed_coordinators;
 extern int gbl_all_waitdie;
 extern int gbl_debug_disable_waitdie_deadlock_detection;
+extern int gbl_incremental_deadlock_detect;
+extern int gbl_ix_key_plans;
+extern int gbl_bulk_column_decode;
+extern int gbl_hash_join;
+extern int gbl_hash_join_mem_kb;
 extern int gbl_coordinator_sync_on_commit;
 extern int gbl_coordinator_wait_propagate;
 extern int gbl_coordinator_block_until_durable;
@@ -146,9 +157,13 @@ extern int gbl_osql_verify_retries_max;
 extern int gbl_dump_history_on_too_many_verify_errors;
 extern int gbl_page_latches;
 extern int gbl_pb_connectmsg;
+extern int gbl_net_compress;
+extern int gbl_net_compress_min_bytes;
+extern int gbl_net_compress_min_rtt_us;
 extern int gbl_prefault_udp;
 extern int gbl_print_syntax_err;
 extern int gbl_lclpooled_buffers;
+extern int gbl_latency_histograms;
 extern int gbl_reallyearly;
 extern int gbl_endianize_locklist;
 extern int gbl_debug_lock_get_list_copy_compare;
@@ -262,6 +277,9 @@ extern int gbl_max_apply_dequeue;
 extern int gbl_catchup_window_trace;
 extern int gbl_early_ack_trace;
 extern int gbl_commit_delay_timeout;
+extern int gbl_commit_ack_coordinator;
+extern int gbl_rep_ack_coalesce_us;
+extern int gbl_rep_ack_coalesce_bytes;
 extern int gbl_commit_delay_copy_ms;
 extern int gbl_test_commit_lsn_map;
 extern int gbl_throttle_logput_trace;
@@ -307,6 +325,9 @@ extern int gbl_rand_elect_timeout;
 extern uint32_t gbl_rand_elect_min_ms;
 extern int gbl_rand_elect_max_ms;
 extern int gbl_handle_buf_add_latency_ms;
+extern int gbl_osql_coalesce_max_ops;
+extern int gbl_osql_stream_apply_ops;
+extern int gbl_osql_stream_apply_wait_ms;
 extern int gbl_osql_send_startgen;
 extern int gbl_osql_send_fingerprint;
 extern int gbl_log_fingerprint;
@@ -345,6 +366,8 @@ extern int gbl_load_cache_max_pages;
 extern int gbl_dump_cache_max_pages;
 extern int gbl_max_pages_per_cache_thread;
 extern int gbl_memp_dump_cache_threshold;
+extern int gbl_memp_probation_pct;
+extern int gbl_memp_probation_min_age_pct;
 extern int gbl_disable_ckp;
 extern int gbl_abort_on_illegal_log_put;
 extern int gbl_sc_close_txn;
@@ -363,6 +386,8 @@ extern int gbl_fingerprint_max_queries;
 extern int gbl_query_plan_max_plans;
 extern double gbl_query_plan_percentage;
 extern int gbl_ufid_log;
+extern int gbl_log_prefetch_records;
+extern int gbl_recovery_redo_threads;
 extern int gbl_utxnid_log;
 extern int gbl_snapshot_isolation;
 extern int gbl_ufid_add_on_collect;
@@ -431,6 +456,7 @@ extern int gbl_ack_trace;
 
 /* bdb/bdblock.c */
 extern int gbl_bdblock_debug;
+extern int gbl_bdblock_reader_slots;
 
 extern int gbl_debug_aa;
 
@@ -627,6 +653,8 @@ extern int gbl_retro_tpt_verbose;
 extern int gbl_retro_tpt_start;
 extern int gbl_legacy_tpt;
 extern int gbl_dohsql_joins;
+extern int gbl_dohsql_parallel_scan;
+extern int gbl_dohsql_parallel_scan_min_rows;
 extern int gbl_altersc_latency;
 extern int gbl_altersc_delay_usec;
 extern int gbl_altersc_latency_thr;
@@ -817,6 +845,47 @@ static void *checkctags_value(void *context)
     return "unknown";
 }
 
+struct sql_scheduler_tenant_st {
+    const char *name;
+    int code;
+} sql_scheduler_tenant_vals[] = {{"USER", SQL_SCHED_TENANT_USER},
+                                 {"HOST", SQL_SCHED_TENANT_HOST},
+                                 {"FINGERPRINT", SQL_SCHED_TENANT_FINGERPRINT}};
+
+static int sql_scheduler_tenant_update(void *context, void *value)
+{
+    comdb2_tunable *tunable;
+    char *tok;
+    int st = 0;
+    int ltok;
+    int len;
+
+    tunable = (comdb2_tunable *)context;
+    len = strlen(value);
+
+    tok = segtok(value, len, &st, &ltok);
+
+    for (int i = 0; i < (sizeof(sql_scheduler_tenant_vals) / sizeof(struct sql_scheduler_tenant_st)); i++) {
+        if (tokcmp(tok, ltok, sql_scheduler_tenant_vals[i].name) == 0) {
+            *(int *)tunable->var = sql_scheduler_tenant_vals[i].code;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void *sql_scheduler_tenant_value(void *context)
+{
+    comdb2_tunable *tunable = (comdb2_tunable *)context;
+
+    for (int i = 0; i < (sizeof(sql_scheduler_tenant_vals) / sizeof(struct sql_scheduler_tenant_st)); i++) {
+        if (sql_scheduler_tenant_vals[i].code == *(int *)tunable->var) {
+            return (void *)sql_scheduler_tenant_vals[i].name;
+        }
+    }
+    return "unknown";
+}
+
 static void *next_genid_value(void *context)
 {
     /*comdb2_tunable *tunable = (comdb2_tunable *)context;*/
@@ -962,6 +1031,17 @@ static int maxcolumns_verify(void *context, void *value)
     return 0;
 }
 
+static int rcache_levels_verify(void *context, void *value)
+{
+    if (*(int *)value < 1 || *(int *)value > RCACHE_MAX_LEVELS) {
+        logmsg(LOGMSG_ERROR,
+               "Invalid value for tunable; should be in range [1, %d].\n",
+               RCACHE_MAX_LEVELS);
+        return 1;
+    }
+    return 0;
+}
+
 static int loghist_update(void *context, void *value)
 {
     comdb2_tunable *tunable = (comdb2_tunable *)context;
@@ -115,6 +115,20 @@ REGISTER_TUNABLE("broken_num_parser", NULL, TUNABLE_BOOLEAN,
 REGISTER_TUNABLE("buffers_per_context", NULL, TUNABLE_INTEGER,
                  &gbl_buffers_per_context, READONLY | NOZERO, NULL, NULL, NULL,
                  NULL);
+REGISTER_TUNABLE("bulk_column_decode",
+                 "Decode adjacent integer and real columns of a row in one "
+                 "pass. (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_bulk_column_decode, 0, NULL, NULL, NULL,
+                 NULL);
+REGISTER_TUNABLE("bulk_load_batch_rows",
+                 "Rows inserted per transaction by bulk load. (Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_bulk_load_batch_rows, NOZERO, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("bulk_load_threads",
+                 "Threads used to parse and insert rows by bulk load. "
+                 "(Default: 8)",
+                 TUNABLE_INTEGER, &gbl_bulk_load_threads, NOZERO, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("bulk_import_validation_werror",
                  "Treat bulk import input validation warnings as errors. "
                  "(Default: on)", TUNABLE_BOOLEAN,
@@ -122,6 +136,10 @@ REGISTER_TUNABLE("bulk_import_validation_werror",
                  NULL);
 REGISTER_TUNABLE("enable_bulk_import", "Enable bulk import. (Default: off)", TUNABLE_BOOLEAN, &gbl_enable_bulk_import,
                  NOARG, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("enable_bulk_load",
+                 "Enable BULKIMPORT of a csv file into a table. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_enable_bulk_load, NOARG, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("enable_bulk_import_different_tables",
                  "Enable bulk import across tables with different names. "
                  "(Default: off)",
@@ -630,6 +648,15 @@ REGISTER_TUNABLE(
     "implies SQLITE_MAX_LENGTH, the limit imposed by sqlite. (Default: 0)",
     TUNABLE_INTEGER, &gbl_group_concat_mem_limit, READONLY, NULL, NULL, NULL,
     NULL);
+REGISTER_TUNABLE("hash_join",
+                 "Build automatic indexes probed only for equality as an "
+                 "in-memory join hash. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_hash_join, 0, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("hash_join_mem_kb",
+                 "Spill a join hash to a temp table past this much memory. "
+                 "(Default: 16384)",
+                 TUNABLE_INTEGER, &gbl_hash_join_mem_kb, NOZERO, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("heartbeat_check_time", "Raise an error if no heartbeat for this amount of time (in secs). (Default: 5 secs)",
                  TUNABLE_INTEGER, &gbl_heartbeat_check, READONLY | NOZERO, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("hostname", NULL, TUNABLE_STRING, &gbl_myhostname,
@@ -638,6 +665,22 @@ REGISTER_TUNABLE("incoherent_alarm_time", NULL, TUNABLE_INTEGER,
                  &gbl_incoherent_alarm_time, READONLY, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("incoherent_msg_freq", NULL, TUNABLE_INTEGER,
                  &gbl_incoherent_msg_freq, READONLY, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("incremental_backup_pgmap",
+                 "Keep a map of changed pages for each data file so that "
+                 "incremental backups only read what changed. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_pgmap_enable, READONLY, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("incremental_backup_pgmap_chunk_pages",
+                 "Number of pages covered by each changed-page map entry. "
+                 "(Default: 64)",
+                 TUNABLE_INTEGER, &gbl_pgmap_chunk_pages,
+                 READONLY | NOZERO, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("incremental_deadlock_detect",
+                 "On each lock wait, search only for cycles through the new "
+                 "waits-for edges and run the full deadlock detector only if "
+                 "one may exist. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_incremental_deadlock_detect, 0, NULL,
+                 NULL, NULL, NULL);
 REGISTER_TUNABLE("inflatelog", NULL, TUNABLE_INTEGER, &gbl_inflate_log,
                  READONLY, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("init_with_bthash", NULL, TUNABLE_INTEGER,
@@ -702,6 +745,10 @@ REGISTER_TUNABLE("iothreads",
                  "Number of threads to use for I/O prefaulting. (Default: 0)",
                  TUNABLE_INTEGER, &gbl_iothreads, READONLY, NULL, NULL, NULL,
                  NULL);
+REGISTER_TUNABLE("ix_key_plans",
+                 "Form index keys from a precompiled per-index plan which "
+                 "copies fixed-width columns directly. (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_ix_key_plans, 0, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("keycompr",
                  "Enable index compression (applies to newly allocated index "
                  "pages, rebuild table to force for all pages.",
@@ -710,6 +757,11 @@ REGISTER_TUNABLE("keycompr",
 REGISTER_TUNABLE("largepages", "Enables large pages. (Default: off)",
                  TUNABLE_BOOLEAN, &gbl_largepages, READONLY | NOARG, NULL, NULL,
                  NULL, NULL);
+REGISTER_TUNABLE("latency_histograms",
+                 "Record sql, commit, replication wait, lock wait and page-in "
+                 "latency histograms for comdb2_metrics. (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_latency_histograms, 0, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("lclpooledbufs", NULL, TUNABLE_INTEGER, &gbl_lclpooled_buffers,
                  READONLY, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("lk_hash", NULL, TUNABLE_INTEGER, &gbl_lk_hash,
@@ -1038,6 +1090,12 @@ REGISTER_TUNABLE("rangextlim", NULL, TUNABLE_INTEGER, &gbl_rangextunit,
 REGISTER_TUNABLE(
     "rcache", "Keep a lookaside cache of root pages for B-trees. (Default: off)",
     TUNABLE_BOOLEAN, &gbl_rcache, READONLY | NOARG, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("rcache_levels",
+                 "Number of levels from the top of a B-tree, counting the "
+                 "root, whose pages the rcache keeps for read-only lookups, "
+                 "at most 8.  Raise rcache_count to match.  (Default: 1)",
+                 TUNABLE_INTEGER, &gbl_rcache_levels, 0, NULL,
+                 rcache_levels_verify, NULL, NULL);
 REGISTER_TUNABLE("reallearly",
                  "Acknowledge as soon as a commit record is seen by the "
                  "replicant (before it's applied). This effectively makes "
@@ -1091,6 +1149,16 @@ REGISTER_TUNABLE("deadlkon", "Same as 'report_deadlock_verbose'",
 REGISTER_TUNABLE("deadlkoff", "Disables 'report_deadlock_verbose'",
                  TUNABLE_BOOLEAN, &gbl_disable_deadlock_trace,
                  INVERSE_VALUE | NOARG, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("log_prefetch_records",
+                 "Read in the pages changed by up to this many log records ahead "
+                 "of the one being applied, in recovery and replicated "
+                 "transactions.  0 disables.  (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_log_prefetch_records, 0, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("recovery_redo_threads",
+                 "Threads redoing page records in the forward pass of "
+                 "recovery, split by file.  0 redoes them on the recovering "
+                 "thread.  (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_recovery_redo_threads, 0, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("rep_process_txn_trace",
                  "If set, report processing time on replicant for all "
                  "transactions. (Default: off)",
@@ -1169,6 +1237,20 @@ REGISTER_TUNABLE("sqlsortermem", "Maximum amount of memory to be "
                                  "(Default: 314572800)",
                  TUNABLE_INTEGER, &gbl_sqlite_sorter_mem, 0, NULL, NULL,
                  NULL, NULL);
+REGISTER_TUNABLE("sql_scheduler",
+                 "Admit requests for the default SQL pool through per-tenant weighted fair queues. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_sql_scheduler, 0, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("sql_scheduler_concurrency",
+                 "Requests the SQL scheduler lets run at once; 0 means the size of the default SQL pool. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_sql_scheduler_concurrency, 0, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("sql_scheduler_cost_aware",
+                 "Charge each request the mean execution time of its fingerprint rather than a flat cost. "
+                 "(Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_sql_scheduler_cost_aware, 0, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("sql_scheduler_tenant",
+                 "What the SQL scheduler groups requests into tenants by: USER, HOST or FINGERPRINT. (Default: USER)",
+                 TUNABLE_ENUM, &gbl_sql_scheduler_tenant, 0, sql_scheduler_tenant_value, NULL,
+                 sql_scheduler_tenant_update, NULL);
 REGISTER_TUNABLE("sql_stat4_scan", "Possibly adjust the cost of a full table "
                                    "scan based on STAT4 data.  (Default: off)",
                  TUNABLE_BOOLEAN, &gbl_sqlite_stat4_scan, READONLY | INTERNAL |
@@ -1339,6 +1421,10 @@ REGISTER_TUNABLE("no_ack_trace", "Disables 'ack_trace'", TUNABLE_BOOLEAN,
                  NULL, NULL);
 REGISTER_TUNABLE("bdblock_debug", NULL, TUNABLE_BOOLEAN, &gbl_bdblock_debug,
                  READONLY | NOARG, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("bdblock_reader_slots",
+                 "Per-cpu reader counts for the bdb lock, so that readers do not share a cache line; 0 makes every "
+                 "reader take the underlying rwlock. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_bdblock_reader_slots, READONLY, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("debug.alter_sequences_sleep",
                  "Sleep for 10 seconds before setting sequence to highest value found in existing column during alter "
                  "table 10 seconds prior (Default: 0)",
@@ -1636,6 +1722,19 @@ REGISTER_TUNABLE("commit_delay_on_copy_ms",
 REGISTER_TUNABLE("commit_delay_trace", "Verbose commit-delays.  (Default: off)",
                  TUNABLE_BOOLEAN, &gbl_commit_delay_trace,
                  EXPERIMENTAL | INTERNAL, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("commit_ack_coordinator",
+                 "Queue commits waiting for replicant acks by lsn and wake only "
+                 "those an ack covers.  (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_commit_ack_coordinator, 0, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("rep_ack_coalesce_us",
+                 "Replicants send at most one ack per this many microseconds, "
+                 "covering everything applied since.  0 acks each transaction.  "
+                 "(Default: 0)",
+                 TUNABLE_INTEGER, &gbl_rep_ack_coalesce_us, 0, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("rep_ack_coalesce_bytes",
+                 "Send a coalesced replicant ack early once the log has advanced "
+                 "this many bytes past the last ack.  (Default: 262144)",
+                 TUNABLE_INTEGER, &gbl_rep_ack_coalesce_bytes, 0, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("test_commit_lsn_map", "Maintain a map of transaction commit LSNs. (Default: off)",
                  TUNABLE_BOOLEAN, &gbl_test_commit_lsn_map,
                  NOARG | INTERNAL, NULL, NULL, NULL, NULL);
@@ -1754,6 +1853,24 @@ REGISTER_TUNABLE("queuedb_timeout_sec",
                  "Unassign Lua consumer/trigger if no heartbeat received for this time",
                  TUNABLE_INTEGER, &gbl_queuedb_timeout_sec, 0, NULL, NULL, NULL, NULL);
 
+REGISTER_TUNABLE("osql_coalesce_max_ops",
+                 "Keep up to this many socksql row ops in the shadow tables, "
+                 "so repeated writes to a row reach the master coalesced. "
+                 "0 sends every op as it happens. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_osql_coalesce_max_ops, 0, NULL, NULL, NULL, NULL);
+
+REGISTER_TUNABLE("osql_stream_apply_ops",
+                 "Dispatch a socksql transaction once this many ops reach the "
+                 "master, and apply the rest as they arrive. "
+                 "0 waits for the whole transaction. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_osql_stream_apply_ops, 0, NULL, NULL, NULL, NULL);
+
+REGISTER_TUNABLE("osql_stream_apply_wait_ms",
+                 "Longest a streamed socksql transaction waits for its next "
+                 "op while holding locks on the master, before it releases "
+                 "them and is applied once it is complete. (Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_osql_stream_apply_wait_ms, 0, NULL, NULL, NULL, NULL);
+
 REGISTER_TUNABLE("osql_send_startgen",
                  "Send start-generation in osql stream. (Default: on)",
                  TUNABLE_BOOLEAN, &gbl_osql_send_startgen,
@@ -1847,6 +1964,19 @@ REGISTER_TUNABLE(
     "Maximum number of parallel threads, otherwise run sequential.",
     TUNABLE_INTEGER, &gbl_dohsql_max_threads, 0, NULL, NULL, NULL, NULL);
 
+REGISTER_TUNABLE(
+    "dohsql_parallel_scan",
+    "Split a scan of a single large table into this many key range slices "
+    "run in parallel; 0 disables it. (Default: 0)",
+    TUNABLE_INTEGER, &gbl_dohsql_parallel_scan, 0, NULL, NULL, NULL, NULL);
+
+REGISTER_TUNABLE(
+    "dohsql_parallel_scan_min_rows",
+    "Only split scans of tables estimated by analyze to have at least this "
+    "many rows. (Default: 100000)",
+    TUNABLE_INTEGER, &gbl_dohsql_parallel_scan_min_rows, 0, NULL, NULL, NULL,
+    NULL);
+
 REGISTER_TUNABLE(
     "dohsql_pool_thread_slack",
     "Forbid parallel sql coordinators from running on this many sql engines"
@@ -2218,6 +2348,20 @@ REGISTER_TUNABLE("memp_dump_cache_threshold",
                  TUNABLE_INTEGER, &gbl_memp_dump_cache_threshold, 0, NULL, NULL,
                  NULL, NULL);
 
+REGISTER_TUNABLE("memp_probation_pct",
+                 "Pages read into the cache and not referenced again are "
+                 "aged by this percentage of the cache when released, so "
+                 "large scans do not evict frequently used pages.  0 "
+                 "disables.  (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_memp_probation_pct, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("memp_probation_min_age_pct",
+                 "A page read into the cache is only treated as used again "
+                 "if it is fetched after this percentage of the cache has "
+                 "been released since it was read in.  (Default: 25)",
+                 TUNABLE_INTEGER, &gbl_memp_probation_min_age_pct, 0, NULL,
+                 NULL, NULL, NULL);
+
 REGISTER_TUNABLE("snapshot_serial_verify_retry",
                  "Automatic retries on verify errors for clients that haven't "
                  "read results.  (Default: on)",
@@ -2463,6 +2607,18 @@ REGISTER_TUNABLE("sc_logbytes_per_second",
                  "Throttle schema-changes to this many logbytes per second.  (Default: 10000000)",
                  TUNABLE_INTEGER, &gbl_sc_logbytes_per_second, EXPERIMENTAL | INTERNAL, NULL, NULL, NULL, NULL);
 
+REGISTER_TUNABLE("net_compress",
+                 "Send batches of messages lz4 compressed to nodes which can decode them.  (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_net_compress, 0, NULL, NULL, NULL, NULL);
+
+REGISTER_TUNABLE("net_compress_min_bytes",
+                 "Only compress batches of at least this many bytes.  (Default: 4096)",
+                 TUNABLE_INTEGER, &gbl_net_compress_min_bytes, 0, NULL, NULL, NULL, NULL);
+
+REGISTER_TUNABLE("net_compress_min_rtt_us",
+                 "Only compress on links with a round trip time of at least this many microseconds.  (Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_net_compress_min_rtt_us, 0, NULL, NULL, NULL, NULL);
+
 REGISTER_TUNABLE("net_somaxconn",
                  "listen() backlog setting.  (Default: 0, implies system default)",
                  TUNABLE_INTEGER, &gbl_net_maxconn, READONLY, NULL, NULL, NULL, NULL);
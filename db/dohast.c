@@ -14,6 +14,8 @@
    limitations under the License.
  */
 
+#include <math.h>
+
 #include "comdb2.h"
 #include "sqliteInt.h"
 #include "vdbeInt.h"
@@ -21,10 +23,13 @@
 #include "dohsql.h"
 #include "sql.h"
 #include "fdb_fend.h"
+#include "memcompare.c"
 
 int gbl_dohast_disable = 0;
 int gbl_dohast_verbose = 0;
 int gbl_dohsql_joins = 1;
+int gbl_dohsql_parallel_scan = 0;
+int gbl_dohsql_parallel_scan_min_rows = 100000;
 
 static void node_free(dohsql_node_t **pnode, sqlite3 *db);
 static void _save_params(Parse *pParse, dohsql_node_t *node);
@@ -172,7 +177,8 @@ Expr *_find_join_constrains(Expr *where, int iRightJoinTable)
 
 char *sqlite_struct_to_string(Vdbe *v, Select *p, Expr *extraRows,
                               int *order_size, int **order_dir,
-                              struct params_info **pParamsOut, int is_union)
+                              struct params_info **pParamsOut, int is_union,
+                              const char *slice)
 {
     char *cols = NULL;
     char *tbl = NULL;
@@ -213,6 +219,16 @@ char *sqlite_struct_to_string(Vdbe *v, Select *p, Expr *extraRows,
         }
     }
 
+    if (slice) {
+        /* restrict to the key range of one parallel scan slice */
+        char *sliced = where ? sqlite3_mprintf("(%s) aND %s", where, slice)
+                             : sqlite3_mprintf("%s", slice);
+        sqlite3_free(where);
+        if (!sliced)
+            return NULL;
+        where = sliced;
+    }
+
     if (p->pOrderBy) {
         orderby = describeExprList(v, p->pOrderBy, order_size, order_dir,
                                    pParamsOut, is_union);
@@ -498,7 +514,7 @@ void ast_destroy(ast_t **past, sqlite3 *db)
 
 static dohsql_node_t *gen_oneselect(Vdbe *v, Select *p, Expr *extraRows,
                                     int *order_size, int **order_dir,
-                                    int is_union)
+                                    int is_union, const char *slice)
 {
     dohsql_node_t *node;
     Select *prior = p->pPrior;
@@ -518,7 +534,7 @@ static dohsql_node_t *gen_oneselect(Vdbe *v, Select *p, Expr *extraRows,
     node->type = AST_TYPE_SELECT;
     p->pPrior = p->pNext = NULL;
     node->sql = sqlite_struct_to_string(v, p, extraRows, order_size, order_dir,
-                                        &node->params, is_union);
+                                        &node->params, is_union, slice);
     p->pPrior = prior;
     p->pNext = next;
 
@@ -627,7 +643,7 @@ static dohsql_node_t *gen_union(Vdbe *v, Select *p, int span)
         assert(crt == p || !crt->pOrderBy); /* can "restore" to NULL? */
         crt->pOrderBy = p->pOrderBy;
         *psub = gen_oneselect(v, crt, pOffset, &node->order_size,
-                              &node->order_dir, 1);
+                              &node->order_dir, 1, NULL);
         crt->pLimit = NULL;
         if (crt != p)
             crt->pOrderBy = NULL;
@@ -733,7 +749,7 @@ static dohsql_node_t *gen_select(Vdbe *v, Select *p)
         return NULL;
 
     if (p->op == TK_SELECT) {
-        ret = gen_oneselect(v, p, NULL, NULL, NULL, 0);
+        ret = gen_oneselect(v, p, NULL, NULL, NULL, 0, NULL);
         if (ret) {
             /* single query case, can we push this remotely? */
             int i;
@@ -774,6 +790,412 @@ static dohsql_node_t *gen_select(Vdbe *v, Select *p)
     return ret;
 }
 
+/* Pick an index whose leading column can cut a scan of pTab into key ranges:
+ * it needs stat4 samples to place the boundaries at, and a column type whose
+ * sample values print back as sql literals.  If iLead is not negative, the
+ * index must lead with that column. */
+static Index *_scan_slice_index(Table *pTab, int iLead)
+{
+    Index *pIdx;
+
+    for (pIdx = pTab->pIndex; pIdx; pIdx = pIdx->pNext) {
+        int iCol = pIdx->aiColumn[0];
+        if (iCol < 0 || pIdx->pPartIdxWhere || pIdx->nSample < 2 ||
+            !pIdx->aiRowEst || pIdx->aSortOrder[0] != SQLITE_SO_ASC ||
+            (iLead >= 0 && iCol != iLead))
+            continue;
+        if (sqlite3StrICmp(pIdx->azColl[0], sqlite3StrBINARY))
+            continue;
+        switch (pTab->aCol[iCol].affinity) {
+        case SQLITE_AFF_TEXT:
+        case SQLITE_AFF_NUMERIC:
+        case SQLITE_AFF_INTEGER:
+        case SQLITE_AFF_REAL:
+            return pIdx;
+        }
+    }
+    return NULL;
+}
+
+/* If e is a column of pTab, as cursor iCur, that leads one of its indexes,
+ * return the column number, otherwise -1 */
+static int _index_lead(Table *pTab, int iCur, Expr *e)
+{
+    Index *pIdx;
+
+    e = sqlite3ExprSkipCollate(e);
+    if (!e || e->op != TK_COLUMN || e->iTable != iCur || e->iColumn < 0)
+        return -1;
+    for (pIdx = pTab->pIndex; pIdx; pIdx = pIdx->pNext) {
+        if (pIdx->aiColumn[0] == e->iColumn && !pIdx->pPartIdxWhere)
+            return e->iColumn;
+    }
+    return -1;
+}
+
+/* How the where clause lets the plan search an index of pTab */
+enum { SLICE_SCAN = 0, SLICE_RANGE = 1, SLICE_NONE = 2 };
+
+static int _slice_merge(int a, int iColA, int b, int iColB, int *piCol)
+{
+    if (a == SLICE_NONE || b == SLICE_NONE)
+        return SLICE_NONE;
+    if (a == SLICE_RANGE && b == SLICE_RANGE && iColA != iColB)
+        return SLICE_NONE;
+    *piCol = (a == SLICE_RANGE) ? iColA : iColB;
+    return a > b ? a : b;
+}
+
+/* SLICE_SCAN: no index lead column is constrained, the plan scans.
+ * SLICE_RANGE: only ranges on the leading column *piCol of an index, which
+ * the plan searches; the slices are cut inside that range.
+ * SLICE_NONE: an equality, IN or IS NULL on an index lead column, ranges on
+ * the lead columns of two indexes, or an OR whose every branch can search an
+ * index; these stay serial. */
+static int _where_slicing(Table *pTab, int iCur, Expr *pWhere, int *piCol)
+{
+    int a, b, iColA = -1, iColB = -1;
+
+    if (!pWhere)
+        return SLICE_SCAN;
+    switch (pWhere->op) {
+    case TK_AND:
+        a = _where_slicing(pTab, iCur, pWhere->pLeft, &iColA);
+        b = _where_slicing(pTab, iCur, pWhere->pRight, &iColB);
+        return _slice_merge(a, iColA, b, iColB, piCol);
+    case TK_OR:
+        /* the plan can only use an index for an OR if every branch can */
+        a = _where_slicing(pTab, iCur, pWhere->pLeft, &iColA);
+        b = _where_slicing(pTab, iCur, pWhere->pRight, &iColB);
+        return (a != SLICE_SCAN && b != SLICE_SCAN) ? SLICE_NONE : SLICE_SCAN;
+    case TK_EQ:
+    case TK_IS:
+    case TK_LT:
+    case TK_LE:
+    case TK_GT:
+    case TK_GE:
+        if ((*piCol = _index_lead(pTab, iCur, pWhere->pLeft)) >= 0 &&
+            sqlite3ExprIsConstant(pWhere->pRight))
+            ;
+        else if ((*piCol = _index_lead(pTab, iCur, pWhere->pRight)) >= 0 &&
+                 sqlite3ExprIsConstant(pWhere->pLeft))
+            ;
+        else
+            return SLICE_SCAN;
+        return (pWhere->op == TK_EQ || pWhere->op == TK_IS) ? SLICE_NONE
+                                                            : SLICE_RANGE;
+    case TK_BETWEEN:
+        *piCol = _index_lead(pTab, iCur, pWhere->pLeft);
+        return *piCol >= 0 ? SLICE_RANGE : SLICE_SCAN;
+    case TK_IN:
+    case TK_ISNULL:
+        return _index_lead(pTab, iCur, pWhere->pLeft) >= 0 ? SLICE_NONE
+                                                           : SLICE_SCAN;
+    }
+    return SLICE_SCAN;
+}
+
+/* Compare pVal to the constant e, converted to the affinity of the column.
+ * Returns 0 and sets *pCmp, or -1 if e is not a literal */
+static int _slice_cmp(sqlite3 *db, char aff, sqlite3_value *pVal, Expr *e,
+                      int *pCmp)
+{
+    sqlite3_value *pC = NULL;
+
+    if (sqlite3ValueFromExpr(db, e, SQLITE_UTF8, aff, &pC) || !pC)
+        return -1;
+    if (sqlite3_value_type(pC) == SQLITE_NULL) {
+        sqlite3ValueFree(pC);
+        return -1;
+    }
+    *pCmp = sqlite3MemCompare(pVal, pC, NULL);
+    sqlite3ValueFree(pC);
+    return 0;
+}
+
+/* Does pVal, a value of the lead column iCol, pass every range term on that
+ * column in the and-ed terms of pWhere?  1 if so, 0 if not, -1 if a bound is
+ * not a literal */
+static int _slice_in_range(sqlite3 *db, Table *pTab, int iCur, int iCol,
+                           Expr *pWhere, sqlite3_value *pVal)
+{
+    char aff = pTab->aCol[iCol].affinity;
+    int op, rc, cmp, cmp2;
+    Expr *pBound;
+
+    if (!pWhere)
+        return 1;
+    switch (pWhere->op) {
+    case TK_AND:
+        rc = _slice_in_range(db, pTab, iCur, iCol, pWhere->pLeft, pVal);
+        if (rc != 1)
+            return rc;
+        return _slice_in_range(db, pTab, iCur, iCol, pWhere->pRight, pVal);
+    case TK_LT:
+    case TK_LE:
+    case TK_GT:
+    case TK_GE:
+        op = pWhere->op;
+        if (_index_lead(pTab, iCur, pWhere->pLeft) == iCol) {
+            pBound = pWhere->pRight;
+        } else if (_index_lead(pTab, iCur, pWhere->pRight) == iCol) {
+            /* "bound op column" is "column op' bound" */
+            pBound = pWhere->pLeft;
+            op = op == TK_LT ? TK_GT : op == TK_LE ? TK_GE
+               : op == TK_GT ? TK_LT : TK_LE;
+        } else {
+            return 1;
+        }
+        if (_slice_cmp(db, aff, pVal, pBound, &cmp))
+            return -1;
+        switch (op) {
+        case TK_LT: return cmp < 0;
+        case TK_LE: return cmp <= 0;
+        case TK_GT: return cmp > 0;
+        default:    return cmp >= 0;
+        }
+    case TK_BETWEEN:
+        if (_index_lead(pTab, iCur, pWhere->pLeft) != iCol)
+            return 1;
+        if (_slice_cmp(db, aff, pVal, pWhere->x.pList->a[0].pExpr, &cmp) ||
+            _slice_cmp(db, aff, pVal, pWhere->x.pList->a[1].pExpr, &cmp2))
+            return -1;
+        return cmp >= 0 && cmp2 <= 0;
+    }
+    return 1;
+}
+
+/* Leading column of a stat4 sample as a literal, if it is of the type the
+ * column affinity expects */
+static char *_slice_bound(Index *pIdx, sqlite3_value *pVal)
+{
+    char aff = pIdx->pTable->aCol[pIdx->aiColumn[0]].affinity;
+    char *bound = NULL;
+    double r;
+
+    switch (sqlite3_value_type(pVal)) {
+    case SQLITE_INTEGER:
+        if (aff != SQLITE_AFF_TEXT)
+            bound = sqlite3_mprintf("%lld", sqlite3_value_int64(pVal));
+        break;
+    case SQLITE_FLOAT:
+        r = sqlite3_value_double(pVal);
+        if (aff != SQLITE_AFF_TEXT && isfinite(r))
+            bound = sqlite3_mprintf("%!.17g", r);
+        break;
+    case SQLITE_TEXT:
+        if (aff == SQLITE_AFF_TEXT)
+            bound = sqlite3_mprintf("'%q'", sqlite3_value_text(pVal));
+        break;
+    }
+    return bound;
+}
+
+/* Leading column of stat4 sample j of pIdx, or NULL */
+static sqlite3_value *_slice_sample(sqlite3 *db, Index *pIdx, int j)
+{
+    sqlite3_value *pVal = NULL;
+
+    if (sqlite3Stat4Column(db, pIdx->aSample[j].p, pIdx->aSample[j].n, 0,
+                           &pVal))
+        return NULL;
+    return pVal;
+}
+
+/**
+ * Split a full scan of a single large local table into key range slices
+ * on the leading column of an analyzed index, one child select each, so
+ * they run as the branches of a parallel union all.  The boundaries are
+ * the stat4 samples nearest to equal row count quantiles.  If the where
+ * clause holds the leading column of an index to a range, that index is
+ * searched, so the slices are cut on it and only the samples inside the
+ * range are used.  Only plain row streams are split; aggregates, distinct
+ * and limits are left alone since the union has no way to combine partial
+ * results, and so are queries that look up an index by equality, IN or an
+ * OR (see _where_slicing).
+ * Returns the union node and frees "single", or returns "single"
+ */
+static dohsql_node_t *gen_scan_slices(Vdbe *v, Select *p,
+                                      dohsql_node_t *single)
+{
+    struct SrcList_item *src = &p->pSrc->a[0];
+    Table *pTab = src->pTab;
+    dohsql_node_t *node = NULL;
+    Index *pIdx;
+    char **bounds = NULL;
+    char **slices = NULL;
+    const char *zCol;
+    const char *zTab;
+    tRowcnt nRow, lo, hi;
+    int nbounds = 0;
+    int nslices;
+    int nnodes;
+    int nullable;
+    int how, iLead = -1;
+    int i, j, j0, j1;
+
+    if (p->pSrc->nSrc != 1 || !pTab || pTab->pSelect || IsVirtual(pTab) ||
+        pTab->iDb > 1 || single->remotedb || p->pLimit || p->pWin ||
+        (p->selFlags & (SF_Aggregate | SF_Distinct)))
+        return single;
+    how = _where_slicing(pTab, src->iCursor, p->pWhere, &iLead);
+    if (how == SLICE_NONE)
+        return single;
+    /* a merge of ordered slices needs the sort keys in the result set */
+    if (p->pOrderBy) {
+        for (i = 0; i < p->pOrderBy->nExpr; i++) {
+            if (p->pOrderBy->a[i].u.x.iOrderByCol == 0)
+                return single;
+        }
+    }
+
+    pIdx = _scan_slice_index(pTab, how == SLICE_RANGE ? iLead : -1);
+    if (!pIdx)
+        return single;
+
+    /* the rows to share out lie from sample j0 to sample j1 */
+    j0 = 0;
+    j1 = pIdx->nSample - 1;
+    if (how == SLICE_RANGE) {
+        j0 = -1;
+        for (j = 0; j < pIdx->nSample; j++) {
+            sqlite3_value *pVal = _slice_sample(v->db, pIdx, j);
+            int in;
+
+            if (!pVal)
+                return single;
+            in = _slice_in_range(v->db, pTab, src->iCursor, iLead, p->pWhere,
+                                 pVal);
+            sqlite3ValueFree(pVal);
+            if (in < 0)
+                return single;
+            if (in) {
+                if (j0 < 0)
+                    j0 = j;
+                j1 = j;
+            }
+        }
+        if (j0 < 0)
+            return single;
+        lo = pIdx->aSample[j0].anLt[0];
+        hi = pIdx->aSample[j1].anLt[0] + pIdx->aSample[j1].anEq[0];
+    } else {
+        lo = 0;
+        hi = pIdx->aiRowEst[0];
+    }
+    nRow = hi - lo;
+    if (nRow < gbl_dohsql_parallel_scan_min_rows)
+        return single;
+
+    zCol = pTab->aCol[pIdx->aiColumn[0]].zName;
+    zTab = src->zAlias ? src->zAlias : src->zName;
+    /* a range never matches nulls */
+    nullable = how == SLICE_SCAN &&
+               pTab->aCol[pIdx->aiColumn[0]].notNull == OE_None;
+
+    nslices = gbl_dohsql_parallel_scan;
+    if (gbl_dohsql_max_threads && nslices + nullable > gbl_dohsql_max_threads)
+        nslices = gbl_dohsql_max_threads - nullable;
+    if (nslices < 2)
+        return single;
+
+    bounds = calloc(nslices, sizeof(char *));
+    slices = calloc(nslices + 1, sizeof(char *));
+    if (!bounds || !slices)
+        goto done;
+
+    for (i = 1, j = j0; i < nslices && j <= j1; i++) {
+        tRowcnt target = lo + nRow / nslices * i;
+        sqlite3_value *pVal;
+        char *bound;
+
+        while (j <= j1 && pIdx->aSample[j].anLt[0] < target)
+            j++;
+        if (j > j1)
+            break;
+        pVal = _slice_sample(v->db, pIdx, j++);
+        bound = pVal ? _slice_bound(pIdx, pVal) : NULL;
+        sqlite3ValueFree(pVal);
+        if (!bound)
+            goto done;
+        if (nbounds && !strcmp(bound, bounds[nbounds - 1])) {
+            sqlite3_free(bound);
+            continue;
+        }
+        bounds[nbounds++] = bound;
+    }
+    if (nbounds == 0)
+        goto done;
+
+    nnodes = 0;
+    if (nullable)
+        slices[nnodes++] =
+            sqlite3_mprintf("\"%w\".\"%w\" iS NuLL", zTab, zCol);
+    slices[nnodes++] =
+        sqlite3_mprintf("\"%w\".\"%w\" < %s", zTab, zCol, bounds[0]);
+    for (i = 1; i < nbounds; i++)
+        slices[nnodes++] =
+            sqlite3_mprintf("\"%w\".\"%w\" >= %s aND \"%w\".\"%w\" < %s", zTab,
+                            zCol, bounds[i - 1], zTab, zCol, bounds[i]);
+    slices[nnodes++] = sqlite3_mprintf("\"%w\".\"%w\" >= %s", zTab, zCol,
+                                       bounds[nbounds - 1]);
+    for (i = 0; i < nnodes; i++) {
+        if (!slices[i])
+            goto done;
+    }
+
+    node = (dohsql_node_t *)calloc(1, sizeof(dohsql_node_t) +
+                                          nnodes * sizeof(void *));
+    if (!node)
+        goto done;
+
+    node->type = AST_TYPE_UNION;
+    node->nodes = (dohsql_node_t **)(node + 1);
+    node->nnodes = nnodes;
+    node->ncols = p->pEList->nExpr;
+
+    for (i = 0; i < nnodes; i++) {
+        char *tmp;
+        node->nodes[i] = gen_oneselect(v, p, NULL, &node->order_size,
+                                       &node->order_dir, 1, slices[i]);
+        if (!node->nodes[i]) {
+            node_free(&node, v->db);
+            goto done;
+        }
+        if (i > 0)
+            tmp = sqlite3_mprintf("%s uNioN aLL %s", node->sql,
+                                  node->nodes[i]->sql);
+        else
+            tmp = sqlite3_mprintf("%s", node->nodes[i]->sql);
+        sqlite3_free(node->sql);
+        node->sql = tmp;
+        if (!tmp) {
+            node_free(&node, v->db);
+            goto done;
+        }
+    }
+
+    if (gbl_dohast_verbose)
+        logmsg(LOGMSG_USER, "%p Scan of %s split in %d slices on %s.%s\n",
+               (void *)pthread_self(), pTab->zName, nnodes, pIdx->zName, zCol);
+
+done:
+    if (slices) {
+        for (i = 0; i < nslices + 1; i++)
+            sqlite3_free(slices[i]);
+        free(slices);
+    }
+    if (bounds) {
+        for (i = 0; i < nbounds; i++)
+            sqlite3_free(bounds[i]);
+        free(bounds);
+    }
+    if (!node)
+        return single;
+    node_free(&single, v->db);
+    return node;
+}
+
 int ast_push(ast_t *ast, enum ast_type op, Vdbe *v, void *obj)
 {
     int ignore = 0;
@@ -798,8 +1220,12 @@ int ast_push(ast_t *ast, enum ast_type op, Vdbe *v, void *obj)
         Select *p = (Select *)obj;
 
         if ((p->selFlags & SF_ASTIncluded) == 0) {
+            dohsql_node_t *node = gen_select(v, p);
+            if (node && node->type == AST_TYPE_SELECT &&
+                gbl_dohsql_parallel_scan > 1)
+                node = gen_scan_slices(v, p, node);
             ast->stack[ast->nused].op = op;
-            ast->stack[ast->nused].obj = gen_select(v, p);
+            ast->stack[ast->nused].obj = node;
             ast->nused++;
         } else {
             ignore = 1;
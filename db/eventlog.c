@@ -410,6 +410,22 @@ void eventlog_perfdata(cson_object *obj, const struct reqlogger *logger)
                             cson_new_int(thread_stats->pwrite_time_us));
         }
     }
+
+    /* where the request spent its time, by wait event */
+    cson_value *waitval = cson_value_new_object();
+    cson_object *waitobj = cson_value_get_object(waitval);
+    cson_object_set(waitobj, "cpu", cson_new_int(logger->cpuus));
+    for (int i = 0; i < THD_WAIT_MAX; i++) {
+        if (thread_stats->n_waits[i] == 0)
+            continue;
+        cson_object_set(waitobj, thread_wait_event_name(i),
+                        cson_new_int(thread_stats->wait_time_us[i]));
+    }
+    if (thread_stats->n_waits[THD_WAIT_OSQL])
+        cson_object_set(waitobj, "osql_round_trips",
+                        cson_new_int(thread_stats->n_waits[THD_WAIT_OSQL]));
+    cson_object_set(perfobj, "waits", waitval);
+
     cson_object_set(obj, "perf", perfval);
 }
 
@@ -4100,6 +4100,7 @@ int backend_open_tran(struct dbenv *dbenv, tran_type *tran, uint32_t flags)
                    dbenv->basedir, db->tablename, bdberr);
             return -1;
         }
+        javasp_set_queue_partitions(db);
     }
     if (fix_consumers_with_bdblib(dbenv) != 0)
         return -1;
@@ -5307,6 +5308,33 @@ int dbq_add(struct ireq *iq, void *trans, const void *dta, size_t dtalen)
     return dbq_add_recno(iq, trans, 0, dta, dtalen);
 }
 
+/* Add to one partition of a partitioned queuedb. */
+int dbq_add_partition(struct ireq *iq, void *trans, const void *dta,
+                      size_t dtalen, int partition)
+{
+    int bdberr = 0;
+    unsigned long long genid = 0;
+    bdb_state_type *bdb_handle = get_bdb_handle_ireq(iq, AUXDB_NONE);
+    if (!bdb_handle)
+        return ERR_NO_AUXDB;
+    if (bdb_get_type(bdb_handle) != BDBTYPE_QUEUEDB)
+        return dbq_add(iq, trans, dta, dtalen);
+    iq->gluewhere = "bdb_queue_add_partition";
+    bdb_queue_add_partition(bdb_handle, trans, dta, dtalen, partition, &bdberr,
+                            &genid);
+    iq->gluewhere = "bdb_queue_add_partition done";
+
+    if (bdberr == 0)
+        return 0;
+    if (bdberr == BDBERR_DEADLOCK)
+        return RC_INTERNAL_RETRY;
+    if (bdberr == BDBERR_READONLY)
+        return ERR_NOMASTER;
+    if (bdberr == BDBERR_ADD_DUPE)
+        return IX_DUP;
+    return map_unhandled_bdb_wr_rcode("bdb_queue_add_partition", bdberr);
+}
+
 int dbq_consume(struct ireq *iq, void *trans, int consumer, const struct bdb_queue_found *fnd)
 {
     int bdberr;
@@ -116,6 +116,9 @@ int osql_blkseq_register_ireq(struct ireq *iq)
     if (!iq_src) { /* not there, we add it */
         hash_add(hiqs_cnonce, IQ_SNAPINFO(iq));
         rc = OSQL_BLOCKSEQ_FIRST;
+    } else if (iq_src == IQ_SNAPINFO(iq)) {
+        /* a retried streamed session, see osql_blkseq_try_register_ireq */
+        rc = OSQL_BLOCKSEQ_FIRST;
     }
     Pthread_mutex_unlock(&hmtx);
 #ifdef DEBUG_BLKSEQ
@@ -145,6 +148,24 @@ int osql_blkseq_register_ireq(struct ireq *iq)
     return rc;
 }
 
+int osql_blkseq_try_register_ireq(struct ireq *iq)
+{
+    void *iq_src = NULL;
+    int rc = OSQL_BLOCKSEQ_FIRST;
+
+    assert(hiqs_cnonce != NULL);
+
+    Pthread_mutex_lock(&hmtx);
+    iq_src = hash_find(hiqs_cnonce, IQ_SNAPINFO(iq));
+    if (!iq_src)
+        hash_add(hiqs_cnonce, IQ_SNAPINFO(iq));
+    else if (iq_src != IQ_SNAPINFO(iq)) /* not registered by an earlier try */
+        rc = OSQL_BLOCKSEQ_REPLAY;
+    Pthread_mutex_unlock(&hmtx);
+
+    return rc;
+}
+
 /* call with hmtx acquired */
 static inline int osql_blkseq_unregister_ireq(struct ireq *iq)
 {
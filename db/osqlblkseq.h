@@ -59,6 +59,16 @@ int osql_blkseq_unregister_cnonce(void *cnonce, int len);
  */
 int osql_blkseq_register_ireq(struct ireq *iq);
 
+/**
+ * Same as osql_blkseq_register_ireq, without waiting for a request that has
+ * the cnonce already; a streamed session only learns its cnonce with its
+ * last op, by when it holds locks the other request may need
+ * - if the cnonce is held by another request, return OSQL_BLOCKSEQ_REPLAY
+ * - otherwise insert it (if needed) and return OSQL_BLOCKSEQ_FIRST
+ *
+ */
+int osql_blkseq_try_register_ireq(struct ireq *iq);
+
 /**
  * Main function
  * - check to see if the seq exists
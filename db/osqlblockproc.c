@@ -22,6 +22,8 @@
  * that is send and accumulated on the master in a session
  * Once the last bplog message is received, the bplog can be passed to
  * a block processor that runs the actual transaction
+ * With osql_stream_apply_ops, large socksql sessions are passed earlier and
+ * the block processor applies each op once it is received
  *
  */
 #include <stdio.h>
@@ -55,6 +57,7 @@
 #include "sc_logic.h"
 #include "gettimeofday_ms.h"
 #include "eventlog.h"
+#include "osqlblkseq.h"
 #include <disttxn.h>
 
 extern int gbl_reorder_idx_writes;
@@ -110,7 +113,8 @@ static int apply_changes(struct ireq *iq, blocksql_tran_t *tran, void *iq_tran,
                          int (*func)(struct ireq *, uuid_t, void *, char **,
                                      int, int *, int **,
                                      blob_buffer_t blobs[MAXBLOBS], int,
-                                     struct block_err *, int *));
+                                     struct block_err *, int *),
+                         int streamed);
 static int req2blockop(int reqtype);
 extern const char *get_tablename_from_rpl(int is_uuid, const char *rpl,
                                           int *tableversion);
@@ -332,6 +336,32 @@ static int osql_process_selectv(blocksql_tran_t *tran,
     return hash_for(tran->selectv_genids, process_selectv, &hf_args);
 }
 
+/**
+ * Look for a replay of a streamed session once its cnonce is in.  The
+ * request with the same cnonce is not waited for here, since this one holds
+ * the locks of its applied ops.
+ * Returns RC_INTERNAL_RETRY for a replay, 0 otherwise
+ *
+ */
+static int stream_check_replay(struct ireq *iq)
+{
+    void *replay_data = NULL;
+    int replay_len = 0;
+
+    if (osql_blkseq_try_register_ireq(iq) != OSQL_BLOCKSEQ_FIRST)
+        return RC_INTERNAL_RETRY;
+
+    if (bdb_blkseq_find(thedb->bdb_env, NULL, IQ_SNAPINFO(iq)->key,
+                        IQ_SNAPINFO(iq)->keylen, &replay_data,
+                        &replay_len) == IX_FND) {
+        free(replay_data);
+        /* the retry registers it again */
+        osql_blkseq_unregister(iq);
+        return RC_INTERNAL_RETRY;
+    }
+    return 0;
+}
+
 /**
  * Wait for all pending osql sessions of this transaction to finish
  * Once all finished ok, we apply all the changes
@@ -341,17 +371,49 @@ int osql_bplog_commit(struct ireq *iq, void *iq_trans, int *nops,
 {
     blocksql_tran_t *tran = iq->sorese->tran;
     ckgenid_state_t cgstate = {.iq = iq, .trans = iq_trans, .err = err};
+    int streamed = 0;
     int rc;
 
-    /* Pre-process selectv's, getting a writelock on rows that are later updated
+    /* A streamed session is applied while its ops arrive, unless it ran
+       into something that needs the whole bplog */
+    if (osql_sess_is_streamed(iq->sorese)) {
+        rc = osql_sess_stream_wait(iq->sorese, -1);
+        if (rc == OSQL_STREAM_ABORT) {
+            osql_sess_stream_end(iq->sorese);
+            err->blockop_num = 0;
+            err->errcode = ERR_NOMASTER;
+            err->ixnum = 0;
+            reqlog_set_error(iq->reqlogger, "ERR_NOMASTER", ERR_NOMASTER);
+            iq->timings.req_applied = osql_log_time();
+            return ERR_NOMASTER;
+        }
+        streamed = (rc == OSQL_STREAM_OK);
+    }
+
+    /* Pre-process selectv's, getting a writelock on rows that are later updated;
+     * a streamed session has not received them yet
      */
-    if ((rc = osql_process_selectv(tran, pselectv_callback, &cgstate)) != 0) {
+    if (!streamed &&
+        (rc = osql_process_selectv(tran, pselectv_callback, &cgstate)) != 0) {
         iq->timings.req_applied = osql_log_time();
         return rc;
     }
 
     /* apply changes */
-    rc = apply_changes(iq, tran, iq_trans, nops, err, osql_process_packet);
+    rc = apply_changes(iq, tran, iq_trans, nops, err, osql_process_packet,
+                       streamed);
+
+    /* a streamed session was dispatched before its cnonce came in with
+       OSQL_DONE_SNAP, so toblock could not look for a replay; do it now,
+       before the commit.  A replay is retried, and the retry takes the
+       early replay path without applying anything */
+    if (streamed && rc == 0 && IQ_HAS_SNAPINFO_KEY(iq)) {
+        rc = stream_check_replay(iq);
+    }
+
+    /* unless it is retried, the session gets no more ops */
+    if (osql_sess_is_streamed(iq->sorese) && rc != RC_INTERNAL_RETRY)
+        osql_sess_stream_end(iq->sorese);
 
     iq->timings.req_applied = osql_log_time();
 
@@ -1138,12 +1200,125 @@ static int process_this_session(
     return rc_out;
 }
 
+/* Same as process_this_session, for a session dispatched before its bplog
+ * was complete: ops are applied in the order they were saved, each one
+ * as soon as it is in */
+static int process_streamed_session(
+    struct ireq *iq, void *iq_tran, osql_sess_t *sess, int *bdberr, int *nops,
+    struct block_err *err, struct temp_cursor *dbc,
+    int (*func)(struct ireq *, uuid_t, void *, char **, int, int *, int **,
+                blob_buffer_t blobs[MAXBLOBS], int, struct block_err *, int *))
+{
+    blocksql_tran_t *tran = sess->tran;
+    int countops = 0;
+    int lastrcv = 0;
+    int rc = 0, rc_out = 0;
+    int *updCols = NULL;
+
+    /* session info */
+    blob_buffer_t blobs[MAXBLOBS] = {{0}};
+    int step = 0;
+    int receivedrows = 0;
+    int flags = 0;
+
+    iq->queryid = osql_sess_queryid(sess);
+    if (gbl_max_time_per_txn_ms)
+        iq->txn_ttl_ms = gettimeofday_ms() + gbl_max_time_per_txn_ms;
+
+    if (sess->rqid != OSQL_RQID_USE_UUID)
+        reqlog_set_rqid(iq->reqlogger, &sess->rqid, sizeof(unsigned long long));
+    else
+        reqlog_set_rqid(iq->reqlogger, sess->uuid, sizeof(sess->uuid));
+    reqlog_set_event(iq->reqlogger, EV_TXN);
+
+    /* streamed sessions are large by construction */
+    if (gbl_reorder_idx_writes)
+        iq->osql_flags |= OSQL_FLAGS_REORDER_IDX_ON;
+
+    while (!rc_out) {
+        oplog_key_t key = {0};
+        char *data = NULL;
+        int datalen = 0;
+
+        if (bdb_lock_desired(thedb->bdb_env) ||
+            (rc = osql_sess_stream_wait(sess, step)) == OSQL_STREAM_ABORT) {
+            logmsg(LOGMSG_ERROR, "%p %s:%d blocksql session closing early\n", (void *)pthread_self(), __FILE__,
+                   __LINE__);
+            err->blockop_num = 0;
+            err->errcode = ERR_NOMASTER;
+            err->ixnum = 0;
+            reqlog_set_error(iq->reqlogger, "ERR_NOMASTER", ERR_NOMASTER);
+            rc_out = ERR_NOMASTER;
+            break;
+        }
+        if (rc == OSQL_STREAM_FALLBACK) {
+            /* abort, and retry once the whole bplog is in */
+            rc_out = RC_INTERNAL_RETRY;
+            break;
+        }
+
+        key.seq = step;
+        Pthread_mutex_lock(&tran->store_mtx);
+        rc = bdb_temp_table_find_exact(thedb->bdb_env, dbc, &key, sizeof(key),
+                                       bdberr);
+        if (rc == 0) {
+            data = bdb_temp_table_data(dbc);
+            datalen = bdb_temp_table_datasize(dbc);
+            /* Reset temp cursor data - it will be freed after the callback. */
+            bdb_temp_table_reset_datapointers(dbc);
+        }
+        Pthread_mutex_unlock(&tran->store_mtx);
+
+        if (rc) {
+            reqlog_set_error(iq->reqlogger, "Internal Error", rc);
+            logmsg(LOGMSG_ERROR, "%s:%d bdb_temp_table_find_exact seq=%d failed rc=%d bdberr=%d\n", __func__,
+                   __LINE__, step, rc, *bdberr);
+            rc_out = ERR_INTERNAL;
+            break;
+        }
+
+        lastrcv = receivedrows;
+
+        /* This call locks pages:func is osql_process_packet */
+        rc_out = func(iq, sess->uuid, iq_tran, &data, datalen,
+                      &flags, &updCols, blobs, step, err, &receivedrows);
+        free(data);
+
+        if (rc_out != 0 && rc_out != OSQL_RC_DONE) {
+            reqlog_set_error(iq->reqlogger, "Error processing", rc_out);
+            /* error processing, can be a verify error or deadlock */
+            break;
+        }
+
+        if (lastrcv != receivedrows && is_rowlocks_transaction(iq_tran)) {
+            rowlocks_check_commit_physical(thedb->bdb_env, iq_tran, ++countops);
+        }
+
+        step++;
+    }
+
+    /* if for some reason the session has not completed correctly,
+       this will free the eventually allocated buffers */
+    free_blob_buffers(blobs, MAXBLOBS);
+
+    if (updCols)
+        free(updCols);
+
+    if (rc_out == OSQL_RC_DONE) {
+        *nops += receivedrows;
+        rc_out = 0;
+    }
+
+    return rc_out;
+}
+
 static int apply_changes(struct ireq *iq, blocksql_tran_t *tran, void *iq_tran,
                          int *nops, struct block_err *err,
                          int (*func)(struct ireq *, uuid_t, void *, char **,
                                      int, int *, int **,
                                      blob_buffer_t blobs[MAXBLOBS], int,
-                                     struct block_err *, int *))
+                                     struct block_err *, int *),
+                         int streamed)
 {
     int rc = 0;
     int out_rc = 0;
@@ -1206,16 +1381,22 @@ static int apply_changes(struct ireq *iq, blocksql_tran_t *tran, void *iq_tran,
 
     listc_init(&iq->bpfunc_lst, offsetof(bpfunc_lstnode_t, linkct));
 
-    /* go through the complete list and apply all the changes */
-    out_rc = process_this_session(iq, iq_tran, iq->sorese, &bdberr, nops, err,
-                                  dbc, dbc_ins, func);
+    if (streamed) {
+        /* ops are still being saved, the table is locked for each read */
+        Pthread_mutex_unlock(&tran->store_mtx);
+        out_rc = process_streamed_session(iq, iq_tran, iq->sorese, &bdberr,
+                                          nops, err, dbc, func);
+        Pthread_mutex_lock(&tran->store_mtx);
+    } else {
+        /* go through the complete list and apply all the changes */
+        out_rc = process_this_session(iq, iq_tran, iq->sorese, &bdberr, nops,
+                                      err, dbc, dbc_ins, func);
+    }
 
     /* Disarm: this pooled thread must not bill later work to the session's
      * fingerprint. */
     bdb_fingerprint_rtstats_clear();
 
-    Pthread_mutex_unlock(&tran->store_mtx);
-
     /* close the cursor */
     rc = bdb_temp_table_close_cursor(thedb->bdb_env, dbc, &bdberr);
     if (rc != 0) {
@@ -1231,6 +1412,9 @@ static int apply_changes(struct ireq *iq, blocksql_tran_t *tran, void *iq_tran,
         }
     }
 
+    /* a streamed session may still be saving ops */
+    Pthread_mutex_unlock(&tran->store_mtx);
+
     return out_rc;
 }
 
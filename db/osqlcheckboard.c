@@ -24,6 +24,7 @@
 #include <poll.h>
 #include <plhash_glue.h>
 #include <ctrace.h>
+#include <crc32c.h>
 #include "comdb2.h"
 #include "osqlcheckboard.h"
 #include "osqlsqlthr.h"
@@ -41,33 +42,54 @@
 #define SQLHERR_MASTER_QUEUE_FULL -108
 #define SQLHERR_MASTER_TIMEOUT -109
 
-typedef struct osql_checkboard {
+/* Requests are spread over shards by rqid (or uuid), so that sql threads
+ * registering and replies from the master for different requests do not
+ * serialize on one mutex */
+#define OSQL_CHKBOARD_SHARD_BITS 6
+#define OSQL_CHKBOARD_SHARDS (1 << OSQL_CHKBOARD_SHARD_BITS)
+
+typedef struct osql_checkboard_shard {
     hash_t *rqs;     /* sql threads processing a blocksql are registered here */
     hash_t *rqsuuid; /* like above, but register by uuid */
-    pthread_mutex_t mtx; /* protect all the requests */
+    pthread_mutex_t mtx; /* protect the requests in this shard */
+} __attribute__((aligned(64))) osql_checkboard_shard_t;
 
+typedef struct osql_checkboard {
+    osql_checkboard_shard_t shards[OSQL_CHKBOARD_SHARDS];
 } osql_checkboard_t;
 
 static osql_checkboard_t *checkboard = NULL;
 
-/* will get rdlock on checkboard->mtx if parameter lock is set
- * if caller already has mtx, call this func with lock = false
+static inline osql_checkboard_shard_t *chkboard_shard(unsigned long long rqid,
+                                                      uuid_t uuid)
+{
+    uint32_t h;
+    if (rqid == OSQL_RQID_USE_UUID)
+        h = crc32c((const uint8_t *)uuid, sizeof(uuid_t));
+    else
+        h = (uint32_t)(rqid ^ (rqid >> 32)) * 2654435761U;
+    return &checkboard->shards[h >> (32 - OSQL_CHKBOARD_SHARD_BITS)];
+}
+
+/* will lock the shard's mtx if parameter lock is set
+ * if caller already has it, call this func with lock = false
  */
 static inline osql_sqlthr_t *osql_chkboard_fetch_entry(unsigned long long rqid,
                                                        uuid_t uuid, int lock)
 {
+    osql_checkboard_shard_t *shard = chkboard_shard(rqid, uuid);
     osql_sqlthr_t *entry = NULL;
 
     if (lock)
-        Pthread_mutex_lock(&checkboard->mtx);
+        Pthread_mutex_lock(&shard->mtx);
 
     if (rqid == OSQL_RQID_USE_UUID)
-        entry = hash_find_readonly(checkboard->rqsuuid, uuid);
+        entry = hash_find_readonly(shard->rqsuuid, uuid);
     else
-        entry = hash_find_readonly(checkboard->rqs, &rqid);
+        entry = hash_find_readonly(shard->rqs, &rqid);
 
     if (lock)
-        Pthread_mutex_unlock(&checkboard->mtx);
+        Pthread_mutex_unlock(&shard->mtx);
     return entry;
 }
 
@@ -85,16 +107,18 @@ int osql_checkboard_init(void)
         abort();
     }
 
-    tmp->rqs = hash_init_o(offsetof(osql_sqlthr_t, rqid),
-                           sizeof(unsigned long long));
-    if (!tmp->rqs) {
-        free(tmp);
-        logmsg(LOGMSG_ERROR, "%s: error init hash\n", __func__);
-        return -1;
+    for (int i = 0; i < OSQL_CHKBOARD_SHARDS; i++) {
+        osql_checkboard_shard_t *shard = &tmp->shards[i];
+        shard->rqs = hash_init_o(offsetof(osql_sqlthr_t, rqid),
+                                 sizeof(unsigned long long));
+        shard->rqsuuid =
+            hash_init_o(offsetof(osql_sqlthr_t, uuid), sizeof(uuid_t));
+        if (!shard->rqs || !shard->rqsuuid) {
+            logmsg(LOGMSG_ERROR, "%s: error init hash\n", __func__);
+            abort();
+        }
+        Pthread_mutex_init(&shard->mtx, NULL);
     }
-    tmp->rqsuuid = hash_init_o(offsetof(osql_sqlthr_t, uuid), sizeof(uuid_t));
-
-    Pthread_mutex_init(&tmp->mtx, NULL);
     checkboard = tmp;
 
     return 0;
@@ -108,42 +132,42 @@ int osql_checkboard_init(void)
  */
 void osql_checkboard_destroy(void) { /* TODO*/ }
 
-/* insert entry into checkerboard */
-static inline int insert_into_checkerboard(osql_checkboard_t *cb,
-                                           osql_sqlthr_t *entry, int locked)
+/* insert entry into checkerboard; locked if the caller holds its shard */
+static inline int insert_into_checkerboard(osql_sqlthr_t *entry, int locked)
 {
+    osql_checkboard_shard_t *shard = chkboard_shard(entry->rqid, entry->uuid);
     int rc = 0;
 
     if (!locked)
-        Pthread_mutex_lock(&cb->mtx);
+        Pthread_mutex_lock(&shard->mtx);
 
     if (entry->rqid == OSQL_RQID_USE_UUID)
-        rc = hash_add(cb->rqsuuid, entry);
+        rc = hash_add(shard->rqsuuid, entry);
     else
-        rc = hash_add(cb->rqs, entry);
+        rc = hash_add(shard->rqs, entry);
 
     if (!locked)
-        Pthread_mutex_unlock(&cb->mtx);
+        Pthread_mutex_unlock(&shard->mtx);
     return rc;
 }
 
-/* delete entry from checkerboard -- called with checkerboard->mtx held */
-static inline osql_sqlthr_t *
-delete_from_checkerboard(osql_checkboard_t *cb, osqlstate_t *osql)
+/* delete entry from checkerboard */
+static inline osql_sqlthr_t *delete_from_checkerboard(osqlstate_t *osql)
 {
-    Pthread_mutex_lock(&cb->mtx);
+    osql_checkboard_shard_t *shard = chkboard_shard(osql->rqid, osql->uuid);
+    Pthread_mutex_lock(&shard->mtx);
     osql_sqlthr_t *entry =
         osql_chkboard_fetch_entry(osql->rqid, osql->uuid, 0);
     if (!entry) {
         goto done;
     }
     if (osql->rqid == OSQL_RQID_USE_UUID) {
-        int rc = hash_del(cb->rqsuuid, entry);
+        int rc = hash_del(shard->rqsuuid, entry);
         if (rc)
             logmsg(LOGMSG_ERROR, "%s: unable to delete record %llx, rc=%d\n",
                    __func__, entry->rqid, rc);
     } else {
-        int rc = hash_del(cb->rqs, entry);
+        int rc = hash_del(shard->rqs, entry);
         if (rc) {
             uuidstr_t us;
             logmsg(LOGMSG_ERROR, "%s: unable to delete record %llx %s, rc=%d\n",
@@ -151,7 +175,7 @@ delete_from_checkerboard(osql_checkboard_t *cb, osqlstate_t *osql)
         }
     }
 done:
-    Pthread_mutex_unlock(&cb->mtx);
+    Pthread_mutex_unlock(&shard->mtx);
     return entry;
 }
 
@@ -220,7 +244,7 @@ static int _osql_register_sqlthr(struct sqlclntstate *clnt, int type,
         return -1;
     }
 
-    int rc = insert_into_checkerboard(checkboard, entry, locked);
+    int rc = insert_into_checkerboard(entry, locked);
     if (rc) {
         logmsg(LOGMSG_ERROR, "%s: error adding record %llx %s rc=%d\n",
                __func__, entry->rqid, comdb2uuidstr(entry->uuid, us), rc);
@@ -253,7 +277,7 @@ int osql_unregister_sqlthr(struct sqlclntstate *clnt)
     if (clnt->osql.rqid == 0)
         return 0;
 
-    osql_sqlthr_t *entry = delete_from_checkerboard(checkboard, &clnt->osql);
+    osql_sqlthr_t *entry = delete_from_checkerboard(&clnt->osql);
     if (!entry) {
         uuidstr_t us;
         logmsg(LOGMSG_ERROR, "%s: error unable to find record %llx %s\n",
@@ -294,11 +318,12 @@ int osql_chkboard_sqlsession_rc(unsigned long long rqid, uuid_t uuid, int nops,
     if (!checkboard)
         return 0;
 
-    Pthread_mutex_lock(&checkboard->mtx);
+    osql_checkboard_shard_t *shard = chkboard_shard(rqid, uuid);
+    Pthread_mutex_lock(&shard->mtx);
 
     osql_sqlthr_t *entry = osql_chkboard_fetch_entry(rqid, uuid, 0);
     if (!entry) {
-        Pthread_mutex_unlock(&checkboard->mtx);
+        Pthread_mutex_unlock(&shard->mtx);
         /* This happens naturally for example
            if the client drops the connection while block processor
            is sending back the result
@@ -323,7 +348,7 @@ int osql_chkboard_sqlsession_rc(unsigned long long rqid, uuid_t uuid, int nops,
            4) Replicant reader-thread processes the wrong-master error from the old master, and restarts
               the transaction again. */
         if (errstat->errval != 0 && entry->master != from) {
-            Pthread_mutex_unlock(&checkboard->mtx);
+            Pthread_mutex_unlock(&shard->mtx);
             return 0;
         }
         entry->err = *errstat;
@@ -331,7 +356,7 @@ int osql_chkboard_sqlsession_rc(unsigned long long rqid, uuid_t uuid, int nops,
         bzero(&entry->err, sizeof(entry->err));
 
     Pthread_mutex_lock(&entry->mtx);
-    Pthread_mutex_unlock(&checkboard->mtx);
+    Pthread_mutex_unlock(&shard->mtx);
 
     entry->done = 1; /* mem sync? */
     entry->nops = nops;
@@ -383,12 +408,14 @@ void osql_checkboard_for_each(void *arg, int (*func)(void *, void *))
     if (!checkboard)
         return;
 
-    Pthread_mutex_lock(&checkboard->mtx);
-
-    hash_for(checkboard->rqs, func, arg);
-    hash_for(checkboard->rqsuuid, func, arg);
-
-    Pthread_mutex_unlock(&checkboard->mtx);
+    /* One shard at a time: registration and replies carry on in the rest */
+    for (int i = 0; i < OSQL_CHKBOARD_SHARDS; i++) {
+        osql_checkboard_shard_t *shard = &checkboard->shards[i];
+        Pthread_mutex_lock(&shard->mtx);
+        hash_for(shard->rqs, func, arg);
+        hash_for(shard->rqsuuid, func, arg);
+        Pthread_mutex_unlock(&shard->mtx);
+    }
 }
 
 static int osql_checkboard_check_request_down_node(void *obj, void *arg)
@@ -635,18 +662,19 @@ int osql_checkboard_update_status(unsigned long long rqid, uuid_t uuid,
     if (!checkboard)
         return 0;
 
-    Pthread_mutex_lock(&checkboard->mtx);
+    osql_checkboard_shard_t *shard = chkboard_shard(rqid, uuid);
+    Pthread_mutex_lock(&shard->mtx);
 
     osql_sqlthr_t *entry = osql_chkboard_fetch_entry(rqid, uuid, 0);
     if (!entry) {
-        Pthread_mutex_unlock(&checkboard->mtx);
+        Pthread_mutex_unlock(&shard->mtx);
         ctrace("%s: SORESE received exists for missing session %llu %s\n",
                __func__, rqid, comdb2uuidstr(uuid, us));
         return -1;
     }
 
     Pthread_mutex_lock(&entry->mtx);
-    Pthread_mutex_unlock(&checkboard->mtx);
+    Pthread_mutex_unlock(&shard->mtx);
 
     entry->progressing = (entry->status < status);
     entry->status = status;
@@ -668,12 +696,14 @@ int osql_reuse_sqlthr(struct sqlclntstate *clnt, const char *master)
     if (clnt->osql.rqid == 0)
         return 0;
 
-    Pthread_mutex_lock(&checkboard->mtx);
+    osql_checkboard_shard_t *shard =
+        chkboard_shard(clnt->osql.rqid, clnt->osql.uuid);
+    Pthread_mutex_lock(&shard->mtx);
 
     osql_sqlthr_t *entry =
         osql_chkboard_fetch_entry(clnt->osql.rqid, clnt->osql.uuid, 0);
     if (!entry) {
-        Pthread_mutex_unlock(&checkboard->mtx);
+        Pthread_mutex_unlock(&shard->mtx);
         uuidstr_t us;
         logmsg(LOGMSG_ERROR,
                "%s: error unable to find record %llx %s, enter new\n", __func__,
@@ -683,7 +713,7 @@ int osql_reuse_sqlthr(struct sqlclntstate *clnt, const char *master)
     }
 
     Pthread_mutex_lock(&entry->mtx);
-    Pthread_mutex_unlock(&checkboard->mtx);
+    Pthread_mutex_unlock(&shard->mtx);
 
     entry->last_checked = entry->last_updated =
         comdb2_time_epochms(); /* reset these time */
@@ -712,9 +742,10 @@ int osql_chkboard_get_clnt(uuid_t uuid, struct sqlclntstate **clnt)
     if (!checkboard)
         return 0;
 
-    Pthread_mutex_lock(&checkboard->mtx);
+    osql_checkboard_shard_t *shard = chkboard_shard(OSQL_RQID_USE_UUID, uuid);
+    Pthread_mutex_lock(&shard->mtx);
 
-    entry = hash_find_readonly(checkboard->rqsuuid, uuid);
+    entry = hash_find_readonly(shard->rqsuuid, uuid);
     if (!entry) {
         /* This happens naturally for example
            if the client drops the connection while block processor
@@ -741,7 +772,7 @@ int osql_chkboard_get_clnt(uuid_t uuid, struct sqlclntstate **clnt)
         Pthread_mutex_lock(&(*clnt)->dtran_mtx);
     }
 
-    Pthread_mutex_unlock(&checkboard->mtx);
+    Pthread_mutex_unlock(&shard->mtx);
 
     if (*clnt == NULL) {
         uuidstr_t us;
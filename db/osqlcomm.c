@@ -8784,6 +8784,19 @@ static void osql_extract_snap_info(osql_sess_t *sess, void *rpl, int rpllen)
     if ((p_buf = snap_uid_get(snap_info, p_buf, p_buf_end)) == NULL)
         abort();
 
+    if (sess->snap_info) {
+        /* streamed session: the block processor is already counting effects
+         * in the snap_info it was dispatched with */
+        snap_uid_t *crt = sess->snap_info;
+        comdb2uuidcpy(crt->uuid, snap_info->uuid);
+        crt->rqtype = snap_info->rqtype;
+        crt->replicant_is_able_to_retry = snap_info->replicant_is_able_to_retry;
+        memcpy(crt->key, snap_info->key, sizeof(crt->key));
+        crt->keylen = snap_info->keylen;
+        free(snap_info);
+        return;
+    }
+
     sess->snap_info = snap_info;
 
     /* Reset 'write' query effects as master will repopulate them
@@ -40,6 +40,17 @@
 #include <disttxn.h>
 
 int gbl_max_sc_lists = 10000;
+/* dispatch socksql sessions once this many ops are in, and apply the rest
+   as they arrive; 0 waits for the whole bplog */
+int gbl_osql_stream_apply_ops = 0;
+/* longest a streamed session's block processor waits for its next op while
+   holding locks, before it lets go of them and waits for the whole bplog */
+int gbl_osql_stream_apply_wait_ms = 1000;
+int64_t gbl_osql_stream_sessions;
+int64_t gbl_osql_stream_fallbacks;
+
+extern int gbl_disable_cnonce_blkseq;
+extern uint32_t gbl_max_time_per_txn_ms;
 
 struct sess_impl {
     int clients; /* number of threads using the session */
@@ -49,11 +60,26 @@ struct sess_impl {
     unsigned socket : 1;     /* Set if request comes over socket instead of net */
     unsigned embedded_sql : 1; /* Set if sql is part of session malloc object */
 
+    /* streamed sessions are dispatched before their bplog is complete */
+    unsigned streaming : 1;       /* Set when dispatched early */
+    unsigned stream_done : 1;     /* Set once the last op is in */
+    unsigned stream_closed : 1;   /* Set once the block processor is done */
+    unsigned stream_fallback : 1; /* Set if it has to be applied as a batch */
+    unsigned stream_batch : 1;    /* Set once replayed as a batch */
+
+    int saved_ops;  /* ops saved in the bplog */
+    int stream_ops; /* ops the block processor can apply */
+    snap_uid_t *stream_snap; /* snap_info placeholder until OSQL_DONE_SNAP */
+
     pthread_mutex_t mtx; /* dispatched/terminate/clients protection */
+    pthread_cond_t cond; /* signals streamed ops */
 };
 
 static void _destroy_session(osql_sess_t **psess);
 static int handle_buf_sorese(osql_sess_t *psess);
+static int handle_buf_stream(osql_sess_t *psess);
+static int stream_op(osql_sess_t *psess, int type, int is_msg_done);
+static int stream_cancel(osql_sess_t *psess);
 static osql_sess_t *_osql_sess_create(osql_sess_t *sess, char *tzname, int type, unsigned long long rqid, uuid_t uuid,
                                       const char *host, int is_reorder_on, int is_final);
 
@@ -178,9 +204,12 @@ static void _destroy_session(osql_sess_t **psess)
 
     _destroy_schema_changes(sess);
 
+    if (sess->impl->stream_snap != sess->snap_info)
+        free(sess->impl->stream_snap);
     free(sess->snap_info);
 
     Pthread_mutex_destroy(&sess->impl->mtx);
+    Pthread_cond_destroy(&sess->impl->cond);
     Pthread_mutex_destroy(&sess->participant_lk);
     if (sess->coordinator_dbname) {
         free(sess->coordinator_dbname);
@@ -222,7 +251,9 @@ int osql_sess_addclient(osql_sess_t *psess)
     int rc = 0;
 
     Pthread_mutex_lock(&sess->mtx);
-    if (sess->dispatched) {
+    if (sess->dispatched &&
+        (!sess->streaming || sess->stream_done || sess->stream_closed ||
+         sess->terminate)) {
         rc = -1;
     } else
         sess->clients += 1;
@@ -257,7 +288,8 @@ int osql_sess_remclient(osql_sess_t *psess)
     Pthread_mutex_lock(&sess->mtx);
     assert(sess->clients > 0);
     sess->clients -= 1;
-    if (sess->terminate) {
+    /* a streamed session is closed by its block processor */
+    if (sess->terminate && !sess->streaming) {
         rc = 1;
     }
     Pthread_mutex_unlock(&sess->mtx);
@@ -388,6 +420,8 @@ int osql_discard(const char *dist_txnid)
         sess->is_sanctioned = -1;
     }
     Pthread_mutex_unlock(&sess->participant_lk);
+    if (close && stream_cancel(sess))
+        close = 0; /* the block processor closes it */
     rc = osql_repository_put(sess);
     if (close || rc == 1) {
         osql_sess_close(&sess, 1);
@@ -445,6 +479,10 @@ int osql_sess_rcvop(uuid_t uuid, int type, void *data, int datalen, int *found)
         /* failed to save into bplog; discard and be done */
         goto failed_stream;
     }
+    if (stream_op(sess, type, is_msg_done)) {
+        /* dispatched before the DONE op; ops keep coming in */
+        return 0;
+    }
     int dispatch = 0;
     int cancel = 0;
     if (is_msg_done) {
@@ -464,6 +502,8 @@ int osql_sess_rcvop(uuid_t uuid, int type, void *data, int datalen, int *found)
 
     /* release the session */
     if (!is_msg_done || (sess->is_participant && !dispatch)) {
+        if (cancel && stream_cancel(sess))
+            cancel = 0; /* the block processor closes it */
         rc = osql_repository_put(sess);
         if (rc == 1 || cancel) {
             /* session was marked terminated and not finished*/
@@ -482,7 +522,7 @@ int osql_sess_rcvop(uuid_t uuid, int type, void *data, int datalen, int *found)
         }
         rc = collect_participants(sess->dist_txnid, &sess->participants);
         if (rc) {
-            rc = osql_repository_put(sess);
+            /* failed_stream releases the session */
             goto failed_stream;
         }
     }
@@ -492,6 +532,12 @@ int osql_sess_rcvop(uuid_t uuid, int type, void *data, int datalen, int *found)
     return handle_buf_sorese(sess);
 
 failed_stream:
+    if (stream_cancel(sess)) {
+        /* the block processor fails the transaction and closes the session */
+        osql_repository_put(sess);
+        return rc;
+    }
+
     if (is_msg_done && perr)
         osql_comm_signal_sqlthr_rc(&sess->target, OSQL_RQID_USE_UUID, uuid, 0, &sess->xerr, NULL, 0);
 
@@ -575,6 +621,11 @@ int osql_sess_try_terminate(osql_sess_t *psess, const char *host)
 
     if (sess->dispatched) {
         keep_sess = 1;
+        /* a streamed session still waiting for ops is not getting them */
+        if (sess->streaming && !sess->stream_done) {
+            sess->terminate = 1;
+            Pthread_cond_signal(&sess->cond);
+        }
         goto done;
     }
 
@@ -629,6 +680,16 @@ static int handle_buf_sorese(osql_sess_t *psess)
     }
 
     Pthread_mutex_lock(&sess->mtx);
+    if (sess->streaming) {
+        /* already dispatched, let the block processor see the last op */
+        sess->stream_ops = sess->saved_ops;
+        sess->stream_done = 1;
+        psess->sess_endus = comdb2_time_epochus();
+        Pthread_cond_signal(&sess->cond);
+        Pthread_mutex_unlock(&sess->mtx);
+        osql_repository_put(psess);
+        return 0;
+    }
     /* NOTE: the session here has one client at least, so it will not be
     close; it might be terminanted but we allow to dispatch */
     sess->dispatched = 1;
@@ -663,6 +724,237 @@ static int handle_buf_sorese(osql_sess_t *psess)
     return rc;
 }
 
+/* Streaming needs the ops applied in the order they were sent, and none of
+ * the session level work that is done before the bplog is applied.  A local
+ * sql thread could read a page the block processor has locked, then wait on
+ * a lock while the block processor waits for its next op, unseen by the
+ * deadlock detector. */
+static int can_stream(osql_sess_t *psess)
+{
+    return (psess->type == OSQL_SOCK_REQ || psess->type == OSQL_SOCK_REQ_COST) &&
+           !psess->is_reorder_on && !psess->scs.count && !psess->is_tptlock &&
+           !psess->is_participant && !psess->is_coordinator &&
+           psess->target.host != gbl_myhostname;
+}
+
+/**
+ * Account for an op saved in the bplog.  Streamed sessions publish it to
+ * their block processor; other sessions are dispatched early once
+ * gbl_osql_stream_apply_ops ops are in.
+ * Returns 1 if the session was dispatched (and released) here
+ *
+ */
+static int stream_op(osql_sess_t *psess, int type, int is_msg_done)
+{
+    sess_impl_t *sess = psess->impl;
+
+    if (!sess->streaming) {
+        sess->saved_ops++;
+        if (is_msg_done || gbl_osql_stream_apply_ops <= 0 ||
+            sess->saved_ops < gbl_osql_stream_apply_ops || !can_stream(psess))
+            return 0;
+        handle_buf_stream(psess);
+        return 1;
+    }
+
+    Pthread_mutex_lock(&sess->mtx);
+    sess->saved_ops++;
+    if (type == OSQL_DONE_SNAP)
+        sess->stream_snap = NULL; /* filled in by osql_comm_is_done */
+    /* the DONE op is published when the session is dispatched, so
+       participants still wait for the coordinator */
+    if (!is_msg_done) {
+        if (!can_stream(psess))
+            sess->stream_fallback = 1;
+        sess->stream_ops = sess->saved_ops;
+        Pthread_cond_signal(&sess->cond);
+    }
+    Pthread_mutex_unlock(&sess->mtx);
+    return 0;
+}
+
+/**
+ * Fail a streamed session instead of closing it, since its block processor
+ * owns it.  Caller holds a client.
+ * Returns 1 if the session is streamed
+ *
+ */
+static int stream_cancel(osql_sess_t *psess)
+{
+    sess_impl_t *sess = psess->impl;
+
+    if (!sess->streaming)
+        return 0;
+
+    Pthread_mutex_lock(&sess->mtx);
+    sess->terminate = 1;
+    Pthread_cond_signal(&sess->cond);
+    Pthread_mutex_unlock(&sess->mtx);
+    return 1;
+}
+
+/**
+ * Dispatch a session before its bplog is complete; the block processor
+ * applies each op as it arrives (see osql_sess_stream_wait) and the DONE op
+ * goes through handle_buf_sorese as usual
+ *
+ */
+static int handle_buf_stream(osql_sess_t *psess)
+{
+    sess_impl_t *sess = psess->impl;
+    int debug;
+    int rc = 0;
+    uint8_t *p_buf = NULL;
+    const uint8_t *p_buf_end = NULL;
+
+    debug = debug_this_request(gbl_debug_until);
+    if (gbl_who > 0 && gbl_debug) {
+        debug = 1;
+    }
+
+    /* effects are counted as ops are applied, before OSQL_DONE_SNAP brings
+       in the actual snap_info */
+    if (!psess->snap_info && !gbl_disable_cnonce_blkseq)
+        psess->snap_info = sess->stream_snap = calloc(1, sizeof(snap_uid_t));
+
+    /* later ops may delete or update, so adds cannot skip constraints */
+    psess->is_delayed = 1;
+
+    ATOMIC_ADD64(gbl_osql_stream_sessions, 1);
+
+    Pthread_mutex_lock(&sess->mtx);
+    sess->streaming = 1;
+    sess->dispatched = 1;
+    sess->stream_ops = sess->saved_ops;
+    bzero(&psess->xerr, sizeof(psess->xerr));
+    Pthread_mutex_unlock(&sess->mtx);
+
+    osql_repository_put(psess);
+
+    if (osql_bplog_build_sorese_req(&p_buf, &p_buf_end, psess->sql,
+                                    strlen(psess->sql) + 1, psess->tzname,
+                                    psess->type, psess->rqid, psess->uuid)) {
+        logmsg(LOGMSG_ERROR, "bug in code %s:%d", __func__, __LINE__);
+        return rc;
+    }
+
+    rc = handle_buf_main(thedb, NULL, p_buf, p_buf_end, debug,
+                         (char *)psess->target.host, 0, NULL, psess,
+                         REQ_OFFLOAD, NULL, 0, 0, NULL);
+
+    if (rc) {
+        signal_replicant_error(&psess->target, psess->rqid, psess->uuid,
+                               ERR_NOMASTER, "failed to dispatch streamed session");
+        osql_sess_close(&psess, 1);
+    }
+    return rc;
+}
+
+int osql_sess_is_streamed(osql_sess_t *psess)
+{
+    return psess->impl->streaming;
+}
+
+/**
+ * Wait for op "seq" of a streamed session, or with seq < 0 check that the
+ * session is still streamed, waiting for the whole bplog if it is not.
+ * The block processor holds locks while it waits for an op, so if none
+ * comes in time the session falls back to a batch replay
+ *
+ */
+int osql_sess_stream_wait(osql_sess_t *psess, int seq)
+{
+    sess_impl_t *sess = psess->impl;
+    struct timespec ts;
+    int deadline = 0;
+    int rc;
+
+    if (seq >= 0) {
+        int wait_ms = gbl_osql_stream_apply_wait_ms;
+        if (gbl_max_time_per_txn_ms && gbl_max_time_per_txn_ms < wait_ms)
+            wait_ms = gbl_max_time_per_txn_ms;
+        deadline = comdb2_time_epochms() + wait_ms;
+    }
+
+    Pthread_mutex_lock(&sess->mtx);
+    while (1) {
+        if (sess->terminate) {
+            rc = OSQL_STREAM_ABORT;
+            break;
+        }
+        if (sess->stream_fallback) {
+            if (seq >= 0 || sess->stream_done) {
+                rc = OSQL_STREAM_FALLBACK;
+                break;
+            }
+        } else if (seq < sess->stream_ops || seq < 0) {
+            rc = OSQL_STREAM_OK;
+            break;
+        } else if (sess->stream_done || sess->stream_closed) {
+            /* the DONE op should have ended the session */
+            rc = OSQL_STREAM_ABORT;
+            break;
+        } else if (seq >= 0 && comdb2_time_epochms() - deadline >= 0) {
+            /* the replicant is slow: release the locks, apply it later */
+            sess->stream_fallback = 1;
+            ATOMIC_ADD64(gbl_osql_stream_fallbacks, 1);
+            rc = OSQL_STREAM_FALLBACK;
+            break;
+        }
+
+        Pthread_mutex_unlock(&sess->mtx);
+        if (bdb_lock_desired(thedb->bdb_env))
+            return OSQL_STREAM_ABORT;
+        Pthread_mutex_lock(&sess->mtx);
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 100 * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&sess->cond, &sess->mtx, &ts);
+    }
+
+    /* replaying as a batch, do what the dispatch of a complete session
+       would have done */
+    int batch = (rc == OSQL_STREAM_FALLBACK && seq < 0 && !sess->stream_batch);
+    if (batch)
+        sess->stream_batch = 1;
+    Pthread_mutex_unlock(&sess->mtx);
+
+    if (batch) {
+        if (psess->is_coordinator)
+            dispatch_participants(psess->dist_txnid);
+        if (psess->is_participant)
+            reenable_participant_heartbeats(psess->dist_txnid);
+    }
+    return rc;
+}
+
+/**
+ * The block processor stopped applying a streamed session: stop accepting
+ * ops for it and drop a snap_info placeholder that was never filled in
+ *
+ */
+void osql_sess_stream_end(osql_sess_t *psess)
+{
+    sess_impl_t *sess = psess->impl;
+
+    Pthread_mutex_lock(&sess->mtx);
+    sess->stream_closed = 1;
+    Pthread_mutex_unlock(&sess->mtx);
+
+    /* let any reader still saving an op get out */
+    while (ATOMIC_LOAD32(sess->clients) > 0) {
+        poll(NULL, 0, 10);
+    }
+
+    /* still referenced by this thread, it is freed with the session */
+    if (sess->stream_snap && psess->snap_info == sess->stream_snap)
+        psess->snap_info = NULL;
+}
+
 static osql_sess_t *_osql_sess_create(osql_sess_t *sess, char *tzname, int type, unsigned long long rqid, uuid_t uuid,
                                       const char *host, int is_reorder_on, int is_final)
 {
@@ -681,6 +973,7 @@ static osql_sess_t *_osql_sess_create(osql_sess_t *sess, char *tzname, int type,
 
     /* init sync fields */
     Pthread_mutex_init(&sess->impl->mtx, NULL);
+    Pthread_cond_init(&sess->impl->cond, NULL);
 
     /* init participant mutex */
     Pthread_mutex_init(&sess->participant_lk, NULL);
@@ -106,6 +106,38 @@ int osql_sess_queryid(osql_sess_t *sess);
  */
 int osql_sess_try_terminate(osql_sess_t *psess, const char *node);
 
+/**
+ * Streamed sessions are dispatched before their bplog is complete, and
+ * their block processor applies the ops as they arrive
+ *
+ */
+enum {
+    OSQL_STREAM_OK = 0,       /* the op is in */
+    OSQL_STREAM_FALLBACK = 1, /* the session has to be applied as a batch */
+    OSQL_STREAM_ABORT = 2     /* the session will not complete */
+};
+
+/**
+ * Returns 1 if the session was dispatched before its bplog was complete
+ *
+ */
+int osql_sess_is_streamed(osql_sess_t *sess);
+
+/**
+ * Wait until op "seq" of a streamed session is in the bplog; if seq < 0,
+ * only check if the session is still streamed, and if not wait for
+ * the rest of its bplog
+ * Returns OSQL_STREAM_*
+ *
+ */
+int osql_sess_stream_wait(osql_sess_t *sess, int seq);
+
+/**
+ * The block processor is done with a streamed session
+ *
+ */
+void osql_sess_stream_end(osql_sess_t *sess);
+
 /**
  * Save a schema change object inside session
  *
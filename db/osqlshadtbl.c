@@ -92,7 +92,7 @@ static int truncate_tablecursor(bdb_state_type *bdb_env,
 static int process_local_shadtbl_usedb(struct sqlclntstate *clnt,
                                        char *tablename, int tableversion);
 static int process_local_shadtbl_skp(struct sqlclntstate *clnt, shad_tbl_t *tbl,
-                                     int *bdberr, int crt_nops);
+                                     int *bdberr, int crt_nops, int pending);
 static int process_local_shadtbl_qblob(struct sqlclntstate *clnt,
                                        shad_tbl_t *tbl, int *updCols,
                                        int *bdberr, unsigned long long seq,
@@ -101,9 +101,9 @@ static int process_local_shadtbl_index(struct sqlclntstate *clnt,
                                        shad_tbl_t *tbl, int *bdberr,
                                        unsigned long long seq, int is_delete);
 static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
-                                     int *bdberr, int crt_nops);
+                                     int *bdberr, int crt_nops, int pending);
 static int process_local_shadtbl_upd(struct sqlclntstate *clnt, shad_tbl_t *tbl,
-                                     int *bdberr, int crt_nops);
+                                     int *bdberr, int crt_nops, int pending);
 static int process_local_shadtbl_recgenids(struct sqlclntstate *clnt,
                                            int *bdberr);
 static int process_local_shadtbl_sc(struct sqlclntstate *clnt, int *bdberr);
@@ -186,6 +186,8 @@ static int destroy_shadtbl(shad_tbl_t *tbl)
         destroy_idx_hash(tbl->ins_fp_hash);
     if (tbl->del_fp_hash)
         destroy_idx_hash(tbl->del_fp_hash);
+    if (tbl->sent_del_hash)
+        destroy_idx_hash(tbl->sent_del_hash);
 
     if (tbl->delidx_tbl)
         destroy_tablecursor(tbl->env->bdb_env, tbl->delidx_cur, tbl->delidx_tbl,
@@ -530,6 +532,8 @@ static shad_tbl_t *create_shadtbl(struct BtCursor *pCur,
         hash_init_o(offsetof(rec_flags_t, seq), sizeof(unsigned long long));
     tbl->ins_fp_hash = hash_init_o(offsetof(rec_fingerprint_t, seq), sizeof(unsigned long long));
     tbl->del_fp_hash = hash_init_o(offsetof(rec_fingerprint_t, seq), sizeof(unsigned long long));
+    if (clnt->dbtran.mode == TRANLEVEL_SOSQL && clnt->osql.coalesce)
+        tbl->sent_del_hash = hash_init_o(0, sizeof(unsigned long long));
 
     listc_abl(&clnt->osql.shadtbls, tbl);
     pCur->shadtbl = tbl;
@@ -966,6 +970,30 @@ static const unsigned char *get_rec_fingerprint(shad_tbl_t *tbl, unsigned long l
     return rf ? rf->fingerprint : NULL;
 }
 
+/* Was this insert or update, keyed by its synthetic genid, already sent
+ * coalesced */
+static int is_seq_sent(shad_tbl_t *tbl, unsigned long long key)
+{
+    key &= ~GENID_SYNTHETIC_MASK;
+    return bdb_genid_to_host_order(key) <
+           bdb_genid_to_host_order(tbl->sent_seq);
+}
+
+/* Remember that the delete of genid was sent; returns 1 if it already was */
+static int mark_del_sent(shad_tbl_t *tbl, unsigned long long genid)
+{
+    unsigned long long *sent;
+
+    if (hash_find(tbl->sent_del_hash, &genid))
+        return 1;
+    sent = malloc(sizeof(*sent));
+    if (sent) {
+        *sent = genid;
+        hash_add(tbl->sent_del_hash, sent);
+    }
+    return 0;
+}
+
 /*
  * NOTE:
  * Handle upd table for multiple updates of synthetic rows
@@ -1617,7 +1645,7 @@ int osql_shadtbl_process(struct sqlclntstate *clnt, int *nops, int *bdberr,
         if (rc)
             return -1;
 
-        rc = process_local_shadtbl_skp(clnt, tbl, bdberr, *nops);
+        rc = process_local_shadtbl_skp(clnt, tbl, bdberr, *nops, 0);
         if (rc == SQLITE_TOOBIG) {
             *nops += tbl->nops;
             return rc;
@@ -1625,7 +1653,7 @@ int osql_shadtbl_process(struct sqlclntstate *clnt, int *nops, int *bdberr,
         if (rc)
             return -1;
 
-        rc = process_local_shadtbl_add(clnt, tbl, bdberr, *nops);
+        rc = process_local_shadtbl_add(clnt, tbl, bdberr, *nops, 0);
         if (rc == SQLITE_TOOBIG) {
             *nops += tbl->nops;
             return rc;
@@ -1633,7 +1661,7 @@ int osql_shadtbl_process(struct sqlclntstate *clnt, int *nops, int *bdberr,
         if (rc)
             return -1;
 
-        rc = process_local_shadtbl_upd(clnt, tbl, bdberr, *nops);
+        rc = process_local_shadtbl_upd(clnt, tbl, bdberr, *nops, 0);
         if (rc == SQLITE_TOOBIG) {
             *nops += tbl->nops;
             return rc;
@@ -1642,6 +1670,7 @@ int osql_shadtbl_process(struct sqlclntstate *clnt, int *nops, int *bdberr,
             return -1;
 
         *nops += tbl->nops;
+        tbl->sent_seq = tbl->seq;
     }
 
     if ((rc = process_local_shadtbl_dbq(clnt, bdberr, nops)) != 0) {
@@ -1665,6 +1694,46 @@ int osql_shadtbl_process(struct sqlclntstate *clnt, int *nops, int *bdberr,
     return rc;
 }
 
+/**
+ * Send the row ops saved in the shadow tables since they were last sent,
+ * by this or by a full replay.  Only socksql transactions holding back their
+ * row ops call this; anything else they do is sent as it happens.
+ */
+int osql_shadtbl_process_pending(struct sqlclntstate *clnt, int *nops,
+                                 int *bdberr)
+{
+    osqlstate_t *osql = &clnt->osql;
+    shad_tbl_t *tbl = NULL;
+    int rc = 0;
+
+    *nops = 0;
+
+    LISTC_FOR_EACH(&osql->shadtbls, tbl, linkv)
+    {
+        tbl->nops = 0;
+
+        rc = process_local_shadtbl_usedb(clnt, tbl->tablename,
+                                         tbl->tableversion);
+        if (rc)
+            return -1;
+
+        rc = process_local_shadtbl_skp(clnt, tbl, bdberr, *nops, 1);
+        if (rc == 0)
+            rc = process_local_shadtbl_add(clnt, tbl, bdberr, *nops, 1);
+        if (rc == 0)
+            rc = process_local_shadtbl_upd(clnt, tbl, bdberr, *nops, 1);
+        *nops += tbl->nops;
+        if (rc == SQLITE_TOOBIG)
+            return rc;
+        if (rc)
+            return -1;
+
+        tbl->sent_seq = tbl->seq;
+    }
+
+    return 0;
+}
+
 /**
  * Clear the rows from the shadow tables at the end of a transaction
  *
@@ -1772,7 +1841,7 @@ static int process_local_shadtbl_usedb(struct sqlclntstate *clnt,
 
 /* Think of this function as if it were called process_local_shadtbl_del */
 static int process_local_shadtbl_skp(struct sqlclntstate *clnt, shad_tbl_t *tbl,
-                                     int *bdberr, int crt_nops)
+                                     int *bdberr, int crt_nops, int pending)
 {
     osqlstate_t *osql = &clnt->osql;
     struct temp_cursor *cur = NULL;
@@ -1795,7 +1864,9 @@ static int process_local_shadtbl_skp(struct sqlclntstate *clnt, shad_tbl_t *tbl,
 
     while (rc == 0) {
 
-        if (datalen == 0) { /* this a delete, not an update */
+        /* this a delete, not an update; skip it if it was sent coalesced */
+        if (datalen == 0 &&
+            !(tbl->sent_del_hash && mark_del_sent(tbl, genid) && pending)) {
 
             tbl->nops++;
 
@@ -2062,7 +2133,7 @@ static int process_local_shadtbl_index(struct sqlclntstate *clnt,
 }
 
 static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
-                                     int *bdberr, int crt_nops)
+                                     int *bdberr, int crt_nops, int pending)
 {
 
     osqlstate_t *osql = &clnt->osql;
@@ -2090,6 +2161,9 @@ static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
         if (!is_genid_synthetic(key))
             goto next;
 
+        if (pending && is_seq_sent(tbl, key))
+            goto next;
+
         /* lookup the upd_cur: if this is an actual update then skip it
          * TODO: we could package and ship it rite here, rite now (later) */
         rc = bdb_temp_table_find_exact(tbl->env->bdb_env, tbl->upd_cur, &key,
@@ -2174,7 +2248,7 @@ static int process_local_shadtbl_add(struct sqlclntstate *clnt, shad_tbl_t *tbl,
 }
 
 static int process_local_shadtbl_upd(struct sqlclntstate *clnt, shad_tbl_t *tbl,
-                                     int *bdberr, int crt_nops)
+                                     int *bdberr, int crt_nops, int pending)
 {
 
     osqlstate_t *osql = &clnt->osql;
@@ -2199,6 +2273,11 @@ static int process_local_shadtbl_upd(struct sqlclntstate *clnt, shad_tbl_t *tbl,
         seq = *(unsigned long long *)bdb_temp_table_key(tbl->upd_cur);
         genid = *(unsigned long long *)bdb_temp_table_data(tbl->upd_cur);
 
+        if (pending && is_seq_sent(tbl, seq)) {
+            rc = bdb_temp_table_next(tbl->env->bdb_env, tbl->upd_cur, bdberr);
+            continue;
+        }
+
         /* locate the row in the add_cur */
         rc = bdb_temp_table_find_exact(tbl->env->bdb_env, tbl->add_cur, &seq,
                                        sizeof(seq), bdberr);
@@ -63,6 +63,8 @@ struct shad_tbl {
     struct temp_cursor *blb_cur;
 
     unsigned long long seq; /* used to generate uniq row ids */
+    unsigned long long sent_seq; /* rows below this seq were sent coalesced */
+    hash_t *sent_del_hash;       /* deleted genids sent coalesced */
     struct dbenv *env;
     char tablename[MAXTABLELEN];
     int tableversion;
@@ -181,6 +183,13 @@ int osql_save_bpfunc(struct sql_thread *thd, BpfuncArg *arg);
 int osql_shadtbl_process(struct sqlclntstate *clnt, int *nops, int *bdberr,
                          int restarting);
 
+/**
+ * Send the row ops saved in the shadow tables since they were last sent
+ *
+ */
+int osql_shadtbl_process_pending(struct sqlclntstate *clnt, int *nops,
+                                 int *bdberr);
+
 /**
  *  Check of a shadow table transaction has cached selectv records
  *
@@ -56,6 +56,8 @@
 #include "schemachange.h"
 #include "db_access.h"
 #include "fdb_fend.h"
+#include "thread_stats.h"
+#include "comdb2_atomic.h"
 
 extern int gbl_partial_indexes;
 extern int gbl_expressions_indexes;
@@ -65,6 +67,10 @@ int gbl_allow_bplog_restarts = 600;
 int gbl_master_retry_poll_ms = 100;
 int gbl_noleader_retry_duration_ms = 50 * 1000; /* wait up to 50 seconds for a new leader */
 int gbl_noleader_retry_poll_ms = 10;
+/* Hold back up to this many socksql row ops in the shadow tables, which
+ * already coalesce them per genid, and ship only the net effect */
+int gbl_osql_coalesce_max_ops = 0;
+int64_t gbl_osql_coalesce_flushes;
 
 static int osql_send_usedb_logic(struct BtCursor *pCur, struct sql_thread *thd,
                                  int nettype);
@@ -88,6 +94,7 @@ static int osql_end(struct sqlclntstate *clnt);
 static int osql_wait(struct sqlclntstate *clnt);
 
 static int osql_sock_restart(struct sqlclntstate *clnt, int maxretries, int keep_session, int is_final);
+static int osql_flush_coalesced(struct sqlclntstate *clnt);
 
 #ifdef DEBUG_REORDER
 #define DEBUG_PRINT_NUMOPS()                                                   \
@@ -187,6 +194,11 @@ static inline int osql_should_restart(struct sqlclntstate *clnt, int rc,
 
 #define START_SOCKSQL                                                                                                  \
     do {                                                                                                               \
+        if (clnt->osql.coalesced_ops) {                                                                                \
+            rc = osql_flush_coalesced(clnt);                                                                           \
+            if (rc)                                                                                                    \
+                return rc;                                                                                             \
+        }                                                                                                              \
         if (!clnt->osql.sock_started) {                                                                                \
             rc = osql_sock_start(clnt, OSQL_SOCK_REQ, 0, 0);                                                           \
             if (rc) {                                                                                                  \
@@ -268,6 +280,7 @@ retry:
                 logmsg(LOGMSG_WARN, "Retrying to find the master retries=%d uuid:%s\n", retries, us);
             }
             poll(NULL, 0, poll_ms);
+            bdb_thread_wait(THD_WAIT_THROTTLE, M2U(poll_ms));
             goto retry;
         } else {
             uuidstr_t us;
@@ -307,6 +320,7 @@ retry:
             logmsg(LOGMSG_WARN, "Retrying to find the master (2) retries=%d uuid:%s\n", retries, us);
         }
         poll(NULL, 0, poll_ms);
+        bdb_thread_wait(THD_WAIT_THROTTLE, M2U(poll_ms));
         goto retry;
     }
 
@@ -411,13 +425,14 @@ static int osql_wait(struct sqlclntstate *clnt)
             return 0;
 
     // return osql_chkboard_wait_commitrc(osql->rqid, osql->uuid, timeout, err);
-    int startms = comdb2_time_epochms();
+    uint64_t startus = comdb2_time_epochus();
     int rc = osql_chkboard_wait_commitrc(osql->rqid, osql->uuid, timeout, err);
-    int endms = comdb2_time_epochms();
+    uint64_t endus = comdb2_time_epochus();
+    bdb_thread_wait(THD_WAIT_OSQL, endus - startus);
     if (gbl_debug_disttxn_trace) {
         uuidstr_t us;
         logmsg(LOGMSG_USER, "DISTTXN REPL %s %s took %d ms to commit rqid=%llu uuid=%s\n", __func__,
-               clnt->dist_txnid ? clnt->dist_txnid : "(nodisttxn)", (endms - startms), osql->rqid,
+               clnt->dist_txnid ? clnt->dist_txnid : "(nodisttxn)", U2M(endus - startus), osql->rqid,
                comdb2uuidstr(osql->uuid, us));
     }
     return rc;
@@ -488,6 +503,7 @@ int osql_delrec(struct BtCursor *pCur, struct sql_thread *thd)
 {
     struct sqlclntstate *clnt = thd->clnt;
     int restarted;
+    int coalesce = 0;
     int rc = 0;
 
     if ((rc = access_control_check_sql_write(pCur, thd)))
@@ -497,7 +513,7 @@ int osql_delrec(struct BtCursor *pCur, struct sql_thread *thd)
     if ((rc = check_osql_capacity(thd)))
         return rc;
 
-    if (clnt->dbtran.mode == TRANLEVEL_SOSQL) {
+    if (clnt->dbtran.mode == TRANLEVEL_SOSQL && !(coalesce = clnt->osql.coalesce)) {
         START_SOCKSQL;
         do {
             rc = osql_send_del_logic(pCur, thd);
@@ -517,7 +533,10 @@ int osql_delrec(struct BtCursor *pCur, struct sql_thread *thd)
             return rc;
     }
 
-    return osql_save_delrec(pCur, thd);
+    rc = osql_save_delrec(pCur, thd);
+    if (rc == SQLITE_OK && coalesce && ++clnt->osql.coalesced_ops >= gbl_osql_coalesce_max_ops)
+        rc = osql_flush_coalesced(clnt);
+    return rc;
 }
 
 /**
@@ -648,6 +667,7 @@ int osql_insrec(struct BtCursor *pCur, struct sql_thread *thd, char *pData,
 {
     struct sqlclntstate *clnt = thd->clnt;
     int restarted;
+    int coalesce = 0;
     int rc = 0;
 
     if ((rc = access_control_check_sql_write(pCur, thd)))
@@ -659,7 +679,7 @@ int osql_insrec(struct BtCursor *pCur, struct sql_thread *thd, char *pData,
 
     fixup_replicate_local_seqno(pCur, pData, clnt);
 
-    if (clnt->dbtran.mode == TRANLEVEL_SOSQL) {
+    if (clnt->dbtran.mode == TRANLEVEL_SOSQL && !(coalesce = clnt->osql.coalesce)) {
         START_SOCKSQL;
         do {
             rc = osql_send_ins_logic(pCur, thd, pData, nData, blobs, maxblobs,
@@ -685,6 +705,8 @@ int osql_insrec(struct BtCursor *pCur, struct sql_thread *thd, char *pData,
         return rc;
 
     rc = osql_save_insrec(pCur, thd, pData, nData, flags);
+    if (rc == SQLITE_OK && coalesce && ++clnt->osql.coalesced_ops >= gbl_osql_coalesce_max_ops)
+        rc = osql_flush_coalesced(clnt);
     return rc;
 }
 
@@ -792,6 +814,7 @@ int osql_updrec(struct BtCursor *pCur, struct sql_thread *thd, char *pData,
 {
     struct sqlclntstate *clnt = thd->clnt;
     int restarted;
+    int coalesce = 0;
     int rc = 0;
 
     if ((rc = access_control_check_sql_write(pCur, thd)))
@@ -801,7 +824,7 @@ int osql_updrec(struct BtCursor *pCur, struct sql_thread *thd, char *pData,
     if ((rc = check_osql_capacity(thd)))
         return rc;
 
-    if (clnt->dbtran.mode == TRANLEVEL_SOSQL) {
+    if (clnt->dbtran.mode == TRANLEVEL_SOSQL && !(coalesce = clnt->osql.coalesce)) {
         START_SOCKSQL;
         do {
             rc = osql_send_upd_logic(pCur, thd, pData, nData, updCols, blobs,
@@ -835,7 +858,10 @@ int osql_updrec(struct BtCursor *pCur, struct sql_thread *thd, char *pData,
     if (rc != SQLITE_OK)
         return rc;
 
-    return osql_save_updrec(pCur, thd, pData, nData, flags);
+    rc = osql_save_updrec(pCur, thd, pData, nData, flags);
+    if (rc == SQLITE_OK && coalesce && ++clnt->osql.coalesced_ops >= gbl_osql_coalesce_max_ops)
+        rc = osql_flush_coalesced(clnt);
+    return rc;
 }
 
 /**
@@ -934,8 +960,10 @@ static int osql_sock_restart(struct sqlclntstate *clnt, int maxretries, int keep
 
         retries++;
         /* if we're shaking really badly, back off */
-        if (retries > 1)
+        if (retries > 1) {
             usleep(retries * 10000); // sleep for a multiple of 10ms
+            bdb_thread_wait(THD_WAIT_THROTTLE, retries * 10000);
+        }
 
         sentops = 0;
 
@@ -982,6 +1010,7 @@ static int osql_sock_restart(struct sqlclntstate *clnt, int maxretries, int keep
 
         /* process messages from cache */
         rc = osql_shadtbl_process(clnt, &sentops, &bdberr, 1);
+        osql->coalesced_ops = 0;
         if (rc == SQLITE_TOOBIG) {
             logmsg(LOGMSG_ERROR, "%s: transaction too big %d\n", __func__, sentops);
             return rc;
@@ -1017,6 +1046,53 @@ static int osql_sock_restart(struct sqlclntstate *clnt, int maxretries, int keep
     return 0;
 }
 
+/**
+ * Send what the shadow tables coalesced from the row ops held back since the
+ * last flush.  The first flush starts the session and replays them whole,
+ * like a restart; later ones send only the rows past the shadow tables'
+ * watermarks.
+ */
+static int osql_flush_coalesced(struct sqlclntstate *clnt)
+{
+    osqlstate_t *osql = &clnt->osql;
+    int sentops = 0;
+    int bdberr = 0;
+    int rc;
+
+    osql->coalesced_ops = 0;
+    ATOMIC_ADD64(gbl_osql_coalesce_flushes, 1);
+
+    if (!osql->sock_started) {
+        rc = osql_sock_start(clnt, OSQL_SOCK_REQ, 0, 0);
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "%s: failed to start socksql transaction rc=%d\n", __func__, rc);
+            if (rc != SQLITE_ABORT)
+                rc = SQLITE_CLIENT_CHANGENODE;
+            return rc;
+        }
+        rc = osql_shadtbl_process(clnt, &sentops, &bdberr, 1);
+    } else {
+        rc = osql_shadtbl_process_pending(clnt, &sentops, &bdberr);
+    }
+    if (rc == SQLITE_TOOBIG || rc == ERR_SC)
+        return rc;
+
+    /* selectv skip optimization, not an error */
+    if (unlikely(rc == -2 || rc == -3))
+        rc = 0;
+
+    if (rc) {
+        rc = osql_sock_restart(clnt, gbl_allow_bplog_restarts, 1, 0);
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "%s: failed to restart socksql session rc=%d\n", __func__, rc);
+            if (rc != SQLITE_TOOBIG && rc != ERR_SC)
+                rc = SQLITE_INTERNAL;
+        }
+    }
+
+    return rc;
+}
+
 int gbl_random_blkseq_replays;
 int gbl_osql_send_startgen = 1;
 
@@ -1069,6 +1145,21 @@ int osql_sock_commit(struct sqlclntstate *clnt, int type, enum trans_clntcomm si
                clnt->dbtran.dtran ? " has remote writes" : " no remote writes", comdb2uuidstr(clnt->osql.uuid, us));
     }
 
+    /* ship the row ops held back in the shadow tables */
+    if (clnt->dbtran.mode == TRANLEVEL_SOSQL && osql->coalesced_ops) {
+        if (gbl_is_physical_replicant) {
+            logmsg(LOGMSG_ERROR, "%s attempted write against physical replicant\n", __func__);
+            osql_sock_abort(clnt, type);
+            return SQLITE_READONLY;
+        }
+        rc = osql_flush_coalesced(clnt);
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "%s: failed to send coalesced ops rc=%d\n", __func__, rc);
+            osql_sock_abort(clnt, type);
+            return rc;
+        }
+    }
+
     /* is it distributed? */
 
     if (clnt->dbtran.mode == TRANLEVEL_SOSQL && clnt->dbtran.dtran)
@@ -1206,6 +1297,7 @@ retry:
                             retries, gbl_master_retry_poll_ms);
 
                         poll(NULL, 0, gbl_master_retry_poll_ms);
+                        bdb_thread_wait(THD_WAIT_THROTTLE, M2U(gbl_master_retry_poll_ms));
                         int is_final = (retries >= gbl_allow_bplog_restarts);
                         snap_uid_t snap = {{0}};
                         int keep_session = !is_final || (get_cnonce(clnt, &snap) == 0);
@@ -1329,6 +1421,7 @@ done:
     }
 
     osql->sock_started = 0;
+    osql->coalesced_ops = 0;
 
     clnt->effects.num_affected += clnt->remote_effects.num_affected;
     clnt->effects.num_selected += clnt->remote_effects.num_selected;
@@ -1402,6 +1495,7 @@ int osql_sock_abort(struct sqlclntstate *clnt, int type)
     clnt->osql.sentops = 0;  /* reset statement size counter*/
     clnt->osql.tran_ops = 0; /* reset transaction size counter*/
     clnt->osql.replicant_numops = 0; /* reset replicant numops counter*/
+    clnt->osql.coalesced_ops = 0;
 
     osql_shadtbl_close(clnt);
 
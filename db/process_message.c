@@ -70,6 +70,8 @@ extern int __berkdb_read_alarm_ms;
 #include "rtcpu.h"
 #include "machcache.h"
 #include "machclass.h"
+#include "histogram.h"
+#include "sql_scheduler.h"
 
 extern struct ruleset *gbl_ruleset;
 extern int gbl_exit_alarm_sec;
@@ -221,6 +223,7 @@ static const char *HELP_STAT[] = {
     "stat auth                  - auth cache sizing stats (authn/authz evictions)",
     "stat dohsql                - show distributed sql stats",
     "stat oldfile               - dump oldfile hash",
+    "stat latency [reset]       - latency percentiles since startup (or reset)",
     "dmpl                       - dump threads",
     "dmptrn                     - show long transaction stats",
     "dmpcts                     - show table constraints",
@@ -1447,6 +1450,72 @@ clipper_usage:
         logmsg(LOGMSG_USER, "ruleset %p matched %zu, %s\n",
                gbl_ruleset, matchCount, zBuf);
     }
+    else if (tokcmp(tok, ltok, "bench_ruleset") == 0) {
+        char *zCtx = strdup(tok);
+
+        if (zCtx == NULL) {
+            logmsg(LOGMSG_ERROR, "Out of memory for ruleset context\n");
+            return -1;
+        }
+
+        char *zSav = NULL;
+        char zBuf[8192] = {0};
+        char zFileName[PATH_MAX] = {0};
+        struct ruleset_item_criteria uCtx = {0};
+        struct ruleset *pRules = NULL;
+        int bFreeCtx = 1;
+        int nIter = 0;
+
+        char *zTok = strtok_r(zCtx, " ", &zSav); /* "bench_ruleset" */
+        if (zTok != NULL) zTok = strtok_r(NULL, " ", &zSav); /* file name */
+        if (zTok == NULL || strlen(zTok) >= PATH_MAX) {
+            free(zCtx);
+            logmsg(LOGMSG_ERROR, "Expected ruleset file name\n");
+            return -1;
+        }
+        strcpy(zFileName, zTok);
+        zTok = strtok_r(NULL, " ", &zSav); /* iterations */
+        if (zTok != NULL) nIter = atoi(zTok);
+        if (nIter <= 0) {
+            free(zCtx);
+            logmsg(LOGMSG_ERROR, "Expected number of iterations\n");
+            return -1;
+        }
+        zTok = strtok_r(NULL, " ", &zSav); /* next arg? */
+
+        if (zTok != NULL) { /* was context manually specified? */
+            strcpy(zCtx, tok); /* re-copy from original to fix strtok_r() */
+            rc = comdb2_load_ruleset_item_criteria("<bench_ruleset>", 0, zTok, -1, 0, 0, &uCtx, NULL, NULL, &zSav,
+                                                   NULL, zBuf, sizeof(zBuf));
+            free(zCtx);
+
+            if (rc != 0) {
+                comdb2_free_ruleset_item_criteria(&uCtx);
+                logmsg(LOGMSG_ERROR, "comdb2_load_ruleset_item_criteria: %s\n",
+                       zBuf);
+                return -1;
+            }
+        } else {
+            bFreeCtx = 0;
+            free(zCtx);
+            clnt_to_ruleset_item_criteria(get_sql_clnt(), &uCtx);
+        }
+
+        /* bench a private copy so the live ruleset and its counters are
+         * never touched */
+        rc = comdb2_load_ruleset_filename(zFileName, &pRules);
+        if (rc == 0) {
+            rc = comdb2_bench_ruleset(pRules, &uCtx, nIter);
+            if (rc != 0) {
+                logmsg(LOGMSG_ERROR,
+                       "Failed to benchmark ruleset from file \"%s\": rc=%d\n",
+                       zFileName, rc);
+            }
+        }
+        comdb2_free_ruleset(pRules);
+        if (bFreeCtx) { comdb2_free_ruleset_item_criteria(&uCtx); }
+        if (rc != 0) return -1;
+    }
     else if (tokcmp(tok, ltok, "enable_ruleset_item") == 0) {
         tok = segtok(line, lline, &st, &ltok);
         if (ltok != 0) {
@@ -1472,6 +1541,47 @@ clipper_usage:
             return -1;
         }
     }
+    else if (tokcmp(tok, ltok, "sql_tenants") == 0) {
+        sql_sched_dump();
+    }
+    else if (tokcmp(tok, ltok, "sql_tenant") == 0) {
+        int weight = -1, max_concurrent = -1;
+        char *name;
+        tok = segtok(line, lline, &st, &ltok);
+        if (ltok == 0) {
+            logmsg(LOGMSG_ERROR, "Usage: sql_tenant <name> [weight <n>] [maxconcurrent <n>]\n");
+            return -1;
+        }
+        name = tokdup(tok, ltok);
+        while ((tok = segtok(line, lline, &st, &ltok)) != NULL && ltok > 0) {
+            if (tokcmp(tok, ltok, "weight") == 0) {
+                tok = segtok(line, lline, &st, &ltok);
+                weight = toknum(tok, ltok);
+                if (weight <= 0) {
+                    logmsg(LOGMSG_ERROR, "Expected positive weight\n");
+                    free(name);
+                    return -1;
+                }
+            } else if (tokcmp(tok, ltok, "maxconcurrent") == 0) {
+                tok = segtok(line, lline, &st, &ltok);
+                max_concurrent = toknum(tok, ltok);
+                if (max_concurrent < 0) {
+                    logmsg(LOGMSG_ERROR, "Expected maxconcurrent >= 0\n");
+                    free(name);
+                    return -1;
+                }
+            } else {
+                logmsg(LOGMSG_ERROR, "Unknown sql_tenant option %.*s\n", ltok, tok);
+                free(name);
+                return -1;
+            }
+        }
+        rc = sql_sched_set_tenant(name, weight, max_concurrent);
+        if (rc == 0)
+            logmsg(LOGMSG_USER, "SQL tenant %s updated\n", name);
+        free(name);
+        return rc;
+    }
     else if (tokcmp(tok, ltok, "reload_ruleset") == 0) {
         char zFileName[PATH_MAX];
         tok = segtok(line, lline, &st, &ltok);
@@ -1977,6 +2087,14 @@ clipper_usage:
             oldfile_dump();
         } else if (tokcmp(tok, ltok, "ssl") == 0) {
             ssl_stats();
+        } else if (tokcmp(tok, ltok, "latency") == 0) {
+            tok = segtok(line, lline, &st, &ltok);
+            if (tokcmp(tok, ltok, "reset") == 0) {
+                latency_histograms_reset();
+                logmsg(LOGMSG_USER, "latency histograms reset\n");
+            } else {
+                latency_histograms_dump();
+            }
         } else {
             int rc = 1;
             struct message_handler *h;
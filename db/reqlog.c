@@ -1426,12 +1426,21 @@ void reqlog_setflag(struct reqlogger *logger, unsigned flag)
 }
 
 /* figure out what to log for this request */
+static uint64_t thread_cpu_us(void)
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
 static void reqlog_start_request(struct reqlogger *logger)
 {
     int gather;
     int ii;
 
     logger->tracking_tables = master_table_rules;
+    logger->startcpuus = thread_cpu_us();
 
     if (logger->iq && logger->iq->debug) {
         logger->dump_mask = REQL_TRACE;
@@ -1914,6 +1923,12 @@ uint64_t reqlog_current_us(struct reqlogger *logger)
     return (comdb2_time_epochus() - logger->startus);
 }
 
+/* cpu time used by this thread since the request started */
+uint64_t reqlog_cpu_us(struct reqlogger *logger)
+{
+    return (thread_cpu_us() - logger->startcpuus);
+}
+
 inline void reqlog_set_rqid(struct reqlogger *logger, void *id, int idlen)
 {
     assert (idlen == sizeof(unsigned long long) || idlen == sizeof(uuid_t));
@@ -2188,6 +2203,7 @@ void reqlog_end_request(struct reqlogger *logger, int rc, const char *callfunc,
 
     logger->durationus =
         (comdb2_time_epochus() - logger->startprcsus) + logger->queuetimeus;
+    logger->cpuus = reqlog_cpu_us(logger);
 
     eventlog_add(logger);
 
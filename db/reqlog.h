@@ -72,6 +72,7 @@ void reqlog_new_sql_request(struct reqlogger *logger, struct string_ref *sr);
 void reqlog_set_sql(struct reqlogger *logger, struct string_ref *sr);
 void reqlog_set_startprcs(struct reqlogger *logger, uint64_t start);
 uint64_t reqlog_current_us(struct reqlogger *logger);
+uint64_t reqlog_cpu_us(struct reqlogger *logger);
 void reqlog_end_request(struct reqlogger *logger, int rc, const char *callfunc, int line);
 void reqlog_begin_subrequest(struct reqlogger *logger);
 void reqlog_end_subrequest(struct reqlogger *logger, int rc, const char *callfunc, int line);
@@ -110,6 +110,8 @@ struct reqlogger {
     uint64_t startprcsus; /* processing start timestamp */
     uint64_t durationus;
     uint64_t queuetimeus;
+    uint64_t startcpuus;  /* thread cpu time at start */
+    uint64_t cpuus;       /* thread cpu time used by the request */
     int rc;
     int vreplays;
     char fingerprint[FINGERPRINTSZ];
@@ -32,6 +32,7 @@
 #include "osqlcomm.h"
 #include "osqlblockproc.h"
 #include "osqlblkseq.h"
+#include "osqlsession.h"
 #include "logmsg.h"
 #include "reqlog.h"
 #include <plhash_glue.h>
@@ -220,6 +221,14 @@ retry:
             }
             iq->usedb = iq->origdb;
 
+            /* a streamed session that has to be replayed as a batch might
+               have brought in ddl or a tpt lock with the rest of its bplog */
+            if (iq->sorese && osql_sess_is_streamed(iq->sorese) &&
+                osql_sess_stream_wait(iq->sorese, -1) == OSQL_STREAM_FALLBACK) {
+                iq->tranddl = iq->sorese->scs.count;
+                iq->tptlock = iq->sorese->is_tptlock;
+            }
+
             n_retries++;
             
             /* avg_tolock_us is updated without a lock; make sure it stays in [0..25msec]
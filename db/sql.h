@@ -39,6 +39,7 @@
 #include "sqliteInt.h"
 #include "ast.h"
 #include "fingerprint.h"
+#include "thread_stats.h"
 
 /* I'm now splitting handle_fastsql_requests into two functions.  The
  * outer function will maintain state (such as temporary buffers etc) while
@@ -74,6 +75,10 @@ struct fingerprint_track {
     int alert_once_query_plan; /* Alert only once if there is a better query plan for a query. Init to 1 */
     int alert_once_query_plan_max; /* Alert (once) if hit max number of plans for associated query. Init to 1 */
     int alert_once_truncated_col;  /* Alert once if we truncated some col in the query. Init to 1 */
+
+    int64_t cpu_time;                  /* Cumulative thread cpu time */
+    int64_t wait_time[THD_WAIT_MAX];   /* Cumulative time by wait event */
+    int64_t osql_round_trips;          /* Cumulative osql round trips to master */
 };
 
 struct sql_authorizer_state {
@@ -201,6 +206,8 @@ typedef struct osqlstate {
                             (i.e. already translated */
     int dirty; /* optimization to nop selectv only transactions */
     int running_ddl; /* ddl transaction */
+    int coalesce;      /* hold sosql row ops back in the shadow tables */
+    int coalesced_ops; /* sosql row ops held back since the last flush */
     unsigned is_reorder_on : 1;
 
     /* set to 1 if we have already called osql_sock_start in socksql mode */
@@ -711,6 +718,9 @@ struct sqlclntstate {
                                 * being used to service the request; otherwise,
                                 * a specifically assigned SQL thread pool is
                                 * being used. */
+    struct sql_sched_tenant *sched_tenant; /* Tenant charged by the SQL
+                                            * scheduler while this request
+                                            * holds one of its slots. */
 
     struct sqlworkstate work;  /* This is the primary data related to the SQL
                                 * client request in progress.  This includes
@@ -1567,6 +1577,9 @@ void destroy_all_sql_pools(void);
 
 int get_data(BtCursor *pCur, struct schema *sc, uint8_t *in, int fnum, Mem *m,
              uint8_t flip_orig, const char *tzname);
+int get_data_run(BtCursor *pCur, struct schema *sc, uint8_t *in, int fnum,
+                 int n, Mem *m, uint8_t flip_orig, const char *tzname);
+extern int gbl_bulk_column_decode;
 
 #define cur_is_remote(pCur) (pCur->cursor_class == CURSORCLASS_REMOTE)
 
@@ -1618,6 +1631,7 @@ void clnt_query_cost(struct sqlthdstate *thd, double *pCost, int64_t *pPrepMs);
 int clear_fingerprints(int *plans_count);
 int fingerprint_has_main_entry(const unsigned char fingerprint[FINGERPRINTSZ]);
 int fingerprint_is_zero(const unsigned char fingerprint[FINGERPRINTSZ]);
+int64_t fingerprint_avg_time(const unsigned char fingerprint[FINGERPRINTSZ]);
 void calc_fingerprint(const char *zNormSql, size_t *pnNormSql,
                       unsigned char fingerprint[FINGERPRINTSZ]);
 void add_fingerprint(struct sqlclntstate *, sqlite3_stmt *, struct string_ref *, const char *, int64_t, int64_t,
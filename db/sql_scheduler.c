@@ -0,0 +1,353 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "epochlib.h"
+#include "list.h"
+#include "sys_wrap.h"
+#include "logmsg.h"
+#include "plhash_glue.h"
+#include "sql_scheduler.h"
+
+int gbl_sql_scheduler = 0;
+int gbl_sql_scheduler_concurrency = 0;
+int gbl_sql_scheduler_tenant = SQL_SCHED_TENANT_USER;
+int gbl_sql_scheduler_cost_aware = 1;
+
+extern int get_default_sql_pool_max_threads(void);
+
+/* Past this many tenants, new ones share the overflow tenant */
+#define SQL_SCHED_MAX_TENANTS 1000
+#define SQL_SCHED_OVERFLOW_TENANT "(other)"
+/* Virtual time units per ms of cost at weight 1 */
+#define SQL_SCHED_SCALE 1024
+
+struct sql_sched_request {
+    uint64_t vstart;
+    uint64_t enqueue_us;
+    uint64_t deadline_us; /* 0 if it can wait forever */
+    sql_sched_dispatch_fn *fn;
+    void *arg;
+    LINKC_T(struct sql_sched_request) lnk;
+};
+
+struct sql_sched_tenant {
+    char *name;
+    int weight;
+    int max_concurrent;
+    int running;
+    int64_t peak_queued;
+    int64_t dispatched;
+    int64_t total_wait_us;
+    int64_t max_wait_us;
+    int64_t timeouts;
+    uint64_t vfinish; /* virtual finish of the last request queued */
+    LISTC_T(struct sql_sched_request) queue;
+    LINKC_T(struct sql_sched_tenant) active_lnk;
+};
+
+static pthread_mutex_t sched_lk = PTHREAD_MUTEX_INITIALIZER;
+static hash_t *tenants;
+static int ntenants;
+/* tenants with something queued */
+static LISTC_T(struct sql_sched_tenant) active;
+static uint64_t vtime;
+static int running;
+static int queued;
+static int64_t total_wait_us;
+/* Running mean of known costs, charged to requests of unknown cost.  Kept
+ * as a double: most costs are a few ms, and an integer mean moving by
+ * 1/16th of the difference would never rise above them. */
+static double avg_cost = 1;
+
+static int sched_limit(void)
+{
+    if (gbl_sql_scheduler_concurrency > 0)
+        return gbl_sql_scheduler_concurrency;
+    return get_default_sql_pool_max_threads();
+}
+
+static struct sql_sched_tenant *get_tenant(const char *name, int create)
+{
+    struct sql_sched_tenant *t;
+
+    if (tenants == NULL) {
+        tenants = hash_init_strptr(offsetof(struct sql_sched_tenant, name));
+        listc_init(&active, offsetof(struct sql_sched_tenant, active_lnk));
+    }
+    if ((t = hash_find(tenants, &name)) != NULL || !create)
+        return t;
+    if (ntenants >= SQL_SCHED_MAX_TENANTS &&
+        strcmp(name, SQL_SCHED_OVERFLOW_TENANT) != 0)
+        return get_tenant(SQL_SCHED_OVERFLOW_TENANT, 1);
+
+    t = calloc(1, sizeof(struct sql_sched_tenant));
+    if (t == NULL)
+        return NULL;
+    t->name = strdup(name);
+    if (t->name == NULL) {
+        free(t);
+        return NULL;
+    }
+    t->weight = 1;
+    listc_init(&t->queue, offsetof(struct sql_sched_request, lnk));
+    hash_add(tenants, t);
+    ntenants++;
+    return t;
+}
+
+static int can_run(struct sql_sched_tenant *t)
+{
+    return t->max_concurrent <= 0 || t->running < t->max_concurrent;
+}
+
+/* Pick the queued request with the smallest virtual start among tenants
+ * below their cap, and account for it as running.  A request past its
+ * deadline is returned with a NULL tenant and takes no slot. */
+static struct sql_sched_request *next_request(struct sql_sched_tenant **pt)
+{
+    struct sql_sched_tenant *t, *best = NULL;
+    struct sql_sched_request *r;
+    uint64_t now;
+    int64_t wait;
+
+    if (running >= sched_limit())
+        return NULL;
+    LISTC_FOR_EACH(&active, t, active_lnk)
+    {
+        if (!can_run(t))
+            continue;
+        if (best == NULL || t->queue.top->vstart < best->queue.top->vstart)
+            best = t;
+    }
+    if (best == NULL)
+        return NULL;
+
+    r = listc_rtl(&best->queue);
+    if (best->queue.count == 0)
+        listc_rfl(&active, best);
+    queued--;
+    if (vtime < r->vstart)
+        vtime = r->vstart;
+
+    now = comdb2_time_epochus();
+    if (r->deadline_us && now > r->deadline_us) {
+        best->timeouts++;
+        *pt = NULL;
+        return r;
+    }
+    wait = now > r->enqueue_us ? now - r->enqueue_us : 0;
+    best->total_wait_us += wait;
+    if (best->max_wait_us < wait)
+        best->max_wait_us = wait;
+    total_wait_us += wait;
+    best->dispatched++;
+    best->running++;
+    running++;
+    *pt = best;
+    return r;
+}
+
+static void dispatch_ready(void)
+{
+    struct sql_sched_request *r;
+    struct sql_sched_tenant *t = NULL;
+
+    for (;;) {
+        Pthread_mutex_lock(&sched_lk);
+        r = next_request(&t);
+        Pthread_mutex_unlock(&sched_lk);
+        if (r == NULL)
+            break;
+        r->fn(r->arg, t);
+        free(r);
+    }
+}
+
+int sql_sched_submit(const char *name, int64_t cost, int can_queue,
+                     int maxqueue, int maxqueueagems,
+                     sql_sched_dispatch_fn *fn, void *arg)
+{
+    struct sql_sched_tenant *t;
+    struct sql_sched_request *r;
+    uint64_t vstart;
+
+    r = calloc(1, sizeof(struct sql_sched_request));
+    if (r == NULL)
+        return -1;
+    r->fn = fn;
+    r->arg = arg;
+    r->enqueue_us = comdb2_time_epochus();
+    if (maxqueueagems > 0)
+        r->deadline_us = r->enqueue_us + (uint64_t)maxqueueagems * 1000;
+
+    Pthread_mutex_lock(&sched_lk);
+    if ((t = get_tenant(name, 1)) == NULL) {
+        Pthread_mutex_unlock(&sched_lk);
+        free(r);
+        logmsg(LOGMSG_ERROR, "%s: out of memory adding tenant %s\n", __func__, name);
+        return -1;
+    }
+    if ((running >= sched_limit() || !can_run(t) || queued > 0) &&
+        (!can_queue || (maxqueue > 0 && queued >= maxqueue))) {
+        Pthread_mutex_unlock(&sched_lk);
+        free(r);
+        return -1;
+    }
+
+    if (!gbl_sql_scheduler_cost_aware)
+        cost = 1;
+    else if (cost < 0)
+        cost = (int64_t)(avg_cost + 0.5);
+    else
+        avg_cost += (cost - avg_cost) / 16;
+    if (cost < 1)
+        cost = 1;
+
+    vstart = t->vfinish > vtime ? t->vfinish : vtime;
+    r->vstart = vstart;
+    t->vfinish = vstart + (uint64_t)cost * SQL_SCHED_SCALE / t->weight;
+    listc_abl(&t->queue, r);
+    if (t->queue.count == 1)
+        listc_abl(&active, t);
+    if (t->peak_queued < t->queue.count)
+        t->peak_queued = t->queue.count;
+    queued++;
+    Pthread_mutex_unlock(&sched_lk);
+
+    dispatch_ready();
+    return 0;
+}
+
+void sql_sched_done(struct sql_sched_tenant *t)
+{
+    Pthread_mutex_lock(&sched_lk);
+    t->running--;
+    running--;
+    Pthread_mutex_unlock(&sched_lk);
+
+    dispatch_ready();
+}
+
+int sql_sched_set_tenant(const char *name, int weight, int max_concurrent)
+{
+    struct sql_sched_tenant *t;
+
+    Pthread_mutex_lock(&sched_lk);
+    if ((t = get_tenant(name, 1)) == NULL) {
+        Pthread_mutex_unlock(&sched_lk);
+        return -1;
+    }
+    if (weight > 0)
+        t->weight = weight;
+    if (max_concurrent >= 0)
+        t->max_concurrent = max_concurrent;
+    Pthread_mutex_unlock(&sched_lk);
+
+    /* a raised cap may let queued work through */
+    dispatch_ready();
+    return 0;
+}
+
+struct tenant_info_arg {
+    struct sql_sched_tenant_info *info;
+    int n;
+};
+
+static int collect_tenant(void *obj, void *arg)
+{
+    struct sql_sched_tenant *t = obj;
+    struct tenant_info_arg *a = arg;
+    struct sql_sched_tenant_info *i = &a->info[a->n];
+
+    i->name = strdup(t->name);
+    if (i->name == NULL)
+        return 0;
+    i->weight = t->weight;
+    i->max_concurrent = t->max_concurrent;
+    i->running = t->running;
+    i->queued = t->queue.count;
+    i->peak_queued = t->peak_queued;
+    i->dispatched = t->dispatched;
+    i->total_wait_us = t->total_wait_us;
+    i->max_wait_us = t->max_wait_us;
+    i->timeouts = t->timeouts;
+    a->n++;
+    return 0;
+}
+
+int sql_sched_get_tenant_info(struct sql_sched_tenant_info **out, int *n)
+{
+    struct tenant_info_arg a = {0};
+
+    Pthread_mutex_lock(&sched_lk);
+    if (ntenants > 0) {
+        a.info = calloc(ntenants, sizeof(struct sql_sched_tenant_info));
+        if (a.info == NULL) {
+            Pthread_mutex_unlock(&sched_lk);
+            return -1;
+        }
+        hash_for(tenants, collect_tenant, &a);
+    }
+    Pthread_mutex_unlock(&sched_lk);
+
+    *out = a.info;
+    *n = a.n;
+    return 0;
+}
+
+void sql_sched_free_tenant_info(struct sql_sched_tenant_info *info, int n)
+{
+    for (int i = 0; i < n; i++)
+        free(info[i].name);
+    free(info);
+}
+
+void sql_sched_totals(int64_t *pqueued, int64_t *prunning, int64_t *pwait_us)
+{
+    Pthread_mutex_lock(&sched_lk);
+    *pqueued = queued;
+    *prunning = running;
+    *pwait_us = total_wait_us;
+    Pthread_mutex_unlock(&sched_lk);
+}
+
+void sql_sched_dump(void)
+{
+    struct sql_sched_tenant_info *info;
+    int n;
+
+    logmsg(LOGMSG_USER, "sql scheduler %s, limit %d, running %d, queued %d\n",
+           gbl_sql_scheduler ? "enabled" : "disabled", sched_limit(), running,
+           queued);
+    if (sql_sched_get_tenant_info(&info, &n))
+        return;
+    for (int i = 0; i < n; i++) {
+        logmsg(LOGMSG_USER,
+               "  %-32s weight %" PRId64 " max %" PRId64 " running %" PRId64
+               " queued %" PRId64 " dispatched %" PRId64 " wait %" PRId64
+               "us timeouts %" PRId64 "\n",
+               info[i].name, info[i].weight, info[i].max_concurrent,
+               info[i].running, info[i].queued, info[i].dispatched,
+               info[i].total_wait_us, info[i].timeouts);
+    }
+    sql_sched_free_tenant_info(info, n);
+}
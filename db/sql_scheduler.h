@@ -0,0 +1,88 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef INCLUDED_SQL_SCHEDULER_H
+#define INCLUDED_SQL_SCHEDULER_H
+
+#include <stdint.h>
+
+/*
+ * Weighted fair queuing in front of the default SQL thread pool.  Each
+ * request is charged to a tenant (its user, origin host or fingerprint,
+ * depending on the sql_scheduler_tenant tunable).  Requests are admitted
+ * in start-time fair queuing order: a tenant's virtual clock advances by
+ * cost / weight per request, so a tenant flooding the pool only delays
+ * its own later requests.  A tenant may additionally be capped to a number
+ * of concurrently running requests.
+ */
+
+enum sql_sched_tenant_by {
+    SQL_SCHED_TENANT_USER = 0,
+    SQL_SCHED_TENANT_HOST = 1,
+    SQL_SCHED_TENANT_FINGERPRINT = 2
+};
+
+extern int gbl_sql_scheduler;
+extern int gbl_sql_scheduler_concurrency;
+extern int gbl_sql_scheduler_tenant;
+extern int gbl_sql_scheduler_cost_aware;
+
+struct sql_sched_tenant;
+
+/* Called once a request is admitted, outside of the scheduler lock.  On
+ * failure the callee must still call sql_sched_done() for the tenant.  A
+ * NULL tenant means the request waited longer than its maxqueueagems and
+ * must be failed instead; it holds no slot. */
+typedef void sql_sched_dispatch_fn(void *arg, struct sql_sched_tenant *);
+
+/* Admit or queue a request.  cost is in ms; pass a negative cost when it
+ * is unknown.  Returns 0 if the request was dispatched or queued, non-zero
+ * if it could not run now and may not (can_queue == 0) or cannot (queue
+ * full at maxqueue) wait.  As in a thread pool, a request still queued
+ * after maxqueueagems (if > 0) times out when its turn comes. */
+int sql_sched_submit(const char *tenant, int64_t cost, int can_queue,
+                     int maxqueue, int maxqueueagems,
+                     sql_sched_dispatch_fn *fn, void *arg);
+/* An admitted request finished: free its slot and admit the next */
+void sql_sched_done(struct sql_sched_tenant *);
+
+/* Weight and concurrency cap of a tenant; a negative value is left alone,
+ * a max_concurrent of 0 means unlimited */
+int sql_sched_set_tenant(const char *tenant, int weight, int max_concurrent);
+
+struct sql_sched_tenant_info {
+    char *name;
+    int64_t weight;
+    int64_t max_concurrent;
+    int64_t running;
+    int64_t queued;
+    int64_t peak_queued;
+    int64_t dispatched;
+    int64_t total_wait_us;
+    int64_t max_wait_us;
+    int64_t timeouts;
+};
+
+/* Snapshot of all tenants; release with sql_sched_free_tenant_info */
+int sql_sched_get_tenant_info(struct sql_sched_tenant_info **out, int *n);
+void sql_sched_free_tenant_info(struct sql_sched_tenant_info *, int n);
+
+/* Totals across tenants, for the metrics */
+void sql_sched_totals(int64_t *queued, int64_t *running, int64_t *wait_us);
+
+void sql_sched_dump(void);
+
+#endif
@@ -880,6 +880,9 @@ void get_one_explain_line(struct sqlclntstate *clnt, sqlite3 *hndl, strbuf *out,
         if (op->p5 == BTREE_UNORDERED) {
             strbuf_append(out, " [Hash table]");
         }
+        if (op->p5 == BTREE_JOINHASH) {
+            strbuf_append(out, " [Join hash]");
+        }
         break;
     }
     case OP_OpenPseudo:
@@ -109,6 +109,7 @@
 #include <sqlwriter.h>
 
 #include "views.h"
+#include "thread_stats.h"
 
 int gbl_delay_sql_lock_release_sec = 5;
 
@@ -125,6 +126,7 @@ extern int gbl_expressions_indexes;
 extern int gbl_debug_tmptbl_corrupt_mem;
 extern int gbl_utxnid_log;
 extern int gbl_serializable;
+extern int gbl_osql_coalesce_max_ops;
 
 // Lua threads share temp tables.
 // Don't create new btree, use this one (tmptbl_clone)
@@ -941,11 +943,11 @@ static int ondisk_to_sqlite_tz(struct dbtable *db, struct schema *s, void *inp,
 
     *reqsize = 0;
 
+    memset(m, 0, sizeof(Mem) * nField);
+    rc = get_data_run(pCur, s, in, 0, nField, m, 1, tzname);
+    if (rc)
+        goto done;
     for (fnum = 0; fnum < nField; fnum++) {
-        memset(&m[fnum], 0, sizeof(Mem));
-        rc = get_data(pCur, s, in, fnum, &m[fnum], 1, tzname);
-        if (rc)
-            goto done;
         type[fnum] =
             sqlite3VdbeSerialType(&m[fnum], SQLITE_DEFAULT_FILE_FORMAT, &sz);
         datasz += sz;
@@ -3281,6 +3283,95 @@ int temp_table_cmp(KeyInfo *pKeyInfo, int k1len, const void *key1, int k2len,
         return sqlite3VdbeRecordCompare(k1len, key1, (UnpackedRecord *)key2);
 }
 
+#define TMPTBL_FNV_OFFSET 2166136261u
+#define TMPTBL_FNV_PRIME 16777619u
+
+static inline unsigned int fnv1a(unsigned int h, const void *buf, int len)
+{
+    const uint8_t *p = buf;
+    for (int i = 0; i < len; i++)
+        h = (h ^ p[i]) * TMPTBL_FNV_PRIME;
+    return h;
+}
+
+/* Fold one value into the hash so that values sqlite3MemCompare() finds
+ * equal under BINARY collation hash alike: integers and integral reals
+ * share a representation */
+static int temp_table_hash_mem(const Mem *m, unsigned int *h)
+{
+    uint8_t tag;
+    i64 i;
+
+    if (m->flags & MEM_Null) {
+        tag = 0;
+        *h = fnv1a(*h, &tag, 1);
+        return 0;
+    }
+    if (m->flags & (MEM_Datetime | MEM_Interval | MEM_Small | MEM_Zero |
+                    MEM_Xor))
+        return -1;
+    if (m->flags & MEM_Int) {
+        i = m->u.i;
+    } else if (m->flags & MEM_Real) {
+        double r = m->u.r;
+        if (!(r >= -9223372036854775808.0 && r < 9223372036854775808.0) ||
+            (double)(i = (i64)r) != r) {
+            tag = 2;
+            *h = fnv1a(*h, &tag, 1);
+            *h = fnv1a(*h, &r, sizeof(r));
+            return 0;
+        }
+    } else if (m->flags & (MEM_Str | MEM_Blob)) {
+        tag = (m->flags & MEM_Str) ? 3 : 4;
+        *h = fnv1a(*h, &tag, 1);
+        *h = fnv1a(*h, m->z, m->n);
+        return 0;
+    } else {
+        return -1;
+    }
+    tag = 1;
+    *h = fnv1a(*h, &tag, 1);
+    *h = fnv1a(*h, &i, sizeof(i));
+    return 0;
+}
+
+/* tmptbl_hash for sqlite temp tables: hashes the first nfields fields of a
+ * packed record, or of an UnpackedRecord when keylen < 0 */
+int temp_table_hash(int nfields, int keylen, const void *key,
+                    unsigned int *hash)
+{
+    unsigned int h = TMPTBL_FNV_OFFSET;
+
+    if (keylen < 0) {
+        const UnpackedRecord *rec = key;
+        if (nfields > rec->nField)
+            nfields = rec->nField;
+        for (int i = 0; i < nfields; i++) {
+            if (temp_table_hash_mem(&rec->aMem[i], &h))
+                return -1;
+        }
+    } else {
+        const unsigned char *rec = key;
+        u32 hdrsz, serial_type, idx, d;
+        Mem m;
+
+        idx = getVarint32(rec, hdrsz);
+        d = hdrsz;
+        for (int i = 0; i < nfields; i++) {
+            if (idx >= hdrsz || d > keylen)
+                return -1;
+            idx += getVarint32(&rec[idx], serial_type);
+            m.flags = 0;
+            m.szMalloc = 0;
+            d += sqlite3VdbeSerialGet(&rec[d], serial_type, &m);
+            if (d > keylen || temp_table_hash_mem(&m, &h))
+                return -1;
+        }
+    }
+    *hash = h;
+    return 0;
+}
+
 /* This is OP_MakeRecord from vdbe.c. */
 void sqlite3VdbeRecordPack(UnpackedRecord *unpacked, Mem *pOut)
 {
@@ -4817,6 +4908,8 @@ int initialize_shadow_trans(struct sqlclntstate *clnt)
         }
 
         clnt->osql.sock_started = 0;
+        clnt->osql.coalesce = gbl_osql_coalesce_max_ops > 0;
+        clnt->osql.coalesced_ops = 0;
 
         break;
     }
@@ -5480,6 +5573,12 @@ int sqlite3BtreeCreateTable(Btree *pBt, int *piTable, int flags)
     if (pBt->is_hashtable) {
         pNewTbl->tbl = bdb_temp_hashtable_create(thedb->bdb_env, &bdberr);
         if (pNewTbl->tbl != NULL) ATOMIC_ADD32(gbl_sql_temptable_count, 1);
+    } else if (flags & BTREE_JOINHASH) {
+        pNewTbl->tbl = bdb_temp_joinhash_create(thedb->bdb_env, &bdberr);
+        if (pNewTbl->tbl != NULL) {
+            bdb_temp_table_set_hash_func(pNewTbl->tbl, temp_table_hash);
+            ATOMIC_ADD32(gbl_sql_temptable_count, 1);
+        }
     } else if (tmptbl_clone) {
         pNewTbl->sp_tmptbl = tmptbl_clone->sp_tmptbl;
         pNewTbl->tbl = tmptbl_clone->tbl;
@@ -5845,6 +5944,14 @@ int sqlite3BtreeMovetoUnpacked(BtCursor *pCur, /* The cursor to be moved */
                 rc = bdb_temp_table_find(thedb->bdb_env, pCur->tmptable->cursor,
                                          mem.z, mem.n, NULL, &bdberr);
                 sqlite3VdbeMemRelease(&mem);
+            } else if (bdb_is_joinhash(pCur->tmptable->tbl)) {
+                /* probe for equality, whatever the seek bias */
+                i8 default_rc = pIdxKey->default_rc;
+                pIdxKey->default_rc = 0;
+                rc = bdb_temp_table_find_joinhash(
+                    thedb->bdb_env, pCur->tmptable->cursor, pIdxKey,
+                    pIdxKey->nField, &bdberr);
+                pIdxKey->default_rc = default_rc;
             } else {
                 rc = pCur->cursor_find(thedb->bdb_env, pCur->tmptable->cursor,
                                        NULL, 0, pIdxKey, &bdberr, pCur);
@@ -7334,6 +7441,94 @@ done:
     return rc;
 }
 
+int gbl_bulk_column_decode = 1;
+
+/* Decode fields fnum .. fnum + n - 1 of an ondisk record into m[0] ..
+ * m[n - 1].  Ascending binary integers and reals, which make up most of a
+ * wide row, are unbiased in place here in a single pass instead of going
+ * through the generic conversion routines; anything else is handed to
+ * get_data(). */
+int get_data_run(BtCursor *pCur, struct schema *sc, uint8_t *in, int fnum,
+                 int n, Mem *m, uint8_t flip_orig, const char *tzname)
+{
+    int rc;
+
+    for (int i = 0; i < n; i++, m++) {
+        struct field *f = &sc->member[fnum + i];
+        const uint8_t *p = in + f->offset;
+
+        if (!gbl_bulk_column_decode || (f->flags & INDEX_DESCEND) ||
+            (f->type != SERVER_BINT && f->type != SERVER_BREAL))
+            goto slow;
+
+        if (stype_is_null(p)) {
+            m->z = NULL;
+            m->n = 0;
+            m->flags = MEM_Null;
+            continue;
+        }
+
+        if (f->type == SERVER_BINT) {
+            switch (f->len) {
+            case 3: {
+                uint16_t v;
+                memcpy(&v, p + 1, sizeof(v));
+                m->u.i = (int16_t)(ntohs(v) ^ 0x8000U);
+                break;
+            }
+            case 5: {
+                uint32_t v;
+                memcpy(&v, p + 1, sizeof(v));
+                m->u.i = (int32_t)(ntohl(v) ^ 0x80000000U);
+                break;
+            }
+            case 9: {
+                uint64_t v;
+                memcpy(&v, p + 1, sizeof(v));
+                m->u.i = (int64_t)(flibc_ntohll(v) ^ 0x8000000000000000ULL);
+                break;
+            }
+            default:
+                goto slow;
+            }
+            m->flags = MEM_Int;
+        } else {
+            /* a set sign bit marks a positive value, which only had its
+             * sign flipped; negatives had all their bits flipped */
+            switch (f->len) {
+            case 5: {
+                uint32_t v;
+                float r;
+                memcpy(&v, p + 1, sizeof(v));
+                v = ntohl(v);
+                v ^= ((v >> 31) - 1) | 0x80000000U;
+                memcpy(&r, &v, sizeof(r));
+                m->u.r = r;
+                break;
+            }
+            case 9: {
+                uint64_t v;
+                memcpy(&v, p + 1, sizeof(v));
+                v = flibc_ntohll(v);
+                v ^= ((v >> 63) - 1) | 0x8000000000000000ULL;
+                memcpy(&m->u.r, &v, sizeof(v));
+                break;
+            }
+            default:
+                goto slow;
+            }
+            m->flags = MEM_Real;
+        }
+        continue;
+
+    slow:
+        rc = get_data(pCur, sc, in, fnum + i, m, flip_orig, tzname);
+        if (rc)
+            return rc;
+    }
+    return 0;
+}
+
 int get_datacopy(BtCursor *pCur, int fnum, Mem *m)
 {
     uint8_t *in;
@@ -8775,6 +8970,7 @@ static int chunk_transaction(BtCursor *pCur, struct sqlclntstate *clnt,
         int throttle = clnt->dbtran.throttle_txn_chunks_msec > 0 ? clnt->dbtran.throttle_txn_chunks_msec : gbl_throttle_txn_chunks_msec;
         if (throttle > 0) {
             poll(NULL, 0, throttle);
+            bdb_thread_wait(THD_WAIT_THROTTLE, M2U(throttle));
         }
 
         /* restart a new transaction */
@@ -8938,7 +9134,8 @@ int sqlite3BtreeInsert(
         /* data: nKey is 'rrn', pData is record, nData is size of record
          * index: pKey is key, nKey is size of key (no data) */
         UnpackedRecord *rec = NULL;
-        if (pKey) {
+        /* the join hash never compares on insert */
+        if (pKey && !bdb_is_joinhash(pCur->tmptable->tbl)) {
             rec = sqlite3VdbeAllocUnpackedRecord(pCur->pKeyInfo);
             if (rec == 0) {
                 logmsg(LOGMSG_ERROR, "Error rec is zero, returned from "
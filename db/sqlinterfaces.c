@@ -89,6 +89,7 @@
 #include "reqlog.h"
 #include "eventlog.h"
 #include "perf.h"
+#include "histogram.h"
 #include "tohex.h"
 
 #include "dohsql.h"
@@ -99,6 +100,7 @@
 #include <net_appsock.h>
 #include <typessql.h>
 #include <sqlwriter.h>
+#include "sql_scheduler.h"
 
 /*
 ** WARNING: These enumeration values are not arbitrary.  They represent
@@ -1255,8 +1257,11 @@ static void sql_statement_done(struct sql_thread *thd, struct reqlogger *logger,
     h->when = thd->stime;
     h->txnid = clnt->osql.rqid;
 
-    if (clnt->pPool == NULL && !can_consume(clnt))
+    if (clnt->pPool == NULL && !can_consume(clnt)) {
         time_metric_add(thedb->service_time, h->cost.time);
+        if (logger)
+            latency_histogram_add(LATENCY_SQL_STATEMENT, reqlog_current_us(logger));
+    }
     clnt->last_cost = (int64_t) h->cost.cost;
 
     /* request logging framework takes care of logging long sql requests */
@@ -4969,6 +4974,10 @@ static void sqlengine_work_appsock_pp(struct thdpool *pool, void *work,
                                       void *thddata, int op)
 {
     struct sqlclntstate *clnt = work;
+    /* Once signalled done the clnt may be dispatched again, with a new
+     * tenant, before we get to release this one */
+    struct sql_sched_tenant *tenant = clnt->sched_tenant;
+    clnt->sched_tenant = NULL;
 
     switch (op) {
     case THD_RUN:
@@ -4993,6 +5002,8 @@ static void sqlengine_work_appsock_pp(struct thdpool *pool, void *work,
         signal_clnt_as_done(clnt);
         break;
     }
+    if (tenant)
+        sql_sched_done(tenant);
     bdb_temp_table_maybe_reset_priority_thread(thedb->bdb_env, 1);
 }
 
@@ -5033,6 +5044,77 @@ static int send_heartbeat(struct sqlclntstate *clnt)
         }                                                                      \
     } while (0)
 
+static int sql_sched_applies(struct sqlclntstate *clnt, struct thdpool *pool,
+                             int force_dispatch)
+{
+    /* Statements of an open transaction hold locks that queued work may be
+     * waiting on, so they are never held back */
+    return gbl_sql_scheduler && !clnt->admin && !force_dispatch &&
+           !clnt->exec_lua_thread && !in_client_trans(clnt) &&
+           clnt->osql.replay == OSQL_RETRY_NONE &&
+           pool == get_default_sql_pool(0);
+}
+
+static int sql_sched_wants_fingerprint(void)
+{
+    return gbl_sql_scheduler && gbl_fingerprint_queries &&
+           (gbl_sql_scheduler_cost_aware ||
+            gbl_sql_scheduler_tenant == SQL_SCHED_TENANT_FINGERPRINT);
+}
+
+static void sql_sched_tenant_name(struct sqlclntstate *clnt, char *name,
+                                  size_t len)
+{
+    switch (gbl_sql_scheduler_tenant) {
+    case SQL_SCHED_TENANT_HOST:
+        snprintf(name, len, "%s", clnt->origin_host ? clnt->origin_host : "localhost");
+        break;
+    case SQL_SCHED_TENANT_FINGERPRINT:
+        if (fingerprint_is_zero(clnt->work.aFingerprint))
+            snprintf(name, len, "(none)");
+        else
+            util_tohex(name, (char *)clnt->work.aFingerprint, FINGERPRINTSZ);
+        break;
+    default:
+        snprintf(name, len, "%s", clnt->current_user.have_name ? clnt->current_user.name : "(none)");
+        break;
+    }
+}
+
+/* The scheduler admitted this request: hand it to the default pool.  The
+ * scheduler has already accounted for the slot, so the pool may not queue
+ * it again.  Without a tenant the request timed out in the scheduler, and
+ * is failed the way the pool fails work that sat in its queue too long. */
+static void sql_sched_dispatch(void *arg, struct sql_sched_tenant *tenant)
+{
+    struct sqlclntstate *clnt = arg;
+    struct thdpool *pool = get_default_sql_pool(0);
+    if (tenant == NULL) {
+        thdpool_add_timeout(pool);
+        sqlengine_work_appsock_pp(pool, clnt, NULL, THD_FREE);
+        return;
+    }
+    struct string_ref *sr = get_ref(clnt->sql_ref);
+    clnt->sched_tenant = tenant;
+    if (thdpool_enqueue(pool, sqlengine_work_appsock_pp, clnt, 1, sr, THDPOOL_FORCE_DISPATCH)) {
+        logmsg(LOGMSG_ERROR, "%s: failed to dispatch: %s\n", __func__, string_ref_cstr(clnt->sql_ref));
+        put_ref(&sr);
+        sqlengine_work_appsock_pp(NULL, clnt, NULL, THD_FREE);
+    }
+}
+
+static int sql_sched_enqueue(struct sqlclntstate *clnt, struct thdpool *pool)
+{
+    char tenant[64];
+    int64_t cost = -1;
+
+    sql_sched_tenant_name(clnt, tenant, sizeof(tenant));
+    if (gbl_sql_scheduler_cost_aware && !fingerprint_is_zero(clnt->work.aFingerprint))
+        cost = fingerprint_avg_time(clnt->work.aFingerprint);
+    return sql_sched_submit(tenant, cost, clnt->queue_me, thdpool_get_maxqueue(pool), thdpool_get_maxqueueagems(pool),
+                            sql_sched_dispatch, clnt);
+}
+
 static int enqueue_sql_query(struct sqlclntstate *clnt, int force_dispatch)
 {
     char msg[1024];
@@ -5110,6 +5192,17 @@ static int enqueue_sql_query(struct sqlclntstate *clnt, int force_dispatch)
         clnt->queue_me = 1;
     }
 
+    if (sql_sched_applies(clnt, pool, force_dispatch)) {
+        if ((rc = sql_sched_enqueue(clnt, pool)) != 0) {
+            logmsg(LOGMSG_DEBUG, "%s: failed to schedule: %s\n", __func__, string_ref_cstr(clnt->sql_ref));
+            if (clnt->fail_dispatch) {
+                snprintf(msg, sizeof(msg), "%s: unable to dispatch sql query, rc=%d\n", __func__, rc);
+                handle_failed_dispatch(clnt, msg);
+            }
+        }
+        return rc;
+    }
+
     struct string_ref *sr = get_ref(clnt->sql_ref);
     if ((rc = thdpool_enqueue(pool, sqlengine_work_appsock_pp,
                               clnt, clnt->queue_me, sr, flags)) != 0) {
@@ -5222,14 +5315,25 @@ static int verify_dispatch_sql_query(struct sqlclntstate *clnt, int force_dispat
 {
     memset(clnt->work.zRuleRes, 0, sizeof(clnt->work.zRuleRes));
 
-    if (clnt->admin || force_dispatch || !gbl_prioritize_queries || !gbl_ruleset) {
+    if (clnt->admin || force_dispatch) {
+        return 0;
+    }
+
+    int use_ruleset = gbl_prioritize_queries && gbl_ruleset;
+    if (!use_ruleset && !sql_sched_wants_fingerprint()) {
         return 0;
     }
 
     if (gbl_fingerprint_queries) {
+        /* don't let the scheduler see the previous statement's fingerprint */
+        memset(clnt->work.aFingerprint, 0, FINGERPRINTSZ);
         preview_and_calc_fingerprint(clnt);
     }
 
+    if (!use_ruleset) {
+        return 0;
+    }
+
     int ruleNo = 0;
     int bRejected = 0;
     int bTryAgain = 0;
@@ -712,7 +712,8 @@ static void osql_scdone_commit_callback(struct ireq *iq)
                     freedb(iq->sc->db);
                 }
             }
-            if (iq->sc->kind == SC_TRUNCATETABLE)
+            if (iq->sc->kind == SC_TRUNCATETABLE ||
+                iq->sc->kind == SC_BULK_LOAD)
                 autoanalyze_after_fastinit(iq->sc->tablename);
             free_schema_change_type(iq->sc);
 
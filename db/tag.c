@@ -60,6 +60,7 @@
 #include "schemachange.h" /* sc_errf() */
 #include "dynschematypes.h"
 #include "fdb_fend.h"
+#include "comdb2_atomic.h"
 
 extern struct dbenv *thedb;
 extern pthread_mutex_t csc2_subsystem_mtx;
@@ -3552,6 +3553,129 @@ int stag_set_key_null(struct dbtable *table, const char *tag, const char *inkey,
     return 0;
 }
 
+int gbl_ix_key_plans = 1;
+
+static struct ix_key_plan *ix_key_plan_compile(const struct schema *from,
+                                               const struct schema *to)
+{
+    struct ix_key_plan *plan;
+    struct ix_key_step *step, *prev = NULL;
+
+    plan = calloc(1, sizeof(struct ix_key_plan) +
+                         to->nmembers * (sizeof(struct ix_key_step) +
+                                         sizeof(unsigned int)));
+    if (plan == NULL)
+        return NULL;
+    plan->from = from;
+    plan->notnull = (unsigned int *)&plan->steps[to->nmembers + 1];
+
+    for (int i = 0; i < to->nmembers; i++) {
+        const struct field *t = &to->member[i];
+        int idx = find_field_idx_in_tag(from, t->name);
+        const struct field *f = idx >= 0 ? &from->member[idx] : NULL;
+        int kind = IX_KEY_FIELD;
+
+        /* comdb2_seqno may be generated by stag_to_stag_field */
+        if (f && !t->isExpr && f->blob_index < 0 && t->blob_index < 0 &&
+            f->type == t->type && f->len == t->len &&
+            !(f->flags & INDEX_DESCEND) &&
+            strcasecmp(t->name, "comdb2_seqno") != 0) {
+            if (t->type == SERVER_BINT || t->type == SERVER_BREAL)
+                kind = IX_KEY_COPY;
+            else if (t->type == SERVER_BYTEARRAY)
+                kind = IX_KEY_BYTES;
+        }
+
+        if (kind == IX_KEY_FIELD) {
+            step = &plan->steps[plan->nsteps++];
+            step->kind = kind;
+            step->field = i;
+            step->from_idx = idx;
+            prev = NULL;
+            continue;
+        }
+
+        if (t->flags & NO_NULL)
+            plan->notnull[plan->nnotnull++] = f->offset;
+        if (kind == IX_KEY_COPY && !(t->flags & INDEX_DESCEND) && prev &&
+            prev->from_off + prev->len == f->offset &&
+            prev->to_off + prev->len == t->offset) {
+            prev->len += t->len;
+            continue;
+        }
+        step = &plan->steps[plan->nsteps++];
+        step->kind = kind;
+        step->flip = (t->flags & INDEX_DESCEND) ? 1 : 0;
+        step->from_off = f->offset;
+        step->to_off = t->offset;
+        step->len = t->len;
+        prev = (kind == IX_KEY_COPY && !step->flip) ? step : NULL;
+    }
+    return plan;
+}
+
+static struct ix_key_plan *get_ix_key_plan(struct schema *from,
+                                           struct schema *to)
+{
+    struct ix_key_plan *plan, *cur = NULL;
+
+    plan = ATOMIC_LOAD64(to->key_plan);
+    if (plan == NULL) {
+        plan = ix_key_plan_compile(from, to);
+        if (plan == NULL)
+            return NULL;
+        if (!CAS64(to->key_plan, cur, plan)) {
+            free(plan);
+            plan = cur;
+        }
+    }
+    /* the plan is for whichever ondisk schema first used it */
+    return plan->from == from ? plan : NULL;
+}
+
+/* Returns 1 if the record has a null where the key may not, so that the
+ * generic path can run and report it */
+static int ix_key_plan_run(const struct dbtable *tbl,
+                           const struct ix_key_plan *plan,
+                           struct schema *fromsch, struct schema *tosch,
+                           const char *inbuf, char *outbuf,
+                           blob_buffer_t *inblobs, blob_buffer_t *outblobs,
+                           int maxblobs, const char *tzname)
+{
+    int rec_srt_off = gbl_sort_nulls_correctly ? 0 : 1;
+
+    for (int i = 0; i < plan->nnotnull; i++) {
+        if (stype_is_null(inbuf + plan->notnull[i]))
+            return 1;
+    }
+
+    for (int i = 0; i < plan->nsteps; i++) {
+        const struct ix_key_step *step = &plan->steps[i];
+        char *out = outbuf + step->to_off;
+
+        switch (step->kind) {
+        case IX_KEY_BYTES:
+            if (stype_is_null(inbuf + step->from_off)) {
+                set_null(out, step->len);
+                break;
+            }
+            /* fall through */
+        case IX_KEY_COPY:
+            memcpy(out, inbuf + step->from_off, step->len);
+            break;
+        default:
+            if (stag_to_stag_field(tbl, inbuf, outbuf, 0, NULL, inblobs,
+                                   outblobs, maxblobs, tzname, step->from_idx,
+                                   step->field, fromsch, tosch))
+                return -1;
+            continue;
+        }
+        if (step->flip)
+            xorbuf(out + rec_srt_off, step->len - rec_srt_off);
+    }
+    return 0;
+}
+
 /*
  * On success only outblobs will be valid, there is no need to free up inblobs.
  * On failure the caller should free inblobs and outblobs.
@@ -3562,6 +3686,19 @@ static int _stag_to_stag_buf_flags_blobs(const struct dbtable *tbl, struct schem
                                          blob_buffer_t *inblobs, blob_buffer_t *outblobs,
                                          int maxblobs, const char *tzname)
 {
+    /* forming an index key from a record */
+    if (gbl_ix_key_plans && flags == 0 && fail_reason == NULL && fromsch &&
+        tosch && (tosch->flags & SCHEMA_INDEX) &&
+        !(fromsch->flags & SCHEMA_INDEX)) {
+        struct ix_key_plan *plan = get_ix_key_plan(fromsch, tosch);
+        if (plan) {
+            int rc = ix_key_plan_run(tbl, plan, fromsch, tosch, inbuf, outbuf,
+                                     inblobs, outblobs, maxblobs, tzname);
+            if (rc <= 0)
+                return rc;
+        }
+    }
+
     if (fail_reason)
         init_convert_failure_reason(fail_reason);
 
@@ -6134,6 +6271,8 @@ static void freeschema_internals(struct schema *schema)
         freeschema(schema->partial_datacopy, 0);
         schema->partial_datacopy = NULL;
     }
+    free(schema->key_plan);
+    schema->key_plan = NULL;
 }
 
 void freeschema(struct schema *schema, int free_ix)
@@ -74,6 +74,7 @@ struct schema {
     char *sqlitetag;
     int *datacopy;
     char *where;
+    struct ix_key_plan *key_plan; /* for indices, built on first use */
 #if defined STACK_TAG_SCHEMA
     int frames;
     void *buf[MAX_TAG_STACK_FRAMES];
@@ -181,6 +182,33 @@ struct t2t_plan {
     struct t2t_field fields[1];
 };
 
+/* Precompiled conversion of an ondisk record into an index key.  Fields
+ * which carry over byte for byte are copied directly (adjacent ones in a
+ * single copy), everything else goes through the generic per-field path. */
+enum {
+    IX_KEY_COPY,  /* same fixed-width type and length */
+    IX_KEY_BYTES, /* bytearray of the same length; nulls are normalized */
+    IX_KEY_FIELD  /* generic conversion */
+};
+
+struct ix_key_step {
+    int kind;
+    int flip;     /* descending: invert after the copy */
+    int field;    /* index field, for IX_KEY_FIELD */
+    int from_idx; /* ondisk field or -1, for IX_KEY_FIELD */
+    unsigned int from_off;
+    unsigned int to_off;
+    unsigned int len;
+};
+
+struct ix_key_plan {
+    const struct schema *from;
+    int nsteps;
+    int nnotnull;
+    unsigned int *notnull; /* ondisk offsets of copied NOT NULL fields */
+    struct ix_key_step steps[1];
+};
+
 enum {
     /* good rcodes */
     SC_NO_CHANGE = 0,
@@ -220,6 +248,7 @@ extern hash_t *gbl_tag_hash;
 extern char gbl_ondisk_ver[];
 extern const int gbl_ondisk_ver_len;
 extern int gbl_use_t2t;
+extern int gbl_ix_key_plans;
 
 int tag_init(void);
 void add_tag_schema(const char *table, struct schema *);
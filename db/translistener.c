@@ -39,6 +39,7 @@
 #include <unistd.h>
 #include <logmsg.h>
 #include "str0.h"
+#include <crc32c.h>
 
 struct javasp_trans_state {
     /* Which events we are subscribed for. */
@@ -79,6 +80,8 @@ struct stored_proc {
 
     char *qname;
     int flags;
+    int npartitions; /* >1 if the queue is partitioned by partcol */
+    char *partcol;
     LISTC_T(struct sp_table) tables;
     LINKC_T(struct stored_proc) lnk;
 };
@@ -776,6 +779,26 @@ static int append_field(struct byte_buffer *bytes, struct field *f,
     return 0;
 }
 
+/* Rows with the same partition column value always land in the same queue
+ * partition, so per-key ordering is preserved. */
+static int sp_trigger_partition(struct stored_proc *p, struct schema *s,
+                                struct javasp_rec *oldrec,
+                                struct javasp_rec *newrec)
+{
+    struct javasp_rec *rec = newrec ? newrec : oldrec;
+    struct field *f;
+    int ix;
+
+    if (p->npartitions <= 1 || rec == NULL)
+        return 0;
+    ix = find_field_idx_in_tag(s, p->partcol);
+    if (ix < 0)
+        return 0;
+    f = &s->member[ix];
+    return crc32c((uint8_t *)rec->ondisk_dta + f->offset, f->len) %
+           p->npartitions;
+}
+
 /* This is the actual "stored procedure" call. */
 static int sp_trigger_run(struct javasp_trans_state *javasp_trans_handle,
                           struct stored_proc *p, struct sp_table *t, int event,
@@ -867,8 +890,25 @@ static int sp_trigger_run(struct javasp_trans_state *javasp_trans_handle,
     /* post it to queue */
     usedb = javasp_trans_handle->iq->usedb;
     javasp_trans_handle->iq->usedb = getqueuebyname(p->qname);
-    rc = dbq_add(javasp_trans_handle->iq, javasp_trans_handle->trans,
-                 bytes.bytes, bytes.used);
+    if (p->npartitions > 1) {
+        struct dbtable *qdb = javasp_trans_handle->iq->usedb;
+        int bdberr;
+        if (bdb_queuedb_get_partitions(qdb->handle) != p->npartitions &&
+            bdb_queuedb_set_partitions_tran(qdb->handle,
+                                            javasp_trans_handle->trans,
+                                            p->npartitions, &bdberr) != 0) {
+            javasp_trans_handle->iq->usedb = usedb;
+            rc = bdberr == BDBERR_DEADLOCK ? RC_INTERNAL_RETRY : -1;
+            goto done;
+        }
+        rc = dbq_add_partition(javasp_trans_handle->iq,
+                               javasp_trans_handle->trans, bytes.bytes,
+                               bytes.used,
+                               sp_trigger_partition(p, s, oldrec, newrec));
+    } else {
+        rc = dbq_add(javasp_trans_handle->iq, javasp_trans_handle->trans,
+                     bytes.bytes, bytes.used);
+    }
     javasp_trans_handle->iq->usedb = usedb;
 
 done:
@@ -1080,6 +1120,7 @@ int javasp_unload_procedure_int(const char *name)
             free(sp->name);
             free(sp->param);
             free(sp->qname);
+            free(sp->partcol);
 
             t = listc_rtl(&sp->tables);
             while (t) {
@@ -1213,6 +1254,9 @@ int javasp_load_procedure_int(const char *name, const char *param,
         rc = -1;
         goto done;
     }
+    p->qname = NULL;
+    p->npartitions = 0;
+    p->partcol = NULL;
     p->name = strdup(name);
     if (!p->name) {
     oom:
@@ -1412,6 +1456,26 @@ int javasp_load_procedure_int(const char *name, const char *param,
             table->flags |= flags;
             listc_abl(&table->fields, field);
             p->flags |= flags;
+        } else if (strcasecmp(s, "partitions") == 0) {
+            char *n = strtok_r(NULL, toksep, &endp);
+            char *col = strtok_r(NULL, toksep, &endp);
+            if (n == NULL || col == NULL || strtok_r(NULL, toksep, &endp)) {
+                logmsg(LOGMSG_ERROR, "partitions takes a count and a column "
+                                     "(config file %s)\n",
+                       param ? argv[0] : "<from comdb2sc>");
+                rc = -1;
+                goto done;
+            }
+            p->npartitions = atoi(n);
+            if (p->npartitions < 1 ||
+                p->npartitions > BDB_QUEUEDB_MAX_PARTITIONS) {
+                logmsg(LOGMSG_ERROR, "partitions must be between 1 and %d\n",
+                       BDB_QUEUEDB_MAX_PARTITIONS);
+                rc = -1;
+                goto done;
+            }
+            free(p->partcol);
+            p->partcol = strdup(col);
         } else {
             logmsg(LOGMSG_ERROR, "unknown translisten config directive %s (config file %s)\n", s,
                    param ? argv[0] : "<from comdb2sc>");
@@ -1419,6 +1483,11 @@ int javasp_load_procedure_int(const char *name, const char *param,
             goto done;
         }
     }
+    if (p->npartitions > 1) {
+        struct dbtable *qdb = getqueuebyname(p->qname);
+        if (qdb && qdb->handle)
+            bdb_queuedb_set_partitions(qdb->handle, p->npartitions);
+    }
     listc_abl(&stored_procs, p);
 
 done:
@@ -1449,6 +1518,25 @@ void javasp_rec_have_blob(struct javasp_rec *rec, int blobn,
     }
 }
 
+/* The partition count lives in the trigger config, which is loaded before
+ * the queue is opened: hand it to the queue's handle once it is open. */
+void javasp_set_queue_partitions(struct dbtable *qdb)
+{
+    struct stored_proc *sp;
+    if (qdb == NULL || qdb->handle == NULL)
+        return;
+    SP_READLOCK();
+    LISTC_FOR_EACH(&stored_procs, sp, lnk)
+    {
+        if (sp->qname && strcmp(sp->qname, qdb->tablename) == 0) {
+            if (sp->npartitions > 1)
+                bdb_queuedb_set_partitions(qdb->handle, sp->npartitions);
+            break;
+        }
+    }
+    SP_RELLOCK();
+}
+
 int javasp_exists(const char *name)
 {
     struct stored_proc *sp;
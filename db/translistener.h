@@ -190,6 +190,9 @@ int javasp_unload_procedure_int(const char *name);
 /* Check if stored procedure exists. */
 int javasp_exists(const char *name);
 
+/* Set an opened queue's partition count from its trigger config. */
+void javasp_set_queue_partitions(struct dbtable *qdb);
+
 void javasp_splock_wrlock(void);
 void javasp_splock_rdlock(void);
 void javasp_splock_unlock(void);
@@ -303,18 +303,26 @@ int trigger_stat()
             continue;
         }
         const char *type = ctype == CONSUMER_TYPE_LUA ? "trigger" : "consumer";
-        char *spname = SP4Q(qdb->tablename);
-        trigger_info_t *info =
-            trigger_hash ? hash_find(trigger_hash, spname) : NULL;
-        if (info) {
-            logmsg(LOGMSG_USER,
-                   "%s: %8s:%s ASSIGNED to node:%s cookie:%016" PRIx64
-                   " last heartbeat: %.0fs\n",
-                   __func__, type, info->spname, info->host,
-                   info->trigger_cookie, difftime(now, info->hbeat));
-        } else {
-            logmsg(LOGMSG_USER, "%s: %8s:%s UNASSIGNED\n", __func__, type,
-                   spname);
+        int npartitions = bdb_queuedb_get_partitions(qdb->handle);
+        for (int p = 0; p < npartitions; ++p) {
+            char name[MAX_SPNAME + TRIGGER_PARTITION_SUFFIX_LEN];
+            char *spname = SP4Q(qdb->tablename);
+            if (npartitions > 1) {
+                trigger_partition_name(name, sizeof(name), spname, p);
+                spname = name;
+            }
+            trigger_info_t *info =
+                trigger_hash ? hash_find(trigger_hash, spname) : NULL;
+            if (info) {
+                logmsg(LOGMSG_USER,
+                       "%s: %8s:%s ASSIGNED to node:%s cookie:%016" PRIx64
+                       " last heartbeat: %.0fs\n",
+                       __func__, type, info->spname, info->host,
+                       info->trigger_cookie, difftime(now, info->hbeat));
+            } else {
+                logmsg(LOGMSG_USER, "%s: %8s:%s UNASSIGNED\n", __func__,
+                       type, spname);
+            }
         }
         consumer_unlock(qdb);
     }
@@ -337,6 +345,22 @@ static int trigger_registered_int(const char *spname)
     return 0;
 }
 
+void trigger_partition_name(char *buf, size_t len, const char *spname,
+                            int partition)
+{
+    snprintf(buf, len, "%s%c%d", spname, TRIGGER_PARTITION_SEP, partition);
+}
+
+/* t must have room for TRIGGER_PARTITION_SUFFIX_LEN more bytes */
+void trigger_reg_set_partition(trigger_reg_t *t, const char *spname,
+                               int partition)
+{
+    trigger_partition_name(t->spname, strlen(spname) + TRIGGER_PARTITION_SUFFIX_LEN,
+                           spname, partition);
+    t->spname_len = strlen(t->spname);
+    strcpy(trigger_hostname(t), gbl_myhostname);
+}
+
 int trigger_registered(const char *name)
 {
     Pthread_mutex_lock(&trighash_lk);
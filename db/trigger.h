@@ -88,6 +88,15 @@ void trigger_reg_to_cpu(trigger_reg_t *);
 
 #define SP4Q(q) ((q) + (sizeof(Q_TAG) - 1))
 
+/* Consumers of a partitioned queue register as "spname#partition", so the
+ * master hands out each partition to exactly one consumer. */
+#define TRIGGER_PARTITION_SEP '#'
+#define TRIGGER_PARTITION_SUFFIX_LEN 5 /* "#255" + NUL */
+void trigger_partition_name(char *buf, size_t len, const char *spname,
+                            int partition);
+void trigger_reg_set_partition(trigger_reg_t *, const char *spname,
+                               int partition);
+
 struct lua_State;
 void force_unregister(struct lua_State *, trigger_reg_t *);
 
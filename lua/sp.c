@@ -168,6 +168,10 @@ struct dbconsumer_t {
     const uint8_t *status;
     struct __db_trigger_subscription *hndl;
 
+    /* partitioned queues: partition claimed from master, -1 until claimed */
+    int npartitions;
+    int partition;
+
     trigger_reg_t info; // must be last in struct
 };
 
@@ -200,7 +204,8 @@ static struct timespec setup_dbq_ts(int delay_ms)
 
 #define getdb(x) (x)->thd->sqldb
 #define dbconsumer_sz(spname)                                                  \
-    (sizeof(dbconsumer_t) - sizeof(trigger_reg_t) + trigger_reg_sz(spname))
+    (sizeof(dbconsumer_t) - sizeof(trigger_reg_t) + trigger_reg_sz(spname) +  \
+     TRIGGER_PARTITION_SUFFIX_LEN)
 
 static int db_exec(Lua);
 static int dbstmt_emit(Lua);
@@ -396,9 +401,35 @@ static int check_retry_conditions(Lua L, trigger_reg_t *reg, int skip_incoherent
 
 static pthread_mutex_t consumer_sqlthds_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static int luabb_trigger_register(Lua L, trigger_reg_t *reg, int register_timeoutms)
+/* Try each partition in turn and keep the first one master hands us. */
+static int trigger_register_partition(SP sp, dbconsumer_t *q)
+{
+    int rc = CDB2_TRIG_ASSIGNED_OTHER;
+    for (int i = 0; i < q->npartitions; ++i) {
+        trigger_reg_set_partition(&q->info, sp->spname, i);
+        rc = trigger_register_req(&q->info);
+        if (rc == CDB2_TRIG_REQ_SUCCESS) {
+            q->partition = i;
+            break;
+        }
+        if (rc != CDB2_TRIG_ASSIGNED_OTHER)
+            break;
+    }
+    return rc;
+}
+
+static int trigger_register_consumer(SP sp, dbconsumer_t *q)
+{
+    if (q->partition < 0)
+        return trigger_register_partition(sp, q);
+    return trigger_register_req(&q->info);
+}
+
+static int luabb_trigger_register(Lua L, dbconsumer_t *q)
 {
     int rc;
+    trigger_reg_t *reg = &q->info;
+    int register_timeoutms = q->register_timeoutms;
     SP sp = getsp(L);
     sp->num_instructions = 0;
     int retry = round(register_timeoutms / 1000.0);
@@ -411,7 +442,7 @@ static int luabb_trigger_register(Lua L, trigger_reg_t *reg, int register_timeou
     thdpool_add_waitthd(pool);
     Pthread_mutex_unlock(&consumer_sqlthds_mutex);
 
-    while ((rc = trigger_register_req(reg)) != CDB2_TRIG_REQ_SUCCESS) {
+    while ((rc = trigger_register_consumer(sp, q)) != CDB2_TRIG_REQ_SUCCESS) {
         /* trigger_register_req() can take up to 1 second. Tick up immediately
            after this so that it's guaranteed that the appsock thread observes
            a good query state for the next heartbeat. */
@@ -472,8 +503,7 @@ static int stop_waiting(Lua L, dbconsumer_t *q)
     if (sp->pingpong == 2) {
         return 0;
     }
-    if (luabb_trigger_register(L, &q->info, q->register_timeoutms) !=
-        CDB2_TRIG_REQ_SUCCESS)
+    if (luabb_trigger_register(L, q) != CDB2_TRIG_REQ_SUCCESS)
         return 1;
     q->registration_time = time(NULL);
     return 0;
@@ -671,7 +701,8 @@ static int dbq_poll_int(Lua L, dbconsumer_t *q)
     SP sp = getsp(L);
     struct sqlclntstate *clnt = sp->clnt;
     struct qfound f = {0};
-    int rc = dbq_get(&q->iq, 0, &q->last, &f.item, NULL, NULL, &q->fnd, &f.seq,
+    int consumer = bdb_queuedb_partition_consumer(0, q->partition);
+    int rc = dbq_get(&q->iq, consumer, &q->last, &f.item, NULL, NULL, &q->fnd, &f.seq,
                      bdb_get_lid_from_cursortran(clnt->dbtran.cursor_tran));
     Pthread_mutex_unlock(q->lock);
     if (debug_switch_test_trigger_deadlock()) {
@@ -893,7 +924,7 @@ static int dbconsumer_consume(Lua L)
                        __func__, clnt->intrans, err, rc);
         }
     }
-    if ((rc = osql_dbq_consume_logic(clnt, q->info.spname, q->genid)) != 0) {
+    if ((rc = osql_dbq_consume_logic(clnt, sp->spname, q->genid)) != 0) {
         if (implicit_txn) {
             err = db_rollback_int(L, &rc);
             if (err || rc || clnt->intrans) {
@@ -939,7 +970,7 @@ static int dbconsumer_next(Lua L)
             luaL_error(L, "%s osql_sock_start rc:%d", __func__, rc);
         }
     }
-    Q4SP(qname, q->info.spname);
+    Q4SP(qname, sp->spname);
     ++clnt->osql_max_trans;
     rc = osql_delrec_qdb(clnt, qname, q->genid);
     if (rc) {
@@ -4699,6 +4730,19 @@ void force_unregister(Lua L, trigger_reg_t *reg)
     luabb_trigger_unregister(L, q);
 }
 
+static int queue_partitions(Lua L)
+{
+    if (tryrdlock_schema_lk() != 0) {
+        return luaL_error(L, sqlite3ErrStr(SQLITE_SCHEMA));
+    }
+    SP sp = getsp(L);
+    Q4SP(qname, sp->spname);
+    struct dbtable *db = getqueuebyname(qname);
+    int npartitions = db ? bdb_queuedb_get_partitions(db->handle) : 1;
+    unlock_schema_lk();
+    return npartitions;
+}
+
 static int register_queue_with_berkdb_and_master(Lua L, const char *type)
 {
     SP sp = getsp(L);
@@ -4736,13 +4780,15 @@ static int register_queue_with_berkdb_and_master(Lua L, const char *type)
     memcpy(info->spname, sp->spname, info->spname_len + 1);
     int hostname_len = strlen(gbl_myhostname);
     memcpy(trigger_hostname(info), gbl_myhostname, hostname_len + 1);
+    consumer->npartitions = queue_partitions(L);
+    consumer->partition = consumer->npartitions > 1 ? -1 : 0;
     if (strcmp(type, "consumer") == 0) {
         ctrace("%s:%s %016" PRIx64 " register req from host:%s argv0:%s pid:%d\n",
             type, info->spname, info->trigger_cookie, clnt->origin, clnt->argv0, clnt->conninfo.pid);
     } else {
         ctrace("%s:%s %016" PRIx64 " register req\n", type, info->spname, info->trigger_cookie);
     }
-    int rc = luabb_trigger_register(L, info, consumer->register_timeoutms);
+    int rc = luabb_trigger_register(L, consumer);
     if (rc != CDB2_TRIG_REQ_SUCCESS) {
         ctrace("%s:%s %016" PRIx64 " register failed rc:%d\n", type, info->spname, info->trigger_cookie, rc);
         force_unregister(L, info);
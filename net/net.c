@@ -322,6 +322,30 @@ net_ack_message_payload_type_get(net_ack_message_payload_type *payload_type_ptr,
     return p_buf;
 }
 
+const uint8_t *net_lz4_header_get(net_lz4_header *hdr, const uint8_t *p_buf,
+                                  const uint8_t *p_buf_end)
+{
+    if (p_buf_end < p_buf || NET_LZ4_HEADER_LEN > (p_buf_end - p_buf))
+        return NULL;
+
+    p_buf = buf_get(&(hdr->rawlen), sizeof(hdr->rawlen), p_buf, p_buf_end);
+    p_buf = buf_get(&(hdr->complen), sizeof(hdr->complen), p_buf, p_buf_end);
+
+    return p_buf;
+}
+
+uint8_t *net_lz4_header_put(const net_lz4_header *hdr, uint8_t *p_buf,
+                            const uint8_t *p_buf_end)
+{
+    if (p_buf_end < p_buf || NET_LZ4_HEADER_LEN > (p_buf_end - p_buf))
+        return NULL;
+
+    p_buf = buf_put(&(hdr->rawlen), sizeof(hdr->rawlen), p_buf, p_buf_end);
+    p_buf = buf_put(&(hdr->complen), sizeof(hdr->complen), p_buf, p_buf_end);
+
+    return p_buf;
+}
+
 static const uint8_t *
 net_ack_message_type_put(const net_ack_message_type *p_net_ack_message_type,
                          uint8_t *p_buf, const uint8_t *p_buf_end)
@@ -659,6 +683,8 @@ static int write_hello_int(netinfo_type *netinfo_ptr, host_node_type *host_node_
     uint8_t *p_buf, *p_buf_end;
     host_node_type *tmp_host_ptr;
     int datasz;
+    int caps_magic = NET_HELLO_CAPS_MAGIC;
+    int caps = NET_CAP_LZ4;
 
     Pthread_rwlock_rdlock(&(netinfo_ptr->lock));
 
@@ -670,7 +696,8 @@ static int write_hello_int(netinfo_type *netinfo_ptr, host_node_type *host_node_
     datasz = sizeof(int) + sizeof(int) + /* int numhosts */
              (HOSTNAME_LEN * numhosts) + /* char host[16]... ( 1 per host ) */
              (sizeof(int) * numhosts)  + /* int port...      ( 1 per host ) */
-             (sizeof(int) * numhosts);   /* int node...      ( 1 per host ) */
+             (sizeof(int) * numhosts)  + /* int node...      ( 1 per host ) */
+             sizeof(int) + sizeof(int);  /* int magic, int caps */
 
     /* write long hostnames */
     for (tmp_host_ptr = netinfo_ptr->head; tmp_host_ptr != NULL;
@@ -726,6 +753,9 @@ static int write_hello_int(netinfo_type *netinfo_ptr, host_node_type *host_node_
                                p_buf, p_buf_end);
         }
     }
+    /* what we can decode */
+    p_buf = buf_put(&caps_magic, sizeof(int), p_buf, p_buf_end);
+    p_buf = buf_put(&caps, sizeof(int), p_buf, p_buf_end);
 
     Pthread_rwlock_unlock(&(netinfo_ptr->lock));
 
@@ -3169,6 +3199,32 @@ int net_get_host_network_usage(netinfo_type *netinfo_ptr, const char *host,
     return 0;
 }
 
+int net_get_host_compress_usage(netinfo_type *netinfo_ptr, const char *host,
+                                unsigned long long *raw_bytes,
+                                unsigned long long *compressed_bytes,
+                                unsigned long long *compress_usec,
+                                unsigned long long *decompress_usec)
+{
+    host_node_type *ptr;
+
+    Pthread_rwlock_rdlock(&(netinfo_ptr->lock));
+    for (ptr = netinfo_ptr->head; ptr != NULL; ptr = ptr->next) {
+        if (ptr->host == host)
+            break;
+    }
+    Pthread_rwlock_unlock(&(netinfo_ptr->lock));
+
+    if (ptr == NULL)
+        return -1;
+
+    *raw_bytes = ptr->stats.compress_raw_bytes;
+    *compressed_bytes = ptr->stats.compress_bytes;
+    *compress_usec = ptr->stats.compress_usec;
+    *decompress_usec = ptr->stats.decompress_usec;
+
+    return 0;
+}
+
 int net_get_network_usage(netinfo_type *netinfo_ptr,
                           unsigned long long *written, unsigned long long *read,
                           unsigned long long *throttle_waits,
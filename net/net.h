@@ -97,7 +97,9 @@ enum {
     NET_SEND_NODROP = 0x00000002,
     NET_SEND_INORDER = 0x00000004,
     NET_SEND_TRACE = 0x00000008,
-    NET_SEND_LOGPUT = 0x00000010
+    NET_SEND_LOGPUT = 0x00000010,
+    /* net_send_all: data came from net_shared_msg_new */
+    NET_SEND_SHARED = 0x00000020
 };
 
 enum {
@@ -340,6 +342,14 @@ int net_get_host_network_usage(netinfo_type *netinfo_ptr, const char *host,
                                unsigned long long *throttle_waits,
                                unsigned long long *reorders);
 
+/* Bytes sent through lz4 compression to host, what they compressed to,
+ * and the time spent compressing and decompressing */
+int net_get_host_compress_usage(netinfo_type *netinfo_ptr, const char *host,
+                                unsigned long long *raw_bytes,
+                                unsigned long long *compressed_bytes,
+                                unsigned long long *compress_usec,
+                                unsigned long long *decompress_usec);
+
 int net_get_network_usage(netinfo_type *netinfo_ptr,
                           unsigned long long *written, unsigned long long *read,
                           unsigned long long *throttle_waits,
@@ -398,6 +408,15 @@ int64_t net_get_num_accept_timeouts(netinfo_type *netinfo_ptr);
 void net_set_conntime_dump_period(netinfo_type *netinfo_ptr, int value);
 int net_get_conntime_dump_period(netinfo_type *netinfo_ptr);
 int net_send_all(netinfo_type *, int, void **, int *, int *, int *);
+
+/* Broadcast payloads larger than this are queued to every peer by
+ * reference to one refcounted copy rather than copied per peer */
+#define NET_SHARED_MSG_MIN_BYTES 1024
+/* Returns a buffer of len bytes to serialize a broadcast message into.
+ * Pass it to net_send_all with NET_SEND_SHARED, then release it with
+ * net_shared_msg_put; peers drop their references once it is written. */
+void *net_shared_msg_new(int usertype, int len);
+void net_shared_msg_put(void *data);
 void update_host_net_queue_stats(host_node_type *, size_t, size_t);
 int db_is_stopped(void);
 int db_is_exiting(void);
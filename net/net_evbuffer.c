@@ -48,9 +48,11 @@
 #include <comdb2buf.h>
 #include <compat.h>
 #include <connectmsg.pb-c.h>
+#include <epochlib.h>
 #include <hostname_support.h>
 #include <intern_strings.h>
 #include <logmsg.h>
+#include <lz4.h>
 #include <sys_wrap.h>
 #ifdef PER_THREAD_MALLOC
   #include <mem_net.h>
@@ -85,6 +87,13 @@
 
 #define MAX_DISTRESS_COUNT 3
 
+/* lz4 stream history kept by both ends of a connection */
+#define NET_LZ4_DICT_SZ KB(64)
+/* larger batches go out uncompressed */
+#define NET_LZ4_MAX_BLOCK MB(32)
+/* after a batch which barely compressed, send this many uncompressed */
+#define NET_LZ4_BACKOFF 64
+
 #define hprintf_lvl LOGMSG_USER
 #define hprintf_format(a) "[%.3s %-8s fd:%-4d %3s %24s] " a, e->service, e->host, e->fd, e->ssl_data ? "TLS" : "", __func__
 #define distress_logmsg(...)                                                   \
@@ -111,6 +120,9 @@
 int gbl_accept_headroom = 100;
 int gbl_pb_connectmsg = 1;
 int gbl_libevent_rte_only = 0;
+int gbl_net_compress = 0;
+int gbl_net_compress_min_bytes = 4096;
+int gbl_net_compress_min_rtt_us = 1000;
 
 extern char gbl_dbname[MAX_DBNAME_LENGTH];
 extern char *gbl_myhostname;
@@ -387,6 +399,11 @@ struct event_info {
     wire_header_type hdr;
     net_send_message_header msg;
     net_ack_message_payload_type ack;
+    net_lz4_header lz4_hdr;
+    uint8_t *unz_buf;
+    int unz_sz;
+    uint8_t *unz_dict; /* history of the lz4 stream we receive */
+    int unz_dictlen;
 
     /* write */
     ssize_t (*writev)(struct event_info *);
@@ -395,6 +412,13 @@ struct event_info {
     struct evbuffer *wr_buf;
     struct event *wr_ev;
     time_t wr_full;
+    int peer_caps; /* NET_CAP_* from the peer's hello */
+    LZ4_stream_t *lz4;
+    char *lz4_dict; /* history of the lz4 stream we send */
+    struct evbuffer *lz4_raw; /* batch being compressed */
+    int lz4_backoff;
+    int rtt_us;
+    time_t rtt_at;
 };
 
 #define EVENT_HASH_KEY_SZ 128
@@ -987,6 +1011,18 @@ static void do_disable_write(struct event_info *e)
         evbuffer_free(e->wr_buf);
         e->wr_buf = NULL;
     }
+    if (e->lz4_raw) {
+        evbuffer_free(e->lz4_raw);
+        e->lz4_raw = NULL;
+    }
+    if (e->lz4) {
+        LZ4_freeStream(e->lz4);
+        e->lz4 = NULL;
+    }
+    free(e->lz4_dict);
+    e->lz4_dict = NULL;
+    e->lz4_backoff = 0;
+    e->peer_caps = 0;
     e->got_hello = 0;
     e->got_hello_reply = 0;
 }
@@ -1156,17 +1192,114 @@ static ssize_t writev_plaintext(struct event_info *e)
     return evbuffer_write(e->wr_buf, e->fd);
 }
 
+static int link_rtt_us(struct event_info *e)
+{
+#ifdef TCP_INFO
+    time_t now = time(NULL);
+    if (e->rtt_at != now) {
+        struct tcp_info ti;
+        socklen_t len = sizeof(ti);
+        e->rtt_at = now;
+        if (getsockopt(e->fd, IPPROTO_TCP, TCP_INFO, &ti, &len) == 0) {
+            e->rtt_us = ti.tcpi_rtt;
+        }
+    }
+    return e->rtt_us;
+#else
+    return INT_MAX;
+#endif
+}
+
+/* Whether the batch in flush_buf is worth compressing: the peer must
+ * decode lz4, the batch must be big enough to gain from it and the link
+ * slow enough for the bytes saved to matter more than the cpu spent. */
+static int want_compress(struct event_info *e)
+{
+    size_t len = evbuffer_get_length(e->flush_buf);
+    if (!gbl_net_compress || !(e->peer_caps & NET_CAP_LZ4)) return 0;
+    if (len < gbl_net_compress_min_bytes || len > NET_LZ4_MAX_BLOCK) return 0;
+    if (e->lz4_backoff > 0) {
+        --e->lz4_backoff;
+        return 0;
+    }
+    return link_rtt_us(e) >= gbl_net_compress_min_rtt_us;
+}
+
+/* Move the queued batch towards the socket; returns 1 if it was set aside
+ * in lz4_raw for compress_batch() instead */
+static int take_flush_buf(struct event_info *e)
+{
+    if (want_compress(e)) {
+        evbuffer_add_buffer(e->lz4_raw, e->flush_buf);
+        return 1;
+    }
+    evbuffer_add_buffer(e->wr_buf, e->flush_buf);
+    return 0;
+}
+
+/* Compress lz4_raw as the next block of this connection's lz4 stream */
+static void compress_batch(struct event_info *e)
+{
+    int rawlen = evbuffer_get_length(e->lz4_raw);
+    int bound = LZ4_compressBound(rawlen);
+    int hdrlen = e->wirehdr_len + NET_LZ4_HEADER_LEN;
+    int64_t start = comdb2_time_epochus();
+    struct iovec v[1];
+    uint8_t *src;
+    if (!e->lz4) {
+        e->lz4 = LZ4_createStream();
+        e->lz4_dict = malloc(NET_LZ4_DICT_SZ);
+        if (!e->lz4 || !e->lz4_dict) {
+            if (e->lz4) LZ4_freeStream(e->lz4);
+            free(e->lz4_dict);
+            e->lz4 = NULL;
+            e->lz4_dict = NULL;
+            goto raw;
+        }
+    }
+    if ((src = evbuffer_pullup(e->lz4_raw, -1)) == NULL) goto raw;
+    if (evbuffer_reserve_space(e->wr_buf, hdrlen + bound, v, 1) != 1) goto raw;
+    uint8_t *b = v[0].iov_base;
+    int complen = LZ4_compress_fast_continue(e->lz4, (char *)src, (char *)b + hdrlen, rawlen, bound, 1);
+    if (complen <= 0) {
+        /* a fresh stream never refers back, so the peer needs no reset */
+        hprintf("LZ4 COMPRESS FAILED rc:%d len:%d\n", complen, rawlen);
+        LZ4_resetStream(e->lz4);
+        goto raw;
+    }
+    /* the stream must not point into lz4_raw once it is drained */
+    LZ4_saveDict(e->lz4, e->lz4_dict, NET_LZ4_DICT_SZ);
+    net_lz4_header hdr = {.rawlen = rawlen, .complen = complen};
+    memcpy(b, e->wirehdr[WIRE_HEADER_LZ4], e->wirehdr_len);
+    net_lz4_header_put(&hdr, b + e->wirehdr_len, b + hdrlen);
+    v[0].iov_len = hdrlen + complen;
+    evbuffer_commit_space(e->wr_buf, v, 1);
+    evbuffer_drain(e->lz4_raw, rawlen);
+    if (complen > rawlen - rawlen / 8) {
+        e->lz4_backoff = NET_LZ4_BACKOFF;
+    }
+    if (e->host_node_ptr) {
+        e->host_node_ptr->stats.compress_raw_bytes += rawlen;
+        e->host_node_ptr->stats.compress_bytes += complen;
+        e->host_node_ptr->stats.compress_usec += comdb2_time_epochus() - start;
+    }
+    return;
+raw:
+    evbuffer_add_buffer(e->wr_buf, e->lz4_raw);
+}
+
 static void writecb(int fd, short what, void *data)
 {
     struct event_info *e = data;
     Pthread_mutex_lock(&e->wr_lk);
     if (fd != e->fd || !e->flush_buf || !e->wr_buf) abort(); /* sanity check */
-    evbuffer_add_buffer(e->wr_buf, e->flush_buf);
+    int compress = take_flush_buf(e);
     if (e->host_node_ptr) {
         e->host_node_ptr->enque_count = 0;
         e->host_node_ptr->enque_bytes = 0;
     }
     Pthread_mutex_unlock(&e->wr_lk);
+    if (compress) compress_batch(e);
     size_t len = evbuffer_get_length(e->wr_buf);
     while (len) {
         int rc = e->writev(e); // -> writev_plaintext
@@ -1182,9 +1315,9 @@ static void writecb(int fd, short what, void *data)
         }
         e->sent_at = time(NULL);
         Pthread_mutex_lock(&e->wr_lk);
-        evbuffer_add_buffer(e->wr_buf, e->flush_buf);
+        compress = take_flush_buf(e);
         len = evbuffer_get_length(e->wr_buf);
-        if (len == 0) {
+        if (len == 0 && !compress) {
             event_del(e->wr_ev);
             if (e->wr_full) {
                 //hprintf("RESUMING WR after:%ds\n", (int)(time(NULL) - e->wr_full));
@@ -1192,6 +1325,10 @@ static void writecb(int fd, short what, void *data)
             }
         }
         Pthread_mutex_unlock(&e->wr_lk);
+        if (compress) {
+            compress_batch(e);
+            len = evbuffer_get_length(e->wr_buf);
+        }
     }
 }
 
@@ -1479,6 +1616,12 @@ static int hello_msg_common(struct event_info *e)
         struct add_host_info info = {.e = e, .ihost = ihost, .port = ports[i]};
         run_on_base(base, add_host_from_hello_msg, &info);
     }
+    /* optional trailer with what the peer can decode */
+    uint32_t caps[2] = {0};
+    if (e->rd_buf + e->need - buf >= (ptrdiff_t)sizeof(caps)) {
+        memcpy(caps, buf, sizeof(caps));
+    }
+    e->peer_caps = ntohl(caps[0]) == NET_HELLO_CAPS_MAGIC ? ntohl(caps[1]) : 0;
     set_hello_message(e);
     rc = 0;
 out:free(ports);
@@ -1624,6 +1767,100 @@ static int process_decom_hostname(struct event_info *e)
     return 0;
 }
 
+/* Keep the last NET_LZ4_DICT_SZ bytes decompressed, as the sender's lz4
+ * stream may refer back to them in its next block */
+static void save_unz_dict(struct event_info *e, int len)
+{
+    if (len >= NET_LZ4_DICT_SZ) {
+        memcpy(e->unz_dict, e->unz_buf + len - NET_LZ4_DICT_SZ, NET_LZ4_DICT_SZ);
+        e->unz_dictlen = NET_LZ4_DICT_SZ;
+        return;
+    }
+    int keep = e->unz_dictlen;
+    if (keep + len > NET_LZ4_DICT_SZ) {
+        keep = NET_LZ4_DICT_SZ - len;
+    }
+    memmove(e->unz_dict, e->unz_dict + e->unz_dictlen - keep, keep);
+    memcpy(e->unz_dict + keep, e->unz_buf, len);
+    e->unz_dictlen = keep + len;
+}
+
+static int process_hdr(struct event_info *);
+static int process_payload(struct event_info *);
+
+/* Process the whole messages a decompressed block is made of */
+static int process_lz4_block(struct event_info *e, uint8_t *buf, int len)
+{
+    uint8_t *end = buf + len;
+    while (buf < end) {
+        const int need = e->need;
+        if (end - buf < need) break;
+        e->rd_buf = buf;
+        int rc;
+        if (e->hdr.type == 0) {
+            rc = process_hdr(e);
+            if (rc == 0 && e->hdr.type == WIRE_HEADER_LZ4) {
+                hputs("NESTED LZ4 BLOCK\n");
+                rc = -1;
+            }
+        } else {
+            rc = process_payload(e);
+        }
+        if (rc) return rc;
+        buf += need;
+    }
+    if (buf != end || e->hdr.type != 0) {
+        hprintf("PARTIAL MSG IN LZ4 BLOCK len:%d\n", len);
+        return -1;
+    }
+    return 0;
+}
+
+static int process_lz4_msg(struct event_info *e)
+{
+    net_lz4_header *hdr = &e->lz4_hdr;
+    if (e->state == 0) {
+        ++e->state;
+        net_lz4_header_get(hdr, e->rd_buf, e->rd_buf + NET_LZ4_HEADER_LEN);
+        if (hdr->rawlen <= 0 || hdr->rawlen > NET_LZ4_MAX_BLOCK || hdr->complen <= 0 ||
+            hdr->complen > LZ4_compressBound(hdr->rawlen)) {
+            hprintf("BAD LZ4 BLOCK rawlen:%d complen:%d\n", hdr->rawlen, hdr->complen);
+            return -1;
+        }
+        e->need = hdr->complen;
+        return 0;
+    }
+    int64_t start = comdb2_time_epochus();
+    if (e->unz_sz < hdr->rawlen) {
+        free(e->unz_buf);
+        e->unz_sz = hdr->rawlen;
+        e->unz_buf = malloc(e->unz_sz);
+    }
+    if (!e->unz_dict) {
+        e->unz_dict = malloc(NET_LZ4_DICT_SZ);
+    }
+    if (!e->unz_buf || !e->unz_dict) {
+        hprintf("FAILED TO ALLOCATE LZ4 BUFFERS rawlen:%d\n", hdr->rawlen);
+        free(e->unz_buf);
+        e->unz_buf = NULL;
+        e->unz_sz = 0;
+        return -1;
+    }
+    int n = LZ4_decompress_safe_usingDict((char *)e->rd_buf, (char *)e->unz_buf, hdr->complen, hdr->rawlen,
+                                          (char *)e->unz_dict, e->unz_dictlen);
+    if (n != hdr->rawlen) {
+        hprintf("LZ4 DECOMPRESS FAILED rc:%d rawlen:%d complen:%d\n", n, hdr->rawlen, hdr->complen);
+        return -1;
+    }
+    /* before the handlers get to (and may scribble on) the messages */
+    save_unz_dict(e, n);
+    if (e->host_node_ptr) {
+        e->host_node_ptr->stats.decompress_usec += comdb2_time_epochus() - start;
+    }
+    message_done(e);
+    return process_lz4_block(e, e->unz_buf, n);
+}
+
 static int process_hdr(struct event_info *e)
 {
     net_wire_header_get(&e->hdr, e->rd_buf, e->rd_buf + sizeof(wire_header_type));
@@ -1637,6 +1874,7 @@ static int process_hdr(struct event_info *e)
     case WIRE_HEADER_HELLO_REPLY: e->need = sizeof(uint32_t); return 0;
     case WIRE_HEADER_DECOM_NAME: e->need = sizeof(uint32_t); return 0;
     case WIRE_HEADER_ACK_PAYLOAD: e->need = NET_ACK_MESSAGE_PAYLOAD_TYPE_LEN; return 0;
+    case WIRE_HEADER_LZ4: e->need = NET_LZ4_HEADER_LEN; return 0;
     default: hprintf("UNKNOWN HDR:%d\n", e->hdr.type); return -1;
     }
 }
@@ -1651,6 +1889,7 @@ static int process_payload(struct event_info *e)
     case WIRE_HEADER_HELLO_REPLY: return process_hello_reply(e);
     case WIRE_HEADER_DECOM_NAME: return process_decom_hostname(e);
     case WIRE_HEADER_ACK_PAYLOAD: return process_ack_with_payload(e);
+    case WIRE_HEADER_LZ4: return process_lz4_msg(e);
     default: hprintf("UNKNOWN HDR:%d\n", e->hdr.type); return -1;
     }
 }
@@ -1713,6 +1952,7 @@ static void *rd_worker(void *data)
             buf = evbuffer_new();
             gen = e->readv_gen;
             e->rd_worker_sz = 0;
+            e->unz_dictlen = 0;
             message_done(e);
         }
         evbuffer_add_buffer(buf, e->readv_buf);
@@ -2068,6 +2308,7 @@ static void enable_write(int dummyfd, short what, void *data)
     e->wr_ev = event_new(wr_base, e->fd, EV_WRITE | EV_PERSIST, writecb, e);
     e->flush_buf = evbuffer_new();
     e->wr_buf = evbuffer_new();
+    e->lz4_raw = evbuffer_new();
     e->wr_full = 0;
     e->decomissioned = 0;
     if (i->ssl_data) {
@@ -3594,7 +3835,7 @@ struct shared_msg {
     uint8_t buf[0];
 };
 
-static struct shared_msg *shared_msg_new(void *buf, int len, int type)
+static struct shared_msg *shared_msg_alloc(int len, int type)
 {
     struct shared_msg *msg = malloc(sizeof(struct shared_msg) + len);
     if (msg == NULL) {
@@ -3608,10 +3849,23 @@ static struct shared_msg *shared_msg_new(void *buf, int len, int type)
     };
     net_send_message_header *hdr = &msg->hdr;
     net_send_message_header_put(&tmp, (uint8_t *)hdr, (uint8_t *)(hdr + 1));
-    memcpy(&msg->buf, buf, len);
     return msg;
 }
 
+static struct shared_msg *shared_msg_new(void *buf, int len, int type)
+{
+    struct shared_msg *msg = shared_msg_alloc(len, type);
+    if (msg) {
+        memcpy(&msg->buf, buf, len);
+    }
+    return msg;
+}
+
+static struct shared_msg *shared_msg_from_data(void *data)
+{
+    return (struct shared_msg *)((uint8_t *)data - offsetof(struct shared_msg, buf));
+}
+
 static void shared_msg_free(const void *unused0, size_t unused1, void *ptr)
 {
     struct shared_msg *msg = ptr;
@@ -3627,43 +3881,41 @@ static void shared_msg_addref(struct shared_msg *msg)
     ATOMIC_ADD32(msg->ref, 1);
 }
 
-static int addref_evbuffer(struct evbuffer *buf, struct event_info *e, int n, struct shared_msg **msg)
+void *net_shared_msg_new(int usertype, int len)
 {
-    int rc = 0;
-    for (int i = 0; i < n; ++i) {
-        rc = evbuffer_add(buf, e->wirehdr[WIRE_HEADER_USER_MSG], e->wirehdr_len);
-        if (rc) break;
-        rc = evbuffer_add_reference(buf, &msg[i]->hdr, msg[i]->sz, shared_msg_free, msg[i]);
-        if (rc) break;
-        shared_msg_addref(msg[i]);
-    }
-    return rc;
+    struct shared_msg *msg = shared_msg_alloc(len, usertype);
+    return msg ? msg->buf : NULL;
 }
 
-static int memcpy_evbuffer(struct evbuffer *flush_buf, struct event_info *e, int sz, int n, void **buf, int *len, int *type)
+void net_shared_msg_put(void *data)
 {
-    sz += (n * e->wirehdr_len);
-    struct iovec v[1];
-    const int nv = evbuffer_reserve_space(flush_buf, sz, v, 1);
-    if (nv != 1) {
-        return -1;
-    }
-    uint8_t *b = v[0].iov_base;
-    v[0].iov_len = sz;
-    net_send_message_header hdr = {0};
-    for (int i = 0; i < n; ++i) {
-        memcpy(b, e->wirehdr[WIRE_HEADER_USER_MSG], e->wirehdr_len);
-        b += e->wirehdr_len;
+    shared_msg_free(0, 0, shared_msg_from_data(data));
+}
 
+/* Queue the batch to one peer: shared messages by reference behind a copy
+ * of the peer's wire header, the rest copied in with their headers */
+static int add_msgs_evbuffer(struct evbuffer *flush_buf, struct event_info *e, int n, struct shared_msg **msg,
+                             void **buf, int *len, int *type)
+{
+    int rc = 0;
+    net_send_message_header hdr = {0};
+    uint8_t hdrbuf[NET_SEND_MESSAGE_HEADER_LEN];
+    for (int i = 0; i < n && rc == 0; ++i) {
+        rc = evbuffer_add(flush_buf, e->wirehdr[WIRE_HEADER_USER_MSG], e->wirehdr_len);
+        if (rc) break;
+        if (msg[i]) {
+            shared_msg_addref(msg[i]);
+            rc = evbuffer_add_reference(flush_buf, &msg[i]->hdr, msg[i]->sz, shared_msg_free, msg[i]);
+            if (rc) shared_msg_free(0, 0, msg[i]);
+            continue;
+        }
         hdr.usertype = type[i];
         hdr.datalen = len[i];
-        b = net_send_message_header_put(&hdr, b, b + sizeof(net_send_message_header));
-
-        memcpy(b, buf[i], len[i]);
-        b += len[i];
+        net_send_message_header_put(&hdr, hdrbuf, hdrbuf + sizeof(hdrbuf));
+        rc = evbuffer_add(flush_buf, hdrbuf, sizeof(hdrbuf));
+        if (rc == 0) rc = evbuffer_add(flush_buf, buf[i], len[i]);
     }
-    evbuffer_commit_space(flush_buf, v, 1);
-    return 0;
+    return rc;
 }
 
 /* All you base are belong to me.. */
@@ -3988,24 +4240,30 @@ int net_send_all_evbuffer(netinfo_type *netinfo_ptr, int n, void **buf, int *len
     int nodelay = 0;
     int logput = 0;
     int sz = (n * NET_SEND_MESSAGE_HEADER_LEN);
+    struct shared_msg **msg = alloca(sizeof(struct shared_msg *) * n);
     for (int i = 0; i < n; ++i) {
         sz += len[i];
         nodrop |= flags[i] & NET_SEND_NODROP;
         nodelay |= flags[i] & NET_SEND_NODELAY;
         logput |= flags[i] & NET_SEND_LOGPUT;
+        msg[i] = NULL;
     }
-    struct shared_msg **msg = NULL;
-    if (sz > KB(1)) {
-        msg = alloca(sizeof(struct shared_msg *) * n);
-        int i;
-        for (i = 0; i < n; ++i) {
-            if ((msg[i] = shared_msg_new(buf[i], len[i], type[i])) == NULL) break;
-        }
-        if (i < n) {
-            for (int j = 0; j < i; ++j) {
-                shared_msg_free(0, 0, msg[j]);
+    /* Large messages are shared by reference; ones the caller serialized
+     * into a shared buffer already are used as they are */
+    int copysz = 0;
+    for (int i = 0; i < n; ++i) {
+        if (flags[i] & NET_SEND_SHARED) {
+            msg[i] = shared_msg_from_data(buf[i]);
+            shared_msg_addref(msg[i]);
+        } else if (len[i] > NET_SHARED_MSG_MIN_BYTES) {
+            if ((msg[i] = shared_msg_new(buf[i], len[i], type[i])) == NULL) {
+                for (int j = 0; j < i; ++j) {
+                    if (msg[j]) shared_msg_free(0, 0, msg[j]);
+                }
+                return NET_SEND_FAIL_MALLOC_FAIL;
             }
-            return NET_SEND_FAIL_MALLOC_FAIL;
+        } else {
+            copysz += NET_SEND_MESSAGE_HEADER_LEN + len[i];
         }
     }
     struct net_info *ni = netinfo_ptr->net_info;
@@ -4016,10 +4274,8 @@ int net_send_all_evbuffer(netinfo_type *netinfo_ptr, int n, void **buf, int *len
         }
         Pthread_mutex_lock(&e->wr_lk);
         if (e->flush_buf && !skip_send(e, nodrop, 1)) {
-            if (msg) {
-                addref_evbuffer(e->flush_buf, e, n, msg);
-            } else {
-                memcpy_evbuffer(e->flush_buf, e, sz, n, buf, len, type);
+            if (evbuffer_expand(e->flush_buf, copysz + n * e->wirehdr_len) == 0) {
+                add_msgs_evbuffer(e->flush_buf, e, n, msg, buf, len, type);
             }
             flush_evbuffer(e, nodelay);
         }
@@ -4030,10 +4286,8 @@ int net_send_all_evbuffer(netinfo_type *netinfo_ptr, int n, void **buf, int *len
         }
         netinfo_ptr->stats.bytes_written += sz;
     }
-    if (msg) {
-        for (int i = 0; i < n; ++i) {
-            shared_msg_free(0, 0, msg[i]);
-        }
+    for (int i = 0; i < n; ++i) {
+        if (msg[i]) shared_msg_free(0, 0, msg[i]);
     }
     return 0;
 }
@@ -135,6 +135,12 @@ typedef struct {
     unsigned long long bytes_read;
     unsigned long long throttle_waits;
     unsigned long long reorders;
+    /* lz4 blocks sent: bytes in, bytes out, time spent compressing */
+    unsigned long long compress_raw_bytes;
+    unsigned long long compress_bytes;
+    unsigned long long compress_usec;
+    /* time spent decompressing the lz4 blocks received */
+    unsigned long long decompress_usec;
 } stats_type;
 
 typedef struct net_send_message_header {
@@ -164,6 +170,19 @@ enum { NET_ACK_MESSAGE_PAYLOAD_TYPE_LEN = 4 + 4 + 4 };
 BB_COMPILE_TIME_ASSERT(net_ack_message_payload_type,
         sizeof(net_ack_message_payload_type) == NET_ACK_MESSAGE_PAYLOAD_TYPE_LEN);
 
+typedef struct net_lz4_header {
+    int rawlen;
+    int complen;
+} net_lz4_header;
+enum { NET_LZ4_HEADER_LEN = 4 + 4 };
+BB_COMPILE_TIME_ASSERT(net_lz4_header,
+        sizeof(net_lz4_header) == NET_LZ4_HEADER_LEN);
+
+/* Optional trailer of hello messages: magic followed by the NET_CAP_*
+ * flags of what the sender can decode.  Older versions ignore it. */
+enum { NET_HELLO_CAPS_MAGIC = 0x63617073 };
+enum { NET_CAP_LZ4 = 1 };
+
 struct event_info;
 struct host_node_tag {
     struct event_info *event_info;
@@ -333,6 +352,8 @@ const uint8_t *net_ack_message_type_get(net_ack_message_type *, const uint8_t *,
 const uint8_t *net_connect_message_get(connect_message_type *, const uint8_t *, const uint8_t *);
 const uint8_t *net_send_message_header_get(net_send_message_header *, const uint8_t *, const uint8_t *);
 uint8_t *net_send_message_header_put(const net_send_message_header *, uint8_t *, const uint8_t *);
+const uint8_t *net_lz4_header_get(net_lz4_header *, const uint8_t *, const uint8_t *);
+uint8_t *net_lz4_header_put(const net_lz4_header *, uint8_t *, const uint8_t *);
 const uint8_t *net_wire_header_get(wire_header_type *, const uint8_t *, const uint8_t *);
 uint8_t *net_wire_header_put(const wire_header_type *, uint8_t *, const uint8_t *);
 
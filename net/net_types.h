@@ -36,6 +36,13 @@ net_ack_message_type.
 If wire_header_type.type == WIRE_HEADER_ACK_PAYLOAD, then payload is
 net_send_message_payload_ack.
 
+If wire_header_type.type == WIRE_HEADER_LZ4, then payload is
+net_lz4_header followed by complen bytes of lz4 compressed data.  It
+decompresses to rawlen bytes holding whole wire messages (of any type but
+WIRE_HEADER_LZ4).  Blocks are compressed as one stream per connection, so
+each one may refer back to the data of the previous ones.  Only sent to
+peers advertising NET_CAP_LZ4 in their hello.
+
 WIRE_HEADER_HELLO, WIRE_HEADER_HELLO_REPLY, WIRE_HEADER_DECOM,
 WIRE_HEADER_DECOM_NAME do not have a struct defining the payload.
 Would be nice to have this.
@@ -51,6 +58,7 @@ enum {
     WIRE_HEADER_HELLO_REPLY = 7,
     WIRE_HEADER_DECOM_NAME = 8,
     WIRE_HEADER_ACK_PAYLOAD = 9,
+    WIRE_HEADER_LZ4 = 10,
     WIRE_HEADER_MAX
 };
 
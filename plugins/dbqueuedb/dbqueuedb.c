@@ -471,8 +471,20 @@ static void admin(struct dbenv *dbenv, int type)
                     case CONSUMER_TYPE_LUA:
                         dbqueue_check_inactivity(consumer);
 
-                        if (!trigger_registered(consumer->procedure_name)) {
+                        /* one trigger thread per unclaimed partition; each
+                         * thread claims whichever partition is free */
+                        int npartitions = bdb_queuedb_get_partitions(db->handle);
+                        for (int p = 0; p < npartitions; p++) {
                             char *name = consumer->procedure_name;
+                            char pname[MAX_SPNAME + TRIGGER_PARTITION_SUFFIX_LEN];
+                            if (npartitions > 1) {
+                                trigger_partition_name(pname, sizeof(pname),
+                                                       name, p);
+                                if (trigger_registered(pname))
+                                    continue;
+                            } else if (trigger_registered(name)) {
+                                continue;
+                            }
                             char *host =
                                 net_get_osql_node(thedb->handle_sibling);
                             if (host == NULL) {
@@ -706,6 +718,8 @@ static void queue_flush(struct dbtable *db, int consumern)
         return;
     }
 
+    int npartitions = bdb_queuedb_get_partitions(db->handle);
+    int partition = 0;
     while (1) {
         struct bdb_queue_found *item;
         int rc;
@@ -715,15 +729,19 @@ static void queue_flush(struct dbtable *db, int consumern)
             return;
         }
 
-        rc = dbq_get(&iq, consumern, NULL, &item, NULL, NULL, NULL, NULL, 0);
+        rc = dbq_get(&iq, bdb_queuedb_partition_consumer(consumern, partition),
+                     NULL, &item, NULL, NULL, NULL, NULL, 0);
 
+        if (rc == IX_NOTFND && ++partition < npartitions)
+            continue;
         if (rc != 0) {
             if (rc != IX_NOTFND)
                 logmsg(LOGMSG_ERROR, "Terminating with dbq_get rcode %d\n", rc);
             break;
         }
 
-        rc = queue_consume(&iq, item, consumern);
+        rc = queue_consume(
+            &iq, item, bdb_queuedb_partition_consumer(consumern, partition));
         free(item);
         if (rc != 0) {
             logmsg(LOGMSG_ERROR, "Terminating after consume rcode %d\n", rc);
@@ -0,0 +1,942 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Bulk load: replace the contents of a table with rows read from a csv file
+ * on the master, without going through osql.
+ *
+ * This runs as a fastinit: new, empty btrees are created for the table, the
+ * rows are written into them directly by schema change transactions, and the
+ * new btrees are swapped in when the schema change is finalized.  Writes made
+ * to the table while the load runs are discarded, as for truncate.
+ *
+ * The load runs in two parallel phases.  A sample of the file is used to
+ * split the primary key space into one range per thread.  First, each thread
+ * parses a slice of the file and files every row, keyed by its primary key,
+ * into the temp table of the range it falls in.  Then each thread drains one
+ * temp table, which is sorted, into the new btrees.  Threads so append to
+ * disjoint parts of the btrees instead of contending for the same pages.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "schemachange.h"
+#include "sc_bulk_load.h"
+#include "sc_fastinit_table.h"
+#include "sc_global.h"
+#include "sc_logic.h"
+#include "sc_schema.h"
+#include "comdb2_atomic.h"
+#include "logmsg.h"
+#include "thrman.h"
+#include "thread_util.h"
+
+int gbl_enable_bulk_load = 0;
+int gbl_bulk_load_threads = 8;
+int gbl_bulk_load_batch_rows = 1000;
+
+extern int gbl_partial_indexes;
+extern __thread snap_uid_t *osql_snap_info; /* contains cnonce */
+
+#define BULK_LOAD_MAX_THREADS 64
+#define BULK_LOAD_SAMPLES 64 /* sampled rows per key range */
+#define BULK_LOAD_SEQLEN 8   /* keeps rows with equal keys apart */
+
+struct bulk_load_part {
+    pthread_mutex_t lk;
+    struct temp_table *tbl;
+    struct temp_cursor *cur;
+};
+
+struct bulk_load {
+    struct schema_change_type *s;
+    struct dbtable *db; /* the new table being filled */
+    off_t datastart;    /* first byte after the header line */
+    off_t size;
+    int ncols;
+    int *fldcol; /* csv column for each field of the table, or -1 */
+    int keylen;  /* primary key length, 0 if the table has no index */
+    int nparts;
+    char *splits; /* nparts - 1 keys, the first key of each range but one */
+    struct bulk_load_part *parts;
+    int64_t nparsed;
+    int64_t ninserted;
+    pthread_mutex_t lk;
+    int failed;
+};
+
+/* per thread scratch space for turning a csv line into a record */
+struct bulk_load_row {
+    char **fields;
+    int *quoted;
+    char *rec;
+    blob_buffer_t blobs[MAXBLOBS];
+    char key[MAXKEYLEN + BULK_LOAD_SEQLEN];
+    char mangled[MAXKEYLEN];
+    char *hex;
+    size_t hexsz;
+    char *buf;
+    size_t bufsz;
+};
+
+struct bulk_load_thd {
+    struct bulk_load *bl;
+    pthread_t tid;
+    int id;
+    off_t start, end;
+    int nretries;
+};
+
+static void bulk_load_fail(struct bulk_load *bl, const char *fmt, ...)
+{
+    char msg[256];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+
+    /* only the first error goes back to the client */
+    Pthread_mutex_lock(&bl->lk);
+    if (!bl->failed) {
+        bl->failed = 1;
+        sc_client_error(bl->s, "%s", msg);
+    }
+    Pthread_mutex_unlock(&bl->lk);
+}
+
+static int bulk_load_stopped(struct bulk_load *bl)
+{
+    if (gbl_sc_abort || bl->s->db->sc_abort ||
+        (bl->s->iq && bl->s->iq->sc_should_abort)) {
+        bulk_load_fail(bl, "Schema change aborted");
+        return 1;
+    }
+    if (get_stopsc(__func__, __LINE__)) {
+        bulk_load_fail(bl, "master downgrading");
+        return 1;
+    }
+    return bl->failed;
+}
+
+static int bulk_load_row_init(struct bulk_load *bl, struct bulk_load_row *row)
+{
+    memset(row, 0, sizeof(*row));
+    row->fields = calloc(bl->ncols + 1, sizeof(char *));
+    row->quoted = calloc(bl->ncols + 1, sizeof(int));
+    row->rec = malloc(bl->db->lrl);
+    if (!row->fields || !row->quoted || !row->rec)
+        return -1;
+    return 0;
+}
+
+static void bulk_load_row_free(struct bulk_load_row *row)
+{
+    free_blob_buffers(row->blobs, MAXBLOBS);
+    free(row->fields);
+    free(row->quoted);
+    free(row->rec);
+    free(row->hex);
+    free(row->buf);
+}
+
+/* Split a csv line in place.  A field may be quoted with '"', and '""' stands
+ * for a quote inside a quoted field.  Returns the number of fields (at most
+ * max + 1), or -1 if the line is malformed. */
+static int bulk_load_split(char *line, char **fields, int *quoted, int max)
+{
+    char *in = line, *out;
+    int n = 0;
+
+    for (;;) {
+        if (n > max)
+            return n;
+        out = in;
+        fields[n] = out;
+        quoted[n] = 0;
+        if (*in == '"') {
+            quoted[n] = 1;
+            in++;
+            for (;;) {
+                if (*in == '\0')
+                    return -1;
+                if (*in == '"') {
+                    if (in[1] != '"') {
+                        in++;
+                        break;
+                    }
+                    in++;
+                }
+                *out++ = *in++;
+            }
+            if (*in != ',' && *in != '\0')
+                return -1;
+        } else {
+            while (*in != ',' && *in != '\0')
+                out++, in++;
+        }
+        n++;
+        if (*in == '\0') {
+            *out = '\0';
+            return n;
+        }
+        in++;
+        *out = '\0';
+    }
+}
+
+static int bulk_load_nibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static int bulk_load_unhex(struct bulk_load_row *row, const char *in, int *outlen)
+{
+    size_t len = strlen(in);
+
+    if (len % 2)
+        return -1;
+    if (len / 2 > row->hexsz) {
+        char *hex = realloc(row->hex, len / 2);
+        if (!hex)
+            return -1;
+        row->hex = hex;
+        row->hexsz = len / 2;
+    }
+    for (size_t i = 0; i < len / 2; i++) {
+        int hi = bulk_load_nibble(in[2 * i]);
+        int lo = bulk_load_nibble(in[2 * i + 1]);
+        if (hi < 0 || lo < 0)
+            return -1;
+        row->hex[i] = (hi << 4) | lo;
+    }
+    *outlen = len / 2;
+    return 0;
+}
+
+/* Turn the fields of a csv line into an ondisk record and blobs for the new
+ * table.  Columns missing from the file get their dbstore default. */
+static int bulk_load_convert(struct bulk_load *bl, struct bulk_load_row *row,
+                             off_t pos)
+{
+    struct schema *sch = bl->db->schema;
+    int rc;
+
+    memset(row->rec, 0, bl->db->lrl);
+    bzero(row->blobs, sizeof(row->blobs));
+
+    for (int i = 0; i < sch->nmembers; i++) {
+        struct field *f = &sch->member[i];
+        blob_buffer_t *outblob =
+            f->blob_index >= 0 ? &row->blobs[f->blob_index] : NULL;
+        int col = bl->fldcol[i];
+        char *val = col >= 0 ? row->fields[col] : NULL;
+        int outdtsz = 0;
+
+        if (col < 0 && f->in_default && !stype_is_null(f->in_default) &&
+            f->in_default_type != SERVER_FUNCTION) {
+            rc = SERVER_to_SERVER(f->in_default, f->in_default_len,
+                                  f->in_default_type, NULL, NULL, 0,
+                                  row->rec + f->offset, f->len, f->type, 0,
+                                  &outdtsz, &f->convopts, outblob);
+        } else if (col < 0 || (!row->quoted[col] && val[0] == '\0')) {
+            if (f->flags & NO_NULL) {
+                bulk_load_fail(bl, "row at offset %lld: column %s may not be null",
+                               (long long)pos, f->name);
+                return -1;
+            }
+            rc = NULL_to_SERVER(row->rec + f->offset, f->len, f->type);
+        } else if (f->type == SERVER_BLOB || f->type == SERVER_BLOB2 ||
+                   f->type == SERVER_BYTEARRAY) {
+            int len;
+            rc = bulk_load_unhex(row, val, &len);
+            if (rc == 0)
+                rc = CLIENT_to_SERVER(row->hex, len, CLIENT_BYTEARRAY, 0, NULL,
+                                      NULL, row->rec + f->offset, f->len,
+                                      f->type, 0, &outdtsz, &f->convopts,
+                                      outblob);
+        } else {
+            rc = CLIENT_to_SERVER(val, strlen(val) + 1, CLIENT_CSTR, 0, NULL,
+                                  NULL, row->rec + f->offset, f->len, f->type,
+                                  0, &outdtsz, &f->convopts, outblob);
+        }
+        if (rc) {
+            bulk_load_fail(bl, "row at offset %lld: bad value for column %s",
+                           (long long)pos, f->name);
+            return -1;
+        }
+    }
+
+    if (bl->keylen &&
+        create_key_from_schema(bl->db, NULL, 0, NULL, NULL, row->mangled, NULL,
+                               row->rec, bl->db->lrl, row->key, row->blobs,
+                               MAXBLOBS, NULL)) {
+        bulk_load_fail(bl, "row at offset %lld: cannot form primary key",
+                       (long long)pos);
+        return -1;
+    }
+    return 0;
+}
+
+/* Parse and convert one line, which is modified.  Returns 1 for a blank
+ * line, 0 for a row, or -1 on error. */
+static int bulk_load_parse(struct bulk_load *bl, struct bulk_load_row *row,
+                           char *line, ssize_t len, off_t pos)
+{
+    int n;
+
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        line[--len] = '\0';
+    if (len == 0)
+        return 1;
+
+    n = bulk_load_split(line, row->fields, row->quoted, bl->ncols);
+    if (n != bl->ncols) {
+        if (n < 0)
+            bulk_load_fail(bl, "row at offset %lld: malformed csv",
+                           (long long)pos);
+        else
+            bulk_load_fail(bl, "row at offset %lld: expected %d fields",
+                           (long long)pos, bl->ncols);
+        return -1;
+    }
+    return bulk_load_convert(bl, row, pos);
+}
+
+/* Pack a converted row for its temp table: the record, then the length of
+ * each blob (-1 if it doesn't exist) followed by its data. */
+static int bulk_load_pack(struct bulk_load *bl, struct bulk_load_row *row)
+{
+    size_t len = bl->db->lrl + bl->db->numblobs * sizeof(int);
+    char *p;
+
+    for (int i = 0; i < bl->db->numblobs; i++)
+        if (row->blobs[i].exists)
+            len += row->blobs[i].length;
+
+    if (len > row->bufsz) {
+        char *buf = realloc(row->buf, len);
+        if (!buf)
+            return -1;
+        row->buf = buf;
+        row->bufsz = len;
+    }
+
+    p = row->buf;
+    memcpy(p, row->rec, bl->db->lrl);
+    p += bl->db->lrl;
+    for (int i = 0; i < bl->db->numblobs; i++) {
+        int bloblen = row->blobs[i].exists ? row->blobs[i].length : -1;
+        memcpy(p, &bloblen, sizeof(int));
+        p += sizeof(int);
+        if (bloblen > 0) {
+            memcpy(p, row->blobs[i].data, bloblen);
+            p += bloblen;
+        }
+    }
+    return len;
+}
+
+static void bulk_load_unpack(struct bulk_load *bl, char *buf, char *rec,
+                             blob_buffer_t *blobs)
+{
+    char *p = buf + bl->db->lrl;
+
+    memcpy(rec, buf, bl->db->lrl);
+    bzero(blobs, sizeof(blob_buffer_t) * MAXBLOBS);
+    for (int i = 0; i < bl->db->numblobs; i++) {
+        int bloblen;
+        memcpy(&bloblen, p, sizeof(int));
+        p += sizeof(int);
+        if (bloblen >= 0) {
+            blobs[i].exists = 1;
+            blobs[i].data = bloblen ? p : NULL;
+            blobs[i].length = bloblen;
+            blobs[i].collected = bloblen;
+            p += bloblen;
+        }
+    }
+}
+
+static int bulk_load_find_part(struct bulk_load *bl, const char *key)
+{
+    int lo = 0, hi = bl->nparts - 1;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (memcmp(key, bl->splits + mid * bl->keylen, bl->keylen) >= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void bulk_load_put_seq(char *p, uint64_t seq)
+{
+    for (int i = BULK_LOAD_SEQLEN - 1; i >= 0; i--, seq >>= 8)
+        p[i] = seq & 0xff;
+}
+
+/* Position f at the first line starting at or after pos.  Returns that
+ * line's offset. */
+static off_t bulk_load_seek(FILE *f, off_t pos, char **line, size_t *linesz)
+{
+    ssize_t n;
+
+    if (fseeko(f, pos - 1, SEEK_SET))
+        return -1;
+    n = getline(line, linesz, f);
+    if (n < 0)
+        return ferror(f) ? -1 : pos;
+    return pos - 1 + n;
+}
+
+static void *bulk_load_parse_thd(void *arg)
+{
+    struct bulk_load_thd *thd = arg;
+    struct bulk_load *bl = thd->bl;
+    struct bulk_load_row row;
+    uint64_t seq = (uint64_t)thd->id << 48;
+    char *line = NULL;
+    size_t linesz = 0;
+    FILE *f = NULL;
+    off_t pos;
+    ssize_t n;
+    int bdberr;
+
+    comdb2_name_thread(__func__);
+    thread_started("bulk load parse");
+
+    if (bulk_load_row_init(bl, &row)) {
+        bulk_load_fail(bl, "out of memory");
+        goto done;
+    }
+    if ((f = fopen(bl->s->bulk_load_path, "r")) == NULL ||
+        (pos = bulk_load_seek(f, thd->start, &line, &linesz)) < 0) {
+        bulk_load_fail(bl, "cannot read %s: %s", bl->s->bulk_load_path,
+                       strerror(errno));
+        goto done;
+    }
+
+    while (pos < thd->end && (n = getline(&line, &linesz, f)) > 0) {
+        off_t linepos = pos;
+        struct bulk_load_part *part;
+        int rc, len;
+
+        pos += n;
+        if ((thd->nretries++ % 10000) == 0 && bulk_load_stopped(bl))
+            break;
+
+        rc = bulk_load_parse(bl, &row, line, n, linepos);
+        if (rc < 0)
+            break;
+        if (rc > 0)
+            continue;
+
+        part = &bl->parts[bl->keylen ? bulk_load_find_part(bl, row.key)
+                                     : thd->id];
+        bulk_load_put_seq(row.key + bl->keylen, seq++);
+        len = bulk_load_pack(bl, &row);
+        free_blob_buffers(row.blobs, MAXBLOBS);
+        if (len < 0) {
+            bulk_load_fail(bl, "out of memory");
+            break;
+        }
+
+        Pthread_mutex_lock(&part->lk);
+        rc = bdb_temp_table_insert(thedb->bdb_env, part->cur, row.key,
+                                   bl->keylen + BULK_LOAD_SEQLEN, row.buf, len,
+                                   &bdberr);
+        Pthread_mutex_unlock(&part->lk);
+        if (rc) {
+            bulk_load_fail(bl, "temp table insert failed rc %d bdberr %d", rc,
+                           bdberr);
+            break;
+        }
+        ATOMIC_ADD64(bl->nparsed, 1);
+    }
+    if (f && ferror(f))
+        bulk_load_fail(bl, "error reading %s: %s", bl->s->bulk_load_path,
+                       strerror(errno));
+
+done:
+    if (f)
+        fclose(f);
+    free(line);
+    bulk_load_row_free(&row);
+    return NULL;
+}
+
+static int bulk_load_add(struct ireq *iq, struct bulk_load *bl, void *trans,
+                         char *rec, blob_buffer_t *blobs)
+{
+    const char *tag = ".NEW..ONDISK";
+    unsigned long long dirty_keys = -1ULL, genid = 0;
+    int opfailcode = 0, ixfailnum = 0, rrn = 0, rc;
+
+    if (gbl_partial_indexes && bl->db->ix_partial) {
+        dirty_keys =
+            verify_indexes(bl->db, (uint8_t *)rec, blobs, MAXBLOBS, 1);
+        if (dirty_keys == -1ULL) {
+            bulk_load_fail(bl, "error verifying partial indexes");
+            return ERR_VERIFY_PI;
+        }
+    }
+    rc = verify_check_constraints(bl->db, (uint8_t *)rec, blobs, MAXBLOBS, 1);
+    if (rc) {
+        bulk_load_fail(bl, "row violates CHECK constraint %s",
+                       rc > 0 ? bl->db->check_constraints[rc - 1].consname
+                              : "(internal error)");
+        return ERR_CONSTR;
+    }
+    rc = verify_record_constraint(iq, bl->db, trans, rec, dirty_keys, blobs,
+                                  MAXBLOBS, tag, 0, 0);
+    if (rc == RC_INTERNAL_RETRY)
+        return rc;
+    if (rc) {
+        bulk_load_fail(bl, "row violates foreign constraints");
+        return rc;
+    }
+
+    rc = add_record(iq, trans, (const uint8_t *)tag,
+                    (const uint8_t *)tag + strlen(tag), (uint8_t *)rec,
+                    (uint8_t *)rec + bl->db->lrl, NULL, blobs, MAXBLOBS,
+                    &opfailcode, &ixfailnum, &rrn, &genid, dirty_keys,
+                    BLOCK2_ADDKL, 0,
+                    RECFLAGS_NO_TRIGGERS | RECFLAGS_NO_CONSTRAINTS |
+                        RECFLAGS_NEW_SCHEMA,
+                    0);
+    if (rc == RC_INTERNAL_RETRY || rc == 0)
+        return rc;
+    if (rc == IX_DUP)
+        bulk_load_fail(bl, "duplicate entry in index %d", ixfailnum);
+    else
+        bulk_load_fail(bl, "error adding record rcode %d opfailcode %d "
+                           "ixfailnum %d",
+                       rc, opfailcode, ixfailnum);
+    return rc;
+}
+
+/* Insert a batch of packed rows in one transaction, retrying the whole
+ * batch on deadlock. */
+static int bulk_load_insert_batch(struct bulk_load_thd *thd, struct ireq *iq,
+                                  char **rows, int nrows, char *rec)
+{
+    struct bulk_load *bl = thd->bl;
+    blob_buffer_t blobs[MAXBLOBS];
+    tran_type *trans = NULL;
+    int rc = 0;
+
+    for (;;) {
+        if (bulk_load_stopped(bl))
+            return -1;
+        rc = trans_start_sc_lowpri(iq, &trans);
+        if (rc) {
+            bulk_load_fail(bl, "error %d starting transaction", rc);
+            return -1;
+        }
+        for (int i = 0; i < nrows && rc == 0; i++) {
+            bulk_load_unpack(bl, rows[i], rec, blobs);
+            rc = bulk_load_add(iq, bl, trans, rec, blobs);
+        }
+        if (rc != RC_INTERNAL_RETRY)
+            break;
+        trans_abort(iq, trans);
+        thd->nretries++;
+        poll(0, 0, (rand() % 500 + 10));
+    }
+    if (rc) {
+        trans_abort(iq, trans);
+        return -1;
+    }
+    rc = trans_commit(iq, trans, gbl_myhostname);
+    if (rc) {
+        bulk_load_fail(bl, "trans_commit failed with rcode %d", rc);
+        return -1;
+    }
+    ATOMIC_ADD64(bl->ninserted, nrows);
+    ATOMIC_ADD64(bl->s->db->sc_nrecs, nrows);
+    return 0;
+}
+
+static void *bulk_load_insert_thd(void *arg)
+{
+    struct bulk_load_thd *thd = arg;
+    struct bulk_load *bl = thd->bl;
+    struct bulk_load_part *part = &bl->parts[thd->id];
+    struct thr_handle *thr_self;
+    snap_uid_t loc_snap_info;
+    struct ireq iq;
+    int batch = gbl_bulk_load_batch_rows > 0 ? gbl_bulk_load_batch_rows : 1;
+    char **rows = calloc(batch, sizeof(char *));
+    char *rec = malloc(bl->db->lrl);
+    int nrows = 0, rc, bdberr;
+
+    comdb2_name_thread(__func__);
+    thread_started("bulk load insert");
+    thr_self = thrman_register(THRTYPE_SCHEMACHANGE);
+    backend_thread_event(thedb, COMDB2_THR_EVENT_START);
+
+    init_fake_ireq(thedb, &iq);
+    iq.usedb = bl->db;
+    iq.opcode = OP_REBUILD;
+    iq.reqlogger = thrman_get_reqlogger(thr_self);
+    osql_snap_info = &loc_snap_info;
+    loc_snap_info.keylen = snprintf(loc_snap_info.key, sizeof(loc_snap_info.key),
+                                    "internal-bulkload-%p", (void *)pthread_self());
+
+    if (!rows || !rec) {
+        bulk_load_fail(bl, "out of memory");
+        goto done;
+    }
+
+    rc = bdb_temp_table_first(thedb->bdb_env, part->cur, &bdberr);
+    while (rc == 0) {
+        int len = bdb_temp_table_datasize(part->cur);
+        if ((rows[nrows] = malloc(len)) == NULL) {
+            bulk_load_fail(bl, "out of memory");
+            goto done;
+        }
+        memcpy(rows[nrows++], bdb_temp_table_data(part->cur), len);
+        if (nrows == batch) {
+            rc = bulk_load_insert_batch(thd, &iq, rows, nrows, rec);
+            for (int i = 0; i < nrows; i++) {
+                free(rows[i]);
+                rows[i] = NULL;
+            }
+            nrows = 0;
+            if (rc) {
+                bulk_load_fail(bl, "error %d inserting rows", rc);
+                goto done;
+            }
+        }
+        rc = bdb_temp_table_next(thedb->bdb_env, part->cur, &bdberr);
+    }
+    if (rc != IX_EMPTY && rc != IX_PASTEOF) {
+        bulk_load_fail(bl, "temp table read failed rc %d bdberr %d", rc, bdberr);
+        goto done;
+    }
+    if (nrows) {
+        rc = bulk_load_insert_batch(thd, &iq, rows, nrows, rec);
+        if (rc)
+            bulk_load_fail(bl, "error %d inserting rows", rc);
+    }
+
+done:
+    if (rows) {
+        for (int i = 0; i < nrows; i++)
+            free(rows[i]);
+        free(rows);
+    }
+    free(rec);
+    osql_snap_info = NULL;
+    backend_thread_event(thedb, COMDB2_THR_EVENT_DONE);
+    return NULL;
+}
+
+static int bulk_load_header(struct bulk_load *bl, char *line, ssize_t len)
+{
+    struct schema *sch = bl->db->schema;
+    char **cols;
+    int *quoted;
+    int n;
+
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        line[--len] = '\0';
+
+    /* a table has fewer than MAXCOLUMNS columns; allow for one more so that
+     * a longer header is reported */
+    cols = calloc(MAXCOLUMNS + 2, sizeof(char *));
+    quoted = calloc(MAXCOLUMNS + 2, sizeof(int));
+    bl->fldcol = malloc(sch->nmembers * sizeof(int));
+    if (!cols || !quoted || !bl->fldcol) {
+        free(cols);
+        free(quoted);
+        bulk_load_fail(bl, "out of memory");
+        return -1;
+    }
+    for (int i = 0; i < sch->nmembers; i++)
+        bl->fldcol[i] = -1;
+
+    n = bulk_load_split(line, cols, quoted, MAXCOLUMNS);
+    if (n <= 0 || n > MAXCOLUMNS) {
+        bulk_load_fail(bl, "bad csv header in %s", bl->s->bulk_load_path);
+        goto err;
+    }
+    for (int c = 0; c < n; c++) {
+        int i;
+        for (i = 0; i < sch->nmembers; i++)
+            if (strcasecmp(cols[c], sch->member[i].name) == 0)
+                break;
+        if (i == sch->nmembers) {
+            bulk_load_fail(bl, "table %s has no column '%s'",
+                           bl->s->tablename, cols[c]);
+            goto err;
+        }
+        if (bl->fldcol[i] >= 0) {
+            bulk_load_fail(bl, "column '%s' appears twice", cols[c]);
+            goto err;
+        }
+        bl->fldcol[i] = c;
+    }
+    bl->ncols = n;
+    free(cols);
+    free(quoted);
+    return 0;
+
+err:
+    free(cols);
+    free(quoted);
+    return -1;
+}
+
+/* Pick the keys that split the primary key space into nparts ranges of
+ * about the same size, from rows sampled evenly through the file. */
+static int bulk_load_split_keys(struct bulk_load *bl, FILE *f)
+{
+    struct bulk_load_row row;
+    struct temp_table *tbl = NULL;
+    struct temp_cursor *cur = NULL;
+    int nsamples = BULK_LOAD_SAMPLES * bl->nparts, count = 0, rc = -1;
+    char *line = NULL;
+    size_t linesz = 0;
+    int bdberr;
+
+    if (bulk_load_row_init(bl, &row) ||
+        (bl->splits = calloc(bl->nparts - 1, bl->keylen)) == NULL ||
+        (tbl = bdb_temp_table_create(thedb->bdb_env, &bdberr)) == NULL ||
+        (cur = bdb_temp_table_cursor(thedb->bdb_env, tbl, NULL, &bdberr)) ==
+            NULL) {
+        bulk_load_fail(bl, "out of resources sampling %s",
+                       bl->s->bulk_load_path);
+        goto done;
+    }
+
+    for (int i = 0; i < nsamples; i++) {
+        off_t pos = bl->datastart + (bl->size - bl->datastart) * i / nsamples;
+        ssize_t n;
+
+        if ((pos = bulk_load_seek(f, pos, &line, &linesz)) < 0) {
+            bulk_load_fail(bl, "cannot read %s: %s", bl->s->bulk_load_path,
+                           strerror(errno));
+            goto done;
+        }
+        if ((n = getline(&line, &linesz, f)) <= 0)
+            continue;
+        rc = bulk_load_parse(bl, &row, line, n, pos);
+        free_blob_buffers(row.blobs, MAXBLOBS);
+        if (rc < 0)
+            goto done;
+        if (rc > 0)
+            continue;
+        bulk_load_put_seq(row.key + bl->keylen, i);
+        if (bdb_temp_table_insert(thedb->bdb_env, cur, row.key,
+                                  bl->keylen + BULK_LOAD_SEQLEN, NULL, 0,
+                                  &bdberr)) {
+            bulk_load_fail(bl, "temp table insert failed bdberr %d", bdberr);
+            goto done;
+        }
+        count++;
+    }
+
+    /* with no rows every range is empty, and any split will do */
+    rc = bdb_temp_table_first(thedb->bdb_env, cur, &bdberr);
+    for (int i = 0, split = 1; rc == 0 && split < bl->nparts; i++) {
+        if (i == split * count / bl->nparts) {
+            memcpy(bl->splits + (split - 1) * bl->keylen,
+                   bdb_temp_table_key(cur), bl->keylen);
+            split++;
+        }
+        rc = bdb_temp_table_next(thedb->bdb_env, cur, &bdberr);
+    }
+    rc = 0;
+
+done:
+    if (cur)
+        bdb_temp_table_close_cursor(thedb->bdb_env, cur, &bdberr);
+    if (tbl)
+        bdb_temp_table_close(thedb->bdb_env, tbl, &bdberr);
+    free(line);
+    bulk_load_row_free(&row);
+    return rc;
+}
+
+static int bulk_load_run(struct bulk_load *bl, void *(*fn)(void *),
+                         struct bulk_load_thd *thds)
+{
+    pthread_attr_t attr;
+
+    Pthread_attr_init(&attr);
+    Pthread_attr_setstacksize(&attr, DEFAULT_THD_STACKSZ);
+    Pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+    for (int i = 0; i < bl->nparts; i++)
+        Pthread_create(&thds[i].tid, &attr, fn, &thds[i]);
+    for (int i = 0; i < bl->nparts; i++)
+        Pthread_join(thds[i].tid, NULL);
+    Pthread_attr_destroy(&attr);
+
+    return bl->failed ? -1 : 0;
+}
+
+static int bulk_load_records(struct schema_change_type *s, struct dbtable *db)
+{
+    struct bulk_load bl = {0};
+    struct bulk_load_thd *thds = NULL;
+    char *line = NULL;
+    size_t linesz = 0;
+    struct stat st;
+    FILE *f;
+    ssize_t n;
+    int rc = -1, bdberr, nretries = 0;
+
+    bl.s = s;
+    bl.db = db;
+    bl.keylen = db->nix > 0 ? getkeysize(db, 0) : 0;
+    Pthread_mutex_init(&bl.lk, NULL);
+
+    bl.nparts = gbl_bulk_load_threads;
+    if (bl.nparts < 1)
+        bl.nparts = 1;
+    if (bl.nparts > BULK_LOAD_MAX_THREADS)
+        bl.nparts = BULK_LOAD_MAX_THREADS;
+
+    if ((f = fopen(s->bulk_load_path, "r")) == NULL || fstat(fileno(f), &st)) {
+        bulk_load_fail(&bl, "cannot open %s: %s", s->bulk_load_path,
+                       strerror(errno));
+        goto done;
+    }
+    if ((n = getline(&line, &linesz, f)) <= 0) {
+        bulk_load_fail(&bl, "%s has no csv header", s->bulk_load_path);
+        goto done;
+    }
+    bl.datastart = n;
+    bl.size = st.st_size;
+    if (bulk_load_header(&bl, line, n))
+        goto done;
+
+    /* without a primary key to sort on, each thread keeps its own rows */
+    if (bl.keylen && bl.nparts > 1 && bulk_load_split_keys(&bl, f))
+        goto done;
+
+    bl.parts = calloc(bl.nparts, sizeof(struct bulk_load_part));
+    thds = calloc(bl.nparts, sizeof(struct bulk_load_thd));
+    if (!bl.parts || !thds) {
+        bulk_load_fail(&bl, "out of memory");
+        goto done;
+    }
+    for (int i = 0; i < bl.nparts; i++) {
+        Pthread_mutex_init(&bl.parts[i].lk, NULL);
+        bl.parts[i].tbl = bdb_temp_table_create(thedb->bdb_env, &bdberr);
+        if (bl.parts[i].tbl)
+            bl.parts[i].cur = bdb_temp_table_cursor(
+                thedb->bdb_env, bl.parts[i].tbl, NULL, &bdberr);
+        if (!bl.parts[i].cur) {
+            bulk_load_fail(&bl, "cannot create temp table bdberr %d", bdberr);
+            goto done;
+        }
+    }
+
+    for (int i = 0; i < bl.nparts; i++) {
+        thds[i].bl = &bl;
+        thds[i].id = i;
+        thds[i].start = bl.datastart +
+                        (bl.size - bl.datastart) * i / bl.nparts;
+        thds[i].end = bl.datastart +
+                      (bl.size - bl.datastart) * (i + 1) / bl.nparts;
+    }
+    sc_printf(s, "[%s] bulk load parsing %s with %d threads\n", s->tablename,
+              s->bulk_load_path, bl.nparts);
+    if (bulk_load_run(&bl, bulk_load_parse_thd, thds))
+        goto done;
+
+    sc_printf(s, "[%s] bulk load parsed %lld rows, inserting\n", s->tablename,
+              (long long)bl.nparsed);
+    for (int i = 0; i < bl.nparts; i++)
+        thds[i].nretries = 0;
+    if (bulk_load_run(&bl, bulk_load_insert_thd, thds))
+        goto done;
+    for (int i = 0; i < bl.nparts; i++)
+        nretries += thds[i].nretries;
+
+    sc_printf(s, "[%s] bulk load inserted %lld rows with %d retries\n",
+              s->tablename, (long long)bl.ninserted, nretries);
+    rc = 0;
+
+done:
+    if (bl.parts) {
+        for (int i = 0; i < bl.nparts; i++) {
+            if (bl.parts[i].cur)
+                bdb_temp_table_close_cursor(thedb->bdb_env, bl.parts[i].cur,
+                                            &bdberr);
+            if (bl.parts[i].tbl)
+                bdb_temp_table_close(thedb->bdb_env, bl.parts[i].tbl, &bdberr);
+            Pthread_mutex_destroy(&bl.parts[i].lk);
+        }
+        free(bl.parts);
+    }
+    free(thds);
+    free(bl.splits);
+    free(bl.fldcol);
+    free(line);
+    if (f)
+        fclose(f);
+    Pthread_mutex_destroy(&bl.lk);
+    return rc;
+}
+
+int do_bulk_load(struct ireq *iq, struct schema_change_type *s, tran_type *tran)
+{
+    int rc;
+
+    if (!gbl_enable_bulk_load) {
+        sc_client_error(s, "bulk load is not enabled");
+        return SC_INVALID_OPTIONS;
+    }
+
+    rc = do_fastinit(iq, s, tran);
+    if (rc)
+        return rc;
+
+    rc = bulk_load_records(s, s->newdb);
+    if (rc) {
+        delete_temp_table(iq, s->newdb);
+        change_schemas_recover(s->tablename);
+        return get_stopsc(__func__, __LINE__) ? SC_MASTER_DOWNGRADE
+                                              : SC_CONVERSION_FAILED;
+    }
+    return SC_OK;
+}
+
+int finalize_bulk_load(struct ireq *iq, struct schema_change_type *s,
+                       tran_type *tran)
+{
+    return finalize_fastinit_table(iq, s, tran);
+}
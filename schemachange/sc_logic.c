@@ -37,6 +37,7 @@
 #include "sc_rename_table.h"
 #include "sc_view.h"
 #include "sc_import.h"
+#include "sc_bulk_load.h"
 #include "logmsg.h"
 #include "comdb2_atomic.h"
 #include "sc_callbacks.h"
@@ -660,6 +661,7 @@ struct {
     {1, alter, do_alter_table, finalize_alter_table, NULL, NULL},
     {1, bulkimport, do_import, finalize_import, NULL, NULL},
     {0, 0, NULL, NULL, do_default_cons, finalize_default_cons},
+    {1, fastinit, do_bulk_load, finalize_bulk_load, NULL, NULL},
 };
 
 static int do_schema_change_tran_int(sc_arg_t *arg)
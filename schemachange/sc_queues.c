@@ -252,6 +252,7 @@ int perform_trigger_update_replicant(tran_type *tran, const char *queue_name, sc
             rc = -1;
             goto done;
         }
+        javasp_set_queue_partitions(db);
         add_to_qdbs(db);
 
         /* TODO: needs locking */
@@ -136,6 +136,7 @@ void free_schema_change_type(struct schema_change_type *s)
 
     free(s->newcsc2);
     free(s->sc_convert_done);
+    free(s->bulk_load_path);
     if (s->import_src_table_data) {
         import_data__free_unpacked(s->import_src_table_data, &pb_alloc);
         s->import_src_table_data = NULL;
@@ -320,6 +321,7 @@ int pack_schema_change_protobuf(struct schema_change_type *s, void **packed_sc,
 
     sc.import_src_tablename = s->import_src_tablename;
     sc.import_src_dbname = s->import_src_dbname;
+    sc.bulk_load_path = s->bulk_load_path;
 
     sc.tablename_for_default_cons_q = s->tablename_for_default_cons_q;
     if (s->newcsc2_for_default_cons_q) {
@@ -648,6 +650,8 @@ int unpack_schema_change_protobuf(struct schema_change_type *s, void *packed_sc,
         strncpy(s->import_src_dbname, sc->import_src_dbname, sizeof(s->import_src_dbname));
         s->import_src_dbname_len = strlen(s->import_src_dbname) + 1;
     }
+    if (sc->bulk_load_path)
+        s->bulk_load_path = strdup(sc->bulk_load_path);
 
     if (sc->tablename_for_default_cons_q) {
         strncpy0(s->tablename_for_default_cons_q, sc->tablename_for_default_cons_q, sizeof(s->tablename_for_default_cons_q));
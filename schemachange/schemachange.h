@@ -138,12 +138,14 @@ enum schema_change_kind {
     SC_REBUILDTABLE_INDEX = 29,
     SC_BULK_IMPORT = 30,
     SC_DEFAULTCONS = 31, 
+    SC_BULK_LOAD = 32,
     SC_LAST /* End marker */
 };
 
 #define IS_SC_DBTYPE_TAGGED_TABLE(s) ((s)->kind > SC_DROP_VIEW)
 #define IS_FASTINIT(s)                                                         \
-    (((s)->kind == SC_DROP_VIEW) || ((s)->kind == SC_TRUNCATETABLE))
+    (((s)->kind == SC_DROP_VIEW) || ((s)->kind == SC_TRUNCATETABLE) ||        \
+     ((s)->kind == SC_BULK_LOAD))
 #define IS_SFUNC(s) (((s)->kind == SC_ADD_SFUNC) || ((s)->kind == SC_DEL_SFUNC))
 #define IS_AFUNC(s) (((s)->kind == SC_ADD_AFUNC) || ((s)->kind == SC_DEL_AFUNC))
 #define IS_TRIGGER(s)                                                          \
@@ -323,6 +325,8 @@ struct schema_change_type {
     unsigned long long import_dst_index_genids[MAXINDEX];
     unsigned long long import_dst_blob_genids[MAXBLOBS];
 
+    char *bulk_load_path; /* csv file read by a bulk load */
+
     char tablename_for_default_cons_q[MAXTABLELEN];
     size_t tablename_for_default_cons_q_len;
     char * newcsc2_for_default_cons_q;
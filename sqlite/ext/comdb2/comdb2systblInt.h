@@ -68,6 +68,7 @@ int systblKeyComponentsInit(sqlite3 *db);
 int systblTypeSamplesInit(sqlite3 *db);
 int systblRepNetQueueStatInit(sqlite3 *db);
 int systblSqlpoolQueueInit(sqlite3 *db);
+int systblSqlTenantsInit(sqlite3 *db);
 int systblActivelocksInit(sqlite3 *db);
 int systblStringRefsInit(sqlite3 *db);
 int systblNetUserfuncsInit(sqlite3 *db);
@@ -45,6 +45,9 @@ struct fingerprint_track_systbl {
     char *has_query_info; /* 'Y' if this node has the full query text (a
                              gbl_fingerprint_hash entry); 'N' for rtstats-only
                              fingerprints (e.g. master write-apply accounting) */
+    int64_t cpu_time;                  /* Cumulative thread cpu time */
+    int64_t wait_time[THD_WAIT_MAX];   /* Cumulative time by wait event */
+    int64_t osql_round_trips;          /* Cumulative osql round trips */
 
     char fp[FINGERPRINTSZ*2+1];
 };
@@ -175,6 +178,9 @@ static int fingerprints_callback(void **data, int *npoints)
             pFp[copied].total_write_pagein_read_io = counts[3];
             pFp[copied].total_replication_pagein_read = counts[4];
             pFp[copied].total_replication_pagein_read_io = counts[5];
+            pFp[copied].cpu_time = pEntry->cpu_time;
+            memcpy(pFp[copied].wait_time, pEntry->wait_time, sizeof(pEntry->wait_time));
+            pFp[copied].osql_round_trips = pEntry->osql_round_trips;
             /* remember this fingerprint so the rtstats merge below skips it */
             memcpy(&seen_keys[copied * FINGERPRINTSZ], pEntry->fingerprint, FINGERPRINTSZ);
             hash_add(seen, &seen_keys[copied * FINGERPRINTSZ]);
@@ -242,5 +248,27 @@ int systblFingerprintsInit(sqlite3 *db)
         offsetof(struct fingerprint_track_systbl, excluded),
         CDB2_CSTRING, "has_query_info", -1,
         offsetof(struct fingerprint_track_systbl, has_query_info),
+        CDB2_INTEGER, "total_cpu_us", -1,
+        offsetof(struct fingerprint_track_systbl, cpu_time),
+        CDB2_INTEGER, "total_lock_page_wait_us", -1,
+        offsetof(struct fingerprint_track_systbl, wait_time[THD_WAIT_LOCK_PAGE]),
+        CDB2_INTEGER, "total_lock_row_wait_us", -1,
+        offsetof(struct fingerprint_track_systbl, wait_time[THD_WAIT_LOCK_ROW]),
+        CDB2_INTEGER, "total_lock_table_wait_us", -1,
+        offsetof(struct fingerprint_track_systbl, wait_time[THD_WAIT_LOCK_TABLE]),
+        CDB2_INTEGER, "total_lock_other_wait_us", -1,
+        offsetof(struct fingerprint_track_systbl, wait_time[THD_WAIT_LOCK_OTHER]),
+        CDB2_INTEGER, "total_page_in_wait_us", -1,
+        offsetof(struct fingerprint_track_systbl, wait_time[THD_WAIT_PAGE_IN]),
+        CDB2_INTEGER, "total_log_flush_wait_us", -1,
+        offsetof(struct fingerprint_track_systbl, wait_time[THD_WAIT_LOG_FLUSH]),
+        CDB2_INTEGER, "total_rep_wait_us", -1,
+        offsetof(struct fingerprint_track_systbl, wait_time[THD_WAIT_REP]),
+        CDB2_INTEGER, "total_osql_wait_us", -1,
+        offsetof(struct fingerprint_track_systbl, wait_time[THD_WAIT_OSQL]),
+        CDB2_INTEGER, "total_throttle_wait_us", -1,
+        offsetof(struct fingerprint_track_systbl, wait_time[THD_WAIT_THROTTLE]),
+        CDB2_INTEGER, "total_osql_round_trips", -1,
+        offsetof(struct fingerprint_track_systbl, osql_round_trips),
         SYSTABLE_END_OF_FIELDS);
 }
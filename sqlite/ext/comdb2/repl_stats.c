@@ -51,7 +51,13 @@ enum {
     COLUMN_AVG_WAIT_OVER_1MIN,
     COLUMN_MAX_WAIT_OVER_1MIN,
     COLUMN_LSN,
-    COLUMN_LSN_BYTES_BEHIND_MASTER
+    COLUMN_LSN_BYTES_BEHIND_MASTER,
+    COLUMN_COMPRESS_RAW_BYTES,
+    COLUMN_COMPRESS_BYTES,
+    COLUMN_COMPRESS_USECS,
+    COLUMN_DECOMPRESS_USECS,
+    COLUMN_ACKS,
+    COLUMN_WAITERS_RELEASED
 };
 
 static int systblReplStatsConnect(sqlite3 *db, void *pAux, int argc,
@@ -65,7 +71,10 @@ static int systblReplStatsConnect(sqlite3 *db, void *pAux, int argc,
             "\"bytes_written\", \"bytes_read\", \"throttle_waits\", "
             "\"reorders\", \"avg_wait_over_10secs\", \"max_wait_over_10secs\", "
             "\"avg_wait_over_1min\", \"max_wait_over_1min\", "
-            "\"lsn\", \"lsn_bytes_behind_master\")");
+            "\"lsn\", \"lsn_bytes_behind_master\", "
+            "\"compress_raw_bytes\", \"compress_bytes\", "
+            "\"compress_usecs\", \"decompress_usecs\", "
+            "\"acks\", \"waiters_released\")");
 
     if (rc == SQLITE_OK) {
         if ((*ppVtab = sqlite3_malloc(sizeof(sqlite3_vtab))) == 0) {
@@ -183,6 +192,24 @@ static int systblReplStatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx,
     case COLUMN_LSN_BYTES_BEHIND_MASTER:
         sqlite3_result_int64(ctx, stats->lsn_bytes_behind);
         break;
+    case COLUMN_COMPRESS_RAW_BYTES:
+        sqlite3_result_int64(ctx, stats->compress_raw_bytes);
+        break;
+    case COLUMN_COMPRESS_BYTES:
+        sqlite3_result_int64(ctx, stats->compress_bytes);
+        break;
+    case COLUMN_COMPRESS_USECS:
+        sqlite3_result_int64(ctx, stats->compress_usec);
+        break;
+    case COLUMN_DECOMPRESS_USECS:
+        sqlite3_result_int64(ctx, stats->decompress_usec);
+        break;
+    case COLUMN_ACKS:
+        sqlite3_result_int64(ctx, stats->acks);
+        break;
+    case COLUMN_WAITERS_RELEASED:
+        sqlite3_result_int64(ctx, stats->waiters_released);
+        break;
     default:
         assert(0);
     };
@@ -0,0 +1,59 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <stddef.h>
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "ezsystables.h"
+#include "sql_scheduler.h"
+
+static int get_sqltenants(void **data, int *records)
+{
+    struct sql_sched_tenant_info *info = NULL;
+    int n = 0;
+    int rc = sql_sched_get_tenant_info(&info, &n);
+    *data = info;
+    *records = n;
+    return rc;
+}
+
+static void free_sqltenants(void *p, int n)
+{
+    sql_sched_free_tenant_info(p, n);
+}
+
+sqlite3_module systblSqlTenantsModule = {
+    .access_flag = CDB2_ALLOW_USER,
+};
+
+int systblSqlTenantsInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_sql_tenants", &systblSqlTenantsModule, get_sqltenants,
+        free_sqltenants, sizeof(struct sql_sched_tenant_info),
+        CDB2_CSTRING, "name", -1, offsetof(struct sql_sched_tenant_info, name),
+        CDB2_INTEGER, "weight", -1, offsetof(struct sql_sched_tenant_info, weight),
+        CDB2_INTEGER, "max_concurrent", -1, offsetof(struct sql_sched_tenant_info, max_concurrent),
+        CDB2_INTEGER, "running", -1, offsetof(struct sql_sched_tenant_info, running),
+        CDB2_INTEGER, "queued", -1, offsetof(struct sql_sched_tenant_info, queued),
+        CDB2_INTEGER, "peak_queued", -1, offsetof(struct sql_sched_tenant_info, peak_queued),
+        CDB2_INTEGER, "dispatched", -1, offsetof(struct sql_sched_tenant_info, dispatched),
+        CDB2_INTEGER, "total_wait_us", -1, offsetof(struct sql_sched_tenant_info, total_wait_us),
+        CDB2_INTEGER, "max_wait_us", -1, offsetof(struct sql_sched_tenant_info, max_wait_us),
+        CDB2_INTEGER, "timeouts", -1, offsetof(struct sql_sched_tenant_info, timeouts),
+        SYSTABLE_END_OF_FIELDS);
+}
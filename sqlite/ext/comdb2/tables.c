@@ -183,6 +183,8 @@ int comdb2SystblInit(
     rc = systblActivelocksInit(db);
   if (rc == SQLITE_OK)
     rc = systblSqlpoolQueueInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblSqlTenantsInit(db);
   if (rc == SQLITE_OK)
     rc = systblNetUserfuncsInit(db);
   if (rc == SQLITE_OK)
@@ -53,6 +53,7 @@ int gbl_view_feature = 1;
 int gbl_disable_sql_table_replacement = 0;
 extern int gbl_enable_bulk_import;
 extern int gbl_enable_bulk_import_different_tables;
+extern int gbl_enable_bulk_load;
 
 extern int sqlite3GetToken(const unsigned char *z, int *tokenType);
 extern int sqlite3ParserFallback(int iToken);
@@ -1784,6 +1785,76 @@ void comdb2bulkimport(Parse* pParse, Token* nm,Token* lnm, Token* nm2, Token* ln
            nm->z, nm2->n +lnm2->n, nm2->z);
 }
 
+/* Replace the contents of a table with the rows of a csv file on the
+ * master; see sc_bulk_load.c */
+void comdb2BulkLoad(Parse* pParse, Token* nm, Token* lnm, Token* path)
+{
+    if (comdb2IsPrepareOnly(pParse))
+        return;
+
+    if (comdb2AuthenticateUserOp(pParse))
+        return;
+
+    if (!gbl_enable_bulk_load) {
+        setError(pParse, SQLITE_MISUSE, "bulk load is not enabled");
+        return;
+    }
+
+    if (!gbl_sc_protobuf) {
+        setError(pParse, SQLITE_MISUSE,
+            "sc_protobuf lrl option required for bulk load");
+        return;
+    }
+
+    Vdbe *v  = sqlite3GetVdbe(pParse);
+
+    struct schema_change_type* sc = new_schemachange_type();
+
+    if (sc == NULL) {
+        setError(pParse, SQLITE_NOMEM, "System out of memory");
+        return;
+    }
+
+    if (chkAndCopyTableTokens(pParse, sc->tablename, nm, lnm,
+                              ERROR_ON_TBL_NOT_FOUND, 1, 0, NULL, /* check_for_illegal_chars */ 0))
+        goto out;
+
+    sc->kind = SC_BULK_LOAD;
+    sc->nothrevent = 1;
+    sc->same_schema = 1;
+
+    sc->bulk_load_path = malloc(path->n + 1);
+    if (sc->bulk_load_path == NULL) {
+        setError(pParse, SQLITE_NOMEM, "System out of memory");
+        goto out;
+    }
+    memcpy(sc->bulk_load_path, path->z, path->n);
+    sc->bulk_load_path[path->n] = '\0';
+    sqlite3Dequote(sc->bulk_load_path);
+    if (sc->bulk_load_path[0] != '/') {
+        setError(pParse, SQLITE_MISUSE, "bulk load path must be absolute");
+        goto out;
+    }
+
+    tran_type *tran = curtran_gettran();
+    int rc = get_csc2_file_tran(sc->tablename, -1, &sc->newcsc2, NULL, tran);
+    curtran_puttran(tran);
+    if(rc)
+    {
+        logmsg(LOGMSG_ERROR, "%s: table schema not found: %s\n", __func__,
+               sc->tablename);
+        setError(pParse, SQLITE_ERROR, "Table schema cannot be found");
+        goto out;
+    }
+
+    comdb2PrepareSC(v, pParse, 0, sc, &comdb2SqlSchemaChange_usedb,
+                    (vdbeFuncArgFree)&free_schema_change_type);
+    return;
+
+out:
+    free_schema_change_type(sc);
+}
+
 /********************* IMPORT ****************************************************/
 
 void comdb2Replace(Parse* pParse, Token *nm, Token *nm2, Token *nm3)
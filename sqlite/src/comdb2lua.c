@@ -17,6 +17,7 @@
 #include <trigger.h>
 #include <sqlglue.h>
 #include <str_util.h>
+#include <bdb_api.h>
 
 struct dbtable;
 struct dbtable *getqueuebyname(const char *);
@@ -140,7 +141,17 @@ static int can_create_default_consumer_atomically()
     return gbl_create_default_consumer_atomically && gbl_sc_protobuf;
 }
 
-void comdb2CreateTrigger(Parse *parse, int consumer, int seq, Token *proc, Cdb2TrigTables *tbl)
+static int table_has_column(Table *table, const char *col)
+{
+    for (int i = 0; i < table->nCol; ++i) {
+        if (strcasecmp(table->aCol[i].zName, col) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void comdb2CreateTrigger(Parse *parse, int consumer, int seq, Cdb2TrigPartition *part, Token *proc, Cdb2TrigTables *tbl)
 {
     if (comdb2IsPrepareOnly(parse))
         return;
@@ -197,7 +208,36 @@ void comdb2CreateTrigger(Parse *parse, int consumer, int seq, Token *proc, Cdb2T
         return;
     }
 
+    char partcol[MAXCOLNAME + 1] = {0};
+    if (part->n) {
+        if (part->n < 2 || part->n > BDB_QUEUEDB_MAX_PARTITIONS) {
+            sqlite3ErrorMsg(parse, "number of partitions must be between 2 and %d",
+                            BDB_QUEUEDB_MAX_PARTITIONS);
+            return;
+        }
+        if (comdb2TokenToStr(&part->col, partcol, sizeof(partcol))) {
+            sqlite3ErrorMsg(parse, "partition column name is too long");
+            return;
+        }
+        /* Sequences are kept per queue, not per partition */
+        if (seq == 1) {
+            sqlite3ErrorMsg(parse, "WITH SEQUENCE is not supported with PARTITION BY");
+            return;
+        }
+        seq = 0;
+        for (Cdb2TrigTables *t = tbl; t; t = t->next) {
+            if (!table_has_column(t->table, partcol)) {
+                sqlite3ErrorMsg(parse, "no such partition column %s in table:%s",
+                                partcol, t->table->zName);
+                return;
+            }
+        }
+    }
+
     strbuf *s = strbuf_new();
+    if (part->n) {
+        strbuf_appendf(s, "partitions %d %s\n", part->n, partcol);
+    }
     while (tbl) {
         Table *table = tbl->table;
         Cdb2TrigEvents *events = tbl->events;
@@ -2455,6 +2455,10 @@ cmd ::= BULKIMPORT nm(A) DOT nm(B) nm(C) DOT nm(D). {
     comdb2bulkimport(pParse, &A, &B, &C, &D);
 }
 
+cmd ::= BULKIMPORT nm(T) dbnm(Y) FROM STRING(F). {
+    comdb2BulkLoad(pParse, &T, &Y, &F);
+}
+
 /////////////////////////////// TRUNCOPLOG TABLE ////////////////////////////////
 
 cmd ::= TRUNCOPLOG INTEGER(F). {
@@ -2640,12 +2644,12 @@ cmd ::= dryrun CREATE LUA AGGREGATE FUNCTION nm(Q). {
     comdb2CreateAggFunc(pParse, &Q);
 }
 
-cmd ::= dryrun CREATE trigger(T) nm(Q) withsequence(S) ON table_trigger_event(E). {
-    comdb2CreateTrigger(pParse,T,S,&Q,E);
+cmd ::= dryrun CREATE trigger(T) nm(Q) withsequence(S) withpartition(P) ON table_trigger_event(E). {
+    comdb2CreateTrigger(pParse,T,S,&P,&Q,E);
 }
 
-cmd ::= dryrun CREATE trigger(T) nm(Q) withsequence(S) FOR table_trigger_new_event(E). {
-    comdb2CreateTrigger(pParse,T,S,&Q,E);
+cmd ::= dryrun CREATE trigger(T) nm(Q) withsequence(S) withpartition(P) FOR table_trigger_new_event(E). {
+    comdb2CreateTrigger(pParse,T,S,&P,&Q,E);
 }
 
 %type trigger {int}
@@ -2674,6 +2678,14 @@ withsequence(A) ::= .                   { A = -1; }
 withsequence(A) ::= WITHOUT SEQUENCE.   { A = 0; }
 withsequence(A) ::= WITH SEQUENCE.      { A = 1; }
 
+%type withpartition {Cdb2TrigPartition}
+withpartition(A) ::= . { A.n = 0; A.col.z = 0; A.col.n = 0; }
+withpartition(A) ::= PARTITION BY nm(C) INTO INTEGER(N). {
+  A.col = C;
+  if (!readIntFromToken(&N, &A.n))
+    A.n = -1;
+}
+
 %type table_trigger_event {Cdb2TrigTables*}
 %destructor table_trigger_event {sqlite3DbFree(pParse->db, $$);}
 
@@ -1160,6 +1160,7 @@ typedef struct With With;
 typedef struct Cdb2TrigEvent Cdb2TrigEvent;
 typedef struct Cdb2TrigEvents Cdb2TrigEvents;
 typedef struct Cdb2TrigTables Cdb2TrigTables;
+typedef struct Cdb2TrigPartition Cdb2TrigPartition;
 typedef struct comdb2_ddl_context Cdb2DDL;
 #endif /* defined(SQLITE_BUILDING_FOR_COMDB2) */
 
@@ -5086,11 +5087,15 @@ struct Cdb2TrigTables {
   Cdb2TrigEvents *events;
   Cdb2TrigTables *next;
 };
+struct Cdb2TrigPartition {
+  Token col;   /* column hashed to pick a queue partition */
+  int n;       /* number of partitions, 0 if not partitioned */
+};
 struct schema_change_type;
 Cdb2TrigEvents *comdb2AddTriggerEvent(Parse*,Cdb2TrigEvents*,Cdb2TrigEvent*);
 void comdb2DropTrigger(Parse*,int,Token*);
 Cdb2TrigTables *comdb2AddTriggerTable(Parse*,Cdb2TrigTables*,SrcList*,Cdb2TrigEvents*);
-void comdb2CreateTrigger(Parse*,int,int,Token*,Cdb2TrigTables*);
+void comdb2CreateTrigger(Parse*,int,int,Cdb2TrigPartition*,Token*,Cdb2TrigTables*);
 
 void comdb2CreateScalarFunc(Parse *, Token *, int flags);
 void comdb2DropScalarFunc(Parse *, Token *);
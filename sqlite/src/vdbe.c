@@ -3036,6 +3036,7 @@ case OP_Column: {
 #if defined(SQLITE_BUILDING_FOR_COMDB2)
   i64 payloadSize64; /* Number of bytes in the record */
   int datacopy;
+  int nRun = 1;      /* Adjacent columns decoded together */
 #endif /* defined(SQLITE_BUILDING_FOR_COMDB2) */
   int p2;            /* column number to retrieve */
   VdbeCursor *pC;    /* The VDBE cursor */
@@ -3084,7 +3085,27 @@ case OP_Column: {
     else if( pC->isTable ){
       zData = (u8 *)sqlite3BtreeDataFetch(pCrsr, &pC->szRow);
       assert(zData != NULL);
-      rc = get_data(pCrsr, pCrsr->sc, (u8 *) zData, p2, pDest, 0, pCrsr->clnt->tzname);
+      /* Columns of a row are usually read by a run of OP_Column opcodes
+      ** on consecutive fields into consecutive registers; decode the
+      ** whole run at once.  Skip this if the cursor was remapped by a
+      ** deferred seek, as the following opcodes would be remapped too,
+      ** and end the run at any opcode with different flags or default. */
+      if( gbl_bulk_column_decode && pC==p->apCsr[pOp->p1] && p2==pOp->p2 ){
+        while( pOp[nRun].opcode==OP_Column
+            && pOp[nRun].p1==pOp->p1
+            && pOp[nRun].p2==p2+nRun
+            && pOp[nRun].p3==pOp->p3+nRun
+            && pOp[nRun].p5==pOp->p5
+            && pOp[nRun].p4type==pOp->p4type
+            && pOp[nRun].p4.p==pOp->p4.p
+            && p2+nRun<pCrsr->sc->nmembers ){
+          memAboutToChange(p, &pDest[nRun]);
+          sqlite3VdbeMemRelease(&pDest[nRun]);
+          nRun++;
+        }
+      }
+      rc = get_data_run(pCrsr, pCrsr->sc, (u8 *) zData, p2, nRun, pDest, 0,
+                        pCrsr->clnt->tzname);
     }else{
       datacopy = p2;
       if( is_datacopy(pCrsr, &datacopy) ){
@@ -3105,6 +3126,22 @@ case OP_Column: {
     pDest->db = p->db;
     pDest->enc = encoding;
     rc = sqlite3VdbeMemMakeWriteable(pDest);
+    while( rc==SQLITE_OK && nRun>1 ){
+      pDest->tz = p->tzname;
+      pDest->dtprec = p->dtprec;
+      UPDATE_MAX_BLOBSIZE(pDest);
+      REGISTER_TRACE(pOp->p3, pDest);
+      pOp++;
+      pDest++;
+      nRun--;
+      nVmStep++;
+#ifdef SQLITE_ENABLE_STMT_SCANSTATUS
+      if( p->anExec ) p->anExec[(int)(pOp-aOp)]++;
+#endif
+      pDest->db = p->db;
+      pDest->enc = encoding;
+      rc = sqlite3VdbeMemMakeWriteable(pDest);
+    }
     goto op_column_out;
   }
 
@@ -45,6 +45,7 @@ static int whereLoopResize(sqlite3*, WhereLoop*, int);
 #if defined(SQLITE_BUILDING_FOR_COMDB2)
 int gbl_disable_seekscan_optimization = 1;
 int gbl_sqlite_stat4_scan = 0;
+int gbl_hash_join = 0;
 
 int shard_check_parallelism(int iTable);
 int comdb2_shard_table_constraints(Parse *pParse, 
@@ -717,6 +718,35 @@ static int termCanDriveIndex(
 }
 #endif
 
+#if !defined(SQLITE_OMIT_AUTOMATIC_INDEX) && defined(SQLITE_BUILDING_FOR_COMDB2)
+/*
+** Return true if the automatic index driven by pTerm can be built as a
+** join hash: values of the column type hash the way they compare, and the
+** comparison uses BINARY collation.
+*/
+static int termCanDriveHash(
+  Parse *pParse,                 /* Parsing context */
+  WhereTerm *pTerm,              /* WHERE clause term to check */
+  struct SrcList_item *pSrc      /* Table we are trying to access */
+){
+  Expr *pX = pTerm->pExpr;
+  CollSeq *pColl;
+  if( !gbl_hash_join ) return 0;
+  switch( pSrc->pTab->aCol[pTerm->u.leftColumn].affinity ){
+    case SQLITE_AFF_BLOB:
+    case SQLITE_AFF_TEXT:
+    case SQLITE_AFF_NUMERIC:
+    case SQLITE_AFF_INTEGER:
+    case SQLITE_AFF_REAL:
+      break;
+    default:
+      return 0;
+  }
+  pColl = sqlite3BinaryCompareCollSeq(pParse, pX->pLeft, pX->pRight);
+  return pColl==0 || sqlite3StrICmp(pColl->zName, sqlite3StrBINARY)==0;
+}
+#endif /* !SQLITE_OMIT_AUTOMATIC_INDEX && SQLITE_BUILDING_FOR_COMDB2 */
+
 
 #ifndef SQLITE_OMIT_AUTOMATIC_INDEX
 /*
@@ -754,6 +784,9 @@ static void constructAutomaticIndex(
   struct SrcList_item *pTabItem;  /* FROM clause term being indexed */
   int addrCounter = 0;        /* Address where integer counter is initialized */
   int regBase;                /* Array of registers where record is assembled */
+#if defined(SQLITE_BUILDING_FOR_COMDB2)
+  int bHash = gbl_hash_join;  /* True if every key column can be hashed */
+#endif /* defined(SQLITE_BUILDING_FOR_COMDB2) */
 
   /* Generate code to skip over the creation and initialization of the
   ** transient index on 2nd and subsequent iterations of the loop. */
@@ -844,6 +877,9 @@ static void constructAutomaticIndex(
         pIdx->aiColumn[n] = pTerm->u.leftColumn;
         pColl = sqlite3BinaryCompareCollSeq(pParse, pX->pLeft, pX->pRight);
         pIdx->azColl[n] = pColl ? pColl->zName : sqlite3StrBINARY;
+#if defined(SQLITE_BUILDING_FOR_COMDB2)
+        if( bHash && !termCanDriveHash(pParse, pTerm, pSrc) ) bHash = 0;
+#endif /* defined(SQLITE_BUILDING_FOR_COMDB2) */
         n++;
       }
     }
@@ -875,6 +911,17 @@ static void constructAutomaticIndex(
   pLevel->iIdxCur = pParse->nTab++;
   sqlite3VdbeAddOp2(v, OP_OpenAutoindex, pLevel->iIdxCur, nKeyCol+1);
   sqlite3VdbeSetP4KeyInfo(pParse, pIdx);
+#if defined(SQLITE_BUILDING_FOR_COMDB2)
+  /* Only ever probed for equality on all key columns: build a join hash
+  ** instead of sorting the rows */
+  if( bHash ){
+    sqlite3VdbeChangeP5(v, BTREE_JOINHASH);
+    pLoop->wsFlags |= WHERE_HASH_INDEX;
+    pIdx->bUnordered = 1;
+  }else{
+    pLoop->wsFlags &= ~WHERE_HASH_INDEX;
+  }
+#endif /* defined(SQLITE_BUILDING_FOR_COMDB2) */
   VdbeComment((v, "for %s", pTable->zName));
 
   /* Fill the automatic index with content */
@@ -3008,6 +3055,12 @@ static int whereLoopAddBtree(
         ** those objects, since there is no opportunity to add schema
         ** indexes on subqueries and views. */
         pNew->rSetup = rLogSize + rSize;
+#if defined(SQLITE_BUILDING_FOR_COMDB2)
+        /* TUNING: A join hash is built in one pass, without the sort */
+        if( termCanDriveHash(pWInfo->pParse, pTerm, pSrc) ){
+          pNew->rSetup = rSize;
+        }
+#endif /* defined(SQLITE_BUILDING_FOR_COMDB2) */
         if( pTab->pSelect==0 && (pTab->tabFlags & TF_Ephemeral)==0 ){
           pNew->rSetup += 28;
         }else{
@@ -3022,6 +3075,13 @@ static int whereLoopAddBtree(
         pNew->nOut = 43;  assert( 43==sqlite3LogEst(20) );
         pNew->rRun = sqlite3LogEstAdd(rLogSize,pNew->nOut);
         pNew->wsFlags = WHERE_AUTO_INDEX;
+#if defined(SQLITE_BUILDING_FOR_COMDB2)
+        /* TUNING: A hash probe costs about two steps, whatever N is */
+        if( termCanDriveHash(pWInfo->pParse, pTerm, pSrc) ){
+          pNew->rRun = sqlite3LogEstAdd(10,pNew->nOut);
+          pNew->wsFlags |= WHERE_HASH_INDEX;
+        }
+#endif /* defined(SQLITE_BUILDING_FOR_COMDB2) */
         pNew->prereq = mPrereq | pTerm->prereqRight;
         rc = whereLoopInsert(pBuilder, pNew);
       }
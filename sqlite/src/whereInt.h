@@ -593,3 +593,6 @@ void sqlite3WhereTabFuncArgs(Parse*, struct SrcList_item*, WhereClause*);
 #define WHERE_PARTIALIDX   0x00020000  /* The automatic index is partial */
 #define WHERE_IN_EARLYOUT  0x00040000  /* Perhaps quit IN loops early */
 #define WHERE_IN_SEEKSCAN  0x00100000  /* Seek-scan optimization for IN */
+#if defined(SQLITE_BUILDING_FOR_COMDB2)
+#define WHERE_HASH_INDEX   0x00080000  /* The automatic index is a join hash */
+#endif /* defined(SQLITE_BUILDING_FOR_COMDB2) */
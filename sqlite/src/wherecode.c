@@ -169,6 +169,11 @@ int sqlite3WhereExplainOneScan(
         if( isSearch ){
           zFmt = "PRIMARY KEY";
         }
+#if defined(SQLITE_BUILDING_FOR_COMDB2)
+      }else if( flags & WHERE_HASH_INDEX ){
+        zFmt = (flags & WHERE_PARTIALIDX) ? "AUTOMATIC PARTIAL HASH INDEX"
+                                          : "AUTOMATIC HASH INDEX";
+#endif /* defined(SQLITE_BUILDING_FOR_COMDB2) */
       }else if( flags & WHERE_PARTIALIDX ){
         zFmt = "AUTOMATIC PARTIAL COVERING INDEX";
       }else if( flags & WHERE_AUTO_INDEX ){
@@ -0,0 +1,276 @@
+#!/usr/bin/env python3
+#
+# Decode a Parquet file written by cdb2_export and print it, so the test can
+# compare it with the table.  Only what cdb2_export writes is understood:
+# flat schemas of optional columns and PLAIN encoded v1 data pages,
+# uncompressed, gzip or lz4.
+#
+#   parquet_dump.py --schema file   one "name type [converted]" line a column
+#   parquet_dump.py file            rows, tab separated, ordered by the first
+#                                   column; NULL for nulls, blobs in hex,
+#                                   doubles as %.17g
+#
+# Row group statistics are checked against the values on the way.
+
+import struct
+import sys
+import zlib
+
+TYPES = {2: 'INT64', 5: 'DOUBLE', 6: 'BYTE_ARRAY'}
+CONVERTED = {0: 'UTF8', 10: 'TIMESTAMP_MICROS'}
+GZIP, LZ4_RAW = 2, 7
+
+
+def fail(msg):
+    sys.stderr.write('parquet_dump: %s\n' % msg)
+    sys.exit(1)
+
+
+class Compact:
+    """Thrift compact protocol; structs decode to dicts keyed by field id"""
+
+    def __init__(self, buf, pos=0):
+        self.buf = buf
+        self.pos = pos
+
+    def byte(self):
+        b = self.buf[self.pos]
+        self.pos += 1
+        return b
+
+    def varint(self):
+        v = shift = 0
+        while True:
+            b = self.byte()
+            v |= (b & 0x7f) << shift
+            shift += 7
+            if not b & 0x80:
+                return v
+
+    def zigzag(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def value(self, t):
+        if t in (1, 2):
+            return t == 1
+        if t == 3:
+            return struct.unpack('b', bytes([self.byte()]))[0]
+        if t in (4, 5, 6):
+            return self.zigzag()
+        if t == 7:
+            v = struct.unpack_from('<d', self.buf, self.pos)[0]
+            self.pos += 8
+            return v
+        if t == 8:
+            n = self.varint()
+            v = bytes(self.buf[self.pos:self.pos + n])
+            self.pos += n
+            return v
+        if t in (9, 10):
+            h = self.byte()
+            n = h >> 4
+            if n == 15:
+                n = self.varint()
+            return [self.value(h & 0x0f) for _ in range(n)]
+        if t == 12:
+            return self.struct()
+        fail('unexpected thrift type %d' % t)
+
+    def struct(self):
+        fields = {}
+        last = 0
+        while True:
+            h = self.byte()
+            if h == 0:
+                return fields
+            t = h & 0x0f
+            last = last + (h >> 4) if h >> 4 else self.zigzag()
+            fields[last] = self.value(t)
+
+
+def lz4_block(src):
+    out = bytearray()
+    i = 0
+    while i < len(src):
+        token = src[i]
+        i += 1
+        n = token >> 4
+        if n == 15:
+            while True:
+                n += src[i]
+                i += 1
+                if src[i - 1] != 255:
+                    break
+        out += src[i:i + n]
+        i += n
+        if i >= len(src):
+            break
+        offset = src[i] | src[i + 1] << 8
+        i += 2
+        n = token & 0x0f
+        if n == 15:
+            while True:
+                n += src[i]
+                i += 1
+                if src[i - 1] != 255:
+                    break
+        n += 4
+        start = len(out) - offset
+        if offset >= n:
+            out += out[start:start + n]
+        else:
+            for k in range(n):
+                out.append(out[start + k])
+    return bytes(out)
+
+
+def decompress(codec, data, size):
+    if codec == GZIP:
+        data = zlib.decompress(data, 16 + zlib.MAX_WBITS)
+    elif codec == LZ4_RAW:
+        data = lz4_block(data)
+    elif codec != 0:
+        fail('unexpected codec %d' % codec)
+    if len(data) != size:
+        fail('page is %d bytes, header says %d' % (len(data), size))
+    return data
+
+
+def def_levels(buf, count):
+    """RLE/bit-packed hybrid of width 1"""
+    r = Compact(buf)
+    levels = []
+    while len(levels) < count:
+        h = r.varint()
+        if h & 1:
+            for _ in range(h >> 1):
+                b = r.byte()
+                levels.extend((b >> k) & 1 for k in range(8))
+        else:
+            levels.extend([r.byte()] * (h >> 1))
+    return levels[:count]
+
+
+def plain_values(ptype, buf, count):
+    if ptype == 2:
+        return list(struct.unpack_from('<%dq' % count, buf))
+    if ptype == 5:
+        return list(struct.unpack_from('<%dd' % count, buf))
+    values = []
+    pos = 0
+    for _ in range(count):
+        n = struct.unpack_from('<I', buf, pos)[0]
+        values.append(bytes(buf[pos + 4:pos + 4 + n]))
+        pos += 4 + n
+    return values
+
+
+def plain_stat(ptype, raw):
+    if ptype == 2:
+        return struct.unpack('<q', raw)[0]
+    if ptype == 5:
+        return struct.unpack('<d', raw)[0]
+    return raw
+
+
+def read_chunk(data, chunk, ptype, name):
+    meta = chunk[3]
+    codec, nvalues = meta[4], meta[5]
+    pos = meta.get(11, meta[9])
+    end = pos + meta[7]
+    values = []
+    while pos < end:
+        r = Compact(data, pos)
+        header = r.struct()
+        pos = r.pos + header[3]
+        if header[1] != 0:
+            fail('%s: unexpected page type %d' % (name, header[1]))
+        dph = header[5]
+        if dph[2] != 0:
+            fail('%s: unexpected encoding %d' % (name, dph[2]))
+        page = decompress(codec, data[r.pos:pos], header[2])
+        n = struct.unpack_from('<I', page)[0]
+        levels = def_levels(page[4:4 + n], dph[1])
+        present = plain_values(ptype, page[4 + n:], sum(levels))
+        present.reverse()
+        values.extend(present.pop() if l else None for l in levels)
+    if pos != end or len(values) != nvalues:
+        fail('%s: chunk has %d values, metadata says %d' %
+             (name, len(values), nvalues))
+
+    stats = meta.get(12, {})
+    nulls = values.count(None)
+    if stats.get(3) != nulls:
+        fail('%s: %d nulls, statistics say %s' % (name, nulls, stats.get(3)))
+    if 5 in stats:
+        present = [v for v in values if v is not None and v == v]
+        if plain_stat(ptype, stats[6]) != min(present) or \
+                plain_stat(ptype, stats[5]) != max(present):
+            fail('%s: wrong min/max statistics' % name)
+    return values
+
+
+def main():
+    args = sys.argv[1:]
+    schema_only = args[:1] == ['--schema']
+    if schema_only:
+        args = args[1:]
+    if len(args) != 1:
+        fail('usage: parquet_dump.py [--schema] file')
+
+    with open(args[0], 'rb') as f:
+        data = f.read()
+    if data[:4] != b'PAR1' or data[-4:] != b'PAR1':
+        fail('no PAR1 magic')
+    footer_len = struct.unpack_from('<I', data, len(data) - 8)[0]
+    meta = Compact(data, len(data) - 8 - footer_len).struct()
+
+    cols = meta[2][1:]
+    if meta[2][0].get(5) != len(cols):
+        fail('schema root has %s children, not %d' %
+             (meta[2][0].get(5), len(cols)))
+    if schema_only:
+        for c in cols:
+            line = [c[4].decode(), TYPES.get(c[1], str(c[1]))]
+            if 6 in c:
+                line.append(CONVERTED.get(c[6], str(c[6])))
+            print(' '.join(line))
+        return
+
+    rows = []
+    for rg in meta.get(4, []):
+        if len(rg[1]) != len(cols):
+            fail('row group has %d columns, schema %d' %
+                 (len(rg[1]), len(cols)))
+        columns = [read_chunk(data, chunk, c[1], c[4].decode())
+                   for chunk, c in zip(rg[1], cols)]
+        for col in columns:
+            if len(col) != rg[3]:
+                fail('row group has %d rows, a column has %d' %
+                     (rg[3], len(col)))
+        rows.extend(zip(*columns))
+    if len(rows) != meta[3]:
+        fail('%d rows, footer says %d' % (len(rows), meta[3]))
+
+    rows.sort(key=lambda row: row[0])
+    out = sys.stdout.buffer
+    for row in rows:
+        fields = []
+        for c, v in zip(cols, row):
+            if v is None:
+                fields.append(b'NULL')
+            elif c[1] == 5:
+                fields.append(b'%.17g' % v)
+            elif c[1] == 6 and c.get(6) == 0:
+                v.decode('utf-8')  # fails if it isn't
+                fields.append(v)
+            elif c[1] == 6:
+                fields.append(v.hex().upper().encode())
+            else:
+                fields.append(b'%d' % v)
+        out.write(b'\t'.join(fields) + b'\n')
+
+
+if __name__ == '__main__':
+    main()
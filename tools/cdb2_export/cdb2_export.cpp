@@ -0,0 +1,527 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Comdb2 tool to export a table to a Parquet file
+ *
+ * The table is split into ranges of an integer column (by default the
+ * leading column of its first index), and each range is read by its own
+ * connection.  Every connection reads from a snapshot of the database as of
+ * the same second, so the file is consistent even though the table is read
+ * in pieces.  Each thread turns its rows into compressed row groups, which
+ * are appended to a single file as they fill.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include "cdb2api.h"
+#include "parquet_writer.h"
+
+static const char *usage_text =
+    "Usage: cdb2_export [options] dbname table FILE\n"
+    "\n"
+    "Export a table to a Parquet file.\n"
+    "\n"
+    "Options:\n"
+    "  -c, --cdb2cfg FILE       Set the config file to FILE\n"
+    "  -t, --type TYPE          Database type or tier (default: default)\n"
+    "  -j, --threads N          Read the table with N connections (default: 4)\n"
+    "  -k, --split-by COLUMN    Integer column to split the table on (default:\n"
+    "                           the leading column of the first index)\n"
+    "  -w, --where CONDITION    Only export rows matching CONDITION\n"
+    "  -r, --row-group-rows N   Rows per row group (default: 100000)\n"
+    "  -z, --compression CODEC  none, gzip or lz4 (default: gzip)\n"
+    "  -n, --no-snapshot        Don't read from a snapshot; the threads may\n"
+    "                           then see different versions of the table\n"
+    "  -v, --verbose            Report progress\n"
+    "\n"
+    "The snapshot needs the database to run with snapshot isolation enabled.\n";
+
+struct options {
+    std::string dbname;
+    std::string table;
+    std::string path;
+    std::string type = "default";
+    std::string split_by;
+    std::string where;
+    int threads = 4;
+    int64_t row_group_rows = 100000;
+    parquet::Codec codec = parquet::GZIP;
+    bool snapshot = true;
+    bool verbose = false;
+};
+
+static options opts;
+static std::string asof; /* snapshot datetime, if any */
+
+static std::mutex err_lock;
+static std::string err;
+static std::atomic<bool> failed(false);
+
+static void usage()
+{
+    std::cerr << usage_text;
+    exit(EXIT_FAILURE);
+}
+
+static std::string quote_name(const std::string &name)
+{
+    std::string q = "\"";
+    for (char c : name) {
+        if (c == '"')
+            q += '"';
+        q += c;
+    }
+    return q + "\"";
+}
+
+/* A connection to the database, optionally inside the export snapshot */
+class Connection {
+    cdb2_hndl_tp *m_hndl;
+
+public:
+    Connection() : m_hndl(nullptr)
+    {
+        int rc = cdb2_open(&m_hndl, opts.dbname.c_str(), opts.type.c_str(), 0);
+        if (rc) {
+            std::string msg = cdb2_errstr(m_hndl);
+            cdb2_close(m_hndl);
+            throw std::runtime_error("cdb2_open failed: " + msg);
+        }
+        /* datetimes are exported as UTC timestamps */
+        run("set timezone UTC");
+    }
+
+    ~Connection() { cdb2_close(m_hndl); }
+
+    cdb2_hndl_tp *hndl() { return m_hndl; }
+
+    /* run a statement, leaving its rows to be read */
+    void run(const std::string &sql)
+    {
+        int rc = cdb2_run_statement(m_hndl, sql.c_str());
+        if (rc)
+            throw std::runtime_error(sql + ": " + cdb2_errstr(m_hndl));
+    }
+
+    /* run a statement and discard its rows */
+    void exec(const std::string &sql)
+    {
+        run(sql);
+        while (next())
+            ;
+    }
+
+    bool next()
+    {
+        int rc = cdb2_next_record(m_hndl);
+        if (rc == CDB2_OK)
+            return true;
+        if (rc == CDB2_OK_DONE)
+            return false;
+        throw std::runtime_error(std::string("cdb2_next_record: ") +
+                                 cdb2_errstr(m_hndl));
+    }
+
+    void begin()
+    {
+        if (asof.empty())
+            return;
+        run("set transaction snapshot isolation");
+        exec("begin transaction as of datetime " + asof);
+    }
+
+    void end()
+    {
+        if (!asof.empty())
+            exec("commit");
+    }
+};
+
+static void set_error(const std::string &msg)
+{
+    std::lock_guard<std::mutex> guard(err_lock);
+    if (!failed) {
+        err = msg;
+        failed = true;
+    }
+}
+
+/* Pick the snapshot: a whole second which has already passed */
+static void pick_snapshot(Connection &conn)
+{
+    conn.run("select now()");
+    if (!conn.next())
+        throw std::runtime_error("select now() returned no rows");
+    cdb2_client_datetime_t *dt =
+        (cdb2_client_datetime_t *)cdb2_column_value(conn.hndl(), 0);
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d%02d%02d",
+             dt->tm.tm_year + 1900, dt->tm.tm_mon + 1, dt->tm.tm_mday,
+             dt->tm.tm_hour, dt->tm.tm_min, dt->tm.tm_sec);
+    asof = buf;
+    while (conn.next())
+        ;
+    sleep(1);
+}
+
+static std::string default_split_column(Connection &conn)
+{
+    std::string col;
+    cdb2_bind_param(conn.hndl(), "tbl", CDB2_CSTRING, opts.table.c_str(),
+                    opts.table.size());
+    conn.run("select kc.columnname from comdb2_keys k, comdb2_keycomponents kc "
+             "where k.tablename = @tbl and kc.tablename = k.tablename and "
+             "kc.keyname = k.keyname order by k.keynumber, kc.columnnumber "
+             "limit 1");
+    if (conn.next())
+        col = (const char *)cdb2_column_value(conn.hndl(), 0);
+    while (conn.next())
+        ;
+    cdb2_clearbindings(conn.hndl());
+    return col;
+}
+
+static std::vector<parquet::Column> table_columns(Connection &conn)
+{
+    std::vector<parquet::Column> cols;
+
+    conn.run("select * from " + quote_name(opts.table) + " limit 0");
+    for (int i = 0; i < cdb2_numcolumns(conn.hndl()); i++) {
+        parquet::Column col;
+        col.name = cdb2_column_name(conn.hndl(), i);
+        col.converted = parquet::NONE;
+        switch (cdb2_column_type(conn.hndl(), i)) {
+        case CDB2_INTEGER:
+        case CDB2_INTERVALYM:
+        case CDB2_INTERVALDS:
+        case CDB2_INTERVALDSUS:
+            col.type = parquet::INT64;
+            break;
+        case CDB2_REAL:
+            col.type = parquet::DOUBLE;
+            break;
+        case CDB2_CSTRING:
+            col.type = parquet::BYTE_ARRAY;
+            col.converted = parquet::UTF8;
+            break;
+        case CDB2_BLOB:
+            col.type = parquet::BYTE_ARRAY;
+            break;
+        case CDB2_DATETIME:
+        case CDB2_DATETIMEUS:
+            col.type = parquet::INT64;
+            col.converted = parquet::TIMESTAMP_MICROS;
+            break;
+        default:
+            throw std::runtime_error("column " + col.name +
+                                     " has an unsupported type");
+        }
+        cols.push_back(col);
+    }
+    while (conn.next())
+        ;
+    return cols;
+}
+
+/* The where clauses of each thread's share of the table */
+static std::vector<std::string> split_table(Connection &conn)
+{
+    std::vector<std::string> parts;
+    std::string col = opts.split_by;
+    std::string filter = opts.where.empty() ? "" : "(" + opts.where + ")";
+
+    if (col.empty() && opts.threads > 1)
+        col = default_split_column(conn);
+    if (col.empty() || opts.threads == 1) {
+        parts.push_back(filter);
+        return parts;
+    }
+
+    std::string qcol = quote_name(col);
+    conn.run("select min(" + qcol + "), max(" + qcol + ") from " +
+             quote_name(opts.table) +
+             (filter.empty() ? "" : " where " + filter));
+    if (!conn.next())
+        throw std::runtime_error("cannot find the range of " + col);
+    int64_t *pmin = (int64_t *)cdb2_column_value(conn.hndl(), 0);
+    int64_t *pmax = (int64_t *)cdb2_column_value(conn.hndl(), 1);
+    bool integer = cdb2_column_type(conn.hndl(), 0) == CDB2_INTEGER;
+    int64_t min = pmin ? *pmin : 0, max = pmax ? *pmax : 0;
+    while (conn.next())
+        ;
+
+    if (!integer || !pmin) {
+        if (opts.verbose)
+            std::cerr << "not splitting on " << col
+                      << ", which is empty or not an integer" << std::endl;
+        parts.push_back(filter);
+        return parts;
+    }
+
+    /* rows with a null split column go to the first thread */
+    std::string and_filter = filter.empty() ? "" : " and " + filter;
+    __int128 span = (__int128)max - min + 1;
+    int64_t lo = min;
+    for (int i = 0; i < opts.threads; i++) {
+        std::ostringstream where;
+        int64_t hi = (int64_t)(min + span * (i + 1) / opts.threads);
+        if (i == 0)
+            where << "(" << qcol << " is null or " << qcol << " < " << hi
+                  << ")";
+        else if (i == opts.threads - 1)
+            where << qcol << " >= " << lo;
+        else
+            where << qcol << " >= " << lo << " and " << qcol << " < " << hi;
+        where << and_filter;
+        parts.push_back(where.str());
+        lo = hi;
+    }
+    return parts;
+}
+
+static int64_t to_micros(const cdb2_tm_t &t, int64_t frac_usec)
+{
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_sec = t.tm_sec;
+    tm.tm_min = t.tm_min;
+    tm.tm_hour = t.tm_hour;
+    tm.tm_mday = t.tm_mday;
+    tm.tm_mon = t.tm_mon;
+    tm.tm_year = t.tm_year;
+    return (int64_t)timegm(&tm) * 1000000 + frac_usec;
+}
+
+static void append_value(Connection &conn, int i,
+                         parquet::ColumnChunkBuilder &col)
+{
+    void *val = cdb2_column_value(conn.hndl(), i);
+    if (val == nullptr) {
+        col.append_null();
+        return;
+    }
+
+    switch (cdb2_column_type(conn.hndl(), i)) {
+    case CDB2_INTEGER:
+        col.append_int64(*(int64_t *)val);
+        break;
+    case CDB2_REAL:
+        col.append_double(*(double *)val);
+        break;
+    case CDB2_CSTRING:
+        col.append_bytes(val, strnlen((const char *)val,
+                                      cdb2_column_size(conn.hndl(), i)));
+        break;
+    case CDB2_BLOB:
+        col.append_bytes(val, cdb2_column_size(conn.hndl(), i));
+        break;
+    case CDB2_DATETIME: {
+        cdb2_client_datetime_t *dt = (cdb2_client_datetime_t *)val;
+        col.append_int64(to_micros(dt->tm, dt->msec * 1000));
+        break;
+    }
+    case CDB2_DATETIMEUS: {
+        cdb2_client_datetimeus_t *dt = (cdb2_client_datetimeus_t *)val;
+        col.append_int64(to_micros(dt->tm, dt->usec));
+        break;
+    }
+    case CDB2_INTERVALYM: {
+        cdb2_client_intv_ym_t *ym = (cdb2_client_intv_ym_t *)val;
+        col.append_int64(ym->sign * ((int64_t)ym->years * 12 + ym->months));
+        break;
+    }
+    case CDB2_INTERVALDS: {
+        cdb2_client_intv_ds_t *ds = (cdb2_client_intv_ds_t *)val;
+        int64_t sec = ((int64_t)ds->days * 24 + ds->hours) * 3600 +
+                      ds->mins * 60 + ds->sec;
+        col.append_int64(ds->sign * (sec * 1000000 + ds->msec * 1000));
+        break;
+    }
+    case CDB2_INTERVALDSUS: {
+        cdb2_client_intv_dsus_t *ds = (cdb2_client_intv_dsus_t *)val;
+        int64_t sec = ((int64_t)ds->days * 24 + ds->hours) * 3600 +
+                      ds->mins * 60 + ds->sec;
+        col.append_int64(ds->sign * (sec * 1000000 + ds->usec));
+        break;
+    }
+    default:
+        throw std::runtime_error("unexpected column type");
+    }
+}
+
+static void export_part(parquet::Writer *writer,
+                        const std::vector<parquet::Column> *cols,
+                        std::string where)
+{
+    try {
+        Connection conn;
+        parquet::RowGroupBuilder rg(*cols, opts.codec);
+        int64_t nrows = 0;
+
+        conn.begin();
+        conn.run("select * from " + quote_name(opts.table) +
+                 (where.empty() ? "" : " where " + where));
+        if ((size_t)cdb2_numcolumns(conn.hndl()) != cols->size())
+            throw std::runtime_error("table schema changed during export");
+
+        while (!failed && conn.next()) {
+            for (size_t i = 0; i < cols->size(); i++)
+                append_value(conn, i, rg.column(i));
+            rg.end_row();
+            if (rg.num_rows() == opts.row_group_rows) {
+                rg.finish();
+                writer->write_row_group(rg);
+                nrows += rg.num_rows();
+                rg.reset();
+            }
+        }
+        if (failed)
+            return;
+        if (rg.num_rows() > 0) {
+            rg.finish();
+            writer->write_row_group(rg);
+            nrows += rg.num_rows();
+        }
+        conn.end();
+
+        if (opts.verbose)
+            std::cerr << "exported " << nrows << " rows"
+                      << (where.empty() ? "" : " where " + where) << std::endl;
+    } catch (std::exception &e) {
+        set_error(e.what());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static struct option long_options[] = {
+        {"cdb2cfg", required_argument, NULL, 'c'},
+        {"type", required_argument, NULL, 't'},
+        {"threads", required_argument, NULL, 'j'},
+        {"split-by", required_argument, NULL, 'k'},
+        {"where", required_argument, NULL, 'w'},
+        {"row-group-rows", required_argument, NULL, 'r'},
+        {"compression", required_argument, NULL, 'z'},
+        {"no-snapshot", no_argument, NULL, 'n'},
+        {"verbose", no_argument, NULL, 'v'},
+        {"help", no_argument, NULL, 'h'},
+        {0, 0, 0, 0}};
+    int c;
+
+    while ((c = getopt_long(argc, argv, "c:t:j:k:w:r:z:nvh", long_options,
+                            NULL)) != -1) {
+        switch (c) {
+        case 'c':
+            cdb2_set_comdb2db_config(optarg);
+            break;
+        case 't':
+            opts.type = optarg;
+            break;
+        case 'j':
+            opts.threads = atoi(optarg);
+            break;
+        case 'k':
+            opts.split_by = optarg;
+            break;
+        case 'w':
+            opts.where = optarg;
+            break;
+        case 'r':
+            opts.row_group_rows = atoll(optarg);
+            break;
+        case 'z':
+            if (strcmp(optarg, "none") == 0)
+                opts.codec = parquet::UNCOMPRESSED;
+            else if (strcmp(optarg, "gzip") == 0)
+                opts.codec = parquet::GZIP;
+            else if (strcmp(optarg, "lz4") == 0)
+                opts.codec = parquet::LZ4_RAW;
+            else
+                usage();
+            break;
+        case 'n':
+            opts.snapshot = false;
+            break;
+        case 'v':
+            opts.verbose = true;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (argc - optind != 3 || opts.threads < 1 || opts.row_group_rows < 1)
+        usage();
+    opts.dbname = argv[optind];
+    opts.table = argv[optind + 1];
+    opts.path = argv[optind + 2];
+
+    bool created = false;
+    try {
+        std::vector<parquet::Column> cols;
+        std::vector<std::string> parts;
+        {
+            Connection conn;
+            if (opts.snapshot)
+                pick_snapshot(conn);
+            conn.begin();
+            cols = table_columns(conn);
+            parts = split_table(conn);
+            conn.end();
+        }
+
+        parquet::Writer writer(opts.path, cols, opts.codec);
+        created = true;
+        writer.add_metadata("comdb2.dbname", opts.dbname);
+        writer.add_metadata("comdb2.table", opts.table);
+        if (!asof.empty())
+            writer.add_metadata("comdb2.snapshot", asof + " UTC");
+
+        std::vector<std::thread> threads;
+        for (const std::string &where : parts)
+            threads.emplace_back(export_part, &writer, &cols, where);
+        for (std::thread &t : threads)
+            t.join();
+        if (failed)
+            throw std::runtime_error(err);
+
+        writer.close();
+        std::cout << "exported " << writer.num_rows() << " rows in "
+                  << writer.num_row_groups() << " row groups to " << opts.path
+                  << std::endl;
+    } catch (std::exception &e) {
+        std::cerr << "cdb2_export: " << e.what() << std::endl;
+        if (created)
+            unlink(opts.path.c_str());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
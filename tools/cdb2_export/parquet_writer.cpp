@@ -0,0 +1,511 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "parquet_writer.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <lz4.h>
+#include <zlib.h>
+
+namespace parquet {
+
+/* data pages are cut once their values reach this size */
+static const size_t PAGE_SIZE = 1024 * 1024;
+
+/* longer byte array values leave a chunk without min and max statistics */
+static const size_t MAX_STAT_SIZE = 256;
+
+enum { PAGE_DATA = 0 };
+enum { ENCODING_PLAIN = 0, ENCODING_RLE = 3 };
+enum { REPETITION_OPTIONAL = 1 };
+
+/* Thrift compact protocol, just enough of it for the Parquet metadata */
+class CompactWriter {
+    std::string &m_out;
+    std::vector<int16_t> m_stack;
+    int16_t m_last;
+
+public:
+    enum {
+        T_I32 = 5,
+        T_I64 = 6,
+        T_BINARY = 8,
+        T_LIST = 9,
+        T_STRUCT = 12
+    };
+
+    explicit CompactWriter(std::string &out) : m_out(out), m_last(0) {}
+
+    void varint(uint64_t v)
+    {
+        while (v >= 0x80) {
+            m_out.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        m_out.push_back((char)v);
+    }
+
+    void zigzag(int64_t v) { varint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63)); }
+
+    void field(int16_t id, int type)
+    {
+        if (id > m_last && id - m_last <= 15) {
+            m_out.push_back((char)(((id - m_last) << 4) | type));
+        } else {
+            m_out.push_back((char)type);
+            zigzag(id);
+        }
+        m_last = id;
+    }
+
+    void i32(int16_t id, int32_t v) { field(id, T_I32); zigzag(v); }
+    void i64(int16_t id, int64_t v) { field(id, T_I64); zigzag(v); }
+
+    void binary(int16_t id, const std::string &v)
+    {
+        field(id, T_BINARY);
+        varint(v.size());
+        m_out.append(v);
+    }
+
+    void list(int16_t id, int elemtype, size_t size)
+    {
+        field(id, T_LIST);
+        if (size < 15) {
+            m_out.push_back((char)((size << 4) | elemtype));
+        } else {
+            m_out.push_back((char)(0xf0 | elemtype));
+            varint(size);
+        }
+    }
+
+    /* list elements */
+    void list_i32(int32_t v) { zigzag(v); }
+    void list_binary(const std::string &v)
+    {
+        varint(v.size());
+        m_out.append(v);
+    }
+
+    /* a struct field, or a struct list element if id is 0 */
+    void begin_struct(int16_t id = 0)
+    {
+        if (id)
+            field(id, T_STRUCT);
+        m_stack.push_back(m_last);
+        m_last = 0;
+    }
+
+    void end_struct()
+    {
+        m_out.push_back(0);
+        m_last = m_stack.back();
+        m_stack.pop_back();
+    }
+
+    /* end of the outermost struct */
+    void stop() { m_out.push_back(0); }
+};
+
+static void put_le32(std::string &out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++, v >>= 8)
+        out.push_back((char)(v & 0xff));
+}
+
+static void put_le64(std::string &out, uint64_t v)
+{
+    for (int i = 0; i < 8; i++, v >>= 8)
+        out.push_back((char)(v & 0xff));
+}
+
+static void compress(Codec codec, const std::string &in, std::string &out)
+{
+    switch (codec) {
+    case UNCOMPRESSED:
+        out = in;
+        return;
+
+    case GZIP: {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        /* windowBits + 16 writes a gzip header, as Parquet requires */
+        if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("deflateInit2 failed");
+        out.resize(deflateBound(&zs, in.size()));
+        zs.next_in = (Bytef *)in.data();
+        zs.avail_in = in.size();
+        zs.next_out = (Bytef *)&out[0];
+        zs.avail_out = out.size();
+        int rc = deflate(&zs, Z_FINISH);
+        deflateEnd(&zs);
+        if (rc != Z_STREAM_END)
+            throw std::runtime_error("deflate failed");
+        out.resize(zs.total_out);
+        return;
+    }
+
+    case LZ4_RAW: {
+        out.resize(LZ4_compressBound(in.size()));
+        int len = LZ4_compress_default(in.data(), &out[0], in.size(),
+                                       out.size());
+        if (len <= 0)
+            throw std::runtime_error("LZ4_compress_default failed");
+        out.resize(len);
+        return;
+    }
+    }
+    throw std::runtime_error("unknown codec");
+}
+
+static void write_statistics(CompactWriter &w, int16_t id,
+                             const ColumnChunkBuilder &chunk)
+{
+    std::string min, max;
+
+    w.begin_struct(id);
+    w.i64(3, chunk.null_count());
+    if (chunk.min_max(min, max)) {
+        w.binary(5, max);
+        w.binary(6, min);
+    }
+    w.end_struct();
+}
+
+ColumnChunkBuilder::ColumnChunkBuilder(const Column &col, Codec codec)
+    : m_col(col), m_codec(codec)
+{
+    reset();
+}
+
+void ColumnChunkBuilder::reset()
+{
+    m_deflevels.clear();
+    m_values.clear();
+    m_page_values = 0;
+    m_pages.clear();
+    m_uncompressed_size = 0;
+    m_num_values = 0;
+    m_null_count = 0;
+    m_has_minmax = false;
+    m_minmax_valid = true;
+}
+
+void ColumnChunkBuilder::append_null()
+{
+    m_deflevels.push_back(0);
+    m_page_values++;
+    m_num_values++;
+    m_null_count++;
+}
+
+void ColumnChunkBuilder::append_int64(int64_t v)
+{
+    m_deflevels.push_back(1);
+    put_le64(m_values, v);
+    if (!m_has_minmax || v < m_min_i)
+        m_min_i = v;
+    if (!m_has_minmax || v > m_max_i)
+        m_max_i = v;
+    m_has_minmax = true;
+    m_page_values++;
+    m_num_values++;
+    if (m_values.size() >= PAGE_SIZE)
+        flush_page();
+}
+
+void ColumnChunkBuilder::append_double(double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    m_deflevels.push_back(1);
+    put_le64(m_values, bits);
+    /* NaN has no place in the order, and is left out of min and max */
+    if (!std::isnan(v)) {
+        if (!m_has_minmax || v < m_min_d)
+            m_min_d = v;
+        if (!m_has_minmax || v > m_max_d)
+            m_max_d = v;
+        m_has_minmax = true;
+    }
+    m_page_values++;
+    m_num_values++;
+    if (m_values.size() >= PAGE_SIZE)
+        flush_page();
+}
+
+void ColumnChunkBuilder::append_bytes(const void *data, size_t len)
+{
+    m_deflevels.push_back(1);
+    put_le32(m_values, len);
+    m_values.append((const char *)data, len);
+    if (len > MAX_STAT_SIZE) {
+        m_minmax_valid = false;
+    } else if (m_minmax_valid) {
+        /* byte arrays order as unsigned bytes */
+        std::string v((const char *)data, len);
+        if (!m_has_minmax || v < m_min_s)
+            m_min_s = v;
+        if (!m_has_minmax || v > m_max_s)
+            m_max_s = v;
+        m_has_minmax = true;
+    }
+    m_page_values++;
+    m_num_values++;
+    if (m_values.size() >= PAGE_SIZE)
+        flush_page();
+}
+
+bool ColumnChunkBuilder::min_max(std::string &min, std::string &max) const
+{
+    if (!m_has_minmax || !m_minmax_valid)
+        return false;
+    min.clear();
+    max.clear();
+    switch (m_col.type) {
+    case INT64:
+        put_le64(min, m_min_i);
+        put_le64(max, m_max_i);
+        break;
+    case DOUBLE: {
+        uint64_t bits;
+        memcpy(&bits, &m_min_d, sizeof(bits));
+        put_le64(min, bits);
+        memcpy(&bits, &m_max_d, sizeof(bits));
+        put_le64(max, bits);
+        break;
+    }
+    case BYTE_ARRAY:
+        min = m_min_s;
+        max = m_max_s;
+        break;
+    }
+    return true;
+}
+
+/* Cut a v1 data page: the definition levels as a single bit-packed run of
+ * width 1, then the non-null values */
+void ColumnChunkBuilder::flush_page()
+{
+    if (m_page_values == 0)
+        return;
+
+    std::string body, levels, compressed;
+    size_t ngroups = (m_deflevels.size() + 7) / 8;
+
+    CompactWriter lw(levels);
+    lw.varint((ngroups << 1) | 1);
+    for (size_t g = 0; g < ngroups; g++) {
+        uint8_t byte = 0;
+        for (size_t i = 0; i < 8 && g * 8 + i < m_deflevels.size(); i++)
+            byte |= m_deflevels[g * 8 + i] << i;
+        levels.push_back((char)byte);
+    }
+    put_le32(body, levels.size());
+    body.append(levels);
+    body.append(m_values);
+
+    compress(m_codec, body, compressed);
+
+    std::string header;
+    CompactWriter w(header);
+    w.i32(1, PAGE_DATA);
+    w.i32(2, body.size());
+    w.i32(3, compressed.size());
+    w.begin_struct(5);
+    w.i32(1, m_page_values);
+    w.i32(2, ENCODING_PLAIN);
+    w.i32(3, ENCODING_RLE);
+    w.i32(4, ENCODING_RLE);
+    w.end_struct();
+    w.stop();
+
+    m_pages.append(header);
+    m_pages.append(compressed);
+    m_uncompressed_size += header.size() + body.size();
+
+    m_deflevels.clear();
+    m_values.clear();
+    m_page_values = 0;
+}
+
+void ColumnChunkBuilder::finish() { flush_page(); }
+
+RowGroupBuilder::RowGroupBuilder(const std::vector<Column> &columns,
+                                 Codec codec)
+    : m_num_rows(0)
+{
+    m_columns.reserve(columns.size());
+    for (const Column &col : columns)
+        m_columns.emplace_back(col, codec);
+}
+
+void RowGroupBuilder::finish()
+{
+    for (ColumnChunkBuilder &c : m_columns)
+        c.finish();
+}
+
+void RowGroupBuilder::reset()
+{
+    for (ColumnChunkBuilder &c : m_columns)
+        c.reset();
+    m_num_rows = 0;
+}
+
+Writer::Writer(const std::string &path, const std::vector<Column> &columns,
+               Codec codec)
+    : m_columns(columns), m_codec(codec), m_file(NULL), m_offset(0),
+      m_num_row_groups(0), m_num_rows(0)
+{
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file)
+        throw std::runtime_error("cannot open " + path + ": " +
+                                 std::strerror(errno));
+    write("PAR1");
+}
+
+Writer::~Writer()
+{
+    if (m_file)
+        std::fclose(m_file);
+}
+
+void Writer::write(const std::string &data)
+{
+    if (std::fwrite(data.data(), 1, data.size(), m_file) != data.size())
+        throw std::runtime_error(std::string("write failed: ") +
+                                 std::strerror(errno));
+    m_offset += data.size();
+}
+
+void Writer::add_metadata(const std::string &key, const std::string &value)
+{
+    m_metadata.push_back(std::make_pair(key, value));
+}
+
+void Writer::write_row_group(RowGroupBuilder &rg)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    int64_t total_uncompressed = 0;
+
+    /* columns may go anywhere; their offsets are in the footer */
+    std::vector<int64_t> offsets;
+    for (size_t i = 0; i < rg.num_columns(); i++) {
+        offsets.push_back(m_offset);
+        write(rg.column(i).pages());
+        total_uncompressed += rg.column(i).uncompressed_size();
+    }
+
+    CompactWriter w(m_row_groups);
+    w.begin_struct();
+    w.list(1, CompactWriter::T_STRUCT, rg.num_columns());
+    for (size_t i = 0; i < rg.num_columns(); i++) {
+        const ColumnChunkBuilder &chunk = rg.column(i);
+        const Column &col = m_columns[i];
+
+        w.begin_struct();
+        w.i64(2, offsets[i]);
+        w.begin_struct(3);
+        w.i32(1, col.type);
+        w.list(2, CompactWriter::T_I32, 2);
+        w.list_i32(ENCODING_PLAIN);
+        w.list_i32(ENCODING_RLE);
+        w.list(3, CompactWriter::T_BINARY, 1);
+        w.list_binary(col.name);
+        w.i32(4, m_codec);
+        w.i64(5, chunk.num_values());
+        w.i64(6, chunk.uncompressed_size());
+        w.i64(7, chunk.pages().size());
+        w.i64(9, offsets[i]);
+        write_statistics(w, 12, chunk);
+        w.end_struct();
+        w.end_struct();
+    }
+    w.i64(2, total_uncompressed);
+    w.i64(3, rg.num_rows());
+    w.end_struct();
+
+    m_num_row_groups++;
+    m_num_rows += rg.num_rows();
+}
+
+void Writer::close()
+{
+    std::string footer;
+    CompactWriter w(footer);
+
+    w.i32(1, 1);
+
+    w.list(2, CompactWriter::T_STRUCT, m_columns.size() + 1);
+    w.begin_struct();
+    w.binary(4, "schema");
+    w.i32(5, m_columns.size());
+    w.end_struct();
+    for (const Column &col : m_columns) {
+        w.begin_struct();
+        w.i32(1, col.type);
+        w.i32(3, REPETITION_OPTIONAL);
+        w.binary(4, col.name);
+        if (col.converted != NONE)
+            w.i32(6, col.converted);
+        w.end_struct();
+    }
+
+    w.i64(3, m_num_rows);
+
+    w.list(4, CompactWriter::T_STRUCT, m_num_row_groups);
+    footer.append(m_row_groups);
+
+    if (!m_metadata.empty()) {
+        w.list(5, CompactWriter::T_STRUCT, m_metadata.size());
+        for (const auto &kv : m_metadata) {
+            w.begin_struct();
+            w.binary(1, kv.first);
+            w.binary(2, kv.second);
+            w.end_struct();
+        }
+    }
+    w.binary(6, "cdb2_export");
+
+    /* the statistics use the type-defined order of each column */
+    w.list(7, CompactWriter::T_STRUCT, m_columns.size());
+    for (size_t i = 0; i < m_columns.size(); i++) {
+        w.begin_struct();
+        w.begin_struct(1);
+        w.end_struct();
+        w.end_struct();
+    }
+    w.stop();
+
+    std::string tail;
+    put_le32(tail, footer.size());
+    tail.append("PAR1");
+    write(footer);
+    write(tail);
+
+    if (std::fclose(m_file))
+        throw std::runtime_error(std::string("close failed: ") +
+                                 std::strerror(errno));
+    m_file = NULL;
+}
+
+} // namespace parquet
@@ -0,0 +1,143 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef INCLUDED_PARQUET_WRITER_H
+#define INCLUDED_PARQUET_WRITER_H
+
+/*
+ * A minimal Parquet file writer: flat schemas of optional columns, PLAIN
+ * encoded data pages, per-column compression and row group statistics.
+ * Row groups are built independently (one builder per thread) and appended
+ * to the file in whatever order they complete.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace parquet {
+
+/* physical types, as in parquet.thrift */
+enum Type { INT64 = 2, DOUBLE = 5, BYTE_ARRAY = 6 };
+
+/* converted types, as in parquet.thrift */
+enum ConvertedType { NONE = -1, UTF8 = 0, TIMESTAMP_MICROS = 10 };
+
+enum Codec { UNCOMPRESSED = 0, GZIP = 2, LZ4_RAW = 7 };
+
+struct Column {
+    std::string name;
+    Type type;
+    ConvertedType converted;
+};
+
+/* Values of one column in one row group, cut into compressed pages */
+class ColumnChunkBuilder {
+    const Column &m_col;
+    Codec m_codec;
+
+    /* the page being filled */
+    std::vector<uint8_t> m_deflevels;
+    std::string m_values;
+    int64_t m_page_values;
+
+    /* finished pages */
+    std::string m_pages;
+    int64_t m_uncompressed_size;
+
+    int64_t m_num_values;
+    int64_t m_null_count;
+    bool m_has_minmax;
+    bool m_minmax_valid;
+    int64_t m_min_i, m_max_i;
+    double m_min_d, m_max_d;
+    std::string m_min_s, m_max_s;
+
+    void flush_page();
+
+public:
+    ColumnChunkBuilder(const Column &col, Codec codec);
+
+    void append_null();
+    void append_int64(int64_t v);
+    void append_double(double v);
+    void append_bytes(const void *data, size_t len);
+
+    /* finish the last page; the chunk is then ready to be written */
+    void finish();
+    void reset();
+
+    const std::string &pages() const { return m_pages; }
+    int64_t uncompressed_size() const { return m_uncompressed_size; }
+    int64_t num_values() const { return m_num_values; }
+    int64_t null_count() const { return m_null_count; }
+    /* plain-encoded min and max, if they can be given for this chunk */
+    bool min_max(std::string &min, std::string &max) const;
+};
+
+class RowGroupBuilder {
+    std::vector<ColumnChunkBuilder> m_columns;
+    int64_t m_num_rows;
+
+public:
+    RowGroupBuilder(const std::vector<Column> &columns, Codec codec);
+
+    ColumnChunkBuilder &column(size_t i) { return m_columns[i]; }
+    size_t num_columns() const { return m_columns.size(); }
+    void end_row() { m_num_rows++; }
+    int64_t num_rows() const { return m_num_rows; }
+
+    void finish();
+    void reset();
+};
+
+class Writer {
+    std::vector<Column> m_columns;
+    Codec m_codec;
+    std::FILE *m_file;
+    int64_t m_offset;
+    std::string m_row_groups; /* serialised RowGroup structs */
+    int m_num_row_groups;
+    int64_t m_num_rows;
+    std::vector<std::pair<std::string, std::string>> m_metadata;
+    std::mutex m_lock;
+
+    void write(const std::string &data);
+
+public:
+    /* throws on error, as do the other members */
+    Writer(const std::string &path, const std::vector<Column> &columns,
+           Codec codec);
+    ~Writer();
+
+    void add_metadata(const std::string &key, const std::string &value);
+
+    /* Write a finished row group; may be called from several threads */
+    void write_row_group(RowGroupBuilder &rg);
+
+    /* write the footer and close the file */
+    void close();
+
+    int num_row_groups() const { return m_num_row_groups; }
+    int64_t num_rows() const { return m_num_rows; }
+};
+
+} // namespace parquet
+
+#endif
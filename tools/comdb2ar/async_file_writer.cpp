@@ -0,0 +1,69 @@
+#include "async_file_writer.h"
+#include "error.h"
+
+#include <cstring>
+#include <sstream>
+
+AsyncFileWriter::AsyncFileWriter(const std::string& filename,
+        std::unique_ptr<fdostream> out, size_t depth) :
+    m_filename(filename), m_out(std::move(out)), m_queue(depth)
+{
+    m_thread = std::thread(&AsyncFileWriter::run, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+    if (m_thread.joinable()) {
+        m_queue.abort();
+        m_queue.close();
+        m_thread.join();
+    }
+}
+
+void AsyncFileWriter::run()
+{
+    std::unique_ptr<Chunk> chunk;
+    unsigned long long written = 0;
+
+    while ((chunk = m_queue.pop())) {
+        if (!m_out->write((char *) chunk->data, chunk->size)) {
+            std::ostringstream ss;
+            ss << "Error Writing " << m_filename << " after " << written
+               << " bytes";
+            m_error = ss.str();
+            m_queue.abort();
+            break;
+        }
+        written += chunk->size;
+    }
+
+    // Close the file from this thread as well; with direct io this is
+    // where the last of the data is flushed.
+    if (m_error.empty() && !m_out->flush()) {
+        std::ostringstream ss;
+        ss << "Error flushing " << m_filename;
+        m_error = ss.str();
+    }
+    m_out.reset();
+}
+
+void AsyncFileWriter::write(const uint8_t *buf, size_t len)
+{
+    std::unique_ptr<Chunk> chunk(new Chunk(len));
+    std::memcpy(chunk->data, buf, len);
+    chunk->size = len;
+    try {
+        m_queue.push(std::move(chunk));
+    } catch (Error &e) {
+        // The writer aborted the queue; report why
+        throw Error(m_error);
+    }
+}
+
+void AsyncFileWriter::finish()
+{
+    m_queue.close();
+    m_thread.join();
+    if (!m_error.empty())
+        throw Error(m_error);
+}
@@ -0,0 +1,59 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef INCLUDED_ASYNC_FILE_WRITER
+#define INCLUDED_ASYNC_FILE_WRITER
+
+#include "chunk_queue.h"
+#include "fdostream.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+
+class AsyncFileWriter {
+// Writes a file out on a thread of its own, so that the thread reading the
+// archive can move on to the next file while this one is still being
+// written.  The writer takes ownership of the output stream, which is
+// closed once everything has been written.
+
+    std::string m_filename;
+    std::unique_ptr<fdostream> m_out;
+    ChunkQueue m_queue;
+    std::string m_error;
+    std::thread m_thread;
+
+    void run();
+
+public:
+    AsyncFileWriter(const std::string& filename,
+                    std::unique_ptr<fdostream> out, size_t depth);
+    ~AsyncFileWriter();
+    // If finish() was not called, discard any pending data and wait for the
+    // writer thread to exit.
+
+    void write(const uint8_t *buf, size_t len);
+    // Queue a copy of buf to be written.  Blocks if the writer is too far
+    // behind.  Throws Error if the writer has failed.
+
+    void finish();
+    // Wait for all queued data to be written and the file closed.  Throws
+    // Error if anything failed.
+
+    const std::string& get_filename() const { return m_filename; }
+};
+
+#endif // INCLUDED_ASYNC_FILE_WRITER
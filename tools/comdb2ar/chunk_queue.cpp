@@ -0,0 +1,94 @@
+#include "chunk_queue.h"
+#include "error.h"
+
+#include <stdlib.h>
+
+/* dlmalloc clashes with malloc definitions, so can't include malloc.h
+ * that defines this properly */
+void *memalign(size_t boundary, size_t size);
+
+Chunk::Chunk(size_t capacity) : data(NULL), size(0), capacity(capacity)
+{
+#if ! defined  ( _SUN_SOURCE )
+    if(posix_memalign((void**) &data, 512, capacity))
+        throw Error("Failed to allocate chunk buffer");
+#else
+    data = (uint8_t*) memalign(512, capacity);
+    if(data == NULL)
+        throw Error("Failed to allocate chunk buffer");
+#endif
+}
+
+Chunk::~Chunk()
+{
+    free(data);
+}
+
+
+ChunkQueue::ChunkQueue(size_t max_chunks) :
+    m_max(max_chunks), m_started(false), m_closed(false), m_aborted(false)
+{
+}
+
+void ChunkQueue::start()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_started = true;
+    m_cond.notify_all();
+}
+
+bool ChunkQueue::wait_started()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_cond.wait(guard, [this]{ return m_started || m_closed; });
+    if(!m_error.empty())
+        throw Error(m_error);
+    return m_started;
+}
+
+void ChunkQueue::push(std::unique_ptr<Chunk> chunk)
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_cond.wait(guard, [this]{ return m_chunks.size() < m_max || m_aborted; });
+    if(m_aborted)
+        throw Error("consumer aborted");
+    m_chunks.push_back(std::move(chunk));
+    m_cond.notify_all();
+}
+
+std::unique_ptr<Chunk> ChunkQueue::pop()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_cond.wait(guard, [this]{ return !m_chunks.empty() || m_closed; });
+    if(!m_error.empty())
+        throw Error(m_error);
+    if(m_chunks.empty())
+        return std::unique_ptr<Chunk>();
+    std::unique_ptr<Chunk> chunk(std::move(m_chunks.front()));
+    m_chunks.pop_front();
+    m_cond.notify_all();
+    return chunk;
+}
+
+void ChunkQueue::close()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_closed = true;
+    m_cond.notify_all();
+}
+
+void ChunkQueue::fail(const std::string& error)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_error = error.empty() ? "unknown error" : error;
+    m_closed = true;
+    m_cond.notify_all();
+}
+
+void ChunkQueue::abort()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_aborted = true;
+    m_chunks.clear();
+    m_cond.notify_all();
+}
@@ -0,0 +1,83 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef INCLUDED_CHUNK_QUEUE
+#define INCLUDED_CHUNK_QUEUE
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+struct Chunk {
+// A 512 byte aligned buffer, suitable for direct io.
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+
+    Chunk(size_t capacity);
+    ~Chunk();
+
+    Chunk(const Chunk&) = delete;
+    Chunk& operator=(const Chunk&) = delete;
+};
+
+class ChunkQueue {
+// A bounded fifo of chunks handed from one producer thread to one consumer
+// thread.  push() blocks while the queue is full and pop() blocks while it is
+// empty.  The producer calls start() once it is ready to produce (e.g. it has
+// opened its file), then close() when done, or fail() to hand an error over
+// to the consumer.  The consumer calls abort() if it gives up, which makes
+// any blocked or future push() throw.
+
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    std::deque<std::unique_ptr<Chunk>> m_chunks;
+    size_t m_max;
+    bool m_started;
+    bool m_closed;
+    bool m_aborted;
+    std::string m_error;
+
+public:
+    ChunkQueue(size_t max_chunks);
+
+    void start();
+    // Producer is ready; wakes up wait_started().
+
+    bool wait_started();
+    // Wait for the producer to start.  Returns false if it closed without
+    // starting.  Throws Error if it failed.
+
+    void push(std::unique_ptr<Chunk> chunk);
+    // Append a chunk, blocking while the queue is full.  Throws Error if the
+    // consumer aborted.
+
+    std::unique_ptr<Chunk> pop();
+    // Remove the oldest chunk, blocking while the queue is empty.  Returns
+    // an empty pointer once the producer has closed the queue and it has been
+    // drained.  Throws Error if the producer failed.
+
+    void close();
+    void fail(const std::string& error);
+    void abort();
+};
+
+#endif // INCLUDED_CHUNK_QUEUE
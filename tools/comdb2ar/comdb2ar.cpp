@@ -62,6 +62,7 @@ const char *help_text[] = {
 "  -D           turn off directio",
 "  -E dbname    create replicant with dbname",
 "  -T type      override physrep type",
+"  -j <n>       read (c) or write (x) up to n data files in parallel",
 NULL
 };
 
@@ -113,6 +114,7 @@ int main(int argc, char *argv[])
     bool incr_path_specified = false;
     bool dryrun = false;
     bool copy_physical = false;
+    int nthreads = 1;
 
     std::string new_db_name = "";
     std::string new_type = "default";
@@ -129,7 +131,7 @@ int main(int argc, char *argv[])
     ss << root << "/bin/comdb2";
     std::string comdb2_task(ss.str());
 
-    while((c = getopt(argc, argv, "hsSLC:I:b:x:u:rRSkKfODE:T:A")) != EOF) {
+    while((c = getopt(argc, argv, "hsSLC:I:b:x:u:rRSkKfODE:T:Aj:")) != EOF) {
         switch(c) {
             case 'O':
                 legacy_mode = true;
@@ -237,6 +239,15 @@ int main(int argc, char *argv[])
                 new_type = std::string(optarg);
                 break;
 
+            case 'j':
+                nthreads = std::atoi(optarg);
+                if(nthreads < 1) {
+                    std::cerr << "Invalid parameter to -j: " << optarg
+                        << std::endl;
+                    std::exit(2);
+                }
+                break;
+
             case '?':
                 std::cerr << "Unrecognised option: -" << (char)c << std::endl;
                 usage();
@@ -315,7 +326,8 @@ int main(int argc, char *argv[])
                 incr_gen,
                 copy_physical,
                 add_latency,
-                incr_path
+                incr_path,
+                nthreads
             );
         } catch(std::exception& e) {
             std::cerr << e.what() << std::endl;
@@ -357,7 +369,8 @@ int main(int argc, char *argv[])
              is_disk_full,
              run_with_done_file,
              incr_ex,
-             dryrun
+             dryrun,
+             nthreads
            );
         } catch(std::exception& e) {
             std::cerr << e.what() << std::endl;
@@ -11,8 +11,10 @@
 #include "util.h"
 #include "ar_wrap.h"
 #include "cdb2_constants.h"
+#include "async_file_writer.h"
 
 #include <cstdlib>
+#include <deque>
 #include <map>
 #include <set>
 #include <string>
@@ -365,6 +367,9 @@ static bool check_dest_dir(const std::string& dir)
 
 #define write_size (1000*1024)
 
+// Number of buffers each parallel file writer may have outstanding
+#define ASYNC_WRITE_DEPTH 4
+
 void deserialise_database(
         const std::string *p_lrldestdir,
         const std::string *p_datadestdir,
@@ -379,7 +384,8 @@ void deserialise_database(
         bool& is_disk_full,
         bool run_with_done_file,
         bool incr_mode,
-        bool dryrun
+        bool dryrun,
+        int nthreads
 )
 // Deserialise a database from serialised from received on stdin.
 // If lrldestdir and datadestdir are not NULL then the lrl and data files
@@ -388,6 +394,8 @@ void deserialise_database(
 // The lrl file written out will be updated to reflect the resulting directory
 // structure.  If the destination disk reaches or exceeds the specified
 // percent_full during the deserialisation then the operation is halted.
+// With nthreads > 1, up to nthreads data files are written out by their own
+// threads while the archive continues to be read.
 {
     static const char zero_head[512] = {0};
     int stlen;
@@ -445,6 +453,15 @@ void deserialise_database(
     // The manifest map
     std::map<std::string, FileInfo> manifest_map;
 
+    // Data files still being written out in parallel, oldest first
+    std::deque<std::unique_ptr<AsyncFileWriter>> writers;
+    auto finish_writers = [&writers](size_t keep) {
+        while (writers.size() > keep) {
+            writers.front()->finish();
+            writers.pop_front();
+        }
+    };
+
     if (run_with_done_file)
     {
        /* remove the DONE file before we start copying */
@@ -521,6 +538,7 @@ void deserialise_database(
         // Alternativelyh, if we're running in incremental mode, then
         // we know we are moving on the the incremental backups
         if(std::memcmp(head.c, zero_head, 512) == 0) {
+            finish_writers(0);
             if(incr_mode){
                 std::clog << "Done with base backup, moving on to increments"
                           << std::endl << std::endl;
@@ -549,6 +567,10 @@ void deserialise_database(
         }
         const std::string filename(head.h.filename);
 
+        // FLUFF is always last, and a short read of it ends the restore
+        if (filename == "FLUFF")
+            finish_writers(0);
+
         // Try to find this file in our manifest
         std::map<std::string, FileInfo>::const_iterator manifest_it = manifest_map.find(filename);
 
@@ -613,6 +635,7 @@ void deserialise_database(
         }
 
         std::unique_ptr<fdostream> of_ptr;
+        std::unique_ptr<AsyncFileWriter> async_writer;
 
         if(is_text) {
             text.reserve(filesize);
@@ -677,6 +700,13 @@ void deserialise_database(
             bufsize <<= 1;
         }
 
+        if (nthreads > 1 && of_ptr && !file_is_sparse &&
+            manifest_it != manifest_map.end() &&
+            manifest_it->second.get_type() == FileInfo::BERKDB_FILE) {
+            async_writer.reset(new AsyncFileWriter(filename, std::move(of_ptr),
+                                                   ASYNC_WRITE_DEPTH));
+        }
+
 
         uint8_t *buf;
 #if defined _SUN_SOURCE
@@ -800,7 +830,9 @@ void deserialise_database(
                         lim = bytes;
                     else
                         lim = write_size;
-                    if (!of_ptr->write((char*) &buf[off], lim))
+                    if (async_writer)
+                        async_writer->write(&buf[off], lim);
+                    else if (!of_ptr->write((char*) &buf[off], lim))
                     {
                         std::ostringstream ss;
 
@@ -881,6 +913,11 @@ void deserialise_database(
             throw Error(ss);
         }
 
+        if (async_writer) {
+            writers.push_back(std::move(async_writer));
+            finish_writers(nthreads);
+        }
+
         /* Restore the permissions. */
         uid_t uid = (uid_t)strtol(head.h.uid, NULL, 8);
         gid_t gid = (gid_t)strtol(head.h.gid, NULL, 8);
@@ -98,6 +98,80 @@ bool assert_cksum_lsn(FileInfo &file, uint8_t *new_pagep, uint8_t *old_pagep, si
     return (memcmp(cmp_arr, old_pagep, 12) != 0);
 }
 
+// Read the changed-page map that the database keeps next to a data file.
+// Returns false if there is no map, or it is not for this incarnation of the
+// file.
+bool read_pgmap(const FileInfo& file, PgMap& pgmap)
+{
+    const std::string& filepath = file.get_filepath();
+    std::string mappath;
+    size_t slash = filepath.find_last_of('/');
+    if (slash == std::string::npos)
+        mappath = std::string(PGMAP_DIR) + "/" + filepath;
+    else
+        mappath = filepath.substr(0, slash) + "/" + PGMAP_DIR +
+                  filepath.substr(slash);
+
+    std::ifstream ifs(mappath, std::ifstream::in | std::ifstream::binary);
+    if (!ifs.read((char *) &pgmap.hdr, sizeof(pgmap.hdr)))
+        return false;
+    if (pgmap.hdr.magic != PGMAP_MAGIC ||
+        pgmap.hdr.version != PGMAP_VERSION || pgmap.hdr.chunk_pages == 0)
+        return false;
+    pgmap.clocks.resize(pgmap.hdr.nchunks);
+    if (pgmap.hdr.nchunks &&
+        !ifs.read((char *) &pgmap.clocks[0],
+                  pgmap.hdr.nchunks * sizeof(uint32_t)))
+        return false;
+
+    // Make sure the map is for this incarnation of the file
+    DBMETA meta;
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    RIIA_fd fd_guard(fd);
+    if (pread(fd, &meta, sizeof(meta), 0) != sizeof(meta))
+        return false;
+    return memcmp(meta.uid, pgmap.hdr.fileid, DB_FILE_ID_LEN) == 0;
+}
+
+static const char *pgmap_bases_file = "/pgmap.bases";
+
+std::map<std::string, uint32_t> read_pgmap_bases(const std::string& incr_path)
+{
+    std::map<std::string, uint32_t> bases;
+    std::ifstream ifs(incr_path + pgmap_bases_file);
+    std::string filename;
+    uint32_t clock;
+    while (ifs >> filename >> clock)
+        bases[filename] = clock;
+    return bases;
+}
+
+void write_pgmap_bases(
+    const std::string& incr_path,
+    const std::map<std::string, uint32_t>& bases
+) {
+    std::string path = incr_path + pgmap_bases_file;
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ofstream::trunc);
+        for (std::map<std::string, uint32_t>::const_iterator it = bases.begin();
+             it != bases.end(); ++it)
+            ofs << it->first << " " << it->second << std::endl;
+        if (!ofs) {
+            std::ostringstream ss;
+            ss << "error writing " << tmp;
+            throw Error(ss);
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        std::ostringstream ss;
+        ss << "error renaming " << tmp << ": " << std::strerror(errno);
+        throw Error(ss);
+    }
+}
+
 // Compare the page with the diff file to determine whether it has changed - driver
 // For each file, populate pages with the page numbers fo the changed pages
 // populate data_size with the total amount of data that needs to be serialised
@@ -107,7 +181,9 @@ bool compare_checksum(
     const std::string& incr_path,
     std::vector<uint32_t>& pages,
     ssize_t *data_size,
-    std::set<std::string>& incr_files
+    std::set<std::string>& incr_files,
+    const PgMap *pgmap,
+    uint32_t pgmap_base
 ) {
     std::string filename = file.get_filename();
     std::string incr_file_name = incr_path + "/" + filename + ".incr";
@@ -127,6 +203,8 @@ bool compare_checksum(
     int flags = O_RDONLY;
     int new_fd = open(file.get_filepath().c_str(), flags);
     int old_fd = open(incr_file_name.c_str(), O_RDWR);
+    RIIA_fd new_fd_guard(new_fd);
+    RIIA_fd old_fd_guard(old_fd);
 
     struct stat new_st;
     if(fstat(new_fd, &new_st) == -1) {
@@ -176,8 +254,32 @@ bool compare_checksum(
         off_t bytesleft = new_st.st_size;
         int64_t filesize = 0;
         int64_t pgno = -1;
+        uint32_t chunk_pages = pgmap ? pgmap->hdr.chunk_pages : 0;
+        off_t chunk_bytes = (off_t) chunk_pages * pagesize;
+        int64_t skipped = 0;
 
         while(bytesleft >= pagesize) {
+            // Skip whole chunks that have not been written since the last
+            // backup, as long as the diff file already covers them
+            int64_t next = pgno + 1;
+            if (pgmap && !file_expanded && next % chunk_pages == 0 &&
+                (size_t) (next / chunk_pages) < pgmap->clocks.size() &&
+                pgmap->clocks[next / chunk_pages] < pgmap_base &&
+                bytesleft >= chunk_bytes &&
+                (next + chunk_pages) * 12 <= sb.st_size) {
+                if (lseek(new_fd, chunk_bytes, SEEK_CUR) == (off_t) -1 ||
+                    lseek(old_fd, 12 * chunk_pages, SEEK_CUR) == (off_t) -1) {
+                    std::ostringstream ss;
+                    ss << "compare_checksum:lseek: " << std::strerror(errno);
+                    throw SerialiseError(filename, ss.str());
+                }
+                pgno += chunk_pages;
+                filesize += chunk_bytes;
+                bytesleft -= chunk_bytes;
+                skipped++;
+                continue;
+            }
+
             ssize_t new_bytesread = read(new_fd, &new_pagebuf[0], pagesize);
 
             filesize += new_bytesread;
@@ -232,6 +334,12 @@ bool compare_checksum(
         }
 
         if(new_pagebuf) free(new_pagebuf);
+
+        if (pgmap) {
+            std::clog << filename << ": skipped " << skipped
+                      << " unchanged chunks of " << chunk_pages << " pages"
+                      << std::endl;
+        }
     }
     return ret;
 }
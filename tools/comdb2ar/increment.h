@@ -9,6 +9,13 @@
 
 
 #include "file_info.h"
+#include "pgmap.h"
+
+struct PgMap {
+// A data file's changed-page map, as kept by the database (see pgmap.h)
+    pgmap_header hdr;
+    std::vector<uint32_t> clocks;
+};
 
 bool is_not_incr_file(std::string filename);
 // Determine whether a file is not .incr or .sha
@@ -24,10 +31,25 @@ bool compare_checksum(
     const std::string& incr_path,
     std::vector<uint32_t>& pages,
     ssize_t *data_size,
-    std::set<std::string>& incr_files
+    std::set<std::string>& incr_files,
+    const PgMap *pgmap = NULL,
+    uint32_t pgmap_base = 0
 );
 // Compare a file's checksum and LSN with it's diff file to determine whether pages
-// have been changed
+// have been changed.  If pgmap is given, chunks it shows as unchanged since
+// pgmap_base are skipped without being read.
+
+bool read_pgmap(const FileInfo& file, PgMap& pgmap);
+// Read the changed-page map for a data file.  Returns false if there isn't
+// one, or it doesn't belong to this file.
+
+std::map<std::string, uint32_t> read_pgmap_bases(const std::string& incr_path);
+void write_pgmap_bases(
+    const std::string& incr_path,
+    const std::map<std::string, uint32_t>& bases
+);
+// Read/write the changed-page map clock of each data file as of the last
+// backup
 
 void write_incr_manifest_entry(
     std::ostream& os,
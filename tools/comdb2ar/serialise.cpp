@@ -13,6 +13,7 @@
 #include "util.h"
 #include "ssl_support.h"
 #include "cdb2_constants.h"
+#include "chunk_queue.h"
 
 #include <cassert>
 #include <cstring>
@@ -25,6 +26,11 @@
 #include <utility>
 #include <vector>
 #include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
 
 #include <errno.h>
 #include <fcntl.h>
@@ -119,17 +125,13 @@ static void serialise_string(const std::string& filename,
  * that defines this properly */
 void *memalign(size_t boundary, size_t size);
 
-static void serialise_file(FileInfo& file, volatile iomap *iomap=NULL, const std::string altpath="",
-                            const std::string incr_path="", bool incr_create = false)
-// Serialise a single file, in tape archive format, onto stdout.  The input
-// filename is expected to be an absolute path.  The name recorded in the
-// tape archive will be relative to dbdir.  Input files outside of dbdir
-// (usually the lrl) will be recorded in the archive as having come from
-// dbdir.
+static int open_file(FileInfo& file, const std::string& altpath, struct stat& st)
+// Open a file for serialisation and stat it.  Returns the open descriptor,
+// which the caller must close, or -1 if the file has gone missing and can be
+// skipped.
 {
     const std::string& filename = file.get_filename();
     int flags;
-    bool skip_iomap = false;
     std::ostringstream ss;
 
     // Ensure large file support
@@ -149,7 +151,7 @@ reopen:
     else {
         fd = open(file.get_filepath().c_str(), flags);
     }
-    RIIA_fd fd_guard(fd);
+    RIIA_fd fdalt_guard(fdalt);
 
     if(fd == -1) {
         /* If this is a log file, we can't ignore it - we need it to run recovery. */
@@ -160,6 +162,9 @@ reopen:
         else if (EINVAL == errno){
             std::clog << "Turning off directio because of open() err: " << std::strerror(errno) << std::endl;
             flags ^= DO_DIRECT;
+            if (fdalt != -1)
+                close(fdalt);
+            fdalt = -1;
             goto reopen;
         }
         else if (ENOENT == errno) {
@@ -168,15 +173,16 @@ reopen:
              * despite this file being unavailable. */
             std::clog << "Error opening file " << file.get_filepath()
                       <<", err: " << std::strerror(errno) << std::endl;
-            return;
+            return -1;
         }
         else
             throw SerialiseError(filename, ss.str());
     }
 
-    struct stat st, stalt;
+    struct stat stalt;
     if(fstat(fd, &st) == -1) {
         ss << "cannot stat file: " << std::strerror(errno);
+        close(fd);
         throw SerialiseError(filename, ss.str());
     }
 
@@ -189,10 +195,18 @@ reopen:
 
     // Ignore special files
     if(!S_ISREG(st.st_mode)) {
+        close(fd);
         throw SerialiseError(filename, "not a regular file");
     }
 
-    // Write the header
+    return fd;
+}
+
+static bool write_file_header(const FileInfo& file, const struct stat& st)
+// Write the tar header for a file.  Returns true if the gnu extension was
+// needed to encode it.
+{
+    const std::string& filename = file.get_filename();
     TarHeader head;
     head.set_filename(filename);
     head.set_attrs(st);
@@ -205,25 +219,46 @@ reopen:
         throw SerialiseError(filename, ss.str());
     }
 
-    // Read the file a page at a time and copy to the output.
-    // Use a large buffer if possible
+    return head.used_gnu();
+}
+
+static size_t file_bufsize(const FileInfo& file)
+// Read buffer size for a file: the largest multiple of its page size that
+// fits in MAX_BUF_SIZE.
+{
     size_t pagesize = file.get_pagesize();
     if(pagesize == 0) {
         pagesize = 4096;
     }
     size_t bufsize = pagesize;
-    int num_waits = 0;
-    int64_t filesize = 0;
 
     while((bufsize << 1) <= MAX_BUF_SIZE) {
         bufsize <<= 1;
     }
-#if 0
-    */
-    std::cerr<<"Computed bufsize="<<bufsize<<" for pagesize="<<pagesize<<" file="<<filename<<"\n";
+    return bufsize;
+}
+
+static int read_file(FileInfo& file, int fd, const struct stat& st,
+                     volatile iomap *iomap, const std::string& incr_path,
+                     bool incr_create, bool drop_cache,
+                     const std::function<void(const uint8_t *, size_t)>& sink)
+// Read a file a buffer at a time, verifying page checksums, and pass each
+// buffer on to sink.  If drop_cache is set the pages we have read are
+// dropped from the page cache as we go so that a large backup does not evict
+// the database's working set.  Returns the number of times we paused because
+// the database was busy writing.
+{
+    const std::string& filename = file.get_filename();
+    bool skip_iomap = false;
+
+    size_t pagesize = file.get_pagesize();
+    if(pagesize == 0) {
+        pagesize = 4096;
+    }
+    size_t bufsize = file_bufsize(file);
+    int num_waits = 0;
+    int64_t filesize = 0;
 
-    std::vector<char> pagebuf(bufsize);
-#endif
     uint8_t *pagebuf = NULL;
     off_t bytesleft = st.st_size;
 
@@ -233,6 +268,12 @@ reopen:
 #else
         pagebuf = (uint8_t*) memalign(512, bufsize);
 #endif
+    RIIA_malloc pagebuf_guard(pagebuf);
+
+#if defined (__linux__)
+    if (drop_cache)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 
     std::string incrFilename = incr_path + "/" + filename + ".incr";
     std::ofstream incrFile(incrFilename,
@@ -261,7 +302,6 @@ reopen:
                 << std::strerror(errno);
             throw SerialiseError(filename, ss.str());
         }
-        filesize += bytesread;
 
         if (file.get_checksums()) {
             // Save current offset
@@ -338,35 +378,47 @@ reopen:
             }
         }
 
-        ssize_t byteswritten = writeall(1, &pagebuf[0], bytesread);
-        if(byteswritten != bytesread) {
-            std::ostringstream ss;
-            ss << "write error after " << bytesleft << "bytes: "
-                << std::strerror(errno);
-            throw SerialiseError(filename, ss.str());
-        }
+        sink(&pagebuf[0], bytesread);
 
+#if defined (__linux__)
+        if (drop_cache)
+            posix_fadvise(fd, filesize, bytesread, POSIX_FADV_DONTNEED);
+#endif
+        filesize += bytesread;
         bytesleft -= bytesread;
     }
 
     file.set_filesize(filesize);
 
-    if (num_waits)
-        std::clog <<  "paused " << num_waits << " times because db is busy writing." << std::endl;
-
     // This is a fatal error as it will leave the archive corrupt if the
     // header says the file is longer than it really is.
     if(bytesleft > 0) {
         throw SerialiseError(filename, "file shrank while being archived!");
     }
 
+    return num_waits;
+}
+
+static void write_file_trailer(const FileInfo& file, const struct stat& st,
+                               bool used_gnu, int num_waits)
+// Pad the archived file out to a 512 byte boundary and log it.
+{
+    const std::string& filename = file.get_filename();
+
+    if (num_waits)
+        std::clog <<  "paused " << num_waits << " times because db is busy writing." << std::endl;
+
     // The length of the output must be a multiple of 512 bytes
-    bytesleft = st.st_size & (512 - 1);
+    off_t bytesleft = st.st_size & (512 - 1);
     bytesleft = 512 - bytesleft;
     if(bytesleft > 0 && bytesleft < 512) {
         writepadding(bytesleft);
     }
 
+    size_t pagesize = file.get_pagesize();
+    if(pagesize == 0) {
+        pagesize = 4096;
+    }
     std::clog << "a " << filename << " size=" << st.st_size
               << " pagesize=" << pagesize;
 
@@ -374,14 +426,186 @@ reopen:
        std::clog << " not sparse ";
 
 
-    if(head.used_gnu()) {
+    if(used_gnu) {
         std::clog << " (encoded using gnu extension)";
     }
 
 
     std::clog << std::endl;
-    if (pagebuf)
-        free(pagebuf);
+}
+
+static void write_data(const std::string& filename, const uint8_t *buf,
+                       size_t len)
+{
+    ssize_t byteswritten = writeall(1, buf, len);
+    if(byteswritten != (ssize_t) len) {
+        std::ostringstream ss;
+        ss << "write error: " << std::strerror(errno);
+        throw SerialiseError(filename, ss.str());
+    }
+}
+
+static void serialise_file(FileInfo& file, volatile iomap *iomap=NULL, const std::string altpath="",
+                            const std::string incr_path="", bool incr_create = false)
+// Serialise a single file, in tape archive format, onto stdout.  The input
+// filename is expected to be an absolute path.  The name recorded in the
+// tape archive will be relative to dbdir.  Input files outside of dbdir
+// (usually the lrl) will be recorded in the archive as having come from
+// dbdir.
+{
+    const std::string& filename = file.get_filename();
+    struct stat st;
+
+    int fd = open_file(file, altpath, st);
+    if (fd == -1)
+        return;
+    RIIA_fd fd_guard(fd);
+
+    bool used_gnu = write_file_header(file, st);
+
+    int num_waits = read_file(file, fd, st, iomap, incr_path, incr_create,
+            false, [&filename](const uint8_t *buf, size_t len) {
+                write_data(filename, buf, len);
+            });
+
+    write_file_trailer(file, st, used_gnu, num_waits);
+}
+
+namespace {
+
+struct ParallelFile {
+// State shared between the reader thread serialising a data file and the
+// thread writing the archive.
+    ChunkQueue queue;
+    struct stat st;
+    int num_waits;
+
+    ParallelFile(size_t depth) : queue(depth), num_waits(0) {}
+};
+
+}
+
+// Number of buffers each reader may have outstanding for its current file.
+static const size_t PARALLEL_QUEUE_DEPTH = 2;
+
+static void serialise_files_parallel(
+    std::list<FileInfo>& files,
+    volatile iomap *iomap,
+    const std::string& incr_path,
+    bool incr_create,
+    int nthreads,
+    bool add_latency,
+    const std::function<void()>& before_file)
+// Serialise a list of data files using nthreads reader threads.  Readers
+// claim files in list order, then open, read and checksum them concurrently,
+// handing buffers over to this thread which writes them to the archive.  The
+// archive is still a single tar stream with files in list order, so it can
+// be extracted by any version of comdb2ar.  Readers may run at most
+// 2 * nthreads files ahead of the writer.  before_file is called on this
+// thread before each file is written.
+{
+    std::vector<FileInfo *> list;
+    for (std::list<FileInfo>::iterator it = files.begin(); it != files.end();
+         ++it)
+        list.push_back(&*it);
+
+    std::vector<std::unique_ptr<ParallelFile>> slots;
+    for (size_t i = 0; i < list.size(); i++)
+        slots.emplace_back(new ParallelFile(PARALLEL_QUEUE_DEPTH));
+
+    std::mutex lk;
+    std::condition_variable cond;
+    size_t next = 0;
+    size_t written = 0;
+    bool aborted = false;
+    const size_t window = 2 * nthreads;
+
+    auto reader = [&]() {
+        for (;;) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> guard(lk);
+                cond.wait(guard, [&] {
+                    return aborted || next >= list.size() ||
+                           next < written + window;
+                });
+                if (aborted || next >= list.size())
+                    return;
+                i = next++;
+            }
+
+            FileInfo& file = *list[i];
+            ParallelFile& slot = *slots[i];
+            try {
+                int fd = open_file(file, "", slot.st);
+                if (fd == -1) {
+                    slot.queue.close();
+                    continue;
+                }
+                RIIA_fd fd_guard(fd);
+                slot.queue.start();
+
+                size_t bufsize = file_bufsize(file);
+                slot.num_waits = read_file(file, fd, slot.st, iomap, incr_path, incr_create,
+                        true, [&slot, bufsize](const uint8_t *buf, size_t len) {
+                            std::unique_ptr<Chunk> chunk(new Chunk(bufsize));
+                            memcpy(chunk->data, buf, len);
+                            chunk->size = len;
+                            slot.queue.push(std::move(chunk));
+                        });
+                slot.queue.close();
+            } catch (std::exception &e) {
+                slot.queue.fail(e.what());
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++)
+        threads.emplace_back(reader);
+
+    try {
+        for (size_t i = 0; i < list.size(); i++) {
+            FileInfo& file = *list[i];
+            ParallelFile& slot = *slots[i];
+
+            before_file();
+
+            if (slot.queue.wait_started()) {
+                bool used_gnu = write_file_header(file, slot.st);
+                std::unique_ptr<Chunk> chunk;
+                while ((chunk = slot.queue.pop()))
+                    write_data(file.get_filename(), chunk->data, chunk->size);
+                write_file_trailer(file, slot.st, used_gnu, slot.num_waits);
+            }
+            slots[i].reset();
+
+            {
+                std::lock_guard<std::mutex> guard(lk);
+                written++;
+                cond.notify_all();
+            }
+
+            if (add_latency) {
+                sleep(1);
+            }
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> guard(lk);
+            aborted = true;
+            cond.notify_all();
+        }
+        for (size_t i = 0; i < slots.size(); i++)
+            if (slots[i])
+                slots[i]->queue.abort();
+        for (size_t i = 0; i < threads.size(); i++)
+            threads[i].join();
+        throw;
+    }
+
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
 }
 
 std::string replace_dbname(const std::string& replaceWith, const std::string& dbname, 
@@ -761,7 +985,8 @@ void serialise_database(
   bool incr_gen,
   bool copy_physical,
   bool add_latency,
-  const std::string& incr_path
+  const std::string& incr_path,
+  int nthreads
 )
 // Serialise a database into tape archive format and write it to stdout.
 // If support_only is true then only support files (lrl and schema) will
@@ -1173,6 +1398,10 @@ void serialise_database(
     // Construct a manifest which will give the page sizes of all the files
     std::ostringstream manifest;
 
+    // Changed-page map clocks to record for the next increment
+    std::map<std::string, uint32_t> pgmap_bases;
+    std::string checkpoint;
+
     // Non-incremental mode or increment creation mode
     if(!incr_gen){
         manifest << "# Manifest for serialisation of " << dbname << std::endl;
@@ -1210,6 +1439,22 @@ void serialise_database(
         manifest << "# Manifest for serialisation of increment produced on "
             << getDTString() << std::endl;
 
+        // Read the checkpoint before the changed-page maps.  The maps are
+        // written after each sync, so they cover every page written before
+        // this checkpoint, and recovery from it replays anything later.
+        {
+            std::string absfile;
+            makeabs(absfile, dbtxndir, "checkpoint");
+            std::ifstream ifs(absfile, std::ifstream::in | std::ifstream::binary);
+            std::ostringstream ss;
+            if(!(ss << ifs.rdbuf())) {
+                std::ostringstream err;
+                err << "error reading checkpoint file " << absfile;
+                throw Error(err);
+            }
+            checkpoint = ss.str();
+        }
+        std::map<std::string, uint32_t> prev_bases = read_pgmap_bases(incr_path);
 
         for(std::list<FileInfo>::iterator
                 it = data_files.begin();
@@ -1219,8 +1464,25 @@ void serialise_database(
             std::vector<uint32_t> pages_list;
             ssize_t data_size = 0;
 
+            // If the database kept a changed-page map for this file since
+            // the last increment, only chunks written since then are read
+            PgMap pgmap;
+            const PgMap *usable_map = NULL;
+            uint32_t pgmap_base = 0;
+            if(read_pgmap(*it, pgmap)) {
+                pgmap_bases[it->get_filename()] = pgmap.hdr.clock;
+                std::map<std::string, uint32_t>::const_iterator base =
+                    prev_bases.find(it->get_filename());
+                if(base != prev_bases.end() &&
+                        base->second >= pgmap.hdr.valid_from) {
+                    usable_map = &pgmap;
+                    pgmap_base = base->second;
+                }
+            }
+
             // Diff the page checksums for each file to find what has been changed
-            if(compare_checksum(*it, incr_path, pages_list, &data_size, incr_files)) {
+            if(compare_checksum(*it, incr_path, pages_list, &data_size, incr_files,
+                        usable_map, pgmap_base)) {
                 // If pages list is empty but compare_checksum returned true, it's a new file
                 if(pages_list.empty()){
                     new_files.push_back(*it);
@@ -1357,8 +1619,30 @@ void serialise_database(
         // Now do data files
         if(!support_files_only) {
 
+            // Note the changed-page map clocks before copying anything;
+            // pages written from here on are marked at or after them
+            if(incr_create) {
+                for(std::list<FileInfo>::const_iterator
+                        it = data_files.begin();
+                        it != data_files.end();
+                        ++it) {
+                    PgMap pgmap;
+                    if(read_pgmap(*it, pgmap))
+                        pgmap_bases[it->get_filename()] = pgmap.hdr.clock;
+                }
+            }
+
             long long log_number(lowest_log);
-            for(std::list<FileInfo>::iterator
+            if (nthreads > 1) {
+                serialise_files_parallel(data_files, iom, incr_path,
+                        incr_create, nthreads, add_latency, [&]() {
+                    long long old_log_number(log_number);
+                    serialise_log_files(dbtxndir, dbdir, log_number, true);
+                    if(log_number != old_log_number && log_holder.get()) {
+                        log_holder->release_log(log_number - 1);
+                    }
+                });
+            } else for(std::list<FileInfo>::iterator
                     it = data_files.begin();
                     it != data_files.end();
                     ++it) {
@@ -1393,13 +1677,14 @@ void serialise_database(
         st.st_mtime = time(NULL);
         st.st_size = total_data_size;
 
-        // Grab the checkpoint file, pretend its a logfile
+        // Grab the checkpoint file as read before the page diff, pretend its
+        // a logfile
         std::string absfile;
         std::cerr<<"Serializing checkpoint"<<std::endl;
         makeabs(absfile, dbtxndir, "checkpoint");
         FileInfo fi(FileInfo::LOG_FILE, absfile, dbdir);
 
-        serialise_file(fi);
+        serialise_string(fi.get_filename(), checkpoint);
         if (add_latency) {
             sleep(1);
         }
@@ -1511,6 +1796,8 @@ void serialise_database(
         std::ofstream sha_file(sha_filename, std::ofstream::trunc);
 
         sha_file.write(sha.c_str(), 40);
+
+        write_pgmap_bases(incr_path, pgmap_bases);
     }
 
     // Release the database for log file deletion.
@@ -0,0 +1,231 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comdb2_atomic.h"
+#include "histogram.h"
+#include "logmsg.h"
+
+#include "mem_util.h"
+#include "mem_override.h"
+
+#define HISTOGRAM_SHARDS 16
+
+int gbl_latency_histograms = 1;
+
+struct histogram_shard {
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[HISTOGRAM_NBUCKETS];
+} __attribute__((aligned(64)));
+
+struct histogram {
+    const char *name;
+    struct histogram_shard shards[HISTOGRAM_SHARDS];
+};
+
+static struct histogram latency[LATENCY_MAX] = {
+    [LATENCY_SQL_STATEMENT] = {.name = "sql_statement"},
+    [LATENCY_COMMIT] = {.name = "commit"},
+    [LATENCY_REP_WAIT] = {.name = "rep_wait"},
+    [LATENCY_LOCK_WAIT] = {.name = "lock_wait"},
+    [LATENCY_PAGE_IN] = {.name = "page_in"},
+};
+
+static int next_shard;
+static __thread int my_shard = -1;
+
+static inline int bucket_index(uint64_t value)
+{
+    int shift;
+    if (value < 2 * HISTOGRAM_SUB_COUNT)
+        return value;
+    shift = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BITS;
+    return shift * HISTOGRAM_SUB_COUNT + (value >> shift);
+}
+
+/* largest value which lands in bucket idx */
+static uint64_t bucket_high(int idx)
+{
+    int shift;
+    uint64_t sub;
+    if (idx < 2 * HISTOGRAM_SUB_COUNT)
+        return idx;
+    shift = idx / HISTOGRAM_SUB_COUNT - 1;
+    sub = idx % HISTOGRAM_SUB_COUNT + HISTOGRAM_SUB_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+struct histogram *histogram_new(const char *name)
+{
+    struct histogram *h = calloc(1, sizeof(struct histogram));
+    if (h == NULL)
+        return NULL;
+    h->name = strdup(name);
+    if (h->name == NULL) {
+        free(h);
+        return NULL;
+    }
+    return h;
+}
+
+void histogram_free(struct histogram *h)
+{
+    free((char *)h->name);
+    free(h);
+}
+
+const char *histogram_name(struct histogram *h)
+{
+    return h->name;
+}
+
+void histogram_add(struct histogram *h, uint64_t value)
+{
+    struct histogram_shard *s;
+    uint64_t max;
+
+    if (my_shard < 0)
+        my_shard = ATOMIC_ADD32(next_shard, 1) % HISTOGRAM_SHARDS;
+    s = &h->shards[my_shard];
+
+    ATOMIC_ADD64(s->buckets[bucket_index(value)], 1);
+    ATOMIC_ADD64(s->sum, value);
+    while (value > (max = ATOMIC_LOAD64(s->max)) && !CAS64(s->max, max, value))
+        ;
+}
+
+void histogram_reset(struct histogram *h)
+{
+    memset(h->shards, 0, sizeof(h->shards));
+}
+
+void histogram_snapshot_merge(struct histogram_snapshot *dst,
+                              const struct histogram_snapshot *src)
+{
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (dst->max < src->max)
+        dst->max = src->max;
+    for (int i = 0; i < HISTOGRAM_NBUCKETS; i++)
+        dst->buckets[i] += src->buckets[i];
+}
+
+void histogram_snapshot(struct histogram *h, struct histogram_snapshot *snap)
+{
+    memset(snap, 0, sizeof(*snap));
+    for (int i = 0; i < HISTOGRAM_SHARDS; i++) {
+        struct histogram_shard *s = &h->shards[i];
+        uint64_t max = ATOMIC_LOAD64(s->max);
+        if (snap->max < max)
+            snap->max = max;
+        snap->sum += ATOMIC_LOAD64(s->sum);
+        for (int j = 0; j < HISTOGRAM_NBUCKETS; j++) {
+            uint64_t n = ATOMIC_LOAD64(s->buckets[j]);
+            snap->buckets[j] += n;
+            snap->count += n;
+        }
+    }
+}
+
+uint64_t histogram_snapshot_percentile(const struct histogram_snapshot *snap,
+                                       double pct)
+{
+    uint64_t target, seen = 0;
+
+    if (snap->count == 0)
+        return 0;
+    target = (uint64_t)(pct / 100.0 * snap->count + 0.5);
+    if (target < 1)
+        target = 1;
+    if (target > snap->count)
+        target = snap->count;
+
+    for (int i = 0; i < HISTOGRAM_NBUCKETS; i++) {
+        seen += snap->buckets[i];
+        if (seen >= target) {
+            uint64_t high = bucket_high(i);
+            return high < snap->max ? high : snap->max;
+        }
+    }
+    return snap->max;
+}
+
+uint64_t histogram_percentiles(struct histogram *h, const double *pct,
+                               uint64_t *out, int n)
+{
+    struct histogram_snapshot *snap;
+    uint64_t count;
+
+    snap = malloc(sizeof(struct histogram_snapshot));
+    if (snap == NULL) {
+        for (int i = 0; i < n; i++)
+            out[i] = 0;
+        return 0;
+    }
+    histogram_snapshot(h, snap);
+    for (int i = 0; i < n; i++)
+        out[i] = histogram_snapshot_percentile(snap, pct[i]);
+    count = snap->count;
+    free(snap);
+    return count;
+}
+
+struct histogram *latency_histogram(enum latency_histogram which)
+{
+    return &latency[which];
+}
+
+void latency_histogram_add(enum latency_histogram which, uint64_t us)
+{
+    if (gbl_latency_histograms)
+        histogram_add(&latency[which], us);
+}
+
+void latency_histograms_dump(void)
+{
+    static const double pct[] = {50, 90, 99, 99.9};
+    const int npct = sizeof(pct) / sizeof(pct[0]);
+    uint64_t v[sizeof(pct) / sizeof(pct[0])];
+
+    logmsg(LOGMSG_USER, "%-14s %12s %10s %10s %10s %10s %10s %10s (usec)\n",
+           "latency", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+    for (int i = 0; i < LATENCY_MAX; i++) {
+        struct histogram_snapshot *snap;
+        snap = malloc(sizeof(struct histogram_snapshot));
+        if (snap == NULL)
+            return;
+        histogram_snapshot(&latency[i], snap);
+        for (int j = 0; j < npct; j++)
+            v[j] = histogram_snapshot_percentile(snap, pct[j]);
+        logmsg(LOGMSG_USER,
+               "%-14s %12" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+               " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
+               latency[i].name, snap->count,
+               snap->count ? snap->sum / snap->count : 0, v[0], v[1], v[2],
+               v[3], snap->max);
+        free(snap);
+    }
+}
+
+void latency_histograms_reset(void)
+{
+    for (int i = 0; i < LATENCY_MAX; i++)
+        histogram_reset(&latency[i]);
+}
@@ -0,0 +1,80 @@
+/*
+   Copyright 2026 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef INCLUDED_HISTOGRAM_H
+#define INCLUDED_HISTOGRAM_H
+
+#include <stdint.h>
+
+/*
+ * Log-linear histograms, in the style of HdrHistogram.  A value is bucketed
+ * by its highest set bit and then linearly into 2^HISTOGRAM_SUB_BITS
+ * sub-buckets, so any percentile read back is within ~3% of the true value
+ * whatever its magnitude.  Writers update one of several shards picked per
+ * thread, so recording is a single uncontended atomic add; readers merge
+ * the shards into a snapshot.
+ */
+
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_NBUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT)
+
+struct histogram;
+
+struct histogram_snapshot {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[HISTOGRAM_NBUCKETS];
+};
+
+struct histogram *histogram_new(const char *name);
+void histogram_free(struct histogram *h);
+const char *histogram_name(struct histogram *h);
+void histogram_add(struct histogram *h, uint64_t value);
+/* Not atomic with respect to concurrent writers */
+void histogram_reset(struct histogram *h);
+
+/* Merge all shards of h into snap (which is overwritten) */
+void histogram_snapshot(struct histogram *h, struct histogram_snapshot *snap);
+/* Add the counts of src into dst */
+void histogram_snapshot_merge(struct histogram_snapshot *dst,
+                              const struct histogram_snapshot *src);
+/* Highest value equivalent to the pct'th percentile (0 < pct <= 100) */
+uint64_t histogram_snapshot_percentile(const struct histogram_snapshot *snap,
+                                       double pct);
+/* Snapshot h and read n percentiles off it; returns the count */
+uint64_t histogram_percentiles(struct histogram *h, const double *pct,
+                               uint64_t *out, int n);
+
+/* Latencies tracked by the server, in microseconds */
+enum latency_histogram {
+    LATENCY_SQL_STATEMENT,
+    LATENCY_COMMIT,
+    LATENCY_REP_WAIT,
+    LATENCY_LOCK_WAIT,
+    LATENCY_PAGE_IN,
+    LATENCY_MAX
+};
+
+extern int gbl_latency_histograms;
+
+struct histogram *latency_histogram(enum latency_histogram which);
+void latency_histogram_add(enum latency_histogram which, uint64_t us);
+void latency_histograms_dump(void);
+void latency_histograms_reset(void);
+
+#endif
@@ -1153,6 +1153,12 @@ void thdpool_remove_waitthd(struct thdpool *pool)
     pool->nwaitthd--;
 }
 
+void thdpool_add_timeout(struct thdpool *pool)
+{
+    LOCK(&pool->mutex) { pool->num_timeout++; }
+    UNLOCK(&pool->mutex);
+}
+
 int thdpool_get_maxthds(struct thdpool *pool)
 {
     return pool->maxnthd;